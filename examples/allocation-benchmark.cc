@@ -0,0 +1,189 @@
+/*
+ * This program counts the heap allocations made per simulated uplink on a
+ * workload sized like aloha-throughput (single gateway, ALOHA channel,
+ * periodic traffic), with the interference events of the PHY layer allocated
+ * one by one from the system and then recycled through their pool. Both runs
+ * simulate the same seeded scenario. Allocations are counted by replacing the
+ * global operator new, while the simulation runs only.
+ */
+
+// ns3 imports
+#include "ns3/core-module.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/propagation-delay-model.h"
+
+// lorawan imports
+#include "ns3/forwarder-helper.h"
+#include "ns3/lorawan-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/periodic-sender-helper.h"
+
+// cpp imports
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("AllocationBenchmark");
+
+bool g_counting = false;    //!< Whether allocations are being counted
+uint64_t g_allocations = 0; //!< Number of counted allocations
+uint64_t g_uplinks = 0;     //!< Number of uplinks sent by end devices
+
+void*
+operator new(size_t size)
+{
+    if (g_counting)
+    {
+        g_allocations++;
+    }
+    if (void* block = std::malloc(size ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void
+operator delete(void* block, size_t /* size */) noexcept
+{
+    std::free(block);
+}
+
+/**
+ * Count an uplink leaving an end device.
+ */
+void
+OnStartSending(Ptr<const Packet> packet, uint32_t index)
+{
+    g_uplinks++;
+}
+
+/**
+ * Build a single-gateway network with periodic traffic on the ALOHA region.
+ *
+ * \return The duration of the simulation.
+ */
+Time
+BuildAloha(int nDevices, double period)
+{
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::UniformDiscPositionAllocator",
+                                  "rho",
+                                  DoubleValue(1000),
+                                  "Z",
+                                  DoubleValue(1.2));
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    NodeContainer endDevices;
+    endDevices.Create(nDevices);
+    mobility.Install(endDevices);
+    NodeContainer gateways;
+    gateways.Create(1);
+    auto allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(0.0, 0.0, 15.0));
+    mobility.SetPositionAllocator(allocator);
+    mobility.Install(gateways);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetInterference("IsolationMatrix", EnumValue(LoraInterferenceHelper::ALOHA));
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    macHelper.SetRegion(LorawanMacHelper::ALOHA);
+    LorawanHelper helper;
+    phyHelper.SetType("ns3::EndDeviceLoraPhy");
+    macHelper.SetType("ns3::ClassAEndDeviceLorawanMac");
+    helper.Install(phyHelper, macHelper, endDevices);
+    phyHelper.SetType("ns3::GatewayLoraPhy");
+    macHelper.SetType("ns3::GatewayLorawanMac");
+    helper.Install(phyHelper, macHelper, gateways);
+
+    NodeContainer networkServer;
+    networkServer.Create(1);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    p2p.Install(networkServer.Get(0), gateways.Get(0));
+    NetworkServerHelper nsHelper;
+    nsHelper.SetEndDevices(endDevices);
+    nsHelper.Install(networkServer);
+    ForwarderHelper().Install(gateways);
+
+    Time duration = Seconds(period);
+    PeriodicSenderHelper appHelper;
+    appHelper.SetPeriod(duration);
+    appHelper.SetPacketSize(50);
+    ApplicationContainer apps = appHelper.Install(endDevices);
+    apps.Start(Seconds(0));
+    apps.Stop(duration * 10);
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+    return duration * 10 + Hours(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+    int nDevices = 2000;
+    double period = 600;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices", nDevices);
+    cmd.AddValue("period", "Application period [s], ten periods are simulated", period);
+    cmd.Parse(argc, argv);
+
+    std::cout << std::left << std::setw(8) << "events" << std::right << std::setw(10)
+              << "uplinks" << std::setw(14) << "allocations" << std::setw(12) << "per uplink"
+              << std::setw(16) << "event allocs" << std::setw(12) << "wall [s]" << std::endl;
+    for (bool pooling : {false, true})
+    {
+        ///////////////////// Same seeded scenario for both allocators
+        RngSeedManager::SetSeed(1);
+        RngSeedManager::SetRun(1);
+        RngSeedManager::ResetNextStreamIndex();
+        LoraInterferenceHelper::Event::SetPooling(pooling);
+
+        Time duration = BuildAloha(nDevices, period);
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/0/$ns3::LoraNetDevice/Phy/$ns3::EndDeviceLoraPhy/StartSending",
+            MakeCallback(&OnStartSending));
+        Simulator::Stop(duration);
+
+        g_allocations = 0;
+        g_uplinks = 0;
+        uint64_t eventsBefore = LoraInterferenceHelper::Event::GetNSystemAllocations();
+        auto start = std::chrono::steady_clock::now();
+        g_counting = true;
+        Simulator::Run();
+        g_counting = false;
+        std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+        uint64_t eventAllocations =
+            LoraInterferenceHelper::Event::GetNSystemAllocations() - eventsBefore;
+        Simulator::Destroy();
+
+        NS_ABORT_MSG_IF(g_uplinks == 0, "No uplink was sent");
+        std::cout << std::left << std::setw(8) << (pooling ? "pooled" : "system") << std::right
+                  << std::setw(10) << g_uplinks << std::setw(14) << g_allocations << std::setw(12)
+                  << std::fixed << std::setprecision(2) << double(g_allocations) / g_uplinks
+                  << std::setw(16) << eventAllocations << std::setw(12) << std::setprecision(3)
+                  << wall.count() << std::endl;
+    }
+
+    return 0;
+}
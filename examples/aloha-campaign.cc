@@ -0,0 +1,391 @@
+/*
+ * This program runs a campaign of the aloha-throughput scenario in a single
+ * process. The network (nodes, devices, gateway, network server, links and
+ * applications) is built once; each job of the campaign then runs in a worker
+ * forked from this pre-built image, where it re-draws the device positions and
+ * the application phases from its own run number, sets the application period,
+ * and simulates. Jobs are the product of the lists of simulation times and
+ * radii with the runs; up to a given number of workers run in parallel.
+ *
+ * Results are written to stdout as one JSON object per line and per job, in
+ * order of completion. Packets sent and received and the time on air of a
+ * packet [us] are given per data rate (index 0 is SF12, index 5 is SF7).
+ */
+
+// ns3 imports
+#include "ns3/core-module.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/propagation-delay-model.h"
+
+// lorawan imports
+#include "ns3/forwarder-helper.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-phy-math.h"
+#include "ns3/lorawan-helper.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/periodic-sender-helper.h"
+
+// cpp imports
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("AlohaCampaign");
+#include "utilities.cc"
+
+/**
+ * A (parameters, run) pair of the campaign.
+ */
+struct Job
+{
+    double simulationTime; //!< Duration of the traffic, and period of the applications [s]
+    double radius;         //!< Radius of the deployment [m]
+    int run;               //!< Run number of the random number generator
+};
+
+/**
+ * Split a comma-separated list of numbers.
+ */
+std::vector<double>
+ParseList(std::string s)
+{
+    std::vector<double> values;
+    std::stringstream ss(s);
+    for (std::string item; std::getline(ss, item, ',');)
+    {
+        values.push_back(std::stod(item));
+    }
+    NS_ABORT_MSG_IF(values.empty(), "Empty list of values");
+    return values;
+}
+
+/**
+ * Compute the time on air of the uplinks of the scenario, per data rate.
+ */
+std::vector<int64_t>
+ComputeDurations(int packetSize)
+{
+    std::vector<int64_t> durations(6);
+    for (uint8_t sf = 7; sf <= 12; sf++)
+    {
+        LoraPhyTxParameters txParams;
+        txParams.sf = sf;
+        txParams.headerDisabled = 0;
+        txParams.codingRate = 1;
+        txParams.bandwidthHz = 125000;
+        txParams.nPreamble = 8;
+        txParams.crcEnabled = 1;
+        txParams.lowDataRateOptimizationEnabled =
+            LoraPhyMath::NeedsLowDataRateOptimization(sf, txParams.bandwidthHz);
+
+        LoraFrameHeader fHdr = LoraFrameHeader();
+        fHdr.SetAsUplink();
+        fHdr.SetFPort(1);
+        fHdr.SetAddress(LoraDeviceAddress());
+        fHdr.SetAdr(0);
+        fHdr.SetAdrAckReq(0);
+        fHdr.SetFCnt(0);
+
+        LorawanMacHeader mHdr = LorawanMacHeader();
+        mHdr.SetFType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+        mHdr.SetMajor(1);
+
+        uint32_t size = packetSize + fHdr.GetSerializedSize() + mHdr.GetSerializedSize();
+        durations[12 - sf] = LoraPhy::GetTimeOnAir(size, txParams).GetMicroSeconds();
+    }
+    return durations;
+}
+
+/**
+ * Write a vector as a JSON array.
+ */
+template <typename T>
+void
+PrintArray(std::ostream& os, const std::vector<T>& values)
+{
+    os << "[";
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        os << (i ? "," : "") << values[i];
+    }
+    os << "]";
+}
+
+/**
+ * Format the result of a job as a line of JSON.
+ */
+std::string
+FormatResult(const Job& job,
+             int nDevices,
+             const std::string& interferenceMatrix,
+             const std::vector<int64_t>& durations,
+             const std::string& status,
+             double wall)
+{
+    std::stringstream ss;
+    ss << std::setprecision(10) << "{\"simulationTime\":" << job.simulationTime
+       << ",\"radius\":" << job.radius << ",\"run\":" << job.run << ",\"nDevices\":" << nDevices
+       << ",\"interferenceMatrix\":\"" << interferenceMatrix << "\",\"status\":\"" << status
+       << "\",\"sent\":";
+    PrintArray(ss, packetsSent);
+    ss << ",\"received\":";
+    PrintArray(ss, packetsReceived);
+    ss << ",\"durations\":";
+    PrintArray(ss, durations);
+    ss << ",\"wall\":" << wall << "}\n";
+    return ss.str();
+}
+
+/**
+ * Run a job in a worker, on the network built by the parent process.
+ *
+ * \return The line of results.
+ */
+std::string
+RunJob(const Job& job,
+       NodeContainer endDevices,
+       NodeContainer gateways,
+       NetDeviceContainer devices,
+       Ptr<LoraChannel> channel,
+       ApplicationContainer apps,
+       int nDevices,
+       const std::string& interferenceMatrix,
+       const std::vector<int64_t>& durations)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Streams created from now on follow the run of the job
+    RngSeedManager::SetRun(job.run);
+    RngSeedManager::ResetNextStreamIndex();
+    // Streams created by the parent keep its run until they are assigned again
+    int64_t stream = LorawanHelper().AssignStreams(devices, 0);
+    for (auto app = apps.Begin(); app != apps.End(); ++app)
+    {
+        stream += (*app)->AssignStreams(stream);
+    }
+
+    auto allocator = CreateObject<UniformDiscPositionAllocator>();
+    allocator->SetRho(job.radius);
+    allocator->SetZ(1.2);
+    for (auto node = endDevices.Begin(); node != endDevices.End(); ++node)
+    {
+        (*node)->GetObject<MobilityModel>()->SetPosition(allocator->GetNext());
+    }
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    auto phase = CreateObject<UniformRandomVariable>();
+    Time period = Seconds(job.simulationTime);
+    for (auto app = apps.Begin(); app != apps.End(); ++app)
+    {
+        Ptr<LoraApplication> loraApp = DynamicCast<LoraApplication>(*app);
+        loraApp->SetInterval(period);
+        loraApp->SetInitialDelay(Seconds(phase->GetValue(0, job.simulationTime)));
+        loraApp->SetStopTime(period);
+    }
+
+    Simulator::Stop(period + Hours(1));
+    Simulator::Run();
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    return FormatResult(job, nDevices, interferenceMatrix, durations, "ok", wall.count());
+}
+
+int
+main(int argc, char* argv[])
+{
+    int nDevices = 200;
+    std::string interferenceMatrix = "ALOHA";
+    std::string simulationTimes = "100";
+    std::string radii = "1000";
+    int runs = 1;
+    int firstRun = 1;
+    int workers = 1;
+    int packetSize = 50;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices to include in the simulation", nDevices);
+    cmd.AddValue("interferenceMatrix",
+                 "Interference matrix to use [ALOHA, GOURSAUD]",
+                 interferenceMatrix);
+    cmd.AddValue("simulationTimes",
+                 "Comma-separated list of simulation times [s]",
+                 simulationTimes);
+    cmd.AddValue("radii", "Comma-separated list of deployment radii [m]", radii);
+    cmd.AddValue("runs", "Number of runs per simulation time and radius", runs);
+    cmd.AddValue("firstRun", "Run number of the first run", firstRun);
+    cmd.AddValue("workers", "Maximum number of jobs running in parallel", workers);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(workers < 1, "At least one worker is needed");
+
+    std::vector<Job> jobs;
+    for (double simulationTime : ParseList(simulationTimes))
+    {
+        for (double radius : ParseList(radii))
+        {
+            for (int run = firstRun; run < firstRun + runs; ++run)
+            {
+                jobs.push_back({simulationTime, radius, run});
+            }
+        }
+    }
+
+    /*****************************
+     *  Build the network, once  *
+     ****************************/
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Positions are drawn by the jobs
+    NodeContainer endDevices;
+    endDevices.Create(nDevices);
+    mobility.Install(endDevices);
+    NodeContainer gateways;
+    gateways.Create(1);
+    auto allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(0.0, 0.0, 15.0));
+    mobility.SetPositionAllocator(allocator);
+    mobility.Install(gateways);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetInterference("IsolationMatrix", EnumValue(sirMap.at(interferenceMatrix)));
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    macHelper.SetRegion(LorawanMacHelper::ALOHA);
+    macHelper.SetAddressGenerator(CreateObject<LoraDeviceAddressGenerator>(54, 1864));
+    LorawanHelper helper;
+    phyHelper.SetType("ns3::EndDeviceLoraPhy");
+    macHelper.SetType("ns3::ClassAEndDeviceLorawanMac");
+    NetDeviceContainer devices = helper.Install(phyHelper, macHelper, endDevices);
+    phyHelper.SetType("ns3::GatewayLoraPhy");
+    macHelper.SetType("ns3::GatewayLorawanMac");
+    helper.Install(phyHelper, macHelper, gateways);
+
+    NodeContainer networkServer;
+    networkServer.Create(1);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    p2p.Install(networkServer.Get(0), gateways.Get(0));
+    NetworkServerHelper nsHelper;
+    nsHelper.SetEndDevices(endDevices);
+    nsHelper.Install(networkServer);
+    ForwarderHelper().Install(gateways);
+
+    // Period, phases and stop time are set by the jobs
+    PeriodicSenderHelper appHelper;
+    appHelper.SetPeriod(Seconds(1));
+    appHelper.SetPacketSize(packetSize);
+    ApplicationContainer apps = appHelper.Install(endDevices);
+    apps.Start(Seconds(0));
+
+    DynamicCast<LoraNetDevice>(gateways.Get(0)->GetDevice(0))
+        ->GetPhy()
+        ->TraceConnectWithoutContext("ReceivedPacket", MakeCallback(OnPacketReceptionCallback));
+    for (auto node = endDevices.Begin(); node != endDevices.End(); ++node)
+    {
+        DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("StartSending", MakeCallback(OnTransmissionCallback));
+    }
+
+    std::vector<int64_t> durations = ComputeDurations(packetSize);
+    NS_LOG_INFO("Network built, running " << jobs.size() << " jobs");
+
+    /************************************
+     *  Run the jobs in forked workers  *
+     ***********************************/
+
+    // Workers write their single line of results to a pipe and exit
+    std::map<pid_t, std::pair<int, size_t>> running; // Pid -> (read end of the pipe, job)
+    size_t next = 0;
+    int failed = 0;
+    std::cout.flush();
+    while (next < jobs.size() || !running.empty())
+    {
+        if (next < jobs.size() && running.size() < size_t(workers))
+        {
+            int fd[2];
+            NS_ABORT_MSG_IF(pipe(fd) != 0, "Unable to create a pipe");
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "Unable to fork a worker");
+            if (pid == 0)
+            {
+                close(fd[0]);
+                std::string line = RunJob(jobs[next],
+                                          endDevices,
+                                          gateways,
+                                          devices,
+                                          channel,
+                                          apps,
+                                          nDevices,
+                                          interferenceMatrix,
+                                          durations);
+                for (size_t off = 0; off < line.size();)
+                {
+                    ssize_t n = write(fd[1], line.data() + off, line.size() - off);
+                    if (n <= 0)
+                    {
+                        _exit(1);
+                    }
+                    off += n;
+                }
+                _exit(0);
+            }
+            close(fd[1]);
+            running[pid] = {fd[0], next++};
+            continue;
+        }
+
+        // Collect a finished worker. Results are small enough to fit in the pipe.
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        NS_ABORT_MSG_IF(pid < 0, "Unable to wait for the workers");
+        auto it = running.find(pid);
+        if (it == running.end())
+        {
+            continue;
+        }
+        std::string line;
+        char buf[4096];
+        for (ssize_t n; (n = read(it->second.first, buf, sizeof(buf))) > 0;)
+        {
+            line.append(buf, n);
+        }
+        close(it->second.first);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || line.empty())
+        {
+            std::fill(packetsSent.begin(), packetsSent.end(), 0);
+            std::fill(packetsReceived.begin(), packetsReceived.end(), 0);
+            line = FormatResult(jobs[it->second.second],
+                                nDevices,
+                                interferenceMatrix,
+                                durations,
+                                "failed",
+                                0);
+            failed++;
+        }
+        std::cout << line << std::flush;
+        running.erase(it);
+    }
+
+    Simulator::Destroy();
+
+    return failed > 0;
+}
@@ -15,6 +15,7 @@
 #include "ns3/lora-device-address.h"
 #include "ns3/lora-frame-header.h"
 #include "ns3/lora-net-device.h"
+#include "ns3/lora-phy-math.h"
 #include "ns3/lora-phy.h"
 #include "ns3/lorawan-helper.h"
 #include "ns3/lorawan-mac-header.h"
@@ -222,8 +223,8 @@ main(int argc, char* argv[])
         txParams.bandwidthHz = 125000;
         txParams.nPreamble = 8;
         txParams.crcEnabled = 1;
-        txParams.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(txParams) > MilliSeconds(16);
-        Ptr<Packet> pkt = Create<Packet>(packetSize);
+        txParams.lowDataRateOptimizationEnabled =
+            LoraPhyMath::NeedsLowDataRateOptimization(sf, txParams.bandwidthHz);
 
         LoraFrameHeader fHdr = LoraFrameHeader();
         fHdr.SetAsUplink();
@@ -232,14 +233,13 @@ main(int argc, char* argv[])
         fHdr.SetAdr(0);
         fHdr.SetAdrAckReq(0);
         fHdr.SetFCnt(0);
-        pkt->AddHeader(fHdr);
 
         LorawanMacHeader mHdr = LorawanMacHeader();
         mHdr.SetFType(ns3::lorawan::LorawanMacHeader::UNCONFIRMED_DATA_UP);
         mHdr.SetMajor(1);
-        pkt->AddHeader(mHdr);
 
-        outputFile << LoraPhy::GetTimeOnAir(pkt, txParams).GetMicroSeconds() << " ";
+        uint32_t size = packetSize + fHdr.GetSerializedSize() + mHdr.GetSerializedSize();
+        outputFile << LoraPhy::GetTimeOnAir(size, txParams).GetMicroSeconds() << " ";
     }
     outputFile.close();
 
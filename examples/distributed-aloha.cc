@@ -0,0 +1,226 @@
+/*
+ * This program runs an uplink-only network split across MPI ranks with the
+ * DistributedLoraChannel. The deployment disc is cut in vertical strips, one
+ * per rank, and each rank owns the gateways and end devices of its strip.
+ * Packets sent and received per SF are summed over ranks, and match those of
+ * a run with a single rank (the distributed-lora-channel test suite checks it):
+ *
+ *     mpirun -np 1 ./ns3-dev-distributed-aloha-default --nDevices=2000
+ *     mpirun -np 4 ./ns3-dev-distributed-aloha-default --nDevices=2000
+ *
+ * Receptions are delivered at preamble lock, which sets the lookahead between
+ * ranks: the propagation delays alone are too short.
+ */
+
+// ns3 imports
+#include "ns3/core-module.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+
+// lorawan imports
+#include "ns3/distributed-lora-channel.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/lora-phy-math.h"
+#include "ns3/lorawan-helper.h"
+#include "ns3/periodic-sender.h"
+
+// cpp imports
+#include <chrono>
+#include <limits>
+#include <mpi.h>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("DistributedAloha");
+#include "utilities.cc"
+
+/**
+ * Get the rank owning a position, by vertical strips of the disc.
+ */
+uint32_t
+GetOwner(const Vector& position, double radius, uint32_t nRanks)
+{
+    double strip = (position.x + radius) / (2 * radius) * nRanks;
+    return std::min<uint32_t>(nRanks - 1, std::max(0.0, strip));
+}
+
+/**
+ * Create a node per position, owned by the rank of its strip.
+ */
+NodeContainer
+CreateNodes(const std::vector<Vector>& positions, double radius, uint32_t nRanks)
+{
+    NodeContainer nodes;
+    auto allocator = CreateObject<ListPositionAllocator>();
+    for (const auto& position : positions)
+    {
+        nodes.Add(CreateObject<Node>(GetOwner(position, radius, nRanks)));
+        allocator->Add(position);
+    }
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+    return nodes;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int nDevices = 1000;
+    int gatewayRings = 2;
+    double range = 2000;
+    double period = 600;
+    double simulationTime = 3600;
+    std::string interferenceMatrix = "CROCE";
+    double rxPowerCutoff = -std::numeric_limits<double>::infinity();
+    double preambleLock = 4;
+
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+    uint32_t rank = MpiInterface::GetSystemId();
+    uint32_t nRanks = MpiInterface::GetSize();
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices to include in the simulation", nDevices);
+    cmd.AddValue("rings", "Number of gateway rings in hexagonal topology", gatewayRings);
+    cmd.AddValue("range", "Distance between neighbouring gateways [m]", range);
+    cmd.AddValue("period", "Period of the devices [s]", period);
+    cmd.AddValue("simulationTime", "Simulated time [s]", simulationTime);
+    cmd.AddValue("interferenceMatrix",
+                 "Interference matrix (ALOHA/GOURSAUD/CROCE)",
+                 interferenceMatrix);
+    cmd.AddValue("rxPowerCutoff", "Weakest reception delivered to PHYs [dBm]", rxPowerCutoff);
+    cmd.AddValue("preambleLock",
+                 "Preamble lock time, in symbols of the fastest data rate (SF7, 125 kHz)",
+                 preambleLock);
+    cmd.Parse(argc, argv);
+
+    /******************
+     *  Partitioning  *
+     ******************/
+
+    // Every rank draws the same positions to build the same network
+    int nGateways = 3 * gatewayRings * gatewayRings - 3 * gatewayRings + 1;
+    double radius = range * gatewayRings;
+    auto gwAllocator = CreateObjectWithAttributes<HexGridPositionAllocator>(
+        "distance",
+        DoubleValue(range),
+        "Z",
+        DoubleValue(15));
+    std::vector<Vector> gwPositions;
+    for (int i = 0; i < nGateways; ++i)
+    {
+        gwPositions.push_back(gwAllocator->GetNext());
+    }
+    auto edAllocator = CreateObjectWithAttributes<UniformDiscPositionAllocator>("rho",
+                                                                                DoubleValue(radius),
+                                                                                "Z",
+                                                                                DoubleValue(1.2));
+    std::vector<Vector> edPositions;
+    for (int i = 0; i < nDevices; ++i)
+    {
+        edPositions.push_back(edAllocator->GetNext());
+    }
+
+    /***********************
+     *  Channel and nodes  *
+     ***********************/
+
+    auto loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    auto delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    auto channel = CreateObject<DistributedLoraChannel>(loss, delay);
+    channel->SetAttribute("RxPowerCutoff", DoubleValue(rxPowerCutoff));
+    channel->SetAttribute(
+        "PreambleLockTime",
+        TimeValue(Seconds(preambleLock * LoraPhyMath::GetSymbolTime(7, 125000))));
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetInterference("IsolationMatrix", EnumValue(sirMap.at(interferenceMatrix)));
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    LorawanHelper helper;
+
+    NodeContainer gateways = CreateNodes(gwPositions, radius, nRanks);
+    phyHelper.SetType("ns3::GatewayLoraPhy");
+    macHelper.SetType("ns3::GatewayLorawanMac");
+    helper.Install(phyHelper, macHelper, gateways);
+
+    NodeContainer endDevices = CreateNodes(edPositions, radius, nRanks);
+    macHelper.SetAddressGenerator(CreateObject<LoraDeviceAddressGenerator>());
+    phyHelper.SetType("ns3::EndDeviceLoraPhy");
+    macHelper.SetType("ns3::ClassAEndDeviceLorawanMac");
+    helper.Install(phyHelper, macHelper, endDevices);
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    channel->Setup();
+    NS_LOG_INFO("Rank " << rank << ": lookahead " << channel->GetLookAhead());
+
+    /******************
+     *  Applications  *
+     ******************/
+
+    // Phases are drawn for all devices, to be the same whatever the number of ranks
+    auto phase = CreateObject<UniformRandomVariable>();
+    for (auto node = endDevices.Begin(); node != endDevices.End(); ++node)
+    {
+        double initialDelay = phase->GetValue(0, period);
+        if ((*node)->GetSystemId() != rank)
+        {
+            continue;
+        }
+        auto app = CreateObject<PeriodicSender>();
+        app->SetInterval(Seconds(period));
+        app->SetInitialDelay(Seconds(initialDelay));
+        app->SetPacketSize(20);
+        app->SetStopTime(Seconds(simulationTime));
+        (*node)->AddApplication(app);
+        DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("StartSending", MakeCallback(OnTransmissionCallback));
+    }
+    for (auto node = gateways.Begin(); node != gateways.End(); ++node)
+    {
+        DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("ReceivedPacket", MakeCallback(OnPacketReceptionCallback));
+    }
+
+    /****************
+     *  Simulation  *
+     ****************/
+
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(simulationTime) + Minutes(1));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    uint64_t messages = channel->GetNMessages();
+    Simulator::Destroy();
+
+    // Sum the counters of all ranks
+    std::vector<int> sent(6, 0);
+    std::vector<int> received(6, 0);
+    uint64_t totalMessages = 0;
+    MPI_Comm comm = MpiInterface::GetCommunicator();
+    MPI_Reduce(packetsSent.data(), sent.data(), 6, MPI_INT, MPI_SUM, 0, comm);
+    MPI_Reduce(packetsReceived.data(), received.data(), 6, MPI_INT, MPI_SUM, 0, comm);
+    MPI_Reduce(&messages, &totalMessages, 1, MPI_UINT64_T, MPI_SUM, 0, comm);
+    if (rank == 0)
+    {
+        std::cout << "ranks " << nRanks << ", wall " << wall.count() << " s, messages "
+                  << totalMessages << std::endl;
+        for (int i = 0; i < 6; i++)
+        {
+            std::cout << "SF" << 12 - i << " " << sent[i] << " " << received[i] << std::endl;
+        }
+    }
+
+    MpiInterface::Disable();
+    return 0;
+}
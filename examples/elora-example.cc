@@ -1,5 +1,7 @@
 /*
- * This program produces real-time traffic to an external chirpstack server.
+ * This program produces real-time traffic to an external chirpstack server
+ * (through a tap-bridge, or host sockets with --hostSockets),
+ * or simulated-time traffic to the built-in server stand-in (--localServer).
  * Key elements are preceded by a comment with lots of dashes ( ///////////// )
  */
 
@@ -16,12 +18,17 @@
 
 // lorawan imports
 #include "ns3/chirpstack-helper.h"
+#include "ns3/fleet-traffic-driver.h"
 #include "ns3/hex-grid-position-allocator.h"
 #include "ns3/lorawan-helper.h"
+#include "ns3/metrics-exporter.h"
+#include "ns3/network-server-helper.h"
 #include "ns3/periodic-sender-helper.h"
 #include "ns3/range-position-allocator.h"
+#include "ns3/realtime-lag-monitor.h"
 #include "ns3/udp-forwarder-helper.h"
 #include "ns3/urban-traffic-helper.h"
+#include "ns3/virtual-device-fleet.h"
 
 // cpp imports
 #include <unordered_map>
@@ -59,7 +66,16 @@ main(int argc, char* argv[])
     bool initializeSF = true;
     bool testDev = false;
     bool file = false; // Warning: will produce a file for each gateway
+    bool mergePcap = false;
     bool log = false;
+    double lagThreshold = 100; // ms
+    std::string lagPolicy = "WARN";
+    std::string metrics = "";
+    bool localServer = false;
+    bool hostSockets = false;
+    std::string bridgeAddr = "127.0.0.1";
+    bool fleet = false;
+    int virtualDevices = 0;
 
     /* Expose parameters to command line */
     {
@@ -78,13 +94,42 @@ main(int argc, char* argv[])
         cmd.AddValue("adr", "ns3::BaseEndDeviceLorawanMac::ADRBit");
         cmd.AddValue("test", "Use test devices (5s period, 5B payload)", testDev);
         cmd.AddValue("file", "Whether to enable .pcap tracing on gateways", file);
+        cmd.AddValue("mergePcap", "Trace all gateways to a single lora.pcapng file", mergePcap);
         cmd.AddValue("log", "Whether to enable logs", log);
+        cmd.AddValue("lagThreshold", "Scheduler lag triggering the lag policy [ms]", lagThreshold);
+        cmd.AddValue("lagPolicy", "Action on excessive scheduler lag (WARN/ABORT/SHED)", lagPolicy);
+        cmd.AddValue("metrics", "If not empty, export live metrics to this file", metrics);
+        cmd.AddValue("localServer",
+                     "Use the built-in network server stand-in instead of Chirpstack",
+                     localServer);
+        cmd.AddValue("hostSockets",
+                     "Forward gateway traffic through host UDP sockets instead of a tap-bridge",
+                     hostSockets);
+        cmd.AddValue("bridgeAddr",
+                     "Chirpstack Gateway Bridge IP address, reached by host sockets",
+                     bridgeAddr);
+        cmd.AddValue("fleet", "Schedule all device sends from a single fleet driver", fleet);
+        cmd.AddValue("virtualDevices",
+                     "Number of devices emulated at gateway level, without radio simulation",
+                     virtualDevices);
         cmd.Parse(argc, argv);
+        NS_ABORT_MSG_IF(localServer && hostSockets,
+                        "The local server stand-in can only be reached through the simulated "
+                        "network");
     }
 
     /* Apply global configurations */
     ///////////////// Real-time operation, necessary to interact with the outside world.
-    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+    if (!localServer)
+    {
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::RealtimeSimulatorImpl"));
+    }
+    else
+    {
+        ///////////////// The stand-in server lives in simulated time, so do gateways
+        Config::SetDefault("ns3::UdpForwarder::ClockSource", StringValue("SIMULATOR"));
+    }
     GlobalValue::Bind("ChecksumEnabled", BooleanValue(true));
     Config::SetDefault("ns3::BaseEndDeviceLorawanMac::ADRBackoff", BooleanValue(true));
     Config::SetDefault("ns3::BaseEndDeviceLorawanMac::EnableCryptography", BooleanValue(true));
@@ -187,6 +232,7 @@ main(int argc, char* argv[])
      ************************/
 
     /* Csma between gateways and tap-bridge (represented by exitnode) */
+    if (!hostSockets)
     {
         NodeContainer csmaNodes(NodeContainer(exitnode), gateways);
 
@@ -209,12 +255,20 @@ main(int argc, char* argv[])
     }
 
     ///////////////// Attach a Tap-bridge to outside the simulation to the server csma device
-    TapBridgeHelper tapBridge;
-    tapBridge.SetAttribute("Mode", StringValue("ConfigureLocal"));
-    tapBridge.SetAttribute("DeviceName", StringValue("ns3-tap"));
-    tapBridge.Install(exitnode, exitnode->GetDevice(0));
+    if (!localServer && !hostSockets)
+    {
+        TapBridgeHelper tapBridge;
+        tapBridge.SetAttribute("Mode", StringValue("ConfigureLocal"));
+        tapBridge.SetAttribute("DeviceName", StringValue("ns3-tap"));
+        tapBridge.Install(exitnode, exitnode->GetDevice(0));
+    }
 
     /* Radio side (between end devicees and gateways) */
+    // Create a LoraDeviceAddressGenerator
+    /////////////////// Enables full parallelism between ELoRa instances
+    uint8_t nwkId = RngSeedManager::GetRun();
+    auto addrGen = CreateObject<LoraDeviceAddressGenerator>(nwkId);
+
     LorawanHelper helper;
     NetDeviceContainer gwNetDev;
     {
@@ -223,11 +277,6 @@ main(int argc, char* argv[])
         phyHelper.SetInterference("IsolationMatrix", EnumValue(sirMap.at(sir)));
         phyHelper.SetChannel(channel);
 
-        // Create a LoraDeviceAddressGenerator
-        /////////////////// Enables full parallelism between ELoRa instances
-        uint8_t nwkId = RngSeedManager::GetRun();
-        auto addrGen = CreateObject<LoraDeviceAddressGenerator>(nwkId);
-
         // Mac layer settings
         LorawanMacHelper macHelper;
         macHelper.SetRegion(LorawanMacHelper::EU);
@@ -248,13 +297,34 @@ main(int argc, char* argv[])
      *  Create Applications  *
      *************************/
 
+    ApplicationContainer devApps;
+    Ptr<VirtualDeviceFleet> virtualFleet;
     {
         // Install UDP forwarders in gateways
         UdpForwarderHelper forwarderHelper;
         forwarderHelper.SetAttribute("RemoteAddress", AddressValue(Ipv4Address("10.1.2.1")));
         forwarderHelper.SetAttribute("RemotePort", UintegerValue(destPort));
+        ///////////////// Skip the simulated backhaul, one host socket per gateway stream
+        if (hostSockets)
+        {
+            forwarderHelper.SetAttribute("Transport", StringValue("HOST"));
+            forwarderHelper.SetAttribute("RemoteAddress",
+                                         AddressValue(Ipv4Address(bridgeAddr.c_str())));
+        }
         forwarderHelper.Install(gateways);
 
+        ///////////////// Serve the gateways from the exit node instead of Chirpstack
+        if (localServer)
+        {
+            NetworkServerHelper serverHelper;
+            serverHelper.SetType("ns3::UdpNetworkServer");
+            serverHelper.SetAttribute("Port", UintegerValue(destPort));
+            serverHelper.SetAttribute("EnableCryptography", BooleanValue(true));
+            serverHelper.SetEndDevices(endDevices);
+            serverHelper.EnableAdr(true);
+            serverHelper.Install(exitnode);
+        }
+
         // Install applications in EDs
         if (testDev)
         {
@@ -263,13 +333,32 @@ main(int argc, char* argv[])
                 CreateObjectWithAttributes<ConstantRandomVariable>("Constant", DoubleValue(5.0)));
             appHelper.SetPacketSizeGenerator(
                 CreateObjectWithAttributes<ConstantRandomVariable>("Constant", DoubleValue(5.0)));
-            appHelper.Install(endDevices);
+            devApps = appHelper.Install(endDevices);
         }
         else
         {
             UrbanTrafficHelper appHelper;
             appHelper.SetDeviceGroups(Commercial);
-            appHelper.Install(endDevices);
+            devApps = appHelper.Install(endDevices);
+        }
+
+        ///////////////// Keep a single event per fleet in the simulator queue
+        if (fleet)
+        {
+            CreateObject<FleetTrafficDriver>()->Add(devApps);
+        }
+
+        ///////////////// Inject the uplinks of a virtual fleet directly in the forwarders
+        if (virtualDevices > 0)
+        {
+            // Addresses follow those of the real devices, both are registered on the server
+            LoraDeviceAddress first = addrGen->GetNextAddress();
+            virtualFleet = CreateObject<VirtualDeviceFleet>();
+            virtualFleet->SetAttribute("NwkId", UintegerValue(first.GetNwkID()));
+            virtualFleet->SetAttribute("FirstNwkAddr", UintegerValue(first.GetNwkAddr()));
+            virtualFleet->AddDevices(virtualDevices);
+            virtualFleet->AddGateways(gateways);
+            virtualFleet->Start();
         }
     }
 
@@ -277,18 +366,26 @@ main(int argc, char* argv[])
      *  Simulation and metrics *
      ***************************/
 
-    ///////////////////// Signal handling
-    OnInterrupt([](int signal) { csHelper.CloseConnection(signal); });
-    ///////////////////// Register tenant, gateways, and devices on the real server
-    csHelper.SetTenant(tenant);
-    csHelper.InitConnection(apiAddr, apiPort, token);
-    csHelper.Register(NodeContainer(endDevices, gateways));
+    if (!localServer)
+    {
+        ///////////////////// Signal handling
+        OnInterrupt([](int signal) { csHelper.CloseConnection(signal); });
+        ///////////////////// Register tenant, gateways, and devices on the real server
+        csHelper.SetTenant(tenant);
+        csHelper.InitConnection(apiAddr, apiPort, token);
+        csHelper.Register(NodeContainer(endDevices, gateways));
+        if (virtualFleet)
+        {
+            csHelper.Register(virtualFleet);
+        }
+    }
 
     // Initialize SF emulating the ADR algorithm, then add variance to path loss
+    // (until then, loss only grows with distance: the nearest gateway is the best one)
     std::vector<int> devPerSF(1, nDevices);
     if (initializeSF)
     {
-        devPerSF = LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+        devPerSF = LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel, 1);
     }
     loss->SetNext(rayleigh);
 
@@ -304,13 +401,44 @@ main(int argc, char* argv[])
 
     if (file)
     {
+        ///////////////////// Keep disk writes off the real-time simulation thread
+        helper.EnableAsyncPcap(mergePcap ? "lora.pcapng" : "");
         helper.EnablePcap("lora", gwNetDev);
     }
 
+    ///////////////////// Detect when the host can not keep up with real-time
+    Ptr<RealtimeLagMonitor> lagMonitor;
+    if (!localServer)
+    {
+        lagMonitor = CreateObject<RealtimeLagMonitor>();
+        lagMonitor->SetAttribute("Threshold", TimeValue(MilliSeconds(lagThreshold)));
+        lagMonitor->SetAttribute("Policy", StringValue(lagPolicy));
+        lagMonitor->SetApplications(devApps);
+        lagMonitor->Start();
+    }
+
+    ///////////////////// Export live metrics off the simulation thread
+    Ptr<MetricsExporter> exporter;
+    if (!metrics.empty())
+    {
+        exporter = CreateObject<MetricsExporter>();
+        exporter->SetAttribute("File", StringValue(metrics));
+        exporter->AddGateways(gateways);
+        if (lagMonitor)
+        {
+            exporter->SetLagMonitor(lagMonitor);
+        }
+        exporter->Start();
+    }
+
     Simulator::Stop(Hours(1) * periods);
 
     // Start simulation
     Simulator::Run();
+    if (exporter)
+    {
+        exporter->Stop();
+    }
     Simulator::Destroy();
 
     return 0;
@@ -0,0 +1,158 @@
+/*
+ * This program compares the wall-clock cost of encoding and decoding LoRaWAN
+ * data frames with the packet headers (LorawanMacHeader and LoraFrameHeader
+ * on a Packet) and with the LorawanFrameCodec on contiguous bytes. Frames are
+ * uplinks carrying a few MAC answers in FOpts and an application payload.
+ */
+
+// ns3 imports
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+
+// lorawan imports
+#include "ns3/lora-frame-header.h"
+#include "ns3/lorawan-frame-codec.h"
+#include "ns3/lorawan-mac-header.h"
+
+// cpp imports
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("FrameCodecBenchmark");
+
+/**
+ * Print a line of results.
+ */
+void
+PrintResult(std::string path, std::string operation, int frames, double wall)
+{
+    std::cout << std::left << std::setw(10) << path << std::setw(10) << operation << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << wall << std::setw(14)
+              << std::setprecision(1) << wall * 1e9 / frames << std::endl;
+}
+
+/**
+ * Set the fields of the benchmarked frame, as the headers path does.
+ */
+void
+FillFrame(LorawanFrame& frame,
+          uint16_t fCnt,
+          const std::vector<uint8_t>& payload,
+          const MacCommandValue& devStatusAns)
+{
+    frame.fType = LorawanMacHeader::UNCONFIRMED_DATA_UP;
+    frame.devAddr = 0x12345678;
+    frame.adr = true;
+    frame.fCnt = fCnt;
+    MacCommandValue linkAdrAns(LINK_ADR_ANS);
+    linkAdrAns.linkAdrAns = {true, true, true};
+    frame.fOpts.PushBack(linkAdrAns);
+    frame.fOpts.PushBack(devStatusAns);
+    frame.fPort = 1;
+    frame.frmPayload = payload.data();
+    frame.frmPayloadSize = payload.size();
+    frame.mic = 0xa1b2c3d4;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int frames = 1000000;
+    int payloadSize = 20;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("frames", "Number of frames encoded and decoded per path", frames);
+    cmd.AddValue("payloadSize", "Size of the application payload [B]", payloadSize);
+    cmd.Parse(argc, argv);
+
+    std::vector<uint8_t> payload(payloadSize);
+    for (int i = 0; i < payloadSize; ++i)
+    {
+        payload[i] = uint8_t(i);
+    }
+    uint8_t mic[LorawanFrameCodec::MIC_SIZE] = {0xd4, 0xc3, 0xb2, 0xa1};
+    MacCommandValue devStatusAns(DEV_STATUS_ANS);
+    devStatusAns.devStatusAns = {200, 20};
+    uint64_t checksum = 0; // Keeps the work from being optimized away
+
+    std::cout << std::left << std::setw(10) << "path" << std::setw(10) << "operation"
+              << std::right << std::setw(12) << "wall [s]" << std::setw(14) << "ns/frame"
+              << std::endl;
+
+    ///////////////////// Packet and headers
+    std::vector<Ptr<Packet>> packets(frames);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        Ptr<Packet> packet = Create<Packet>(payload.data(), payloadSize);
+        LoraFrameHeader fHdr;
+        fHdr.SetAsUplink();
+        fHdr.SetAddress(LoraDeviceAddress(0x12345678));
+        fHdr.SetAdr(true);
+        fHdr.SetFCnt(uint16_t(i));
+        fHdr.SetFPort(1);
+        fHdr.AddLinkAdrAns(true, true, true);
+        fHdr.AddCommand(devStatusAns);
+        packet->AddHeader(fHdr);
+        LorawanMacHeader mHdr;
+        mHdr.SetFType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+        packet->AddHeader(mHdr);
+        packet->AddAtEnd(Create<Packet>(mic, sizeof(mic)));
+        packets[i] = packet;
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    PrintResult("headers", "encode", frames, wall.count());
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        Ptr<Packet> packet = packets[i]->Copy();
+        packet->RemoveAtEnd(LorawanFrameCodec::MIC_SIZE);
+        LorawanMacHeader mHdr;
+        packet->RemoveHeader(mHdr);
+        LoraFrameHeader fHdr;
+        fHdr.SetAsUplink();
+        packet->RemoveHeader(fHdr);
+        checksum += fHdr.GetFCnt() + fHdr.GetCommandList().GetN() + packet->GetSize();
+    }
+    wall = std::chrono::steady_clock::now() - start;
+    PrintResult("headers", "decode", frames, wall.count());
+    packets.clear();
+
+    ///////////////////// Codec on contiguous bytes
+    LorawanFrame reference;
+    FillFrame(reference, 0, payload, devStatusAns);
+    uint32_t frameSize = LorawanFrameCodec::GetSize(reference);
+    NS_ABORT_MSG_IF(frameSize > LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE, "Payload too large");
+    std::vector<uint8_t> bytes(uint64_t(frames) * frameSize);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        LorawanFrame frame;
+        FillFrame(frame, uint16_t(i), payload, devStatusAns);
+        uint32_t size =
+            LorawanFrameCodec::Encode(frame, bytes.data() + uint64_t(i) * frameSize, frameSize);
+        NS_ABORT_MSG_IF(size != frameSize, "Unexpected frame size");
+    }
+    wall = std::chrono::steady_clock::now() - start;
+    PrintResult("codec", "encode", frames, wall.count());
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        LorawanFrame frame;
+        bool ok =
+            LorawanFrameCodec::Decode(bytes.data() + uint64_t(i) * frameSize, frameSize, frame);
+        NS_ABORT_MSG_IF(!ok, "Invalid frame");
+        checksum += frame.fCnt + frame.fOpts.GetN() + frame.frmPayloadSize;
+    }
+    wall = std::chrono::steady_clock::now() - start;
+    PrintResult("codec", "decode", frames, wall.count());
+
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}
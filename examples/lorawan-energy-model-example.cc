@@ -12,6 +12,7 @@
 #include "ns3/gateway-lora-phy.h"
 #include "ns3/gateway-lorawan-mac.h"
 #include "ns3/log.h"
+#include "ns3/lora-analytic-energy-source-helper.h"
 #include "ns3/lora-radio-energy-model-helper.h"
 #include "ns3/lorawan-helper.h"
 #include "ns3/mobility-helper.h"
@@ -32,6 +33,14 @@ NS_LOG_COMPONENT_DEFINE("LoraEnergyModelExample");
 int
 main(int argc, char* argv[])
 {
+    bool analytic = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("analytic",
+                 "Use a LoraAnalyticEnergySource, without periodic updates of the battery",
+                 analytic);
+    cmd.Parse(argc, argv);
+
     // Set up logging
     LogComponentEnable("LoraEnergyModelExample", LOG_LEVEL_ALL);
     // LogComponentEnable ("LoraRadioEnergyModel", LOG_LEVEL_ALL);
@@ -152,11 +161,14 @@ main(int argc, char* argv[])
 
     NS_LOG_INFO("Installing energy model on end devices...");
     BasicEnergySourceHelper basicSourceHelper;
+    LoraAnalyticEnergySourceHelper analyticSourceHelper;
     LoraRadioEnergyModelHelper radioEnergyHelper;
 
     // configure energy source
     basicSourceHelper.Set("BasicEnergySourceInitialEnergyJ", DoubleValue(10000)); // Energy in J
     basicSourceHelper.Set("BasicEnergySupplyVoltageV", DoubleValue(3.3));
+    analyticSourceHelper.Set("InitialEnergyJ", DoubleValue(10000)); // Energy in J
+    analyticSourceHelper.Set("SupplyVoltageV", DoubleValue(3.3));
 
     radioEnergyHelper.Set("StandbyCurrentA", DoubleValue(0.0014));
     radioEnergyHelper.Set("TxCurrentA", DoubleValue(0.028));
@@ -168,7 +180,8 @@ main(int argc, char* argv[])
                                         DoubleValue(0.028));
 
     // install source on EDs' nodes
-    EnergySourceContainer sources = basicSourceHelper.Install(endDevices);
+    EnergySourceContainer sources = analytic ? analyticSourceHelper.Install(endDevices)
+                                             : basicSourceHelper.Install(endDevices);
     Names::Add("/Names/EnergySource", sources.Get(0));
 
     // install device model
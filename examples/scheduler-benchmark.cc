@@ -0,0 +1,259 @@
+/*
+ * This program compares the wall-clock speed of the ns-3 event schedulers
+ * (Map, Heap, Calendar, and the module's TimingWheel) on LoRaWAN workloads
+ * sized like aloha-throughput (single gateway, ALOHA channel, periodic traffic)
+ * and elora-example (hexagonal gateway grid, urban traffic mix, one day).
+ * Every scheduler runs the same seeded scenario, and the number of processed
+ * events is checked to be the same for all of them.
+ */
+
+// ns3 imports
+#include "ns3/core-module.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/okumura-hata-propagation-loss-model.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/propagation-delay-model.h"
+
+// lorawan imports
+#include "ns3/forwarder-helper.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/lorawan-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/range-position-allocator.h"
+#include "ns3/urban-traffic-helper.h"
+
+// cpp imports
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("SchedulerBenchmark");
+
+/**
+ * Build a single-gateway network with periodic traffic on the ALOHA region.
+ *
+ * \return The duration of the simulation.
+ */
+Time
+BuildAloha(int nDevices, double period)
+{
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::UniformDiscPositionAllocator",
+                                  "rho",
+                                  DoubleValue(1000),
+                                  "Z",
+                                  DoubleValue(1.2));
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    NodeContainer endDevices;
+    endDevices.Create(nDevices);
+    mobility.Install(endDevices);
+    NodeContainer gateways;
+    gateways.Create(1);
+    auto allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(0.0, 0.0, 15.0));
+    mobility.SetPositionAllocator(allocator);
+    mobility.Install(gateways);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetInterference("IsolationMatrix", EnumValue(LoraInterferenceHelper::ALOHA));
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    macHelper.SetRegion(LorawanMacHelper::ALOHA);
+    LorawanHelper helper;
+    phyHelper.SetType("ns3::EndDeviceLoraPhy");
+    macHelper.SetType("ns3::ClassAEndDeviceLorawanMac");
+    helper.Install(phyHelper, macHelper, endDevices);
+    phyHelper.SetType("ns3::GatewayLoraPhy");
+    macHelper.SetType("ns3::GatewayLorawanMac");
+    helper.Install(phyHelper, macHelper, gateways);
+
+    NodeContainer networkServer;
+    networkServer.Create(1);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    p2p.Install(networkServer.Get(0), gateways.Get(0));
+    NetworkServerHelper nsHelper;
+    nsHelper.SetEndDevices(endDevices);
+    nsHelper.Install(networkServer);
+    ForwarderHelper().Install(gateways);
+
+    Time duration = Seconds(period);
+    PeriodicSenderHelper appHelper;
+    appHelper.SetPeriod(duration);
+    appHelper.SetPacketSize(50);
+    ApplicationContainer apps = appHelper.Install(endDevices);
+    apps.Start(Seconds(0));
+    apps.Stop(duration);
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+    return duration + Hours(1);
+}
+
+/**
+ * Build an hexagonal grid of gateways with the commercial urban traffic mix.
+ *
+ * \return The duration of the simulation.
+ */
+Time
+BuildElora(int nDevices, int rings, double hours)
+{
+    double range = 2540.25;
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    auto loss = CreateObject<OkumuraHataPropagationLossModel>();
+    loss->SetAttribute("Frequency", DoubleValue(868100000.0));
+    loss->SetAttribute("Environment", EnumValue(UrbanEnvironment));
+    loss->SetAttribute("CitySize", EnumValue(LargeCity));
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    MobilityHelper mobilityGw;
+    mobilityGw.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    double gatewayDistance = range * std::cos(M_PI / 6) * 2;
+    auto hexAllocator = CreateObject<HexGridPositionAllocator>();
+    hexAllocator->SetAttribute("Z", DoubleValue(30.0));
+    hexAllocator->SetAttribute("distance", DoubleValue(gatewayDistance));
+    mobilityGw.SetPositionAllocator(hexAllocator);
+    MobilityHelper mobilityEd;
+    mobilityEd.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    auto rangeAllocator = CreateObject<RangePositionAllocator>();
+    rangeAllocator->SetAttribute("rho", DoubleValue(range + 2.0 * gatewayDistance * (rings - 1)));
+    rangeAllocator->SetAttribute("ZRV", StringValue("ns3::UniformRandomVariable[Min=1|Max=10]"));
+    rangeAllocator->SetAttribute("range", DoubleValue(range));
+    mobilityEd.SetPositionAllocator(rangeAllocator);
+
+    NodeContainer gateways;
+    gateways.Create(3 * rings * rings - 3 * rings + 1);
+    mobilityGw.Install(gateways);
+    rangeAllocator->SetNodes(gateways);
+    NodeContainer endDevices;
+    endDevices.Create(nDevices);
+    mobilityEd.Install(endDevices);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetInterference("IsolationMatrix", EnumValue(LoraInterferenceHelper::CROCE));
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    macHelper.SetRegion(LorawanMacHelper::EU);
+    LorawanHelper helper;
+    phyHelper.SetType("ns3::GatewayLoraPhy");
+    macHelper.SetType("ns3::GatewayLorawanMac");
+    helper.Install(phyHelper, macHelper, gateways);
+    phyHelper.SetType("ns3::EndDeviceLoraPhy");
+    macHelper.SetType("ns3::ClassAEndDeviceLorawanMac");
+    helper.Install(phyHelper, macHelper, endDevices);
+
+    NodeContainer networkServer;
+    networkServer.Create(1);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+    {
+        p2p.Install(networkServer.Get(0), *gw);
+    }
+    NetworkServerHelper nsHelper;
+    nsHelper.SetEndDevices(endDevices);
+    nsHelper.EnableAdr(true);
+    nsHelper.Install(networkServer);
+    ForwarderHelper().Install(gateways);
+
+    UrbanTrafficHelper appHelper;
+    appHelper.SetDeviceGroups(Commercial);
+    appHelper.Install(endDevices);
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+    return Hours(hours);
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string schedulers = "ns3::MapScheduler,ns3::HeapScheduler,ns3::CalendarScheduler,"
+                             "ns3::TimingWheelScheduler";
+    std::string scenarios = "aloha,elora";
+    int alohaDevices = 2000;
+    double alohaPeriod = 600;
+    int eloraDevices = 10000;
+    int eloraRings = 2;
+    double eloraHours = 24;
+    int repetitions = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("schedulers", "Comma-separated list of scheduler TypeIds", schedulers);
+    cmd.AddValue("scenarios", "Comma-separated list of workloads (aloha, elora)", scenarios);
+    cmd.AddValue("alohaDevices", "Number of end devices in the aloha workload", alohaDevices);
+    cmd.AddValue("alohaPeriod", "Application period in the aloha workload [s]", alohaPeriod);
+    cmd.AddValue("eloraDevices", "Number of end devices in the elora workload", eloraDevices);
+    cmd.AddValue("eloraRings", "Number of gateway rings in the elora workload", eloraRings);
+    cmd.AddValue("eloraHours", "Simulated hours in the elora workload", eloraHours);
+    cmd.AddValue("repetitions", "Number of runs per scheduler and workload", repetitions);
+    cmd.Parse(argc, argv);
+
+    auto split = [](std::string s) {
+        std::vector<std::string> items;
+        std::stringstream ss(s);
+        for (std::string item; std::getline(ss, item, ',');)
+        {
+            items.push_back(item);
+        }
+        return items;
+    };
+
+    std::cout << std::left << std::setw(8) << "workload" << std::setw(28) << "scheduler"
+              << std::right << std::setw(14) << "events" << std::setw(12) << "wall [s]"
+              << std::setw(14) << "events/s" << std::endl;
+    for (const auto& scenario : split(scenarios))
+    {
+        NS_ABORT_MSG_IF(scenario != "aloha" && scenario != "elora",
+                        "Unknown workload " << scenario);
+        uint64_t reference = 0;
+        for (const auto& scheduler : split(schedulers))
+        {
+            for (int rep = 0; rep < repetitions; ++rep)
+            {
+                ///////////////////// Same seeded scenario for every scheduler
+                RngSeedManager::SetSeed(1);
+                RngSeedManager::SetRun(rep + 1);
+                RngSeedManager::ResetNextStreamIndex();
+                ObjectFactory factory(scheduler);
+                Simulator::SetScheduler(factory);
+
+                Time duration = (scenario == "aloha")
+                                    ? BuildAloha(alohaDevices, alohaPeriod)
+                                    : BuildElora(eloraDevices, eloraRings, eloraHours);
+                Simulator::Stop(duration);
+
+                auto start = std::chrono::steady_clock::now();
+                Simulator::Run();
+                std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+                uint64_t events = Simulator::GetEventCount();
+                Simulator::Destroy();
+
+                if (rep == 0 && reference == 0)
+                {
+                    reference = events;
+                }
+                NS_ABORT_MSG_IF(rep == 0 && events != reference,
+                                scheduler << " processed a different number of events");
+                std::cout << std::left << std::setw(8) << scenario << std::setw(28) << scheduler
+                          << std::right << std::setw(14) << events << std::setw(12)
+                          << std::fixed << std::setprecision(3) << wall.count() << std::setw(14)
+                          << std::setprecision(0) << events / wall.count() << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "async-pcap-writer.h"
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("AsyncPcapWriter");
+
+NS_OBJECT_ENSURE_REGISTERED(AsyncPcapWriter);
+
+/* Classic pcap (microsecond timestamps) */
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_VERSION_MAJOR 2
+#define PCAP_VERSION_MINOR 4
+
+/* Pcapng blocks and options */
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+namespace
+{
+/* Write a value in host byte order, both formats are endianness-independent */
+template <typename T>
+void
+Put(std::ostream& os, T value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/* Write zeroes up to the next 32-bit boundary */
+void
+Pad32(std::ostream& os, uint32_t length)
+{
+    static const char zeroes[4] = {0, 0, 0, 0};
+    os.write(zeroes, (4 - length % 4) % 4);
+}
+
+uint32_t
+Align32(uint32_t length)
+{
+    return (length + 3) & ~3u;
+}
+} // namespace
+
+TypeId
+AsyncPcapWriter::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AsyncPcapWriter")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<AsyncPcapWriter>()
+            .AddAttribute("MergedFile",
+                          "If not empty, write all interfaces to this single pcapng file instead "
+                          "of one pcap file per interface",
+                          StringValue(""),
+                          MakeStringAccessor(&AsyncPcapWriter::m_mergedFile),
+                          MakeStringChecker())
+            .AddAttribute("BufferSize",
+                          "Size in bytes of the ring buffer between the simulation and the "
+                          "writer thread (rounded up to a power of 2)",
+                          UintegerValue(1 << 22),
+                          MakeUintegerAccessor(&AsyncPcapWriter::m_bufferSize),
+                          MakeUintegerChecker<uint32_t>(4096))
+            .AddAttribute("PollInterval",
+                          "Wall-clock time the writer thread sleeps when the ring buffer is empty",
+                          TimeValue(MilliSeconds(10)),
+                          MakeTimeAccessor(&AsyncPcapWriter::m_pollInterval),
+                          MakeTimeChecker(MicroSeconds(1)))
+            .AddAttribute("SnapLen",
+                          "Snapshot length declared in the capture headers",
+                          UintegerValue(65535),
+                          MakeUintegerAccessor(&AsyncPcapWriter::m_snapLen),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+AsyncPcapWriter::AsyncPcapWriter()
+    : m_bufferSize(1 << 22),
+      m_pollInterval(MilliSeconds(10)),
+      m_snapLen(65535),
+      m_capacity(0),
+      m_head(0),
+      m_tail(0),
+      m_reserved(0),
+      m_stop(false),
+      m_closed(false),
+      m_nInterfaces(0),
+      m_nQueued(0),
+      m_nDropped(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AsyncPcapWriter::~AsyncPcapWriter()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+}
+
+void
+AsyncPcapWriter::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+    Object::DoDispose();
+}
+
+void
+AsyncPcapWriter::Start()
+{
+    NS_LOG_FUNCTION(this);
+    m_capacity = 4096;
+    while (m_capacity < m_bufferSize)
+    {
+        m_capacity <<= 1;
+    }
+    m_ring = std::make_unique<uint8_t[]>(m_capacity);
+
+    if (!m_mergedFile.empty())
+    {
+        m_merged.open(m_mergedFile, std::ios::out | std::ios::binary | std::ios::trunc);
+        NS_ABORT_MSG_UNLESS(m_merged.is_open(), "Unable to open pcapng file " << m_mergedFile);
+        // Section header block, section length unspecified
+        Put<uint32_t>(m_merged, PCAPNG_SHB);
+        Put<uint32_t>(m_merged, 28);
+        Put<uint32_t>(m_merged, PCAPNG_BYTE_ORDER_MAGIC);
+        Put<uint16_t>(m_merged, 1);
+        Put<uint16_t>(m_merged, 0);
+        Put<int64_t>(m_merged, -1);
+        Put<uint32_t>(m_merged, 28);
+    }
+
+    m_writer = std::thread(&AsyncPcapWriter::WriterLoop, this);
+}
+
+uint32_t
+AsyncPcapWriter::AddInterface(std::string name, uint32_t dataLinkType)
+{
+    NS_LOG_FUNCTION(this << name << dataLinkType);
+    NS_ABORT_MSG_IF(m_closed, "Cannot add an interface to a closed pcap writer");
+    if (!m_ring)
+    {
+        Start();
+    }
+    if (m_mergedFile.empty())
+    {
+        // Fail early and in the simulation thread on invalid paths
+        std::ofstream probe(name, std::ios::out | std::ios::binary | std::ios::trunc);
+        NS_ABORT_MSG_UNLESS(probe.is_open(), "Unable to open pcap file " << name);
+    }
+
+    // Interface records are never dropped: wait for the writer to make room
+    RecordHeader* record;
+    while (!(record = Reserve(name.size())))
+    {
+        std::this_thread::yield();
+    }
+    record->type = INTERFACE;
+    record->ifIndex = m_nInterfaces;
+    record->length = name.size();
+    record->linkType = dataLinkType;
+    std::memcpy(record + 1, name.data(), name.size());
+    Commit();
+
+    return m_nInterfaces++;
+}
+
+void
+AsyncPcapWriter::Write(uint32_t ifIndex, Time t, Ptr<const Packet> p)
+{
+    NS_ASSERT_MSG(ifIndex < m_nInterfaces, "Unknown pcap interface " << ifIndex);
+    uint32_t length = p->GetSize();
+    RecordHeader* record = m_closed ? nullptr : Reserve(length);
+    if (!record)
+    {
+        if (m_nDropped++ == 0)
+        {
+            NS_LOG_WARN("Pcap ring buffer full, dropping packets");
+        }
+        return;
+    }
+    record->type = PACKET;
+    record->ifIndex = ifIndex;
+    record->length = length;
+    record->time = t.GetNanoSeconds();
+    p->CopyData(reinterpret_cast<uint8_t*>(record + 1), length);
+    Commit();
+    m_nQueued++;
+}
+
+AsyncPcapWriter::RecordHeader*
+AsyncPcapWriter::Reserve(uint32_t payload)
+{
+    uint64_t size = (sizeof(RecordHeader) + payload + 7) & ~uint64_t(7);
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t tail = m_tail.load(std::memory_order_acquire);
+    uint64_t offset = head & (m_capacity - 1);
+    uint64_t contiguous = m_capacity - offset;
+
+    // Records are contiguous: skip the end of the ring if too short
+    uint64_t needed = size + (contiguous < size ? contiguous : 0);
+    if (size > m_capacity || m_capacity - (head - tail) < needed)
+    {
+        return nullptr;
+    }
+    if (contiguous < size)
+    {
+        // The reader skips ends shorter than a header without a padding record
+        if (contiguous >= sizeof(RecordHeader))
+        {
+            auto padding = reinterpret_cast<RecordHeader*>(&m_ring[offset]);
+            padding->size = contiguous;
+            padding->type = PADDING;
+        }
+        head += contiguous;
+    }
+
+    auto record = reinterpret_cast<RecordHeader*>(&m_ring[head & (m_capacity - 1)]);
+    record->size = size;
+    m_reserved = head + size;
+    return record;
+}
+
+void
+AsyncPcapWriter::Commit()
+{
+    m_head.store(m_reserved, std::memory_order_release);
+}
+
+void
+AsyncPcapWriter::WriterLoop()
+{
+    auto sleep = std::chrono::nanoseconds(m_pollInterval.GetNanoSeconds());
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        // Check the stop request before the head, not to miss the last records
+        bool stop = m_stop.load(std::memory_order_acquire);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            if (stop)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(sleep);
+            continue;
+        }
+
+        while (tail != head)
+        {
+            uint64_t offset = tail & (m_capacity - 1);
+            uint64_t contiguous = m_capacity - offset;
+            if (contiguous < sizeof(RecordHeader))
+            {
+                tail += contiguous;
+                continue;
+            }
+            auto record = reinterpret_cast<const RecordHeader*>(&m_ring[offset]);
+            if (record->type != PADDING)
+            {
+                Consume(record);
+            }
+            tail += record->size;
+            m_tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    for (auto& file : m_files)
+    {
+        if (file)
+        {
+            file->close();
+        }
+    }
+    if (m_merged.is_open())
+    {
+        m_merged.close();
+    }
+}
+
+void
+AsyncPcapWriter::Consume(const RecordHeader* record)
+{
+    auto payload = reinterpret_cast<const char*>(record + 1);
+
+    if (record->type == INTERFACE)
+    {
+        if (m_merged.is_open())
+        {
+            // Interface description block, nanosecond timestamps
+            uint32_t nameLength = record->length;
+            uint32_t total = 16 + (4 + Align32(nameLength)) + 8 + 4 + 4;
+            Put<uint32_t>(m_merged, PCAPNG_IDB);
+            Put<uint32_t>(m_merged, total);
+            Put<uint16_t>(m_merged, record->linkType);
+            Put<uint16_t>(m_merged, 0);
+            Put<uint32_t>(m_merged, m_snapLen);
+            Put<uint16_t>(m_merged, PCAPNG_OPT_IF_NAME);
+            Put<uint16_t>(m_merged, nameLength);
+            m_merged.write(payload, nameLength);
+            Pad32(m_merged, nameLength);
+            Put<uint16_t>(m_merged, PCAPNG_OPT_IF_TSRESOL);
+            Put<uint16_t>(m_merged, 1);
+            Put<uint8_t>(m_merged, 9);
+            Pad32(m_merged, 1);
+            Put<uint16_t>(m_merged, PCAPNG_OPT_ENDOFOPT);
+            Put<uint16_t>(m_merged, 0);
+            Put<uint32_t>(m_merged, total);
+        }
+        else
+        {
+            std::string name(payload, record->length);
+            auto file = std::make_unique<std::ofstream>(name, std::ios::out | std::ios::binary);
+            Put<uint32_t>(*file, PCAP_MAGIC);
+            Put<uint16_t>(*file, PCAP_VERSION_MAJOR);
+            Put<uint16_t>(*file, PCAP_VERSION_MINOR);
+            Put<int32_t>(*file, 0);
+            Put<uint32_t>(*file, 0);
+            Put<uint32_t>(*file, m_snapLen);
+            Put<uint32_t>(*file, record->linkType);
+            if (m_files.size() <= record->ifIndex)
+            {
+                m_files.resize(record->ifIndex + 1);
+            }
+            m_files[record->ifIndex] = std::move(file);
+        }
+        return;
+    }
+
+    uint32_t captured = std::min(record->length, m_snapLen);
+    uint64_t time = record->time;
+    if (m_merged.is_open())
+    {
+        // Enhanced packet block
+        uint32_t total = 28 + Align32(captured) + 4;
+        Put<uint32_t>(m_merged, PCAPNG_EPB);
+        Put<uint32_t>(m_merged, total);
+        Put<uint32_t>(m_merged, record->ifIndex);
+        Put<uint32_t>(m_merged, time >> 32);
+        Put<uint32_t>(m_merged, time & 0xFFFFFFFF);
+        Put<uint32_t>(m_merged, captured);
+        Put<uint32_t>(m_merged, record->length);
+        m_merged.write(payload, captured);
+        Pad32(m_merged, captured);
+        Put<uint32_t>(m_merged, total);
+    }
+    else
+    {
+        std::ofstream& file = *m_files[record->ifIndex];
+        Put<uint32_t>(file, time / 1000000000);
+        Put<uint32_t>(file, (time % 1000000000) / 1000);
+        Put<uint32_t>(file, captured);
+        Put<uint32_t>(file, record->length);
+        file.write(payload, captured);
+    }
+}
+
+void
+AsyncPcapWriter::Close()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_closed)
+    {
+        return;
+    }
+    m_closed = true;
+    if (m_writer.joinable())
+    {
+        m_stop.store(true, std::memory_order_release);
+        m_writer.join();
+    }
+    if (m_nDropped)
+    {
+        NS_LOG_WARN("Pcap writer dropped " << m_nDropped << " of " << m_nQueued + m_nDropped
+                                           << " packets");
+    }
+}
+
+bool
+AsyncPcapWriter::IsMerged() const
+{
+    return !m_mergedFile.empty();
+}
+
+uint64_t
+AsyncPcapWriter::GetNQueued() const
+{
+    return m_nQueued;
+}
+
+uint64_t
+AsyncPcapWriter::GetNDropped() const
+{
+    return m_nDropped;
+}
+
+} // namespace lorawan
+} // namespace ns3
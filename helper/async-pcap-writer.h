@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef ASYNC_PCAP_WRITER_H
+#define ASYNC_PCAP_WRITER_H
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Pcap writer moving disk I/O off the simulation thread.
+ *
+ * Captured packets are copied into a bounded single-producer/single-consumer
+ * ring buffer, and written to disk by a background thread. The simulation
+ * thread never blocks: if the ring is full (i.e., the disk cannot keep up),
+ * packets are dropped and counted.
+ *
+ * Each capture interface (e.g., a gateway) is written to its own classic pcap
+ * file, or, if the MergedFile attribute is set, all interfaces are written to
+ * a single pcapng file, where packets are identified by their interface ID.
+ *
+ * Only the simulation thread may call the public methods.
+ */
+class AsyncPcapWriter : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    AsyncPcapWriter();
+    ~AsyncPcapWriter() override;
+
+    /**
+     * Add a capture interface.
+     *
+     * \param name File name of the interface capture, or interface name in
+     *             the merged capture.
+     * \param dataLinkType Data link type of the packets (e.g., DLT_LORATAP).
+     * \return The index of the interface, to be used in Write.
+     */
+    uint32_t AddInterface(std::string name, uint32_t dataLinkType);
+
+    /**
+     * Queue a packet for writing.
+     *
+     * \param ifIndex Index of the interface returned by AddInterface.
+     * \param t Timestamp of the packet.
+     * \param p The packet.
+     */
+    void Write(uint32_t ifIndex, Time t, Ptr<const Packet> p);
+
+    /**
+     * Write all queued packets and close the files. Further packets are dropped.
+     */
+    void Close();
+
+    /**
+     * Whether all interfaces are written to a single pcapng file.
+     */
+    bool IsMerged() const;
+
+    /**
+     * Get the number of packets written to the ring buffer.
+     */
+    uint64_t GetNQueued() const;
+
+    /**
+     * Get the number of packets dropped because the ring buffer was full.
+     */
+    uint64_t GetNDropped() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Type of the records in the ring buffer.
+     */
+    enum RecordType : uint32_t
+    {
+        PACKET,    //!< Captured packet
+        INTERFACE, //!< Interface creation, the payload is the name
+        PADDING,   //!< Unused space up to the end of the ring
+    };
+
+    /**
+     * Header of a record in the ring buffer, followed by the payload.
+     */
+    struct RecordHeader
+    {
+        uint32_t size;     //!< Size of the record, header included, multiple of 8
+        uint32_t type;     //!< RecordType
+        uint32_t ifIndex;  //!< Interface index
+        uint32_t length;   //!< Payload length
+        uint32_t linkType; //!< Data link type (INTERFACE)
+        uint32_t reserved; //!< Alignment
+        int64_t time;      //!< Timestamp in nanoseconds (PACKET)
+    };
+
+    /**
+     * Allocate the ring buffer and start the writer thread.
+     */
+    void Start();
+
+    /**
+     * Reserve space for a record in the ring buffer.
+     *
+     * \param payload Length of the record payload.
+     * \return Pointer to the reserved record, nullptr if the ring is full.
+     */
+    RecordHeader* Reserve(uint32_t payload);
+
+    /**
+     * Make the last reserved record visible to the writer thread.
+     */
+    void Commit();
+
+    /**
+     * Body of the writer thread.
+     */
+    void WriterLoop();
+
+    /**
+     * Write a record to disk (writer thread).
+     */
+    void Consume(const RecordHeader* record);
+
+    std::string m_mergedFile; //!< Merged pcapng capture, empty for per-interface pcap files
+    uint32_t m_bufferSize;    //!< Requested ring buffer size (bytes)
+    Time m_pollInterval;      //!< Wall-clock sleep of the writer when the ring is empty
+    uint32_t m_snapLen;       //!< Snapshot length declared in the captures
+
+    std::unique_ptr<uint8_t[]> m_ring; //!< Ring buffer
+    uint64_t m_capacity;               //!< Ring capacity, power of 2
+    std::atomic<uint64_t> m_head;      //!< Write position (simulation thread)
+    std::atomic<uint64_t> m_tail;      //!< Read position (writer thread)
+    uint64_t m_reserved;               //!< Write position after the last reserved record
+    std::atomic<bool> m_stop;          //!< Request the writer to drain and exit
+    std::thread m_writer;              //!< Writer thread
+    bool m_closed;                     //!< Whether Close was called
+
+    uint32_t m_nInterfaces; //!< Number of interfaces added
+    uint64_t m_nQueued;     //!< Packets queued
+    uint64_t m_nDropped;    //!< Packets dropped on a full ring
+
+    /* Owned by the writer thread */
+    std::vector<std::unique_ptr<std::ofstream>> m_files; //!< Per-interface pcap files
+    std::ofstream m_merged;                              //!< Merged pcapng file
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* ASYNC_PCAP_WRITER_H */
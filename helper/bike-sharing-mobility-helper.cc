@@ -22,15 +22,413 @@
 
 #include "bike-sharing-mobility-helper.h"
 
-#include "ns3/csv-reader.h"
-#include "ns3/waypoint-mobility-model.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("BikeSharingMobilityHelper");
 
+namespace
+{
+
+/* Layout of a trip index: header, bikes, trips (grouped by bike), then bike names */
+
+const char INDEX_MAGIC[8] = {'E', 'L', 'B', 'I', 'K', 'E', 'S', '1'};
+
+struct IndexHeader
+{
+    char magic[8];      //!< INDEX_MAGIC
+    uint64_t csvSize;   //!< Size of the source .csv file
+    int64_t csvMtime;   //!< Modification time of the source .csv file (ns)
+    uint32_t delimiter; //!< Delimiter used to parse the source
+    uint32_t nBikes;    //!< Number of bikes
+    uint64_t nTrips;    //!< Number of trips
+    uint64_t namesSize; //!< Size of the bike names table
+};
+
+struct IndexBike
+{
+    uint64_t firstTrip;  //!< Index of the first trip of the bike
+    uint32_t nTrips;     //!< Number of trips of the bike
+    uint32_t nameOffset; //!< Offset of the name in the names table
+    uint32_t nameLength; //!< Length of the name
+    uint32_t reserved;   //!< Alignment
+};
+
+struct IndexTrip
+{
+    double startTime; //!< Start time (s)
+    double endTime;   //!< End time (s)
+    double startX;    //!< Start position (m)
+    double startY;    //!< Start position (m)
+    double endX;      //!< End position (m)
+    double endY;      //!< End position (m)
+};
+
+/**
+ * Read-only memory mapping of a whole file
+ */
+class MappedFile
+{
+  public:
+    static std::shared_ptr<MappedFile> Open(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        auto file = std::make_shared<MappedFile>();
+        file->data = static_cast<const char*>(addr);
+        file->size = st.st_size;
+        return file;
+    }
+
+    ~MappedFile()
+    {
+        munmap(const_cast<char*>(data), size);
+    }
+
+    const char* data = nullptr; //!< Mapped content
+    size_t size = 0;            //!< Size of the content
+};
+
+/// Strip blanks around a field, then double quotes
+std::string_view
+Trim(std::string_view field)
+{
+    while (!field.empty() && (field.front() == ' ' || field.front() == '\t'))
+    {
+        field.remove_prefix(1);
+    }
+    while (!field.empty() && (field.back() == ' ' || field.back() == '\t' || field.back() == '\r'))
+    {
+        field.remove_suffix(1);
+    }
+    if (field.size() >= 2 && field.front() == '"' && field.back() == '"')
+    {
+        field = field.substr(1, field.size() - 2);
+    }
+    return field;
+}
+
+/// Parse a whole field as a double
+bool
+ParseDouble(std::string_view field, double& value)
+{
+    char buf[64];
+    if (field.empty() || field.size() >= sizeof(buf))
+    {
+        return false;
+    }
+    std::memcpy(buf, field.data(), field.size());
+    buf[field.size()] = '\0';
+    char* end;
+    value = std::strtod(buf, &end);
+    return end == buf + field.size();
+}
+
+} // namespace
+
+/**
+ * Compact, read-only index of the trips of a dataset, grouped by bike
+ */
+class BikeTripIndex
+{
+  public:
+    /**
+     * Load the index of a dataset, from the cache if it is up to date.
+     */
+    static std::shared_ptr<const BikeTripIndex> Load(const std::string& csvPath,
+                                                     char delimiter,
+                                                     double z,
+                                                     bool caching);
+
+    uint32_t GetNBikes() const
+    {
+        return m_header->nBikes;
+    }
+
+    uint64_t GetNTrips() const
+    {
+        return m_header->nTrips;
+    }
+
+    std::string_view GetName(uint32_t bike) const
+    {
+        return {m_names + m_bikes[bike].nameOffset, m_bikes[bike].nameLength};
+    }
+
+    uint64_t GetNTrips(uint32_t bike) const
+    {
+        return m_bikes[bike].nTrips;
+    }
+
+    TripData_t GetTrip(uint32_t bike, uint64_t i) const
+    {
+        const IndexTrip& t = m_trips[m_bikes[bike].firstTrip + i];
+        return {Seconds(t.startTime),
+                Seconds(t.endTime),
+                Vector(t.startX, t.startY, m_z),
+                Vector(t.endX, t.endY, m_z)};
+    }
+
+  private:
+    /**
+     * Parse a .csv dataset into the index layout.
+     */
+    static std::vector<char> Parse(const MappedFile& csv, char delimiter);
+
+    /**
+     * Point to the content of an index, after checking that it is consistent.
+     */
+    bool Attach(const char* data, size_t size);
+
+    std::shared_ptr<MappedFile> m_file; //!< Mapped index, if any
+    std::vector<char> m_buffer;         //!< Index in memory, if not mapped
+    const IndexHeader* m_header;        //!< Index header
+    const IndexBike* m_bikes;           //!< Bikes
+    const IndexTrip* m_trips;           //!< Trips, grouped by bike
+    const char* m_names;                //!< Bike names
+    double m_z;                         //!< Z of the positions
+};
+
+std::shared_ptr<const BikeTripIndex>
+BikeTripIndex::Load(const std::string& csvPath, char delimiter, double z, bool caching)
+{
+    struct stat st;
+    NS_ABORT_MSG_IF(stat(csvPath.c_str(), &st) != 0, "Cannot open " << csvPath);
+    int64_t mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    std::string cachePath = csvPath + ".idx";
+
+    auto index = std::make_shared<BikeTripIndex>();
+    index->m_z = z;
+    auto upToDate = [&]() {
+        return index->m_header->csvSize == uint64_t(st.st_size) &&
+               index->m_header->csvMtime == mtime &&
+               index->m_header->delimiter == uint32_t(delimiter);
+    };
+
+    if (caching)
+    {
+        index->m_file = MappedFile::Open(cachePath);
+        if (index->m_file && index->Attach(index->m_file->data, index->m_file->size) &&
+            upToDate())
+        {
+            NS_LOG_DEBUG("Loaded cached trip index " << cachePath);
+            return index;
+        }
+        index->m_file = nullptr;
+    }
+
+    auto csv = MappedFile::Open(csvPath);
+    NS_ABORT_MSG_UNLESS(csv, "Cannot map " << csvPath);
+    index->m_buffer = Parse(*csv, delimiter);
+    auto header = reinterpret_cast<IndexHeader*>(index->m_buffer.data());
+    header->csvSize = st.st_size;
+    header->csvMtime = mtime;
+    header->delimiter = delimiter;
+
+    if (caching)
+    {
+        // Write to a temporary file, then rename: concurrent runs never see partial indexes
+        std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid());
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(index->m_buffer.data(), index->m_buffer.size());
+        out.close();
+        if (out.good() && std::rename(tmpPath.c_str(), cachePath.c_str()) == 0)
+        {
+            // Trips are paged in from the cache on demand, instead of staying in memory
+            auto file = MappedFile::Open(cachePath);
+            if (file && index->Attach(file->data, file->size))
+            {
+                index->m_file = file;
+                std::vector<char>().swap(index->m_buffer);
+                return index;
+            }
+        }
+        else
+        {
+            NS_LOG_WARN("Could not write trip index cache " << cachePath);
+            std::remove(tmpPath.c_str());
+        }
+    }
+    index->Attach(index->m_buffer.data(), index->m_buffer.size());
+    return index;
+}
+
+std::vector<char>
+BikeTripIndex::Parse(const MappedFile& csv, char delimiter)
+{
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> bikeOf;
+    std::vector<IndexTrip> trips;
+
+    const char* p = csv.data;
+    const char* end = csv.data + csv.size;
+    uint64_t row = 0;
+    while (p < end)
+    {
+        auto nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* eol = nl ? nl : end;
+        std::string_view line(p, eol - p);
+        p = eol + 1;
+        if (row++ == 0)
+        {
+            continue; // Skip row with column names
+        }
+
+        line = line.substr(0, line.find('#'));
+        if (Trim(line).empty())
+        {
+            continue; // Comment or blank line
+        }
+
+        std::string_view fields[7];
+        size_t nFields = 0;
+        while (nFields < 7)
+        {
+            size_t pos = line.find(delimiter);
+            fields[nFields++] = Trim(line.substr(0, pos));
+            if (pos == std::string_view::npos)
+            {
+                break;
+            }
+            line.remove_prefix(pos + 1);
+        }
+        NS_ABORT_MSG_IF(nFields < 7, "Row " << row << " of the trips dataset has missing fields");
+
+        IndexTrip t;
+        bool ok = ParseDouble(fields[0], t.startTime) && ParseDouble(fields[1], t.endTime) &&
+                  ParseDouble(fields[2], t.startX) && ParseDouble(fields[3], t.startY) &&
+                  ParseDouble(fields[4], t.endX) && ParseDouble(fields[5], t.endY);
+        NS_ABORT_MSG_UNLESS(ok, "Row " << row << " of the trips dataset has malformed fields");
+
+        auto [it, inserted] = ids.emplace(fields[6], names.size());
+        if (inserted)
+        {
+            names.push_back(fields[6]);
+        }
+        bikeOf.push_back(it->second);
+        trips.push_back(t);
+    }
+    NS_LOG_DEBUG("read " << trips.size() << " trips of " << names.size() << " bikes");
+
+    // Lay out the index, grouping trips by bike while keeping the file order
+    uint32_t nBikes = names.size();
+    uint64_t namesSize = 0;
+    for (const auto& name : names)
+    {
+        namesSize += name.size();
+    }
+    size_t bikesOffset = sizeof(IndexHeader);
+    size_t tripsOffset = bikesOffset + nBikes * sizeof(IndexBike);
+    size_t namesOffset = tripsOffset + trips.size() * sizeof(IndexTrip);
+    std::vector<char> buffer(namesOffset + namesSize);
+
+    auto header = reinterpret_cast<IndexHeader*>(buffer.data());
+    std::memcpy(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header->nBikes = nBikes;
+    header->nTrips = trips.size();
+    header->namesSize = namesSize;
+
+    auto bikes = reinterpret_cast<IndexBike*>(buffer.data() + bikesOffset);
+    std::vector<uint64_t> next(nBikes, 0);
+    for (uint32_t bike : bikeOf)
+    {
+        bikes[bike].nTrips++;
+    }
+    uint64_t first = 0;
+    uint32_t nameOffset = 0;
+    for (uint32_t b = 0; b < nBikes; ++b)
+    {
+        bikes[b].firstTrip = next[b] = first;
+        first += bikes[b].nTrips;
+        bikes[b].nameOffset = nameOffset;
+        bikes[b].nameLength = names[b].size();
+        std::memcpy(buffer.data() + namesOffset + nameOffset, names[b].data(), names[b].size());
+        nameOffset += names[b].size();
+    }
+    auto sorted = reinterpret_cast<IndexTrip*>(buffer.data() + tripsOffset);
+    for (size_t i = 0; i < trips.size(); ++i)
+    {
+        sorted[next[bikeOf[i]]++] = trips[i];
+    }
+    return buffer;
+}
+
+bool
+BikeTripIndex::Attach(const char* data, size_t size)
+{
+    if (size < sizeof(IndexHeader))
+    {
+        return false;
+    }
+    m_header = reinterpret_cast<const IndexHeader*>(data);
+    size_t tripsOffset = sizeof(IndexHeader) + uint64_t(m_header->nBikes) * sizeof(IndexBike);
+    size_t namesOffset = tripsOffset + m_header->nTrips * sizeof(IndexTrip);
+    if (std::memcmp(m_header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        namesOffset + m_header->namesSize != size)
+    {
+        return false;
+    }
+    m_bikes = reinterpret_cast<const IndexBike*>(data + sizeof(IndexHeader));
+    m_trips = reinterpret_cast<const IndexTrip*>(data + tripsOffset);
+    m_names = data + namesOffset;
+    for (uint32_t b = 0; b < m_header->nBikes; ++b)
+    {
+        if (m_bikes[b].firstTrip + m_bikes[b].nTrips > m_header->nTrips ||
+            uint64_t(m_bikes[b].nameOffset) + m_bikes[b].nameLength > m_header->namesSize)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t
+BikeSharingMobilityHelper::BikeTrips_t::Size() const
+{
+    return (index ? index->GetNTrips(bike) : 0) + extra.size();
+}
+
+TripData_t
+BikeSharingMobilityHelper::BikeTrips_t::Get(uint64_t i) const
+{
+    uint64_t indexed = index ? index->GetNTrips(bike) : 0;
+    return (i < indexed) ? index->GetTrip(bike, i) : extra[i - indexed];
+}
+
 BikeSharingMobilityHelper::BikeSharingMobilityHelper()
+    : m_lookahead(8),
+      m_caching(true)
 {
 }
 
@@ -41,7 +439,7 @@ BikeSharingMobilityHelper::~BikeSharingMobilityHelper()
 void
 BikeSharingMobilityHelper::Add(TripData_t trip, BikeId_t bike)
 {
-    m_data[bike].push_back(trip);
+    m_data[bike].extra.push_back(trip);
     m_current = m_data.begin();
 }
 
@@ -52,56 +450,24 @@ BikeSharingMobilityHelper::Add(const std::string filePath,
 {
     NS_LOG_FUNCTION(this << filePath << std::string("'") + delimiter + "'");
 
-    NS_ASSERT(std::ifstream(filePath).good()); // Chek if file can be opened
-
-    CsvReader csv(filePath, delimiter);
-    csv.FetchNextRow(); // Skip row with column names
-    while (csv.FetchNextRow())
+    auto index = BikeTripIndex::Load(filePath, delimiter, Z, m_caching);
+    for (uint32_t b = 0; b < index->GetNBikes(); ++b)
     {
-        if (csv.ColumnCount() == 1)
+        BikeTrips_t& trips = m_data[BikeId_t(index->GetName(b))];
+        if (!trips.index && trips.extra.empty())
         {
-            // comment line
+            trips.index = index;
+            trips.bike = b;
             continue;
         }
-
-        TripData_t td;
-        BikeId_t id;
-
-        double tmp;
-        bool ok = csv.GetValue(0, tmp);
-        NS_LOG_LOGIC("read started_at: " << tmp << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading started_at");
-        td.startTime = Seconds(tmp);
-        ok = csv.GetValue(1, tmp);
-        NS_LOG_LOGIC("read ended_at = " << tmp << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading ended_at");
-        td.endTime = Seconds(tmp);
-
-        ok = csv.GetValue(2, td.startPos.x);
-        NS_LOG_LOGIC("read start_x = " << td.startPos.x << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading start_x");
-        ok = csv.GetValue(3, td.startPos.y);
-        NS_LOG_LOGIC("read start_y = " << td.startPos.y << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading start_y");
-
-        ok = csv.GetValue(4, td.endPos.x);
-        NS_LOG_LOGIC("read end_x = " << td.endPos.x << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading end_x");
-        ok = csv.GetValue(5, td.endPos.y);
-        NS_LOG_LOGIC("read end_y = " << td.endPos.y << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading end_y");
-
-        ok = csv.GetValue(6, id);
-        NS_LOG_LOGIC("read bike_id = " << id << (ok ? " ok" : " FAIL"));
-        NS_ASSERT_MSG(ok, "failed reading bike_id");
-
-        td.startPos.z = Z;
-        td.endPos.z = Z;
-
-        Add(td, id);
-
-    } // while FetchNextRow
-    NS_LOG_DEBUG("read " << csv.RowNumber() - 1 << " rows");
+        // Bike already known: append its trips after the previous ones
+        for (uint64_t i = 0; i < index->GetNTrips(b); ++i)
+        {
+            trips.extra.push_back(index->GetTrip(b, i));
+        }
+    }
+    m_current = m_data.begin();
+    NS_LOG_DEBUG("read " << index->GetNTrips() << " trips of " << index->GetNBikes() << " bikes");
 }
 
 int
@@ -112,10 +478,22 @@ BikeSharingMobilityHelper::GetNBikes()
     return size;
 }
 
-const BikeSharingMobilityHelper::TripList_t&
+void
+BikeSharingMobilityHelper::SetLookahead(uint32_t trips)
+{
+    m_lookahead = trips;
+}
+
+void
+BikeSharingMobilityHelper::SetIndexCaching(bool enable)
+{
+    m_caching = enable;
+}
+
+const BikeSharingMobilityHelper::BikeTrips_t&
 BikeSharingMobilityHelper::GetNextBike() const
 {
-    const TripList_t& tl = (*m_current).second;
+    const BikeTrips_t& tl = (*m_current).second;
     NS_LOG_DEBUG("bikeID=" << (*m_current).first);
     m_current++;
     if (m_current == m_data.end())
@@ -126,6 +504,37 @@ BikeSharingMobilityHelper::GetNextBike() const
     return tl;
 }
 
+void
+BikeSharingMobilityHelper::FeedTrips(Ptr<WaypointMobilityModel> model,
+                                     std::shared_ptr<const BikeTrips_t> trips,
+                                     uint64_t first,
+                                     uint64_t count,
+                                     uint32_t lookahead)
+{
+    uint64_t last = std::min(first + count, trips->Size());
+    for (uint64_t i = first; i < last; ++i)
+    {
+        TripData_t t = trips->Get(i);
+        model->AddWaypoint(Waypoint(t.startTime, t.startPos));
+        NS_LOG_INFO("Added trip-start waypoint: " << Waypoint(t.startTime, t.startPos));
+        model->AddWaypoint(Waypoint(t.endTime, t.endPos));
+        NS_LOG_INFO("Added trip-end waypoint: " << Waypoint(t.endTime, t.endPos));
+    }
+    if (last == trips->Size())
+    {
+        return;
+    }
+    // Feed more when the bike starts the trip lookahead trips before the last fed one
+    Time when = trips->Get(last - lookahead).startTime;
+    Simulator::Schedule(Max(when - Simulator::Now(), Seconds(0)),
+                        &BikeSharingMobilityHelper::FeedTrips,
+                        model,
+                        trips,
+                        last,
+                        lookahead,
+                        lookahead);
+}
+
 void
 BikeSharingMobilityHelper::Install(Ptr<Node> node) const
 {
@@ -142,14 +551,9 @@ BikeSharingMobilityHelper::Install(Ptr<Node> node) const
     NS_LOG_DEBUG("node=" << object << ", mob=" << model);
     object->AggregateObject(model);
 
-    const TripList_t& triplist = GetNextBike();
-    for (const auto& t : triplist)
-    {
-        model->AddWaypoint(Waypoint(t.startTime, t.startPos));
-        NS_LOG_INFO("Added trip-start waypoint: " << Waypoint(t.startTime, t.startPos));
-        model->AddWaypoint(Waypoint(t.endTime, t.endPos));
-        NS_LOG_INFO("Added trip-end waypoint: " << Waypoint(t.endTime, t.endPos));
-    }
+    auto trips = std::make_shared<const BikeTrips_t>(GetNextBike());
+    uint64_t count = m_lookahead ? 2 * uint64_t(m_lookahead) : trips->Size();
+    FeedTrips(model, trips, 0, count, m_lookahead);
 }
 
 void
@@ -26,8 +26,10 @@
 #include "ns3/node-container.h"
 #include "ns3/nstime.h"
 #include "ns3/vector.h"
+#include "ns3/waypoint-mobility-model.h"
 
 #include <map>
+#include <memory>
 
 namespace ns3
 {
@@ -42,6 +44,8 @@ struct TripData_t
 
 using BikeId_t = std::string;
 
+class BikeTripIndex;
+
 /**
  * This class is an helper to simulate bicycles in a bike sharing service. It loads datasets
  * containing a list of bycicle trips between locations. Then, it uses the data to install on nodes
@@ -54,12 +58,29 @@ using BikeId_t = std::string;
  * Each subsequent line represents one trip. Time (started_at,ended_at) is in seconds and positions
  * (start/end_x/y) are in meters from the center of the ns-3 the catesian plane. bike_id is any
  * string that identifies a bike. Trips can also be added manually one at a time.
+ *
+ * Datasets are parsed from a memory-mapped file into a compact binary trip index, which is cached
+ * next to the .csv file (with an .idx suffix) and reused by later runs as long as the .csv file is
+ * unchanged. Trips stay in the mapped index: waypoints are fed to the mobility model of each node
+ * a few trips ahead of the simulation time, instead of all at once when installing.
  */
 
 class BikeSharingMobilityHelper
 {
     using TripList_t = std::vector<TripData_t>;
-    using BikeDataMap_t = std::map<BikeId_t, TripList_t>;
+
+    /* Trips of a bike: those of a dataset index, followed by those added one at a time */
+    struct BikeTrips_t
+    {
+        std::shared_ptr<const BikeTripIndex> index; //!< Dataset index, if any
+        uint32_t bike = 0;                          //!< Number of the bike in the index
+        TripList_t extra;                           //!< Trips following the index ones
+
+        uint64_t Size() const;
+        TripData_t Get(uint64_t i) const;
+    };
+
+    using BikeDataMap_t = std::map<BikeId_t, BikeTrips_t>;
 
   public:
     BikeSharingMobilityHelper();
@@ -87,8 +108,8 @@ class BikeSharingMobilityHelper
      * It is up to you to provide trips that are sorted by start time and that do not overlap in
      * time for the same bike.
      *
-     * The file is read using CsvReader, which explains how comments
-     * and whitespace are handled.
+     * Comments (from '#' to the end of a line), blank lines and whitespace around fields are
+     * ignored, as with CsvReader. The parsed trips are cached in filePath + ".idx".
      *
      * \param [in] filePath The path to the input file.
      * \param [in] Z The Z value to use aside X and Y positions.
@@ -99,6 +120,20 @@ class BikeSharingMobilityHelper
     /* Returns the number of distinct bicycles of which we have data available */
     int GetNBikes(void);
 
+    /**
+     * \brief Set how many trips are fed in advance to the mobility model of a node.
+     *
+     * Further trips are fed while the node moves. With 0, all trips are fed when installing.
+     *
+     * \param [in] trips The number of trips (default 8).
+     */
+    void SetLookahead(uint32_t trips);
+
+    /**
+     * \brief Set whether dataset indexes are cached next to the dataset files (default true).
+     */
+    void SetIndexCaching(bool enable);
+
     /* Install a waypoint mobility model based on bike data on this node */
     void Install(Ptr<Node> node) const;
 
@@ -106,10 +141,27 @@ class BikeSharingMobilityHelper
     void Install(NodeContainer container) const;
 
   private:
-    const TripList_t& GetNextBike(void) const;
+    const BikeTrips_t& GetNextBike(void) const;
+
+    /**
+     * Feed trips of a bike to its mobility model, then schedule the next feeding.
+     *
+     * \param model The mobility model of the node.
+     * \param trips The trips of the bike.
+     * \param first The first trip to feed.
+     * \param count The number of trips to feed.
+     * \param lookahead The number of trips to keep ahead of the current one, 0 for all.
+     */
+    static void FeedTrips(Ptr<WaypointMobilityModel> model,
+                          std::shared_ptr<const BikeTrips_t> trips,
+                          uint64_t first,
+                          uint64_t count,
+                          uint32_t lookahead);
 
     BikeDataMap_t m_data;                            //! map of bikes and associated list of trips
     mutable BikeDataMap_t::const_iterator m_current; //!< vector iterator
+    uint32_t m_lookahead;                            //!< Trips fed in advance, 0 for all
+    bool m_caching;                                  //!< Cache dataset indexes on disk
 };
 
 } // namespace ns3
@@ -119,6 +119,30 @@ ChirpstackHelper::Register(NodeContainer c) const
     return EXIT_SUCCESS;
 }
 
+int
+ChirpstackHelper::Register(Ptr<VirtualDeviceFleet> fleet) const
+{
+    NS_LOG_FUNCTION(this << fleet);
+
+    /* Virtual devices are numbered above 32-bit node ids */
+    for (uint32_t i = 0; i < fleet->GetNDevices(); ++i)
+    {
+        char key[33];
+        const uint8_t* bytes = fleet->GetSessionKey(i);
+        for (int j = 0; j < 16; ++j)
+        {
+            snprintf(key + 2 * j, 3, "%02x", bytes[j]);
+        }
+        uint64_t id = (uint64_t(1) << 32) + i;
+        if (NewDevice(id, fleet->GetDeviceAddress(i).Get(), str(key)) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
 void
 ChirpstackHelper::SetTenant(str& name)
 {
@@ -340,9 +364,17 @@ ChirpstackHelper::RegisterPriv(Ptr<Node> node) const
 
 int
 ChirpstackHelper::NewDevice(Ptr<Node> node) const
+{
+    auto netdev = DynamicCast<LoraNetDevice>(node->GetDevice(0));
+    auto mac = DynamicCast<BaseEndDeviceLorawanMac>(netdev->GetMac());
+    return NewDevice(node->GetId(), mac->GetDeviceAddress().Get(), m_session.netKey);
+}
+
+int
+ChirpstackHelper::NewDevice(uint64_t id, uint32_t address, const str& netKey) const
 {
     char eui[17];
-    uint64_t id = (m_run << 48) + node->GetId();
+    id += (m_run << 48);
     snprintf(eui, 17, "%016lx", id);
 
     str payload = "{"
@@ -374,9 +406,7 @@ ChirpstackHelper::NewDevice(Ptr<Node> node) const
     }
 
     char devAddr[9];
-    auto netdev = DynamicCast<LoraNetDevice>(node->GetDevice(0));
-    auto mac = DynamicCast<BaseEndDeviceLorawanMac>(netdev->GetMac());
-    snprintf(devAddr, 9, "%08x", mac->GetDeviceAddress().Get());
+    snprintf(devAddr, 9, "%08x", address);
 
     payload = "{"
               "  \"deviceActivation\": {"
@@ -389,14 +419,14 @@ ChirpstackHelper::NewDevice(Ptr<Node> node) const
               "\","
               "    \"fCntUp\": 0,"
               "    \"fNwkSIntKey\": \"" +
-              m_session.netKey +
+              netKey +
               "\","
               "    \"nFCntDown\": 0,"
               "    \"nwkSEncKey\": \"" +
-              m_session.netKey +
+              netKey +
               "\","
               "    \"sNwkSIntKey\": \"" +
-              m_session.netKey +
+              netKey +
               "\""
               "  }"
               "}";
@@ -23,6 +23,7 @@
 
 #include "ns3/loragw_hal.h"
 #include "ns3/node-container.h"
+#include "ns3/virtual-device-fleet.h"
 
 #include <curl/curl.h>
 
@@ -71,6 +72,12 @@ class ChirpstackHelper
 
     int Register(Ptr<Node> node) const;
 
+    /**
+     * Register and activate all devices of a virtual fleet, with their
+     * addresses and session keys.
+     */
+    int Register(Ptr<VirtualDeviceFleet> fleet) const;
+
     void SetTenant(str& name);
 
     void SetDeviceProfile(str& name);
@@ -90,6 +97,8 @@ class ChirpstackHelper
 
     int NewDevice(Ptr<Node> node) const;
 
+    int NewDevice(uint64_t id, uint32_t address, const str& netKey) const;
+
     int NewGateway(Ptr<Node> node) const;
 
     int POST(const str& path, const str& body, str& out) const;
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "lora-analytic-energy-source-helper.h"
+
+#include "ns3/lora-analytic-energy-source.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+LoraAnalyticEnergySourceHelper::LoraAnalyticEnergySourceHelper()
+{
+    m_energySource.SetTypeId("ns3::LoraAnalyticEnergySource");
+}
+
+LoraAnalyticEnergySourceHelper::~LoraAnalyticEnergySourceHelper()
+{
+}
+
+void
+LoraAnalyticEnergySourceHelper::Set(std::string name, const AttributeValue& v)
+{
+    m_energySource.Set(name, v);
+}
+
+Ptr<EnergySource>
+LoraAnalyticEnergySourceHelper::DoInstall(Ptr<Node> node) const
+{
+    NS_ASSERT(node != nullptr);
+    Ptr<EnergySource> source = m_energySource.Create<EnergySource>();
+    NS_ASSERT(source != nullptr);
+    source->SetNode(node);
+    return source;
+}
+
+} // namespace lorawan
+} // namespace ns3
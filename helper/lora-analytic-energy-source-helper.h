@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef LORA_ANALYTIC_ENERGY_SOURCE_HELPER_H
+#define LORA_ANALYTIC_ENERGY_SOURCE_HELPER_H
+
+#include "ns3/energy-model-helper.h"
+#include "ns3/node.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup energy
+ * \brief Creates a LoraAnalyticEnergySource object.
+ *
+ * Use it in place of BasicEnergySourceHelper to avoid the periodic updates of
+ * the sources, e.g., in fleets of battery-powered devices.
+ */
+class LoraAnalyticEnergySourceHelper : public EnergySourceHelper
+{
+  public:
+    LoraAnalyticEnergySourceHelper();
+    ~LoraAnalyticEnergySourceHelper() override;
+
+    /**
+     * \param name the name of the attribute to set
+     * \param v the value of the attribute
+     *
+     * Sets an attribute of the underlying energy source.
+     */
+    void Set(std::string name, const AttributeValue& v) override;
+
+  private:
+    /**
+     * \param node Pointer to node where the energy source is to be installed.
+     * \returns Pointer to the created LoraAnalyticEnergySource.
+     */
+    Ptr<EnergySource> DoInstall(Ptr<Node> node) const override;
+
+    ObjectFactory m_energySource; ///< energy source
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_ANALYTIC_ENERGY_SOURCE_HELPER_H */
@@ -546,10 +546,11 @@ LoraPacketTracker::PrintSimulationStatistics(Time startTime)
 
         LoraPhyTxParameters params;
         LoraTag tag;
-        pd.first->Copy()->RemovePacketTag(tag);
+        pd.first->PeekPacketTag(tag);
         params.sf = tag.GetTxParameters().sf;
-        params.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(params) > MilliSeconds(16);
-        totOffTraff += LoraPhy::GetTimeOnAir(pd.first->Copy(), params).GetSeconds();
+        params.lowDataRateOptimizationEnabled =
+            LoraPhyMath::NeedsLowDataRateOptimization(params.sf, params.bandwidthHz);
+        totOffTraff += LoraPhy::GetTimeOnAir(pd.first->GetSize(), params).GetSeconds();
 
         total++;
         totBytesSent += pd.first->GetSize();
@@ -632,6 +633,18 @@ LoraPacketTracker::EnableOldPacketsCleanup(Time oldPacketThreshold)
     m_oldPacketThreshold = oldPacketThreshold;
 }
 
+size_t
+LoraPacketTracker::GetNPhyPackets() const
+{
+    return m_packetTracker.size();
+}
+
+size_t
+LoraPacketTracker::GetNMacPackets() const
+{
+    return m_macPacketTracker.size();
+}
+
 void
 LoraPacketTracker::CleanupOldPackets()
 {
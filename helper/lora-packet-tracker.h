@@ -96,8 +96,13 @@ struct phyPrint_t
 
 using GwsPhyPktPrint = std::unordered_map<uint32_t, phyPrint_t>;
 
+class NetworkCheckpointHelper;
+
 class LoraPacketTracker
 {
+    /// Checkpoints save and restore the packet records
+    friend class NetworkCheckpointHelper;
+
   public:
     LoraPacketTracker();
     ~LoraPacketTracker();
@@ -188,6 +193,12 @@ class LoraPacketTracker
 
     void EnableOldPacketsCleanup(Time oldPacketThreshold = Hours(12));
 
+    /**
+     * Get the number of packets currently tracked at the PHY and MAC layers.
+     */
+    size_t GetNPhyPackets() const;
+    size_t GetNMacPackets() const;
+
   private:
     void CleanupOldPackets();
 
@@ -25,9 +25,11 @@
 
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/energy-source-container.h"
+#include "ns3/gateway-spatial-index.h"
 #include "ns3/log.h"
 #include "ns3/lora-application.h"
 #include "ns3/loratap-header.h"
+#include "ns3/string.h"
 
 #include <fstream>
 
@@ -113,6 +115,26 @@ LorawanHelper::Install(const LoraPhyHelper& phy, const LorawanMacHelper& mac, Pt
     return Install(phy, mac, NodeContainer(node));
 }
 
+int64_t
+LorawanHelper::AssignStreams(NetDeviceContainer c, int64_t stream)
+{
+    int64_t currentStream = stream;
+    for (auto i = c.Begin(); i != c.End(); ++i)
+    {
+        auto device = DynamicCast<LoraNetDevice>(*i);
+        if (!device)
+        {
+            continue;
+        }
+        // Only end devices draw random values, in the MAC layer
+        if (auto mac = DynamicCast<BaseEndDeviceLorawanMac>(device->GetMac()))
+        {
+            currentStream += mac->AssignStreams(currentStream);
+        }
+    }
+    return (currentStream - stream);
+}
+
 void
 LorawanHelper::EnablePacketTracking()
 {
@@ -190,6 +212,7 @@ LorawanHelper::DoPrintDeviceStatus(NodeContainer endDevices,
     DevPktCount devPktCount;
     m_packetTracker->CountAllDevicesPackets(m_lastDeviceStatusUpdate, currentTime, devPktCount);
 
+    auto gatewayIndex = CreateObject<GatewaySpatialIndex>(gateways);
     for (NodeContainer::Iterator j = endDevices.Begin(); j != endDevices.End(); ++j)
     {
         auto node = *j;
@@ -201,9 +224,9 @@ LorawanHelper::DoPrintDeviceStatus(NodeContainer endDevices,
         Vector pos = position->GetPosition();
 
         double gwdist = std::numeric_limits<double>::max();
-        for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+        if (auto nearest = gatewayIndex->GetNearest(pos, 1); !nearest.empty())
         {
-            gwdist = std::min(gwdist, (*gw)->GetObject<MobilityModel>()->GetDistanceFrom(position));
+            gwdist = nearest[0].distance;
         }
 
         int dr = int(mac->GetDataRate());
@@ -217,9 +240,9 @@ LorawanHelper::DoPrintDeviceStatus(NodeContainer endDevices,
         double interval = app->GetInterval().GetSeconds();
         LoraPhyTxParameters params;
         params.sf = 12 - dr;
-        params.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(params) > MilliSeconds(16);
-        double maxot =
-            LoraPhy::GetTimeOnAir(Create<Packet>(size + 13), params).GetSeconds() / interval;
+        params.lowDataRateOptimizationEnabled =
+            LoraPhyMath::NeedsLowDataRateOptimization(params.sf, params.bandwidthHz);
+        double maxot = LoraPhy::GetTimeOnAir(size + 13, params).GetSeconds() / interval;
         maxot = std::min(maxot, 0.01);
 
         double ot = mac->GetAggregatedDutyCycle();
@@ -400,9 +423,9 @@ LorawanHelper::DoPrintSFStatus(NodeContainer endDevices,
         double interval = app->GetInterval().GetSeconds();
         LoraPhyTxParameters params;
         params.sf = 12 - dr;
-        params.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(params) > MilliSeconds(16);
-        double maxot =
-            LoraPhy::GetTimeOnAir(Create<Packet>(size + 13), params).GetSeconds() / interval;
+        params.lowDataRateOptimizationEnabled =
+            LoraPhyMath::NeedsLowDataRateOptimization(params.sf, params.bandwidthHz);
+        double maxot = LoraPhy::GetTimeOnAir(size + 13, params).GetSeconds() / interval;
         maxot = std::min(maxot, 0.01);
         double ot = mac->GetAggregatedDutyCycle();
         ot = std::min(ot, maxot);
@@ -502,6 +525,25 @@ LorawanHelper::EnablePcapInternal(std::string prefix,
         filename = pcapHelper.GetFilenameFromDevice(prefix, device);
     }
 
+    if (m_pcapWriter)
+    {
+        // In a merged capture, the file name (without extension) names the interface
+        std::string name = filename;
+        if (m_pcapWriter->IsMerged() && name.size() > 5 &&
+            name.compare(name.size() - 5, 5, ".pcap") == 0)
+        {
+            name.resize(name.size() - 5);
+        }
+        uint32_t ifIndex = m_pcapWriter->AddInterface(name, PcapHelper::DLT_LORATAP);
+        phy->TraceConnectWithoutContext(
+            "SnifferRx",
+            MakeBoundCallback(&LorawanHelper::AsyncPcapSniffEvent, m_pcapWriter, ifIndex));
+        phy->TraceConnectWithoutContext(
+            "SnifferTx",
+            MakeBoundCallback(&LorawanHelper::AsyncPcapSniffEvent, m_pcapWriter, ifIndex));
+        return;
+    }
+
     auto file = pcapHelper.CreateFile(filename, std::ios::out, PcapHelper::DLT_LORATAP);
     phy->TraceConnectWithoutContext("SnifferRx",
                                     MakeBoundCallback(&LorawanHelper::PcapSniffRxEvent, file));
@@ -512,9 +554,9 @@ LorawanHelper::EnablePcapInternal(std::string prefix,
 void
 LorawanHelper::PcapSniffRxEvent(Ptr<PcapFileWrapper> file, Ptr<const Packet> packet)
 {
-    Ptr<Packet> p = packet->Copy();
     LoraTag tag;
-    p->RemovePacketTag(tag);
+    packet->PeekPacketTag(tag);
+    Ptr<Packet> p = packet->Copy();
     LoratapHeader header;
     header.Fill(tag);
     p->AddHeader(header);
@@ -524,14 +566,42 @@ LorawanHelper::PcapSniffRxEvent(Ptr<PcapFileWrapper> file, Ptr<const Packet> pac
 void
 LorawanHelper::PcapSniffTxEvent(Ptr<PcapFileWrapper> file, Ptr<const Packet> packet)
 {
-    Ptr<Packet> p = packet->Copy();
     LoraTag tag;
-    p->RemovePacketTag(tag);
+    packet->PeekPacketTag(tag);
+    Ptr<Packet> p = packet->Copy();
     LoratapHeader header;
     header.Fill(tag);
     p->AddHeader(header);
     file->Write(Simulator::Now(), p);
 }
 
+void
+LorawanHelper::AsyncPcapSniffEvent(Ptr<AsyncPcapWriter> writer,
+                                   uint32_t ifIndex,
+                                   Ptr<const Packet> packet)
+{
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    Ptr<Packet> p = packet->Copy();
+    LoratapHeader header;
+    header.Fill(tag);
+    p->AddHeader(header);
+    writer->Write(ifIndex, Simulator::Now(), p);
+}
+
+void
+LorawanHelper::EnableAsyncPcap(std::string mergedFilename)
+{
+    NS_LOG_FUNCTION(this << mergedFilename);
+    m_pcapWriter = CreateObjectWithAttributes<AsyncPcapWriter>("MergedFile",
+                                                               StringValue(mergedFilename));
+}
+
+Ptr<AsyncPcapWriter>
+LorawanHelper::GetAsyncPcapWriter() const
+{
+    return m_pcapWriter;
+}
+
 } // namespace lorawan
 } // namespace ns3
@@ -24,6 +24,7 @@
 #ifndef LORAWAN_HELPER_H
 #define LORAWAN_HELPER_H
 
+#include "ns3/async-pcap-writer.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-packet-tracker.h"
 #include "ns3/lora-phy-helper.h"
@@ -87,6 +88,16 @@ class LorawanHelper : public PcapHelperForDevice
                                        const LorawanMacHelper& macHelper,
                                        Ptr<Node> node) const;
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by the MAC layer of the end devices in the container.
+     *
+     * \param c The devices.
+     * \param stream The first stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(NetDeviceContainer c, int64_t stream);
+
     /**
      * Enable tracking of packets via trace sources.
      *
@@ -145,6 +156,24 @@ class LorawanHelper : public PcapHelperForDevice
 
     LoraPacketTracker& GetPacketTracker();
 
+    /**
+     * Write pcap traces from a background thread instead of the simulation thread.
+     *
+     * Must be called before EnablePcap. Disk latency does not stall the
+     * simulation anymore, but packets are dropped if the writer cannot keep up.
+     *
+     * \param mergedFilename If not empty, capture all devices to this single
+     *                       pcapng file, with one interface per device.
+     */
+    void EnableAsyncPcap(std::string mergedFilename = "");
+
+    /**
+     * Get the background pcap writer, to retrieve drop statistics.
+     *
+     * \return The writer, nullptr if EnableAsyncPcap was not called.
+     */
+    Ptr<AsyncPcapWriter> GetAsyncPcapWriter() const;
+
     LoraPacketTracker* m_packetTracker = nullptr;
 
     time_t m_oldtime;
@@ -154,6 +183,10 @@ class LorawanHelper : public PcapHelperForDevice
 
     static void PcapSniffTxEvent(Ptr<PcapFileWrapper> file, Ptr<const Packet> packet);
 
+    static void AsyncPcapSniffEvent(Ptr<AsyncPcapWriter> writer,
+                                    uint32_t ifIndex,
+                                    Ptr<const Packet> packet);
+
   private:
     /**
      * Actually print the simulation time and re-schedule execution of this
@@ -170,6 +203,8 @@ class LorawanHelper : public PcapHelperForDevice
     Time m_lastGlobalPerformanceUpdate;
     Time m_lastDeviceStatusUpdate;
     Time m_lastSFStatusUpdate;
+
+    Ptr<AsyncPcapWriter> m_pcapWriter; //!< Background pcap writer, if enabled
 };
 
 } // namespace lorawan
@@ -24,9 +24,12 @@
 #include "lorawan-mac-helper.h"
 
 #include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/gateway-spatial-index.h"
 #include "ns3/lora-application.h"
 #include "ns3/node-list.h"
 
+#include <algorithm>
+
 namespace ns3
 {
 namespace lorawan
@@ -345,10 +348,18 @@ LorawanMacHelper::ConfigureForSingleChannelRegion(Ptr<LorawanMac> mac) const
 std::vector<int>
 LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
                                         NodeContainer gateways,
-                                        Ptr<LoraChannel> channel)
+                                        Ptr<LoraChannel> channel,
+                                        uint32_t nearestGateways)
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    Ptr<GatewaySpatialIndex> index;
+    std::vector<uint32_t> candidates;
+    if (nearestGateways > 0)
+    {
+        index = CreateObject<GatewaySpatialIndex>(gateways);
+    }
+
     std::vector<int> sfQuantity(6, 0);
     for (auto j = endDevices.Begin(); j != endDevices.End(); ++j)
     {
@@ -359,15 +370,33 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
         auto mac = DynamicCast<BaseEndDeviceLorawanMac>(loraNetDevice->GetMac());
         NS_ASSERT(bool(position) && bool(mac));
 
+        // Candidate gateways, in container order (so that ties are broken the same way)
+        candidates.clear();
+        if (index)
+        {
+            for (const auto& gw : index->GetNearest(position->GetPosition(), nearestGateways))
+            {
+                candidates.push_back(gw.index);
+            }
+            std::sort(candidates.begin(), candidates.end());
+        }
+        else
+        {
+            for (uint32_t i = 0; i < gateways.GetN(); ++i)
+            {
+                candidates.push_back(i);
+            }
+        }
+
         // Try computing the distance from each gateway and find the best one
-        auto bestGateway = gateways.Get(0);
+        auto bestGateway = gateways.Get(candidates[0]);
         auto bestGatewayPosition = bestGateway->GetObject<MobilityModel>();
         // Assume devices transmit at 14 dBm erp
         double highestRxPower = channel->GetRxPower(14, position, bestGatewayPosition);
-        for (auto currentGw = gateways.Begin() + 1; currentGw != gateways.End(); ++currentGw)
+        for (auto currentGw = candidates.begin() + 1; currentGw != candidates.end(); ++currentGw)
         {
             // Compute the power received from the current gateway
-            auto curr = *currentGw;
+            auto curr = gateways.Get(*currentGw);
             auto currPosition = curr->GetObject<MobilityModel>();
             double currentRxPower = channel->GetRxPower(14, position, currPosition); // dBm
             if (currentRxPower > highestRxPower)
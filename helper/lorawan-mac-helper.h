@@ -92,10 +92,21 @@ class LorawanMacHelper
 
     /**
      * Set up the end device's data rates with the criteria from the default ADR algortithm
+     *
+     * The best gateway of each device is looked for among all gateways by default. With a
+     * positive nearestGateways, only that many gateways nearest to the device are considered,
+     * which is exact as long as the loss never decreases with distance (e.g., no shadowing).
+     *
+     * \param endDevices The end devices to configure.
+     * \param gateways The gateways.
+     * \param channel The channel used to compute received power.
+     * \param nearestGateways The number of nearest gateways to consider (0 for all).
+     * \return The number of devices per data rate.
      */
     static std::vector<int> SetSpreadingFactorsUp(NodeContainer endDevices,
                                                   NodeContainer gateways,
-                                                  Ptr<LoraChannel> channel);
+                                                  Ptr<LoraChannel> channel,
+                                                  uint32_t nearestGateways = 0);
 
   private:
     /**
@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "metrics-exporter.h"
+
+#include "ns3/log.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("MetricsExporter");
+
+NS_OBJECT_ENSURE_REGISTERED(MetricsExporter);
+
+namespace
+{
+/* Resident set size of the process, 0 if unknown */
+uint64_t
+GetResidentMemory()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Write the HELP and TYPE lines of a metric */
+void
+Describe(std::ostream& os, const char* name, const char* type, const char* help)
+{
+    os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+} // namespace
+
+TypeId
+MetricsExporter::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::MetricsExporter")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<MetricsExporter>()
+            .AddAttribute("Interval",
+                          "Simulated time between two snapshots of the metrics",
+                          TimeValue(Seconds(10)),
+                          MakeTimeAccessor(&MetricsExporter::m_interval),
+                          MakeTimeChecker(MicroSeconds(1)))
+            .AddAttribute("File",
+                          "If not empty, atomically replace this file with each snapshot",
+                          StringValue(""),
+                          MakeStringAccessor(&MetricsExporter::m_file),
+                          MakeStringChecker())
+            .AddAttribute("Socket",
+                          "If not empty, serve the last snapshot over HTTP on a UNIX socket "
+                          "bound to this path",
+                          StringValue(""),
+                          MakeStringAccessor(&MetricsExporter::m_socket),
+                          MakeStringChecker())
+            .AddAttribute("PollInterval",
+                          "Wall-clock time the exporter thread waits for snapshots or "
+                          "connections",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&MetricsExporter::m_pollInterval),
+                          MakeTimeChecker(MilliSeconds(1)));
+    return tid;
+}
+
+MetricsExporter::MetricsExporter()
+    : m_interval(Seconds(10)),
+      m_pollInterval(MilliSeconds(100)),
+      m_tracker(nullptr),
+      m_nSnapshots(0),
+      m_stop(false),
+      m_listenFd(-1)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+}
+
+void
+MetricsExporter::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_snapshotEvent);
+    Close();
+    m_gateways.clear();
+    m_lagMonitor = nullptr;
+    m_tracker = nullptr;
+    Object::DoDispose();
+}
+
+void
+MetricsExporter::AddGateways(NodeContainer gateways)
+{
+    NS_LOG_FUNCTION(this);
+    for (auto node = gateways.Begin(); node != gateways.End(); ++node)
+    {
+        auto device = DynamicCast<LoraNetDevice>((*node)->GetDevice(0));
+        NS_ABORT_MSG_UNLESS(device, "Gateway " << (*node)->GetId() << " has no LoraNetDevice");
+        auto phy = DynamicCast<GatewayLoraPhy>(device->GetPhy());
+        NS_ABORT_MSG_UNLESS(phy, "Node " << (*node)->GetId() << " is not a gateway");
+
+        Gateway gateway;
+        gateway.nodeId = (*node)->GetId();
+        gateway.phy = phy;
+        for (uint32_t i = 0; i < (*node)->GetNApplications(); ++i)
+        {
+            if (auto forwarder = DynamicCast<UdpForwarder>((*node)->GetApplication(i)))
+            {
+                gateway.forwarder = forwarder;
+                break;
+            }
+        }
+        m_gateways.push_back(gateway);
+        m_counters[gateway.nodeId] = GatewayCounters();
+
+        phy->TraceConnectWithoutContext("ReceivedPacket",
+                                        MakeCallback(&MetricsExporter::OnReceived, this));
+        phy->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                        MakeCallback(&MetricsExporter::OnInterference, this));
+        phy->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                        MakeCallback(&MetricsExporter::OnUnderSensitivity, this));
+        phy->TraceConnectWithoutContext("LostPacketBecauseNoMoreReceivers",
+                                        MakeCallback(&MetricsExporter::OnNoMoreReceivers, this));
+        phy->TraceConnectWithoutContext("NoReceptionBecauseTransmitting",
+                                        MakeCallback(&MetricsExporter::OnTransmitting, this));
+        phy->TraceConnectWithoutContext("StartSending",
+                                        MakeCallback(&MetricsExporter::OnSent, this));
+    }
+}
+
+void
+MetricsExporter::SetPacketTracker(LoraPacketTracker& tracker)
+{
+    m_tracker = &tracker;
+}
+
+void
+MetricsExporter::SetLagMonitor(Ptr<RealtimeLagMonitor> monitor)
+{
+    m_lagMonitor = monitor;
+}
+
+void
+MetricsExporter::Start()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_exporter.joinable(), "Metrics exporter already started");
+    NS_ABORT_MSG_IF(m_file.empty() && m_socket.empty(), "Metrics exporter has no File or Socket");
+
+    if (!m_socket.empty())
+    {
+        // Fail early and in the simulation thread on invalid paths
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        NS_ABORT_MSG_IF(m_socket.size() >= sizeof(address.sun_path),
+                        "UNIX socket path too long: " << m_socket);
+        m_socket.copy(address.sun_path, m_socket.size());
+        unlink(m_socket.c_str());
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        NS_ABORT_MSG_IF(m_listenFd < 0, "Unable to create UNIX socket");
+        auto addr = reinterpret_cast<sockaddr*>(&address);
+        NS_ABORT_MSG_IF(bind(m_listenFd, addr, sizeof(address)) < 0 || listen(m_listenFd, 4) < 0,
+                        "Unable to listen on UNIX socket " << m_socket);
+    }
+
+    m_stop = false;
+    m_exporter = std::thread(&MetricsExporter::ExportLoop, this);
+    m_snapshotEvent = Simulator::ScheduleNow(&MetricsExporter::TakeSnapshot, this);
+}
+
+void
+MetricsExporter::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_exporter.joinable())
+    {
+        return;
+    }
+    Simulator::Cancel(m_snapshotEvent);
+    Publish();
+    Close();
+}
+
+void
+MetricsExporter::Close()
+{
+    if (!m_exporter.joinable())
+    {
+        return;
+    }
+    m_stop.store(true, std::memory_order_release);
+    m_exporter.join();
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+        unlink(m_socket.c_str());
+        m_listenFd = -1;
+    }
+}
+
+uint64_t
+MetricsExporter::GetNSnapshots() const
+{
+    return m_nSnapshots;
+}
+
+void
+MetricsExporter::TakeSnapshot()
+{
+    Publish();
+    m_snapshotEvent = Simulator::Schedule(m_interval, &MetricsExporter::TakeSnapshot, this);
+}
+
+void
+MetricsExporter::Publish()
+{
+    auto snapshot = std::make_unique<Snapshot>();
+    snapshot->simTime = Simulator::Now().GetSeconds();
+    snapshot->events = Simulator::GetEventCount();
+    snapshot->wall = std::chrono::steady_clock::now();
+    snapshot->hasLag = bool(m_lagMonitor);
+    snapshot->lag = m_lagMonitor ? m_lagMonitor->GetLag().GetSeconds() : 0;
+    snapshot->maxLag = m_lagMonitor ? m_lagMonitor->GetMaxLag().GetSeconds() : 0;
+    snapshot->hasTracker = m_tracker != nullptr;
+    snapshot->phyPackets = m_tracker ? m_tracker->GetNPhyPackets() : 0;
+    snapshot->macPackets = m_tracker ? m_tracker->GetNMacPackets() : 0;
+    snapshot->gateways.reserve(m_gateways.size());
+    for (const auto& gateway : m_gateways)
+    {
+        GatewaySample sample;
+        sample.nodeId = gateway.nodeId;
+        sample.counters = m_counters[gateway.nodeId];
+        sample.utilization = gateway.phy->GetUtilization();
+        sample.hasForwarder = bool(gateway.forwarder);
+        sample.jitQueue = gateway.forwarder ? gateway.forwarder->GetJitQueueSize() : 0;
+        sample.pushDataSent = gateway.forwarder ? gateway.forwarder->GetNPushDataSent() : 0;
+        sample.pushAckReceived = gateway.forwarder ? gateway.forwarder->GetNPushAckReceived() : 0;
+        snapshot->gateways.push_back(sample);
+    }
+
+    // An older snapshot not yet exported is simply replaced
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending = std::move(snapshot);
+    m_nSnapshots++;
+}
+
+void
+MetricsExporter::ExportLoop()
+{
+    int timeout = std::max<int64_t>(1, m_pollInterval.GetMilliSeconds());
+    std::unique_ptr<Snapshot> previous;
+    std::string text;
+    while (true)
+    {
+        // Check the stop request before the snapshot, not to miss the last one
+        bool stop = m_stop.load(std::memory_order_acquire);
+        std::unique_ptr<Snapshot> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            snapshot = std::move(m_pending);
+        }
+        if (snapshot)
+        {
+            text = Format(*snapshot, previous.get());
+            if (!m_file.empty())
+            {
+                WriteFile(text);
+            }
+            previous = std::move(snapshot);
+        }
+        if (stop)
+        {
+            break;
+        }
+
+        if (m_listenFd < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+            continue;
+        }
+        pollfd pfd = {m_listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout) > 0 && (pfd.revents & POLLIN))
+        {
+            int fd = accept(m_listenFd, nullptr, nullptr);
+            if (fd >= 0)
+            {
+                Serve(fd, text);
+                close(fd);
+            }
+        }
+    }
+}
+
+std::string
+MetricsExporter::Format(const Snapshot& snapshot, const Snapshot* previous)
+{
+    std::ostringstream os;
+    os.precision(12);
+
+    Describe(os,
+             "elora_gateway_rx_packets_total",
+             "counter",
+             "Packets correctly received by the gateway PHY.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        os << "elora_gateway_rx_packets_total{gateway=\"" << gw.nodeId << "\"} "
+           << gw.counters.received << "\n";
+    }
+
+    Describe(os,
+             "elora_gateway_rx_dropped_total",
+             "counter",
+             "Packets lost by the gateway PHY, by reason.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        const std::pair<const char*, uint64_t> reasons[] = {
+            {"interference", gw.counters.interference},
+            {"under_sensitivity", gw.counters.underSensitivity},
+            {"no_more_receivers", gw.counters.noMoreReceivers},
+            {"transmitting", gw.counters.transmitting}};
+        for (const auto& reason : reasons)
+        {
+            os << "elora_gateway_rx_dropped_total{gateway=\"" << gw.nodeId << "\",reason=\""
+               << reason.first << "\"} " << reason.second << "\n";
+        }
+    }
+
+    Describe(os,
+             "elora_gateway_tx_packets_total",
+             "counter",
+             "Packets transmitted by the gateway PHY.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        os << "elora_gateway_tx_packets_total{gateway=\"" << gw.nodeId << "\"} "
+           << gw.counters.sent << "\n";
+    }
+
+    Describe(os,
+             "elora_gateway_reception_path_utilization",
+             "gauge",
+             "Time-weighted mean fraction of occupied reception paths.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        os << "elora_gateway_reception_path_utilization{gateway=\"" << gw.nodeId << "\"} "
+           << gw.utilization << "\n";
+    }
+
+    Describe(os,
+             "elora_gateway_jit_queue_packets",
+             "gauge",
+             "Downlink packets in the just-in-time queue of the packet forwarder.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        if (gw.hasForwarder)
+        {
+            os << "elora_gateway_jit_queue_packets{gateway=\"" << gw.nodeId << "\"} "
+               << gw.jitQueue << "\n";
+        }
+    }
+
+    Describe(os,
+             "elora_gateway_push_data_sent_total",
+             "counter",
+             "PUSH_DATA datagrams sent by the packet forwarder.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        if (gw.hasForwarder)
+        {
+            os << "elora_gateway_push_data_sent_total{gateway=\"" << gw.nodeId << "\"} "
+               << gw.pushDataSent << "\n";
+        }
+    }
+
+    Describe(os,
+             "elora_gateway_push_ack_received_total",
+             "counter",
+             "PUSH_ACK datagrams received by the packet forwarder.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        if (gw.hasForwarder)
+        {
+            os << "elora_gateway_push_ack_received_total{gateway=\"" << gw.nodeId << "\"} "
+               << gw.pushAckReceived << "\n";
+        }
+    }
+
+    Describe(os,
+             "elora_gateway_push_ack_ratio",
+             "gauge",
+             "Fraction of PUSH_DATA datagrams acknowledged since the start.");
+    for (const auto& gw : snapshot.gateways)
+    {
+        if (gw.hasForwarder && gw.pushDataSent > 0)
+        {
+            os << "elora_gateway_push_ack_ratio{gateway=\"" << gw.nodeId << "\"} "
+               << double(gw.pushAckReceived) / gw.pushDataSent << "\n";
+        }
+    }
+
+    if (snapshot.hasLag)
+    {
+        Describe(os,
+                 "elora_scheduler_lag_seconds",
+                 "gauge",
+                 "Last lag of the real-time scheduler behind the wall clock.");
+        os << "elora_scheduler_lag_seconds " << snapshot.lag << "\n";
+        Describe(os,
+                 "elora_scheduler_max_lag_seconds",
+                 "gauge",
+                 "Maximum lag of the real-time scheduler behind the wall clock.");
+        os << "elora_scheduler_max_lag_seconds " << snapshot.maxLag << "\n";
+    }
+
+    Describe(os, "elora_simulator_events_total", "counter", "Events executed by the simulator.");
+    os << "elora_simulator_events_total " << snapshot.events << "\n";
+    if (previous)
+    {
+        std::chrono::duration<double> wall = snapshot.wall - previous->wall;
+        if (wall.count() > 0)
+        {
+            Describe(os,
+                     "elora_simulator_events_per_second",
+                     "gauge",
+                     "Events executed per wall-clock second since the previous snapshot.");
+            os << "elora_simulator_events_per_second "
+               << (snapshot.events - previous->events) / wall.count() << "\n";
+        }
+    }
+
+    Describe(os, "elora_simulation_time_seconds", "gauge", "Current simulated time.");
+    os << "elora_simulation_time_seconds " << snapshot.simTime << "\n";
+
+    if (snapshot.hasTracker)
+    {
+        Describe(os,
+                 "elora_packet_tracker_entries",
+                 "gauge",
+                 "Packets held by the packet tracker, by layer.");
+        os << "elora_packet_tracker_entries{layer=\"phy\"} " << snapshot.phyPackets << "\n";
+        os << "elora_packet_tracker_entries{layer=\"mac\"} " << snapshot.macPackets << "\n";
+    }
+
+    Describe(os, "process_resident_memory_bytes", "gauge", "Resident memory size in bytes.");
+    os << "process_resident_memory_bytes " << GetResidentMemory() << "\n";
+
+    return os.str();
+}
+
+void
+MetricsExporter::WriteFile(const std::string& text) const
+{
+    // Readers never see a partial file: write aside, then rename over
+    std::string tmp = m_file + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::out | std::ios::trunc);
+        if (!(file << text).flush())
+        {
+            return;
+        }
+    }
+    std::rename(tmp.c_str(), m_file.c_str());
+}
+
+void
+MetricsExporter::Serve(int fd, const std::string& text)
+{
+    // Never block the exporter on a slow client
+    timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Whatever the request, answer with the metrics
+    char request[1024];
+    if (recv(fd, request, sizeof(request), 0) < 0)
+    {
+        return;
+    }
+    std::ostringstream os;
+    os << "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+       << text.size() << "\r\nConnection: close\r\n\r\n"
+       << text;
+    std::string response = os.str();
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return;
+        }
+        sent += n;
+    }
+}
+
+void
+MetricsExporter::OnReceived(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].received++;
+}
+
+void
+MetricsExporter::OnInterference(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].interference++;
+}
+
+void
+MetricsExporter::OnUnderSensitivity(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].underSensitivity++;
+}
+
+void
+MetricsExporter::OnNoMoreReceivers(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].noMoreReceivers++;
+}
+
+void
+MetricsExporter::OnTransmitting(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].transmitting++;
+}
+
+void
+MetricsExporter::OnSent(Ptr<const Packet> packet, uint32_t nodeId)
+{
+    m_counters[nodeId].sent++;
+}
+
+} // namespace lorawan
+} // namespace ns3
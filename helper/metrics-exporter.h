@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "ns3/event-id.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/lora-packet-tracker.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/realtime-lag-monitor.h"
+#include "ns3/udp-forwarder.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Exporter of live metrics of a long-running simulation or emulation.
+ *
+ * At each interval of simulated time, the simulation thread samples the
+ * metrics (per-gateway PHY counters and drop reasons, reception path
+ * utilization, JIT queue depth and PUSH_ACK ratio of UDP forwarders, scheduler
+ * lag, event count, and packet tracker size) and hands them to a background
+ * thread. The background thread formats them in the Prometheus text format,
+ * adds the resident memory of the process, and writes them atomically to a
+ * file (write to a temporary file, then rename), or serves them over HTTP on a
+ * local UNIX socket, or both. The simulation thread never waits for I/O.
+ *
+ * Only the simulation thread may call the public methods.
+ */
+class MetricsExporter : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    MetricsExporter();
+    ~MetricsExporter() override;
+
+    /**
+     * Export the metrics of these gateways, and of their UdpForwarder, if any.
+     *
+     * \param gateways Gateway nodes, with a LoraNetDevice at index 0.
+     */
+    void AddGateways(NodeContainer gateways);
+
+    /**
+     * Export the size of this packet tracker.
+     */
+    void SetPacketTracker(LoraPacketTracker& tracker);
+
+    /**
+     * Export the scheduler lag measured by this monitor.
+     */
+    void SetLagMonitor(Ptr<RealtimeLagMonitor> monitor);
+
+    /**
+     * Open the socket, start the background thread and schedule the first
+     * snapshot at the current simulated time.
+     */
+    void Start();
+
+    /**
+     * Take a last snapshot, export it, and stop the background thread.
+     */
+    void Stop();
+
+    /**
+     * Get the number of snapshots handed to the background thread.
+     */
+    uint64_t GetNSnapshots() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Counters of the PHY of a gateway.
+     */
+    struct GatewayCounters
+    {
+        uint64_t received = 0;         //!< Packets received correctly
+        uint64_t interference = 0;     //!< Packets lost to interference
+        uint64_t underSensitivity = 0; //!< Packets lost under the sensitivity
+        uint64_t noMoreReceivers = 0;  //!< Packets lost for lack of free reception paths
+        uint64_t transmitting = 0;     //!< Packets lost because the gateway was transmitting
+        uint64_t sent = 0;             //!< Packets transmitted
+    };
+
+    /**
+     * Metrics of a gateway at the time of a snapshot.
+     */
+    struct GatewaySample
+    {
+        uint32_t nodeId;          //!< Node of the gateway
+        GatewayCounters counters; //!< PHY counters
+        double utilization;       //!< Time-weighted utilization of the reception paths
+        bool hasForwarder;        //!< Whether the gateway runs a UdpForwarder
+        uint32_t jitQueue;        //!< Packets in the JIT queue of the forwarder
+        uint64_t pushDataSent;    //!< PUSH_DATA sent by the forwarder
+        uint64_t pushAckReceived; //!< PUSH_ACK received by the forwarder
+    };
+
+    /**
+     * Metrics sampled by the simulation thread.
+     */
+    struct Snapshot
+    {
+        double simTime;                             //!< Simulated time [s]
+        uint64_t events;                            //!< Events executed so far
+        std::chrono::steady_clock::time_point wall; //!< Wall-clock time of the snapshot
+        bool hasLag;                                //!< Whether the lag is known
+        double lag;                                 //!< Last scheduler lag [s]
+        double maxLag;                              //!< Maximum scheduler lag [s]
+        bool hasTracker;                            //!< Whether tracker sizes are known
+        uint64_t phyPackets;                        //!< PHY packets in the tracker
+        uint64_t macPackets;                        //!< MAC packets in the tracker
+        std::vector<GatewaySample> gateways;        //!< Per-gateway metrics
+    };
+
+    /**
+     * A gateway whose metrics are exported.
+     */
+    struct Gateway
+    {
+        uint32_t nodeId;             //!< Node of the gateway
+        Ptr<GatewayLoraPhy> phy;     //!< PHY of the gateway
+        Ptr<UdpForwarder> forwarder; //!< UdpForwarder of the gateway, if any
+    };
+
+    /**
+     * Sample the metrics, hand them to the background thread, and reschedule.
+     */
+    void TakeSnapshot();
+
+    /**
+     * Sample the metrics and hand them to the background thread.
+     */
+    void Publish();
+
+    /**
+     * Body of the background thread.
+     */
+    void ExportLoop();
+
+    /**
+     * Stop the background thread after it exported the pending snapshot, and
+     * close the socket.
+     */
+    void Close();
+
+    /**
+     * Format a snapshot in the Prometheus text format (background thread).
+     *
+     * \param snapshot The snapshot.
+     * \param previous The previous snapshot, to compute rates, or nullptr.
+     * \return The text.
+     */
+    static std::string Format(const Snapshot& snapshot, const Snapshot* previous);
+
+    /**
+     * Write the text to the file atomically (background thread).
+     */
+    void WriteFile(const std::string& text) const;
+
+    /**
+     * Answer a connection on the socket with the text (background thread).
+     */
+    static void Serve(int fd, const std::string& text);
+
+    /**
+     * Trace sinks of the gateway PHYs.
+     */
+    void OnReceived(Ptr<const Packet> packet, uint32_t nodeId);
+    void OnInterference(Ptr<const Packet> packet, uint32_t nodeId);
+    void OnUnderSensitivity(Ptr<const Packet> packet, uint32_t nodeId);
+    void OnNoMoreReceivers(Ptr<const Packet> packet, uint32_t nodeId);
+    void OnTransmitting(Ptr<const Packet> packet, uint32_t nodeId);
+    void OnSent(Ptr<const Packet> packet, uint32_t nodeId);
+
+    Time m_interval;      //!< Simulated time between snapshots
+    std::string m_file;   //!< Path of the exported file, empty if disabled
+    std::string m_socket; //!< Path of the UNIX socket, empty if disabled
+    Time m_pollInterval;  //!< Wall-clock period of the background thread
+
+    std::vector<Gateway> m_gateways;                //!< Exported gateways
+    std::map<uint32_t, GatewayCounters> m_counters; //!< PHY counters, by node
+    LoraPacketTracker* m_tracker;                   //!< Packet tracker, if any
+    Ptr<RealtimeLagMonitor> m_lagMonitor;           //!< Lag monitor, if any
+    EventId m_snapshotEvent;                        //!< Next snapshot
+    uint64_t m_nSnapshots;                          //!< Snapshots taken
+
+    std::mutex m_mutex;                  //!< Protects m_pending
+    std::unique_ptr<Snapshot> m_pending; //!< Last snapshot not yet exported
+    std::atomic<bool> m_stop;            //!< Request the thread to export and exit
+    std::thread m_exporter;              //!< Background thread
+    int m_listenFd;                      //!< Listening UNIX socket, or -1
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* METRICS_EXPORTER_H */
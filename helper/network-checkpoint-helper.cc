@@ -0,0 +1,747 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "network-checkpoint-helper.h"
+
+#include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/lora-application.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lorawan-frame-codec.h"
+#include "ns3/simulator.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("NetworkCheckpointHelper");
+
+namespace
+{
+
+/*
+ * Layout of a checkpoint, in host byte order: magic, save time, end devices,
+ * gateways, network server, packet tracker. Sections are sequences of
+ * fixed-size fields and of counted lists.
+ */
+
+const char CHECKPOINT_MAGIC[8] = {'E', 'L', 'C', 'K', 'P', 'T', '0', '1'};
+
+/// Saved instead of a relative time for Time::Max ()
+const int64_t TIME_MAX = std::numeric_limits<int64_t>::max();
+
+/**
+ * Append fields to a checkpoint
+ */
+class CheckpointWriter
+{
+  public:
+    CheckpointWriter(Time origin)
+        : m_origin(origin)
+    {
+    }
+
+    template <typename T>
+    void Put(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Fields must be plain values");
+        const char* p = reinterpret_cast<const char*>(&value);
+        m_buffer.insert(m_buffer.end(), p, p + sizeof(T));
+    }
+
+    void PutBytes(const uint8_t* data, uint32_t size)
+    {
+        Put(size);
+        m_buffer.insert(m_buffer.end(), data, data + size);
+    }
+
+    /// A time instant, relative to the save time
+    void PutTime(Time t)
+    {
+        Put<int64_t>(t == Time::Max() ? TIME_MAX : (t - m_origin).GetNanoSeconds());
+    }
+
+    /// A duration
+    void PutDuration(Time d)
+    {
+        Put<int64_t>(d.GetNanoSeconds());
+    }
+
+    /// The bytes of a packet, and its LoraTag if requested
+    void PutPacket(Ptr<const Packet> packet, bool withTag)
+    {
+        std::vector<uint8_t> bytes(packet->GetSize());
+        packet->CopyData(bytes.data(), bytes.size());
+        PutBytes(bytes.data(), bytes.size());
+        if (!withTag)
+        {
+            return;
+        }
+        LoraTag tag;
+        bool tagged = packet->PeekPacketTag(tag);
+        Put<uint8_t>(tagged);
+        if (tagged)
+        {
+            std::vector<uint8_t> tagBytes(tag.GetSerializedSize());
+            tag.Serialize(TagBuffer(tagBytes.data(), tagBytes.data() + tagBytes.size()));
+            PutBytes(tagBytes.data(), tagBytes.size());
+        }
+    }
+
+    const std::vector<char>& GetBuffer() const
+    {
+        return m_buffer;
+    }
+
+  private:
+    Time m_origin;              //!< Save time
+    std::vector<char> m_buffer; //!< Checkpoint content
+};
+
+/**
+ * Read fields from a checkpoint. Reads past the end return zeros and
+ * invalidate the reader.
+ */
+class CheckpointReader
+{
+  public:
+    CheckpointReader(const std::vector<char>& buffer, Time origin)
+        : m_buffer(buffer),
+          m_offset(0),
+          m_origin(origin),
+          m_valid(true)
+    {
+    }
+
+    template <typename T>
+    T Get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Fields must be plain values");
+        T value{};
+        if (m_offset + sizeof(T) > m_buffer.size())
+        {
+            m_valid = false;
+            m_offset = m_buffer.size();
+            return value;
+        }
+        std::memcpy(&value, m_buffer.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    std::vector<uint8_t> GetBytes()
+    {
+        uint32_t size = Get<uint32_t>();
+        if (m_offset + size > m_buffer.size())
+        {
+            m_valid = false;
+            m_offset = m_buffer.size();
+            return {};
+        }
+        auto begin = reinterpret_cast<const uint8_t*>(m_buffer.data() + m_offset);
+        m_offset += size;
+        return std::vector<uint8_t>(begin, begin + size);
+    }
+
+    /// A time instant, restored relative to the restore time
+    Time GetTime()
+    {
+        int64_t t = Get<int64_t>();
+        return t == TIME_MAX ? Time::Max() : m_origin + NanoSeconds(t);
+    }
+
+    Time GetDuration()
+    {
+        return NanoSeconds(Get<int64_t>());
+    }
+
+    Ptr<Packet> GetPacket(bool withTag)
+    {
+        std::vector<uint8_t> bytes = GetBytes();
+        Ptr<Packet> packet = Create<Packet>(bytes.data(), bytes.size());
+        if (withTag && Get<uint8_t>())
+        {
+            std::vector<uint8_t> tagBytes = GetBytes();
+            LoraTag tag;
+            if (tagBytes.size() == tag.GetSerializedSize())
+            {
+                tag.Deserialize(TagBuffer(tagBytes.data(), tagBytes.data() + tagBytes.size()));
+                packet->AddPacketTag(tag);
+            }
+            else
+            {
+                m_valid = false;
+            }
+        }
+        return packet;
+    }
+
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    bool AtEnd() const
+    {
+        return m_offset == m_buffer.size();
+    }
+
+  private:
+    const std::vector<char>& m_buffer; //!< Checkpoint content
+    size_t m_offset;                   //!< Read position
+    Time m_origin;                     //!< Restore time
+    bool m_valid;                      //!< Whether all reads were in bounds
+};
+
+/// Get the MAC layer of the LoraNetDevice of a node
+Ptr<LorawanMac>
+GetLorawanMac(Ptr<Node> node)
+{
+    for (uint32_t i = 0; i < node->GetNDevices(); ++i)
+    {
+        if (auto loraNetDevice = DynamicCast<LoraNetDevice>(node->GetDevice(i)))
+        {
+            return loraNetDevice->GetMac();
+        }
+    }
+    NS_ABORT_MSG("Node " << node->GetId() << " has no LoraNetDevice");
+    return nullptr;
+}
+
+/// Save the channel mask and the duty-cycle state of a channel manager
+void
+SaveChannels(CheckpointWriter& out, Ptr<LogicalChannelManager> manager)
+{
+    std::vector<std::pair<uint8_t, Ptr<LogicalChannel>>> channels;
+    for (uint16_t i = 0; i <= std::numeric_limits<uint8_t>::max(); ++i)
+    {
+        if (auto channel = manager->GetChannel(i))
+        {
+            channels.emplace_back(i, channel);
+        }
+    }
+    out.Put<uint16_t>(channels.size());
+    for (const auto& [index, channel] : channels)
+    {
+        out.Put<uint8_t>(index);
+        out.Put<double>(channel->GetFrequency());
+        out.Put<double>(channel->GetReplyFrequency());
+        out.Put<uint8_t>(channel->GetMinimumDataRate());
+        out.Put<uint8_t>(channel->GetMaximumDataRate());
+        out.Put<uint8_t>(channel->IsEnabledForUplink());
+    }
+    auto subBands = manager->GetSubBandList();
+    out.Put<uint32_t>(subBands.size());
+    for (const auto& subBand : subBands)
+    {
+        out.PutTime(subBand->GetNextTransmissionTime());
+    }
+    out.PutTime(manager->GetLastTxStart());
+    out.PutDuration(manager->GetLastTxDuration());
+}
+
+/// Restore the channel mask and the duty-cycle state of a channel manager
+void
+RestoreChannels(CheckpointReader& in, Ptr<LogicalChannelManager> manager)
+{
+    std::vector<bool> saved(std::numeric_limits<uint8_t>::max() + 1, false);
+    uint16_t nChannels = in.Get<uint16_t>();
+    for (uint16_t i = 0; i < nChannels && in.IsValid(); ++i)
+    {
+        uint8_t index = in.Get<uint8_t>();
+        double frequency = in.Get<double>();
+        double replyFrequency = in.Get<double>();
+        uint8_t minDataRate = in.Get<uint8_t>();
+        uint8_t maxDataRate = in.Get<uint8_t>();
+        bool enabled = in.Get<uint8_t>();
+
+        // Channels added by NewChannelReq are created anew
+        Ptr<LogicalChannel> channel = manager->GetChannel(index);
+        if (!channel || channel->GetFrequency() != frequency)
+        {
+            channel = Create<LogicalChannel>(frequency, minDataRate, maxDataRate);
+            manager->AddChannel(index, channel);
+        }
+        channel->SetReplyFrequency(replyFrequency);
+        channel->SetMinimumDataRate(minDataRate);
+        channel->SetMaximumDataRate(maxDataRate);
+        if (enabled)
+        {
+            channel->EnableForUplink();
+        }
+        else
+        {
+            channel->DisableForUplink();
+        }
+        saved[index] = true;
+    }
+    for (uint16_t i = 0; i < saved.size(); ++i)
+    {
+        if (!saved[i] && manager->GetChannel(i))
+        {
+            manager->RemoveChannel(i);
+        }
+    }
+
+    auto subBands = manager->GetSubBandList();
+    NS_ABORT_MSG_IF(in.Get<uint32_t>() != subBands.size(),
+                    "Checkpoint has a different number of sub-bands");
+    for (const auto& subBand : subBands)
+    {
+        subBand->SetNextTransmissionTime(in.GetTime());
+    }
+    Time lastTxStart = in.GetTime();
+    manager->SetLastTransmission(lastTxStart, in.GetDuration());
+}
+
+} // namespace
+
+NetworkCheckpointHelper::NetworkCheckpointHelper()
+    : m_networkServer(nullptr),
+      m_tracker(nullptr)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+NetworkCheckpointHelper::~NetworkCheckpointHelper()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+NetworkCheckpointHelper::SetEndDevices(NodeContainer endDevices)
+{
+    m_endDevices = endDevices;
+}
+
+void
+NetworkCheckpointHelper::SetGateways(NodeContainer gateways)
+{
+    m_gateways = gateways;
+}
+
+void
+NetworkCheckpointHelper::SetNetworkServer(Ptr<NetworkServer> networkServer)
+{
+    m_networkServer = networkServer;
+}
+
+void
+NetworkCheckpointHelper::SetPacketTracker(LoraPacketTracker& tracker)
+{
+    m_tracker = &tracker;
+}
+
+bool
+NetworkCheckpointHelper::Save(const std::string& filename) const
+{
+    NS_LOG_FUNCTION(this << filename);
+    CheckpointWriter out(Simulator::Now());
+    for (char c : CHECKPOINT_MAGIC)
+    {
+        out.Put(c);
+    }
+    out.Put<int64_t>(Simulator::Now().GetNanoSeconds());
+
+    ///////////////////// End devices
+    out.Put<uint32_t>(m_endDevices.GetN());
+    for (auto node = m_endDevices.Begin(); node != m_endDevices.End(); ++node)
+    {
+        auto mac = DynamicCast<ClassAEndDeviceLorawanMac>(GetLorawanMac(*node));
+        NS_ABORT_MSG_UNLESS(mac, "Node " << (*node)->GetId() << " is not a class A end device");
+        out.Put<uint32_t>(mac->GetDeviceAddress().Get());
+        out.Put<uint8_t>(mac->GetDataRate());
+        out.Put<uint8_t>(mac->GetTransmissionPower());
+        out.Put<uint8_t>(mac->GetNumberOfTransmissions());
+        out.Put<double>(mac->GetAggregatedDutyCycle());
+        out.Put<uint16_t>(mac->GetFCnt());
+        out.Put<uint16_t>(mac->GetAdrAckCounter());
+        out.Put<uint8_t>(mac->GetAdrAckRequest());
+        out.Put<uint8_t>(mac->GetRx1DrOffset());
+        out.Put<uint8_t>(mac->GetSecondReceiveWindowDataRate());
+        out.Put<double>(mac->GetSecondReceiveWindowFrequency());
+        out.PutDuration(mac->GetRx1Delay());
+
+        // Pending answers, in their uplink encoding
+        const MacCommandList& commands = mac->GetPendingMacCommands();
+        std::vector<uint8_t> bytes(commands.GetSerializedSize());
+        uint8_t* p = bytes.data();
+        for (const auto& command : commands)
+        {
+            command.Serialize(p);
+            p += command.GetSerializedSize();
+        }
+        out.PutBytes(bytes.data(), bytes.size());
+
+        SaveChannels(out, mac->GetLogicalChannelManager());
+
+        // Next send of each application, negative if none
+        std::vector<Time> delays;
+        for (uint32_t i = 0; i < (*node)->GetNApplications(); ++i)
+        {
+            if (auto app = DynamicCast<LoraApplication>((*node)->GetApplication(i)))
+            {
+                delays.push_back(app->GetNextSendDelay());
+            }
+        }
+        out.Put<uint32_t>(delays.size());
+        for (const auto& delay : delays)
+        {
+            out.PutDuration(delay);
+        }
+    }
+
+    ///////////////////// Gateways
+    out.Put<uint32_t>(m_gateways.GetN());
+    for (auto node = m_gateways.Begin(); node != m_gateways.End(); ++node)
+    {
+        SaveChannels(out, GetLorawanMac(*node)->GetLogicalChannelManager());
+    }
+
+    ///////////////////// Network server
+    if (m_networkServer)
+    {
+        const auto& statuses = m_networkServer->GetNetworkStatus()->m_endDeviceStatuses;
+        out.Put<uint32_t>(statuses.size());
+        for (const auto& [address, status] : statuses)
+        {
+            out.Put<uint32_t>(address.Get());
+            out.Put<uint8_t>(status->GetFirstReceiveWindowDataRate());
+            out.Put<double>(status->GetFirstReceiveWindowFrequency());
+            out.Put<uint8_t>(status->GetSecondReceiveWindowDataRate());
+            out.Put<double>(status->GetSecondReceiveWindowFrequency());
+            const auto& received = status->GetReceivedPacketList();
+            out.Put<uint32_t>(received.size());
+            for (const auto& [packet, info] : received)
+            {
+                out.PutPacket(packet, false);
+                out.Put<uint8_t>(info.sf);
+                out.Put<double>(info.frequency);
+                out.Put<uint32_t>(info.gwList.size());
+                for (const auto& [gwAddress, gwInfo] : info.gwList)
+                {
+                    uint8_t buffer[Address::MAX_SIZE + 2];
+                    uint32_t size = gwAddress.CopyAllTo(buffer, sizeof(buffer));
+                    out.PutBytes(buffer, size);
+                    out.PutTime(gwInfo.receivedTime);
+                    out.Put<double>(gwInfo.rxPower);
+                }
+            }
+        }
+    }
+    else
+    {
+        out.Put<uint32_t>(0);
+    }
+
+    ///////////////////// Packet tracker
+    out.Put<uint8_t>(m_tracker != nullptr);
+    if (m_tracker)
+    {
+        // Records of the same packet share an entry of the packet table
+        std::unordered_map<const Packet*, uint32_t> ids;
+        std::vector<Ptr<const Packet>> packets;
+        auto id = [&ids, &packets](Ptr<const Packet> packet) {
+            auto [it, inserted] = ids.emplace(PeekPointer(packet), packets.size());
+            if (inserted)
+            {
+                packets.push_back(packet);
+            }
+            return it->second;
+        };
+        for (const auto& record : m_tracker->m_packetTracker)
+        {
+            id(record.first);
+        }
+        for (const auto& record : m_tracker->m_macPacketTracker)
+        {
+            id(record.first);
+        }
+        for (const auto& record : m_tracker->m_reTransmissionTracker)
+        {
+            id(record.first);
+        }
+        out.Put<uint32_t>(packets.size());
+        for (const auto& packet : packets)
+        {
+            out.PutPacket(packet, true);
+        }
+
+        out.Put<uint32_t>(m_tracker->m_packetTracker.size());
+        for (const auto& [packet, status] : m_tracker->m_packetTracker)
+        {
+            out.Put<uint32_t>(id(packet));
+            out.Put<uint32_t>(status.senderId);
+            out.PutTime(status.sendTime);
+            out.Put<uint32_t>(status.outcomes.size());
+            for (const auto& [gw, outcome] : status.outcomes)
+            {
+                out.Put<int32_t>(gw);
+                out.Put<uint8_t>(outcome);
+            }
+        }
+        out.Put<uint32_t>(m_tracker->m_macPacketTracker.size());
+        for (const auto& [packet, status] : m_tracker->m_macPacketTracker)
+        {
+            out.Put<uint32_t>(id(packet));
+            out.Put<uint32_t>(status.senderId);
+            out.PutTime(status.sendTime);
+            out.PutTime(status.receivedTime);
+            out.Put<uint32_t>(status.receptionTimes.size());
+            for (const auto& [gw, time] : status.receptionTimes)
+            {
+                out.Put<int32_t>(gw);
+                out.PutTime(time);
+            }
+        }
+        out.Put<uint32_t>(m_tracker->m_reTransmissionTracker.size());
+        for (const auto& [packet, status] : m_tracker->m_reTransmissionTracker)
+        {
+            out.Put<uint32_t>(id(packet));
+            out.PutTime(status.firstAttempt);
+            out.PutTime(status.finishTime);
+            out.Put<uint8_t>(status.reTxAttempts);
+            out.Put<uint8_t>(status.successful);
+        }
+        out.PutTime(m_tracker->m_lastPacketCleanup);
+    }
+
+    // Write to a temporary file, then rename: concurrent runs never see partial checkpoints
+    std::string tmpPath = filename + ".tmp." + std::to_string(getpid());
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    file.write(out.GetBuffer().data(), out.GetBuffer().size());
+    file.close();
+    if (!file.good() || std::rename(tmpPath.c_str(), filename.c_str()) != 0)
+    {
+        NS_LOG_WARN("Could not write checkpoint " << filename);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    NS_LOG_DEBUG("Saved checkpoint " << filename << " (" << out.GetBuffer().size() << " bytes)");
+    return true;
+}
+
+bool
+NetworkCheckpointHelper::Restore(const std::string& filename) const
+{
+    NS_LOG_FUNCTION(this << filename);
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        NS_LOG_DEBUG("No checkpoint " << filename);
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+    CheckpointReader in(buffer, Simulator::Now());
+    for (char c : CHECKPOINT_MAGIC)
+    {
+        if (in.Get<char>() != c)
+        {
+            NS_LOG_WARN(filename << " is not a checkpoint");
+            return false;
+        }
+    }
+    Time savedAt = NanoSeconds(in.Get<int64_t>());
+    NS_LOG_DEBUG("Restoring checkpoint saved at " << savedAt.As(Time::S));
+
+    ///////////////////// End devices
+    NS_ABORT_MSG_IF(in.Get<uint32_t>() != m_endDevices.GetN(),
+                    "Checkpoint has a different number of end devices");
+    for (auto node = m_endDevices.Begin(); node != m_endDevices.End() && in.IsValid(); ++node)
+    {
+        auto mac = DynamicCast<ClassAEndDeviceLorawanMac>(GetLorawanMac(*node));
+        NS_ABORT_MSG_UNLESS(mac, "Node " << (*node)->GetId() << " is not a class A end device");
+        NS_ABORT_MSG_IF(in.Get<uint32_t>() != mac->GetDeviceAddress().Get(),
+                        "Checkpoint has a different address for node " << (*node)->GetId());
+        mac->SetDataRate(in.Get<uint8_t>());
+        mac->SetTransmissionPower(in.Get<uint8_t>());
+        mac->SetNumberOfTransmissions(in.Get<uint8_t>());
+        mac->SetAggregatedDutyCycle(in.Get<double>());
+        mac->SetFCnt(in.Get<uint16_t>());
+        uint16_t adrAckCounter = in.Get<uint16_t>();
+        mac->SetAdrAckCounter(adrAckCounter, in.Get<uint8_t>());
+        mac->SetRx1DrOffset(in.Get<uint8_t>());
+        mac->SetSecondReceiveWindowDataRate(in.Get<uint8_t>());
+        mac->SetSecondReceiveWindowFrequency(in.Get<double>());
+        mac->SetRx1Delay(in.GetDuration());
+
+        std::vector<uint8_t> bytes = in.GetBytes();
+        MacCommandList commands;
+        NS_ABORT_MSG_UNLESS(
+            LorawanFrameCodec::DecodeMacCommands(bytes.data(), bytes.size(), true, commands),
+            "Checkpoint has invalid MAC commands for node " << (*node)->GetId());
+        mac->ClearMacCommands();
+        for (const auto& command : commands)
+        {
+            mac->AddMacCommand(command);
+        }
+
+        RestoreChannels(in, mac->GetLogicalChannelManager());
+
+        std::vector<Ptr<LoraApplication>> apps;
+        for (uint32_t i = 0; i < (*node)->GetNApplications(); ++i)
+        {
+            if (auto app = DynamicCast<LoraApplication>((*node)->GetApplication(i)))
+            {
+                apps.push_back(app);
+            }
+        }
+        NS_ABORT_MSG_IF(in.Get<uint32_t>() != apps.size(),
+                        "Checkpoint has a different number of applications for node "
+                            << (*node)->GetId());
+        for (const auto& app : apps)
+        {
+            Time delay = in.GetDuration();
+            if (!delay.IsNegative())
+            {
+                app->SetNextSendDelay(delay);
+            }
+        }
+    }
+
+    ///////////////////// Gateways
+    NS_ABORT_MSG_IF(in.Get<uint32_t>() != m_gateways.GetN(),
+                    "Checkpoint has a different number of gateways");
+    for (auto node = m_gateways.Begin(); node != m_gateways.End() && in.IsValid(); ++node)
+    {
+        RestoreChannels(in, GetLorawanMac(*node)->GetLogicalChannelManager());
+    }
+
+    ///////////////////// Network server
+    uint32_t nStatuses = in.Get<uint32_t>();
+    NS_ABORT_MSG_IF(nStatuses && !m_networkServer, "Checkpoint has a network server");
+    for (uint32_t i = 0; i < nStatuses && in.IsValid(); ++i)
+    {
+        LoraDeviceAddress address(in.Get<uint32_t>());
+        Ptr<EndDeviceStatus> status =
+            m_networkServer->GetNetworkStatus()->GetEndDeviceStatus(address);
+        NS_ABORT_MSG_UNLESS(status, "Device " << address << " is unknown to the network server");
+        status->SetFirstReceiveWindowDataRate(in.Get<uint8_t>());
+        status->SetFirstReceiveWindowFrequency(in.Get<double>());
+        status->SetSecondReceiveWindowDataRate(in.Get<uint8_t>());
+        status->SetSecondReceiveWindowFrequency(in.Get<double>());
+        status->ClearReceivedPacketList();
+        uint32_t nReceived = in.Get<uint32_t>();
+        for (uint32_t j = 0; j < nReceived && in.IsValid(); ++j)
+        {
+            Ptr<Packet> packet = in.GetPacket(false);
+            EndDeviceStatus::ReceivedPacketInfo info;
+            info.sf = in.Get<uint8_t>();
+            info.frequency = in.Get<double>();
+            uint32_t nGateways = in.Get<uint32_t>();
+            for (uint32_t k = 0; k < nGateways && in.IsValid(); ++k)
+            {
+                std::vector<uint8_t> addressBytes = in.GetBytes();
+                EndDeviceStatus::PacketInfoPerGw gwInfo;
+                if (addressBytes.size() >= 2 && addressBytes.size() <= Address::MAX_SIZE + 2)
+                {
+                    gwInfo.gwAddress.CopyAllFrom(addressBytes.data(), addressBytes.size());
+                }
+                gwInfo.receivedTime = in.GetTime();
+                gwInfo.rxPower = in.Get<double>();
+                info.gwList.emplace(gwInfo.gwAddress, gwInfo);
+            }
+            status->AppendReceivedPacket(packet, info);
+        }
+    }
+
+    ///////////////////// Packet tracker
+    if (in.Get<uint8_t>() && m_tracker)
+    {
+        m_tracker->m_packetTracker.clear();
+        m_tracker->m_macPacketTracker.clear();
+        m_tracker->m_reTransmissionTracker.clear();
+
+        uint32_t nPackets = in.Get<uint32_t>();
+        std::vector<Ptr<Packet>> packets;
+        for (uint32_t i = 0; i < nPackets && in.IsValid(); ++i)
+        {
+            packets.push_back(in.GetPacket(true));
+        }
+        auto packet = [&packets](uint32_t id) {
+            if (id >= packets.size())
+            {
+                NS_ABORT_MSG("Checkpoint has an invalid packet record");
+            }
+            return packets[id];
+        };
+
+        uint32_t nRecords = in.Get<uint32_t>();
+        for (uint32_t i = 0; i < nRecords && in.IsValid(); ++i)
+        {
+            PacketStatus status;
+            status.packet = packet(in.Get<uint32_t>());
+            status.senderId = in.Get<uint32_t>();
+            status.sendTime = in.GetTime();
+            uint32_t nOutcomes = in.Get<uint32_t>();
+            for (uint32_t j = 0; j < nOutcomes && in.IsValid(); ++j)
+            {
+                int gw = in.Get<int32_t>();
+                status.outcomes[gw] = PhyPacketOutcome(in.Get<uint8_t>());
+            }
+            m_tracker->m_packetTracker.emplace(status.packet, status);
+        }
+        nRecords = in.Get<uint32_t>();
+        for (uint32_t i = 0; i < nRecords && in.IsValid(); ++i)
+        {
+            MacPacketStatus status;
+            status.packet = packet(in.Get<uint32_t>());
+            status.senderId = in.Get<uint32_t>();
+            status.sendTime = in.GetTime();
+            status.receivedTime = in.GetTime();
+            uint32_t nReceptions = in.Get<uint32_t>();
+            for (uint32_t j = 0; j < nReceptions && in.IsValid(); ++j)
+            {
+                int gw = in.Get<int32_t>();
+                status.receptionTimes[gw] = in.GetTime();
+            }
+            m_tracker->m_macPacketTracker.emplace(status.packet, status);
+        }
+        nRecords = in.Get<uint32_t>();
+        for (uint32_t i = 0; i < nRecords && in.IsValid(); ++i)
+        {
+            Ptr<const Packet> key = packet(in.Get<uint32_t>());
+            RetransmissionStatus status;
+            status.firstAttempt = in.GetTime();
+            status.finishTime = in.GetTime();
+            status.reTxAttempts = in.Get<uint8_t>();
+            status.successful = in.Get<uint8_t>();
+            m_tracker->m_reTransmissionTracker.emplace(key, status);
+        }
+        m_tracker->m_lastPacketCleanup = in.GetTime();
+    }
+
+    NS_ABORT_MSG_UNLESS(in.IsValid(), "Checkpoint " << filename << " is truncated");
+    return true;
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef NETWORK_CHECKPOINT_HELPER_H
+#define NETWORK_CHECKPOINT_HELPER_H
+
+#include "ns3/lora-packet-tracker.h"
+#include "ns3/network-server.h"
+#include "ns3/node-container.h"
+
+#include <string>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * This class saves the state reached by a network in a compact binary file,
+ * and restores it in a later run with the same topology, so that the warm-up
+ * (ADR convergence, duty-cycle backoffs, randomized application phases) is
+ * simulated once per campaign instead of once per run.
+ *
+ * A checkpoint contains, for each end device: the MAC parameters (data rate,
+ * transmission power, NbTrans, aggregated duty cycle, FCnt, ADR_ACK_CNT,
+ * receive window parameters, pending MAC answers), the channel mask and the
+ * duty-cycle state of the sub-bands, and the delay to the next send of each
+ * LoraApplication. It also contains the duty-cycle state of the gateways, the
+ * EndDeviceStatus of each device at the network server (receive window
+ * parameters and received packet history), and the packet tracker records.
+ *
+ * Times are saved relative to the time of the Save call, and restored
+ * relative to the time of the Restore call: e.g., a device that could send
+ * again 10 s after the checkpoint can send again 10 s after the restore.
+ *
+ * Transmissions in progress (i.e., the retransmission context of the MAC,
+ * pending replies of the network server) are not saved: checkpoints are meant
+ * to be taken at the end of the warm-up, and restored before the applications
+ * start. Random variable streams are not saved either.
+ */
+class NetworkCheckpointHelper
+{
+  public:
+    NetworkCheckpointHelper();
+    ~NetworkCheckpointHelper();
+
+    /**
+     * Set the end devices to checkpoint. They are matched by position in the
+     * container, and checked by device address.
+     */
+    void SetEndDevices(NodeContainer endDevices);
+
+    /**
+     * Set the gateways to checkpoint, matched by position in the container.
+     */
+    void SetGateways(NodeContainer gateways);
+
+    /**
+     * Set the network server to checkpoint.
+     */
+    void SetNetworkServer(Ptr<NetworkServer> networkServer);
+
+    /**
+     * Set the packet tracker to checkpoint.
+     */
+    void SetPacketTracker(LoraPacketTracker& tracker);
+
+    /**
+     * Save the state of the network.
+     *
+     * \param filename The path of the checkpoint file.
+     * \return Whether the checkpoint was written.
+     */
+    bool Save(const std::string& filename) const;
+
+    /**
+     * Restore the state of the network.
+     *
+     * The network must have been built as in the run that saved the
+     * checkpoint. The simulation aborts if the topology does not match.
+     *
+     * \param filename The path of the checkpoint file.
+     * \return Whether the checkpoint was read, false if the file is missing or
+     *         is not a checkpoint.
+     */
+    bool Restore(const std::string& filename) const;
+
+  private:
+    NodeContainer m_endDevices;         //!< End devices to checkpoint
+    NodeContainer m_gateways;           //!< Gateways to checkpoint
+    Ptr<NetworkServer> m_networkServer; //!< Network server to checkpoint, if any
+    LoraPacketTracker* m_tracker;       //!< Packet tracker to checkpoint, if any
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* NETWORK_CHECKPOINT_HELPER_H */
@@ -32,6 +32,7 @@
 #include "ns3/simulator.h"
 #include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/udp-network-server.h"
 
 namespace ns3
 {
@@ -57,6 +58,12 @@ NetworkServerHelper::SetAttribute(std::string name, const AttributeValue& value)
     m_factory.Set(name, value);
 }
 
+void
+NetworkServerHelper::SetType(std::string type)
+{
+    m_factory.SetTypeId(type);
+}
+
 void
 NetworkServerHelper::SetEndDevices(NodeContainer endDevices)
 {
@@ -91,25 +98,29 @@ NetworkServerHelper::InstallPriv(Ptr<Node> node)
     app->SetNode(node);
     node->AddApplication(app);
 
-    for (uint32_t i = 0; i < node->GetNDevices(); i++)
+    // Gateways of a UdpNetworkServer register themselves via the forwarder protocol
+    if (!DynamicCast<UdpNetworkServer>(app))
     {
-        // Link the NetworkServer app to its NetDevices
-        Ptr<NetDevice> currentNetDevice = node->GetDevice(i);
-        currentNetDevice->SetReceiveCallback(MakeCallback(&NetworkServer::Receive, app));
-
-        // Register gateways
-        Ptr<Channel> channel = currentNetDevice->GetChannel();
-        NS_ASSERT_MSG(bool(DynamicCast<PointToPointChannel>(channel)),
-                      "Connection with gateways is not PointToPoint");
-        for (uint32_t j = 0; j < channel->GetNDevices(); ++j)
+        for (uint32_t i = 0; i < node->GetNDevices(); i++)
         {
-            Ptr<Node> gwNode = channel->GetDevice(j)->GetNode();
-            // Point to point, so channel only holds 2 devices
-            if (gwNode->GetId() != node->GetId())
+            // Link the NetworkServer app to its NetDevices
+            Ptr<NetDevice> currentNetDevice = node->GetDevice(i);
+            currentNetDevice->SetReceiveCallback(MakeCallback(&NetworkServer::Receive, app));
+
+            // Register gateways
+            Ptr<Channel> channel = currentNetDevice->GetChannel();
+            NS_ASSERT_MSG(bool(DynamicCast<PointToPointChannel>(channel)),
+                          "Connection with gateways is not PointToPoint");
+            for (uint32_t j = 0; j < channel->GetNDevices(); ++j)
             {
-                // Add the gateway to the NS list
-                app->AddGateway(gwNode, currentNetDevice);
-                break;
+                Ptr<Node> gwNode = channel->GetDevice(j)->GetNode();
+                // Point to point, so channel only holds 2 devices
+                if (gwNode->GetId() != node->GetId())
+                {
+                    // Add the gateway to the NS list
+                    app->AddGateway(gwNode, currentNetDevice);
+                    break;
+                }
             }
         }
     }
@@ -53,6 +53,12 @@ class NetworkServerHelper
 
     void SetAttribute(std::string name, const AttributeValue& value);
 
+    /**
+     * Set the type of Network Server application to install, e.g.
+     * ns3::UdpNetworkServer to serve UdpForwarder gateways.
+     */
+    void SetType(std::string type);
+
     ApplicationContainer Install(NodeContainer c);
 
     ApplicationContainer Install(Ptr<Node> node);
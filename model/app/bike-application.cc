@@ -76,11 +76,9 @@ BikeApplication::StartApplication(void)
 {
     NS_LOG_FUNCTION(this);
     // Schedule the next SendPacket event
-    Simulator::Cancel(m_sendEvent);
     NS_LOG_DEBUG("Starting up application with a first event with a " << m_initialDelay.GetSeconds()
                                                                       << " seconds delay");
-    m_sendEvent = Simulator::Schedule(m_initialDelay, &BikeApplication::SendPacket, this);
-    NS_LOG_INFO("Event Id: " << m_sendEvent.GetUid());
+    ScheduleSend(m_initialDelay);
 }
 
 void
@@ -94,7 +92,7 @@ BikeApplication::SendPacket(void)
     if (waypointsLeft == 0 && m_mobility->GetVelocity() == Vector3D(0, 0, 0))
     {
         // No more trips for this bike
-        Simulator::Cancel(m_sendEvent);
+        CancelSend();
         return;
     }
 
@@ -104,7 +102,7 @@ BikeApplication::SendPacket(void)
         Time now = Simulator::Now();
         Time next =
             m_mobility->GetNextWaypoint().time; // next > now is ensured by WaypointMobilityModel
-        m_sendEvent = Simulator::Schedule(next - now, &BikeApplication::SendPacket, this);
+        ScheduleSend(next - now);
         return;
     }
 
@@ -113,7 +111,7 @@ BikeApplication::SendPacket(void)
     NS_LOG_DEBUG("Sending a packet of app payload size " << packet->GetSize());
     m_mac->Send(packet);
     // Schedule the next SendPacket event
-    m_sendEvent = Simulator::Schedule(m_avgInterval, &BikeApplication::SendPacket, this);
+    ScheduleSend(m_avgInterval);
 }
 
 } // namespace lorawan
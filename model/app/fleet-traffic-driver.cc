@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "fleet-traffic-driver.h"
+
+#include "ns3/log.h"
+#include "ns3/lora-application.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("FleetTrafficDriver");
+
+NS_OBJECT_ENSURE_REGISTERED(FleetTrafficDriver);
+
+namespace
+{
+/* Arity of the heap: shallower than a binary heap, and siblings share cache lines */
+constexpr uint32_t ARITY = 4;
+} // namespace
+
+TypeId
+FleetTrafficDriver::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FleetTrafficDriver")
+                            .SetParent<Object>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<FleetTrafficDriver>();
+    return tid;
+}
+
+FleetTrafficDriver::FleetTrafficDriver()
+    : m_seq(0),
+      m_nApps(0),
+      m_eventTime(0),
+      m_firing(false)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+FleetTrafficDriver::~FleetTrafficDriver()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+FleetTrafficDriver::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    m_heap.clear();
+    for (auto& entry : m_entries)
+    {
+        entry.pos = NOT_PENDING;
+    }
+    Object::DoDispose();
+}
+
+void
+FleetTrafficDriver::Add(ApplicationContainer apps)
+{
+    NS_LOG_FUNCTION(this);
+    for (auto it = apps.Begin(); it != apps.End(); ++it)
+    {
+        if (auto app = DynamicCast<LoraApplication>(*it); app)
+        {
+            app->SetFleetTrafficDriver(this);
+        }
+    }
+    NS_LOG_INFO("Driving the traffic of " << m_nApps << " applications");
+}
+
+uint32_t
+FleetTrafficDriver::GetNApplications() const
+{
+    return m_nApps;
+}
+
+uint32_t
+FleetTrafficDriver::GetNPending() const
+{
+    return m_heap.size();
+}
+
+uint32_t
+FleetTrafficDriver::Register(LoraApplication* app)
+{
+    NS_LOG_FUNCTION(this << app);
+    uint32_t id;
+    if (!m_free.empty())
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        id = m_entries.size();
+        m_entries.emplace_back();
+    }
+    m_entries[id] = {0, 0, app, NOT_PENDING};
+    m_nApps++;
+    return id;
+}
+
+void
+FleetTrafficDriver::Unregister(uint32_t id)
+{
+    NS_LOG_FUNCTION(this << id);
+    NS_ASSERT(id < m_entries.size() && m_entries[id].app);
+    Cancel(id);
+    m_entries[id].app = nullptr;
+    m_free.push_back(id);
+    m_nApps--;
+}
+
+void
+FleetTrafficDriver::Schedule(uint32_t id, Time delay)
+{
+    NS_LOG_FUNCTION(this << id << delay);
+    NS_ASSERT_MSG(!delay.IsStrictlyNegative(), "Cannot schedule a send in the past");
+    Entry& entry = m_entries[id];
+    entry.time = (Simulator::Now() + delay).GetTimeStep();
+    entry.seq = m_seq++;
+    if (entry.pos == NOT_PENDING)
+    {
+        m_heap.push_back(id);
+        entry.pos = m_heap.size() - 1;
+        SiftUp(entry.pos);
+    }
+    else
+    {
+        // Replaced send: the new time may be earlier or later than the old one
+        SiftUp(entry.pos);
+        SiftDown(entry.pos);
+    }
+    UpdateEvent();
+}
+
+void
+FleetTrafficDriver::Cancel(uint32_t id)
+{
+    NS_LOG_FUNCTION(this << id);
+    if (m_entries[id].pos == NOT_PENDING)
+    {
+        return;
+    }
+    Remove(id);
+    UpdateEvent();
+}
+
+bool
+FleetTrafficDriver::IsPending(uint32_t id) const
+{
+    return m_entries[id].pos != NOT_PENDING;
+}
+
+Time
+FleetTrafficDriver::GetDelayLeft(uint32_t id) const
+{
+    if (!IsPending(id))
+    {
+        return Seconds(0);
+    }
+    return TimeStep(m_entries[id].time) - Simulator::Now();
+}
+
+void
+FleetTrafficDriver::Fire()
+{
+    NS_LOG_FUNCTION(this);
+    int64_t now = Simulator::Now().GetTimeStep();
+    m_firing = true;
+    while (!m_heap.empty() && m_entries[m_heap[0]].time <= now)
+    {
+        uint32_t id = m_heap[0];
+        Remove(id);
+        // The application schedules its next send through this driver
+        m_entries[id].app->SendPacket();
+    }
+    m_firing = false;
+    UpdateEvent();
+}
+
+void
+FleetTrafficDriver::UpdateEvent()
+{
+    if (m_firing)
+    {
+        return;
+    }
+    if (m_heap.empty())
+    {
+        m_event.Cancel();
+        return;
+    }
+    int64_t next = m_entries[m_heap[0]].time;
+    if (m_event.IsRunning() && m_eventTime == next)
+    {
+        return;
+    }
+    m_event.Cancel();
+    m_eventTime = next;
+    m_event =
+        Simulator::Schedule(TimeStep(next) - Simulator::Now(), &FleetTrafficDriver::Fire, this);
+}
+
+bool
+FleetTrafficDriver::Before(uint32_t a, uint32_t b) const
+{
+    const Entry& ea = m_entries[a];
+    const Entry& eb = m_entries[b];
+    return ea.time < eb.time || (ea.time == eb.time && ea.seq < eb.seq);
+}
+
+void
+FleetTrafficDriver::Place(uint32_t pos, uint32_t id)
+{
+    m_heap[pos] = id;
+    m_entries[id].pos = pos;
+}
+
+void
+FleetTrafficDriver::SiftUp(uint32_t pos)
+{
+    uint32_t id = m_heap[pos];
+    while (pos > 0)
+    {
+        uint32_t parent = (pos - 1) / ARITY;
+        if (!Before(id, m_heap[parent]))
+        {
+            break;
+        }
+        Place(pos, m_heap[parent]);
+        pos = parent;
+    }
+    Place(pos, id);
+}
+
+void
+FleetTrafficDriver::SiftDown(uint32_t pos)
+{
+    uint32_t id = m_heap[pos];
+    uint32_t size = m_heap.size();
+    while (true)
+    {
+        uint32_t first = pos * ARITY + 1;
+        if (first >= size)
+        {
+            break;
+        }
+        uint32_t last = std::min(first + ARITY, size);
+        uint32_t best = first;
+        for (uint32_t child = first + 1; child < last; ++child)
+        {
+            if (Before(m_heap[child], m_heap[best]))
+            {
+                best = child;
+            }
+        }
+        if (!Before(m_heap[best], id))
+        {
+            break;
+        }
+        Place(pos, m_heap[best]);
+        pos = best;
+    }
+    Place(pos, id);
+}
+
+void
+FleetTrafficDriver::Remove(uint32_t id)
+{
+    uint32_t pos = m_entries[id].pos;
+    uint32_t last = m_heap.back();
+    m_heap.pop_back();
+    m_entries[id].pos = NOT_PENDING;
+    if (last == id)
+    {
+        return;
+    }
+    Place(pos, last);
+    // The moved entry may belong either above or below its new position
+    SiftUp(pos);
+    SiftDown(m_entries[last].pos);
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef FLEET_TRAFFIC_DRIVER_H
+#define FLEET_TRAFFIC_DRIVER_H
+
+#include "ns3/application-container.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+class LoraApplication;
+
+/**
+ * Single scheduler entity driving the send events of many LoraApplication.
+ *
+ * By default, every device application keeps its own pending event in the
+ * global simulator queue. Applications added to a fleet driver instead record
+ * their next send time in a compact indexed 4-ary heap, and only the earliest
+ * of them is scheduled in the simulator. Send times, packet sizes and random
+ * variable draws are left to the applications, so traffic is the same as with
+ * standalone applications. Applications due at the same time are served in
+ * the order in which they were scheduled, like simulator events.
+ */
+class FleetTrafficDriver : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    FleetTrafficDriver();
+    ~FleetTrafficDriver() override;
+
+    /**
+     * Drive the send events of all LoraApplication in the container.
+     *
+     * Pending send events of running applications are moved to the driver.
+     *
+     * \param apps The applications.
+     */
+    void Add(ApplicationContainer apps);
+
+    /**
+     * Get the number of applications registered with this driver.
+     */
+    uint32_t GetNApplications() const;
+
+    /**
+     * Get the number of applications with a pending send.
+     */
+    uint32_t GetNPending() const;
+
+    /**
+     * Register an application (called by LoraApplication).
+     *
+     * \param app The application.
+     * \return The identifier of the application within the driver.
+     */
+    uint32_t Register(LoraApplication* app);
+
+    /**
+     * Unregister an application, cancelling its pending send.
+     *
+     * \param id The identifier returned by Register.
+     */
+    void Unregister(uint32_t id);
+
+    /**
+     * Schedule the next send of an application, replacing the pending one.
+     *
+     * \param id The identifier returned by Register.
+     * \param delay Delay from now of the send.
+     */
+    void Schedule(uint32_t id, Time delay);
+
+    /**
+     * Cancel the pending send of an application, if any.
+     *
+     * \param id The identifier returned by Register.
+     */
+    void Cancel(uint32_t id);
+
+    /**
+     * Check whether an application has a pending send.
+     *
+     * \param id The identifier returned by Register.
+     */
+    bool IsPending(uint32_t id) const;
+
+    /**
+     * Get the time left before the pending send of an application.
+     *
+     * \param id The identifier returned by Register.
+     */
+    Time GetDelayLeft(uint32_t id) const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * An application slot.
+     */
+    struct Entry
+    {
+        int64_t time;         //!< Time step of the next send
+        uint64_t seq;         //!< Scheduling order, to break ties
+        LoraApplication* app; //!< The application, nullptr if the slot is free
+        uint32_t pos;         //!< Position in the heap, NOT_PENDING if none
+    };
+
+    static constexpr uint32_t NOT_PENDING = UINT32_MAX;
+
+    /**
+     * Serve all applications due now, then schedule the next wake-up.
+     */
+    void Fire();
+
+    /**
+     * Align the simulator event with the earliest pending send.
+     */
+    void UpdateEvent();
+
+    bool Before(uint32_t a, uint32_t b) const; //!< Heap order between two entries
+    void Place(uint32_t pos, uint32_t id);     //!< Put an entry at a heap position
+    void SiftUp(uint32_t pos);                 //!< Restore the heap upwards
+    void SiftDown(uint32_t pos);               //!< Restore the heap downwards
+    void Remove(uint32_t id);                  //!< Remove a pending entry from the heap
+
+    std::vector<Entry> m_entries; //!< Application slots
+    std::vector<uint32_t> m_free; //!< Free slots
+    std::vector<uint32_t> m_heap; //!< 4-ary min-heap of pending slots
+    uint64_t m_seq;               //!< Next scheduling order
+    uint32_t m_nApps;             //!< Registered applications
+    EventId m_event;              //!< Wake-up event in the simulator
+    int64_t m_eventTime;          //!< Time step of the wake-up event
+    bool m_firing;                //!< Serving due applications
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* FLEET_TRAFFIC_DRIVER_H */
@@ -0,0 +1,758 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "host-udp-socket.h"
+
+#include "ns3/log.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("HostUdpSocket");
+
+NS_OBJECT_ENSURE_REGISTERED(HostUdpSocket);
+
+/* Largest datagram read from the host, and maximum datagrams read per call */
+#define HOST_UDP_MAX_DGRAM 2048
+#define HOST_UDP_RX_BATCH 16
+
+namespace
+{
+/* What the reception thread needs to know about a registered socket */
+struct Endpoint
+{
+    int fd;           //!< Host socket descriptor
+    uint32_t context; //!< Context of the reception events
+};
+
+/* State shared by all host sockets. Apart from the endpoints, which are
+ * guarded by their mutex, it is accessed in the simulator thread. Sockets are
+ * known by identifier, so that events in flight for a closed socket are not
+ * handed to a later one reusing its descriptor */
+std::map<uint64_t, HostUdpSocket*> g_sockets; //!< Open sockets by identifier
+std::map<uint64_t, Endpoint> g_endpoints;     //!< Open sockets, for the reception thread
+std::mutex g_endpointsMutex;                  //!< Guards g_endpoints
+uint64_t g_nextId = 1;                        //!< Identifier of the next socket (0: wake up)
+std::vector<HostUdpSocket*> g_pendingTx;      //!< Sockets with datagrams to flush
+EventId g_flushEvent;                         //!< Flush of the pending datagrams
+std::thread g_reader;                         //!< Reception thread
+int g_epollFd = -1;                           //!< Descriptor polled by the reception thread
+int g_wakeFd = -1;                            //!< Event descriptor stopping the reader
+} // namespace
+
+TypeId
+HostUdpSocket::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HostUdpSocket")
+            .SetParent<Socket>()
+            .SetGroupName("lorawan")
+            .AddConstructor<HostUdpSocket>()
+            .AddAttribute("RcvBufSize",
+                          "Maximum bytes of received datagrams waiting to be read",
+                          UintegerValue(131072),
+                          MakeUintegerAccessor(&HostUdpSocket::m_rcvBufSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxBatch",
+                          "Maximum number of datagrams handed to the host in a single "
+                          "sendmmsg call",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&HostUdpSocket::m_maxBatch),
+                          MakeUintegerChecker<uint32_t>(1, 1024));
+    return tid;
+}
+
+HostUdpSocket::HostUdpSocket()
+    : m_fd(-1),
+      m_id(0),
+      m_waitWritable(false),
+      m_errno(ERROR_NOTERROR),
+      m_connected(false),
+      m_peer(Ipv4Address::GetAny(), 0),
+      m_shutdownSend(false),
+      m_shutdownRecv(false),
+      m_allowBroadcast(false),
+      m_rcvBufSize(131072),
+      m_maxBatch(64),
+      m_rxAvailable(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HostUdpSocket::~HostUdpSocket()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+}
+
+void
+HostUdpSocket::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+    m_node = nullptr;
+    Socket::DoDispose();
+}
+
+void
+HostUdpSocket::SetNode(Ptr<Node> node)
+{
+    NS_LOG_FUNCTION(this << node);
+    m_node = node;
+}
+
+Socket::SocketErrno
+HostUdpSocket::GetErrno() const
+{
+    return m_errno;
+}
+
+Socket::SocketType
+HostUdpSocket::GetSocketType() const
+{
+    return NS3_SOCK_DGRAM;
+}
+
+Ptr<Node>
+HostUdpSocket::GetNode() const
+{
+    return m_node;
+}
+
+int
+HostUdpSocket::Bind(const Address& address)
+{
+    NS_LOG_FUNCTION(this << address);
+    if (!InetSocketAddress::IsMatchingType(address))
+    {
+        m_errno = ERROR_AFNOSUPPORT;
+        return -1;
+    }
+    return DoBind(InetSocketAddress::ConvertFrom(address));
+}
+
+int
+HostUdpSocket::Bind()
+{
+    NS_LOG_FUNCTION(this);
+    // Port 0: the host picks an ephemeral source port
+    return DoBind(InetSocketAddress(Ipv4Address::GetAny(), 0));
+}
+
+int
+HostUdpSocket::Bind6()
+{
+    NS_LOG_FUNCTION(this);
+    m_errno = ERROR_AFNOSUPPORT;
+    return -1;
+}
+
+int
+HostUdpSocket::DoBind(const InetSocketAddress& address)
+{
+    NS_LOG_FUNCTION(this);
+    if (m_fd >= 0)
+    {
+        m_errno = ERROR_INVAL;
+        return -1;
+    }
+
+    if (!DynamicCast<RealtimeSimulatorImpl>(Simulator::GetImplementation()))
+    {
+        NS_LOG_WARN("Simulator is not real-time: datagrams from the host will be delivered at "
+                    "arbitrary simulated times");
+    }
+
+    m_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0)
+    {
+        NS_LOG_ERROR("socket: " << std::strerror(errno));
+        m_errno = ERROR_BADF;
+        return -1;
+    }
+
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(address.GetIpv4().Get());
+    local.sin_port = htons(address.GetPort());
+    if (bind(m_fd, (sockaddr*)&local, sizeof(local)) < 0)
+    {
+        int err = errno;
+        NS_LOG_ERROR("bind: " << std::strerror(err));
+        close(m_fd);
+        m_fd = -1;
+        m_errno = (err == EADDRINUSE) ? ERROR_ADDRINUSE : ERROR_INVAL;
+        return -1;
+    }
+
+    Register(this);
+    return 0;
+}
+
+int
+HostUdpSocket::Close()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_fd < 0)
+    {
+        return 0;
+    }
+    Flush();
+    if (!m_txQueue.empty())
+    {
+        NS_LOG_WARN("Host socket closed with " << m_txQueue.size() << " datagrams unsent");
+        m_txQueue.clear();
+    }
+    g_pendingTx.erase(std::remove(g_pendingTx.begin(), g_pendingTx.end(), this),
+                      g_pendingTx.end());
+    Unregister(this);
+    close(m_fd);
+    m_fd = -1;
+    m_connected = false;
+    m_rxQueue.clear();
+    m_rxAvailable = 0;
+    return 0;
+}
+
+int
+HostUdpSocket::ShutdownSend()
+{
+    NS_LOG_FUNCTION(this);
+    m_shutdownSend = true;
+    return 0;
+}
+
+int
+HostUdpSocket::ShutdownRecv()
+{
+    NS_LOG_FUNCTION(this);
+    m_shutdownRecv = true;
+    return 0;
+}
+
+int
+HostUdpSocket::Connect(const Address& address)
+{
+    NS_LOG_FUNCTION(this << address);
+    if (!InetSocketAddress::IsMatchingType(address))
+    {
+        m_errno = ERROR_AFNOSUPPORT;
+        return -1;
+    }
+    if (m_fd < 0 && Bind() < 0)
+    {
+        return -1;
+    }
+
+    m_peer = InetSocketAddress::ConvertFrom(address);
+    sockaddr_in remote;
+    std::memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(m_peer.GetIpv4().Get());
+    remote.sin_port = htons(m_peer.GetPort());
+    if (connect(m_fd, (sockaddr*)&remote, sizeof(remote)) < 0)
+    {
+        NS_LOG_ERROR("connect: " << std::strerror(errno));
+        m_errno = ERROR_NOROUTETOHOST;
+        NotifyConnectionFailed();
+        return -1;
+    }
+    m_connected = true;
+    NotifyConnectionSucceeded();
+    return 0;
+}
+
+int
+HostUdpSocket::Listen()
+{
+    m_errno = ERROR_OPNOTSUPP;
+    return -1;
+}
+
+uint32_t
+HostUdpSocket::GetTxAvailable() const
+{
+    // Maximum UDP payload over IPv4
+    return 65507;
+}
+
+int
+HostUdpSocket::Send(Ptr<Packet> p, uint32_t flags)
+{
+    NS_LOG_FUNCTION(this << p << flags);
+    if (!m_connected)
+    {
+        m_errno = ERROR_NOTCONN;
+        return -1;
+    }
+    return Enqueue(p, nullptr);
+}
+
+int
+HostUdpSocket::SendTo(Ptr<Packet> p, uint32_t flags, const Address& toAddress)
+{
+    NS_LOG_FUNCTION(this << p << flags << toAddress);
+    if (!InetSocketAddress::IsMatchingType(toAddress))
+    {
+        m_errno = ERROR_AFNOSUPPORT;
+        return -1;
+    }
+    if (m_fd < 0 && Bind() < 0)
+    {
+        return -1;
+    }
+    InetSocketAddress to = InetSocketAddress::ConvertFrom(toAddress);
+    sockaddr_in remote;
+    std::memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(to.GetIpv4().Get());
+    remote.sin_port = htons(to.GetPort());
+    return Enqueue(p, &remote);
+}
+
+int
+HostUdpSocket::Enqueue(Ptr<Packet> p, const sockaddr_in* to)
+{
+    if (m_shutdownSend)
+    {
+        m_errno = ERROR_SHUTDOWN;
+        return -1;
+    }
+    if (p->GetSize() > GetTxAvailable())
+    {
+        m_errno = ERROR_MSGSIZE;
+        return -1;
+    }
+
+    TxDatagram dgram;
+    dgram.data.resize(p->GetSize());
+    p->CopyData(dgram.data.data(), dgram.data.size());
+    dgram.connected = (to == nullptr);
+    if (to)
+    {
+        dgram.to = *to;
+    }
+    if (m_txQueue.empty())
+    {
+        g_pendingTx.push_back(this);
+    }
+    m_txQueue.push_back(std::move(dgram));
+
+    // Flush once all events of the current instant have been executed
+    if (!g_flushEvent.IsRunning())
+    {
+        g_flushEvent = Simulator::ScheduleNow(&HostUdpSocket::FlushAll);
+    }
+
+    NotifyDataSent(p->GetSize());
+    return p->GetSize();
+}
+
+void
+HostUdpSocket::Flush()
+{
+    NS_LOG_FUNCTION(this << m_txQueue.size());
+    size_t sent = 0;
+    while (sent < m_txQueue.size())
+    {
+        size_t n = std::min<size_t>(m_maxBatch, m_txQueue.size() - sent);
+        std::vector<mmsghdr> msgs(n);
+        std::vector<iovec> iovs(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            TxDatagram& dgram = m_txQueue[sent + i];
+            iovs[i].iov_base = dgram.data.data();
+            iovs[i].iov_len = dgram.data.size();
+            std::memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (!dgram.connected)
+            {
+                msgs[i].msg_hdr.msg_name = &dgram.to;
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+        }
+
+        int res = sendmmsg(m_fd, msgs.data(), n, 0);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            // Datagram semantics: the datagram the host refused is lost
+            NS_LOG_WARN("sendmmsg: " << std::strerror(errno) << ", dropping a datagram");
+            res = 1;
+        }
+        sent += res;
+    }
+    m_txQueue.erase(m_txQueue.begin(), m_txQueue.begin() + sent);
+
+    // Send the rest once the host socket buffer has room
+    if (!m_txQueue.empty())
+    {
+        NS_LOG_DEBUG(m_txQueue.size() << " datagrams wait for the host socket");
+    }
+    SetWaitWritable(!m_txQueue.empty());
+}
+
+void
+HostUdpSocket::SetWaitWritable(bool wait)
+{
+    NS_LOG_FUNCTION(this << wait);
+    if (wait == m_waitWritable || m_fd < 0)
+    {
+        return;
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET | (wait ? EPOLLOUT : 0);
+    ev.data.u64 = m_id;
+    NS_ABORT_MSG_IF(epoll_ctl(g_epollFd, EPOLL_CTL_MOD, m_fd, &ev) < 0,
+                    "Failed to poll host socket: " << std::strerror(errno));
+    m_waitWritable = wait;
+}
+
+void
+HostUdpSocket::NotifyWritable(uint64_t id)
+{
+    NS_LOG_FUNCTION(id);
+    auto it = g_sockets.find(id);
+    if (it != g_sockets.end() && it->second->m_waitWritable)
+    {
+        it->second->Flush();
+    }
+}
+
+void
+HostUdpSocket::FlushAll()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    std::vector<HostUdpSocket*> pending;
+    pending.swap(g_pendingTx);
+    for (auto socket : pending)
+    {
+        socket->Flush();
+    }
+}
+
+uint32_t
+HostUdpSocket::GetRxAvailable() const
+{
+    return m_rxAvailable;
+}
+
+Ptr<Packet>
+HostUdpSocket::Recv(uint32_t maxSize, uint32_t flags)
+{
+    NS_LOG_FUNCTION(this << maxSize << flags);
+    Address fromAddress;
+    return RecvFrom(maxSize, flags, fromAddress);
+}
+
+Ptr<Packet>
+HostUdpSocket::RecvFrom(uint32_t maxSize, uint32_t flags, Address& fromAddress)
+{
+    NS_LOG_FUNCTION(this << maxSize << flags);
+    if (m_rxQueue.empty())
+    {
+        m_errno = ERROR_AGAIN;
+        return nullptr;
+    }
+    if (m_rxQueue.front().first->GetSize() > maxSize)
+    {
+        return nullptr;
+    }
+    Ptr<Packet> p = m_rxQueue.front().first;
+    fromAddress = m_rxQueue.front().second;
+    m_rxQueue.pop_front();
+    m_rxAvailable -= p->GetSize();
+    return p;
+}
+
+int
+HostUdpSocket::GetSockName(Address& address) const
+{
+    NS_LOG_FUNCTION(this);
+    sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (m_fd < 0 || getsockname(m_fd, (sockaddr*)&local, &len) < 0)
+    {
+        m_errno = ERROR_BADF;
+        return -1;
+    }
+    address = InetSocketAddress(Ipv4Address(ntohl(local.sin_addr.s_addr)), ntohs(local.sin_port));
+    return 0;
+}
+
+int
+HostUdpSocket::GetPeerName(Address& address) const
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_connected)
+    {
+        m_errno = ERROR_NOTCONN;
+        return -1;
+    }
+    address = m_peer;
+    return 0;
+}
+
+bool
+HostUdpSocket::SetAllowBroadcast(bool allowBroadcast)
+{
+    NS_LOG_FUNCTION(this << allowBroadcast);
+    int opt = allowBroadcast;
+    if (m_fd >= 0 && setsockopt(m_fd, SOL_SOCKET, SO_BROADCAST, &opt, sizeof(opt)) < 0)
+    {
+        return false;
+    }
+    m_allowBroadcast = allowBroadcast;
+    return true;
+}
+
+bool
+HostUdpSocket::GetAllowBroadcast() const
+{
+    return m_allowBroadcast;
+}
+
+void
+HostUdpSocket::Deliver(uint64_t id, uint8_t* buffer, uint32_t size, uint32_t ip, uint16_t port)
+{
+    auto it = g_sockets.find(id);
+    if (it == g_sockets.end())
+    {
+        // Socket closed while the datagram was in flight
+        delete[] buffer;
+        return;
+    }
+    HostUdpSocket* socket = it->second;
+    Ptr<Packet> p = Create<Packet>(buffer, size);
+    delete[] buffer;
+
+    if (socket->m_shutdownRecv)
+    {
+        return;
+    }
+    if (socket->m_rxAvailable + size > socket->m_rcvBufSize)
+    {
+        NS_LOG_WARN("Reception queue of host socket " << socket->m_fd
+                                                      << " full, dropping datagram");
+        return;
+    }
+    socket->m_rxQueue.emplace_back(p, InetSocketAddress(Ipv4Address(ntohl(ip)), ntohs(port)));
+    socket->m_rxAvailable += size;
+    socket->NotifyDataRecv();
+}
+
+void
+HostUdpSocket::ReadLoop()
+{
+    std::vector<uint8_t> buffers(HOST_UDP_RX_BATCH * HOST_UDP_MAX_DGRAM);
+    mmsghdr msgs[HOST_UDP_RX_BATCH];
+    iovec iovs[HOST_UDP_RX_BATCH];
+    sockaddr_in from[HOST_UDP_RX_BATCH];
+    epoll_event events[HOST_UDP_RX_BATCH];
+
+    while (true)
+    {
+        int nfds = epoll_wait(g_epollFd, events, HOST_UDP_RX_BATCH, -1);
+        if (nfds < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            NS_FATAL_ERROR("epoll_wait: " << std::strerror(errno));
+        }
+
+        for (int e = 0; e < nfds; ++e)
+        {
+            uint64_t id = events[e].data.u64;
+            if (id == 0)
+            {
+                return;
+            }
+
+            // Closing waits for the drain, so the descriptor is not reused meanwhile
+            std::lock_guard<std::mutex> lock(g_endpointsMutex);
+            auto endpoint = g_endpoints.find(id);
+            if (endpoint == g_endpoints.end())
+            {
+                continue;
+            }
+            int fd = endpoint->second.fd;
+            uint32_t context = endpoint->second.context;
+            if (events[e].events & EPOLLOUT)
+            {
+                Simulator::ScheduleWithContext(context,
+                                               Time(0),
+                                               &HostUdpSocket::NotifyWritable,
+                                               id);
+            }
+
+            // Drain the socket, it is registered as edge-triggered
+            while (events[e].events & EPOLLIN)
+            {
+                for (int i = 0; i < HOST_UDP_RX_BATCH; ++i)
+                {
+                    iovs[i].iov_base = &buffers[i * HOST_UDP_MAX_DGRAM];
+                    iovs[i].iov_len = HOST_UDP_MAX_DGRAM;
+                    std::memset(&msgs[i], 0, sizeof(mmsghdr));
+                    msgs[i].msg_hdr.msg_iov = &iovs[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                    msgs[i].msg_hdr.msg_name = &from[i];
+                    msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                }
+                int n = recvmmsg(fd, msgs, HOST_UDP_RX_BATCH, MSG_DONTWAIT, nullptr);
+                if (n <= 0)
+                {
+                    break;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    // Packets are not created here, ns-3 allocators are not thread-safe
+                    uint32_t size = msgs[i].msg_len;
+                    auto copy = new uint8_t[size];
+                    std::memcpy(copy, iovs[i].iov_base, size);
+                    Simulator::ScheduleWithContext(context,
+                                                   Time(0),
+                                                   &HostUdpSocket::Deliver,
+                                                   id,
+                                                   copy,
+                                                   size,
+                                                   from[i].sin_addr.s_addr,
+                                                   from[i].sin_port);
+                }
+            }
+        }
+    }
+}
+
+void
+HostUdpSocket::Register(HostUdpSocket* socket)
+{
+    NS_LOG_FUNCTION(socket);
+    if (g_epollFd < 0)
+    {
+        g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        g_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        NS_ABORT_MSG_IF(g_epollFd < 0 || g_wakeFd < 0,
+                        "Failed to set up host socket polling: " << std::strerror(errno));
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = 0;
+        epoll_ctl(g_epollFd, EPOLL_CTL_ADD, g_wakeFd, &ev);
+        g_reader = std::thread(&HostUdpSocket::ReadLoop);
+        Simulator::ScheduleDestroy(&HostUdpSocket::CloseAll);
+        NS_LOG_INFO("Started host socket reception thread");
+    }
+
+    socket->m_id = g_nextId++;
+    uint32_t context = socket->m_node ? socket->m_node->GetId() : Simulator::NO_CONTEXT;
+    {
+        std::lock_guard<std::mutex> lock(g_endpointsMutex);
+        g_endpoints[socket->m_id] = {socket->m_fd, context};
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = socket->m_id;
+    NS_ABORT_MSG_IF(epoll_ctl(g_epollFd, EPOLL_CTL_ADD, socket->m_fd, &ev) < 0,
+                    "Failed to poll host socket: " << std::strerror(errno));
+    g_sockets[socket->m_id] = socket;
+}
+
+void
+HostUdpSocket::Unregister(HostUdpSocket* socket)
+{
+    NS_LOG_FUNCTION(socket);
+    g_sockets.erase(socket->m_id);
+    {
+        std::lock_guard<std::mutex> lock(g_endpointsMutex);
+        g_endpoints.erase(socket->m_id);
+    }
+    if (g_epollFd >= 0)
+    {
+        epoll_ctl(g_epollFd, EPOLL_CTL_DEL, socket->m_fd, nullptr);
+    }
+    socket->m_id = 0;
+    socket->m_waitWritable = false;
+    if (g_sockets.empty())
+    {
+        StopReader();
+    }
+}
+
+void
+HostUdpSocket::StopReader()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    if (g_epollFd < 0)
+    {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(g_wakeFd, &one, sizeof(one)) < 0)
+    {
+        NS_LOG_ERROR("Failed to wake up the reception thread: " << std::strerror(errno));
+    }
+    g_reader.join();
+    close(g_epollFd);
+    close(g_wakeFd);
+    g_epollFd = -1;
+    g_wakeFd = -1;
+    NS_LOG_INFO("Stopped host socket reception thread");
+}
+
+void
+HostUdpSocket::CloseAll()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    Simulator::Cancel(g_flushEvent);
+    while (!g_sockets.empty())
+    {
+        g_sockets.begin()->second->Close();
+    }
+    StopReader();
+}
+
+} // namespace lorawan
+} // namespace ns3
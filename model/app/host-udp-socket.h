@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef HOST_UDP_SOCKET_H
+#define HOST_UDP_SOCKET_H
+
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+
+#include <deque>
+#include <netinet/in.h>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * An ns-3 Socket backed by a real UDP socket of the host.
+ *
+ * This lets applications written against the ns-3 socket API (e.g.,
+ * UdpForwarder) exchange datagrams with servers running on the host, without
+ * simulating a CSMA/IP stack and a TapBridge. Each instance owns a
+ * non-blocking host socket, hence a distinct source port.
+ *
+ * Reception is performed by a single background thread shared by all
+ * instances, which polls the host sockets and hands incoming datagrams to the
+ * simulator with ScheduleWithContext. With the RealtimeSimulatorImpl they are
+ * therefore delivered at the wall-clock time of their arrival. Datagrams sent
+ * during the same simulated instant are queued and flushed together at the
+ * end of it, with one sendmmsg call per host socket. Datagrams the host can
+ * not take yet stay queued, and are sent when the host socket is writable.
+ */
+class HostUdpSocket : public Socket
+{
+  public:
+    static TypeId GetTypeId();
+
+    HostUdpSocket();
+    ~HostUdpSocket() override;
+
+    /**
+     * Set the node this socket belongs to, used as context of reception events.
+     *
+     * \param node The node.
+     */
+    void SetNode(Ptr<Node> node);
+
+    // Inherited from Socket
+    SocketErrno GetErrno() const override;
+    SocketType GetSocketType() const override;
+    Ptr<Node> GetNode() const override;
+    int Bind(const Address& address) override;
+    int Bind() override;
+    int Bind6() override;
+    int Close() override;
+    int ShutdownSend() override;
+    int ShutdownRecv() override;
+    int Connect(const Address& address) override;
+    int Listen() override;
+    uint32_t GetTxAvailable() const override;
+    int Send(Ptr<Packet> p, uint32_t flags) override;
+    int SendTo(Ptr<Packet> p, uint32_t flags, const Address& toAddress) override;
+    uint32_t GetRxAvailable() const override;
+    Ptr<Packet> Recv(uint32_t maxSize, uint32_t flags) override;
+    Ptr<Packet> RecvFrom(uint32_t maxSize, uint32_t flags, Address& fromAddress) override;
+    int GetSockName(Address& address) const override;
+    int GetPeerName(Address& address) const override;
+    bool SetAllowBroadcast(bool allowBroadcast) override;
+    bool GetAllowBroadcast() const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * A datagram waiting to be flushed.
+     */
+    struct TxDatagram
+    {
+        std::vector<uint8_t> data; //!< Payload
+        sockaddr_in to;            //!< Destination (unused if connected)
+        bool connected;            //!< Whether to use the connected peer
+    };
+
+    /**
+     * Open the host socket and bind it to an IPv4 endpoint.
+     */
+    int DoBind(const InetSocketAddress& address);
+
+    /**
+     * Queue a datagram and schedule the flush of all pending datagrams.
+     */
+    int Enqueue(Ptr<Packet> p, const sockaddr_in* to);
+
+    /**
+     * Send the datagrams queued on this socket with sendmmsg. Those the host
+     * can not take yet stay queued until the host socket is writable.
+     */
+    void Flush();
+
+    /**
+     * Poll the host socket for writability, or stop doing so.
+     */
+    void SetWaitWritable(bool wait);
+
+    /**
+     * Flush all sockets with pending datagrams.
+     */
+    static void FlushAll();
+
+    /**
+     * Hand a datagram read by the reception thread to its socket.
+     *
+     * Executed in the simulator thread, takes ownership of the buffer.
+     *
+     * \param id The identifier of the socket.
+     */
+    static void Deliver(uint64_t id, uint8_t* buffer, uint32_t size, uint32_t ip, uint16_t port);
+
+    /**
+     * Resume the flush of a socket whose host socket became writable.
+     *
+     * Executed in the simulator thread.
+     *
+     * \param id The identifier of the socket.
+     */
+    static void NotifyWritable(uint64_t id);
+
+    /**
+     * Body of the reception thread.
+     */
+    static void ReadLoop();
+
+    /**
+     * Register a socket with the reception thread, starting it if needed.
+     */
+    static void Register(HostUdpSocket* socket);
+
+    /**
+     * Unregister a socket, stopping the reception thread if it was the last.
+     */
+    static void Unregister(HostUdpSocket* socket);
+
+    /**
+     * Stop the reception thread.
+     */
+    static void StopReader();
+
+    /**
+     * Close all remaining sockets when the simulator is destroyed.
+     */
+    static void CloseAll();
+
+    int m_fd;                    //!< Host socket descriptor
+    uint64_t m_id;               //!< Identifier while registered, never reused
+    bool m_waitWritable;         //!< Whether queued datagrams wait for the host socket
+    Ptr<Node> m_node;            //!< The node of this socket
+    mutable SocketErrno m_errno; //!< Last error
+    bool m_connected;            //!< Whether Connect was called
+    InetSocketAddress m_peer;    //!< Connected peer
+    bool m_shutdownSend;         //!< Send no longer allowed
+    bool m_shutdownRecv;         //!< Receive no longer allowed
+    bool m_allowBroadcast;       //!< SO_BROADCAST
+    uint32_t m_rcvBufSize;       //!< Maximum bytes waiting in the reception queue
+    uint32_t m_maxBatch;         //!< Maximum datagrams per sendmmsg call
+
+    std::vector<TxDatagram> m_txQueue;                     //!< Datagrams waiting to be flushed
+    std::deque<std::pair<Ptr<Packet>, Address>> m_rxQueue; //!< Received datagrams
+    uint32_t m_rxAvailable;                                //!< Bytes in the reception queue
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* HOST_UDP_SOCKET_H */
@@ -20,6 +20,7 @@
 
 #include "lora-application.h"
 
+#include "ns3/fleet-traffic-driver.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/uinteger.h"
 
@@ -59,8 +60,9 @@ LoraApplication::LoraApplication()
       m_initialDelay(Seconds(0)),
       m_sendEvent(EventId()),
       m_basePktSize(18),
-      m_mac(nullptr)
-
+      m_mac(nullptr),
+      m_fleet(nullptr),
+      m_fleetId(0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -109,9 +111,70 @@ bool
 LoraApplication::IsRunning()
 {
     NS_LOG_FUNCTION(this);
+    if (m_fleet)
+    {
+        return m_fleet->IsPending(m_fleetId);
+    }
     return m_sendEvent.IsRunning();
 }
 
+void
+LoraApplication::Suspend()
+{
+    NS_LOG_FUNCTION(this);
+    StopApplication();
+}
+
+void
+LoraApplication::SetFleetTrafficDriver(Ptr<FleetTrafficDriver> fleet)
+{
+    NS_LOG_FUNCTION(this << fleet);
+    if (fleet == m_fleet)
+    {
+        return;
+    }
+    // Carry over the pending send, if any
+    bool pending = IsRunning();
+    Time left =
+        m_fleet ? m_fleet->GetDelayLeft(m_fleetId) : Simulator::GetDelayLeft(m_sendEvent);
+    CancelSend();
+    if (m_fleet)
+    {
+        m_fleet->Unregister(m_fleetId);
+    }
+    m_fleet = fleet;
+    if (m_fleet)
+    {
+        m_fleetId = m_fleet->Register(this);
+    }
+    if (pending)
+    {
+        ScheduleSend(left);
+    }
+}
+
+Time
+LoraApplication::GetNextSendDelay()
+{
+    NS_LOG_FUNCTION(this);
+    if (!IsRunning())
+    {
+        return Seconds(-1);
+    }
+    return m_fleet ? m_fleet->GetDelayLeft(m_fleetId) : Simulator::GetDelayLeft(m_sendEvent);
+}
+
+void
+LoraApplication::SetNextSendDelay(Time delay)
+{
+    NS_LOG_FUNCTION(this << delay);
+    m_initialDelay = delay;
+    if (IsRunning())
+    {
+        ScheduleSend(delay);
+    }
+}
+
 void
 LoraApplication::DoInitialize()
 {
@@ -144,6 +207,11 @@ LoraApplication::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_mac = nullptr;
+    if (m_fleet)
+    {
+        m_fleet->Unregister(m_fleetId);
+        m_fleet = nullptr;
+    }
     Application::DoDispose();
 }
 
@@ -159,7 +227,7 @@ void
 LoraApplication::StopApplication()
 {
     NS_LOG_FUNCTION_NOARGS();
-    m_sendEvent.Cancel();
+    CancelSend();
 }
 
 void
@@ -168,5 +236,31 @@ LoraApplication::SendPacket()
     NS_LOG_FUNCTION(this);
 }
 
+void
+LoraApplication::ScheduleSend(Time delay)
+{
+    NS_LOG_FUNCTION(this << delay);
+    if (m_fleet)
+    {
+        m_fleet->Schedule(m_fleetId, delay);
+        return;
+    }
+    Simulator::Cancel(m_sendEvent);
+    m_sendEvent = Simulator::Schedule(delay, &LoraApplication::SendPacket, this);
+    NS_LOG_DEBUG("Event Id: " << m_sendEvent.GetUid());
+}
+
+void
+LoraApplication::CancelSend()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_fleet)
+    {
+        m_fleet->Cancel(m_fleetId);
+        return;
+    }
+    Simulator::Cancel(m_sendEvent);
+}
+
 } // namespace lorawan
 } // namespace ns3
@@ -29,6 +29,8 @@ namespace ns3
 namespace lorawan
 {
 
+class FleetTrafficDriver;
+
 class LoraApplication : public Application
 {
   public:
@@ -72,7 +74,36 @@ class LoraApplication : public Application
      */
     bool IsRunning();
 
+    /**
+     * Stop generating traffic before the scheduled stop time
+     *
+     * Used to thin the offered load at runtime (e.g., by RealtimeLagMonitor).
+     */
+    void Suspend();
+
+    /**
+     * Let a fleet driver schedule the send events of this application
+     *
+     * A pending send event is moved to the driver. Pass nullptr to go back to
+     * scheduling sends in the simulator directly.
+     */
+    void SetFleetTrafficDriver(Ptr<FleetTrafficDriver> fleet);
+
+    /**
+     * Get the delay from now of the pending send, or a negative time if there is none
+     */
+    Time GetNextSendDelay();
+
+    /**
+     * Reschedule the pending send, or set the delay of the first one if the
+     * application has not started yet
+     */
+    void SetNextSendDelay(Time delay);
+
   protected:
+    /// The fleet driver calls SendPacket directly
+    friend class FleetTrafficDriver;
+
     void DoInitialize() override;
     void DoDispose() override;
 
@@ -91,6 +122,18 @@ class LoraApplication : public Application
      */
     virtual void SendPacket();
 
+    /**
+     * Schedule the next SendPacket call, replacing the pending one
+     *
+     * \param delay Delay from now of the call
+     */
+    void ScheduleSend(Time delay);
+
+    /**
+     * Cancel the pending SendPacket call, if any
+     */
+    void CancelSend();
+
     /**
      * The average interval between to consecutive send events
      */
@@ -115,6 +158,16 @@ class LoraApplication : public Application
      * The MAC layer of this node
      */
     Ptr<BaseEndDeviceLorawanMac> m_mac;
+
+    /**
+     * The fleet driver scheduling sends, if any
+     */
+    Ptr<FleetTrafficDriver> m_fleet;
+
+    /**
+     * The identifier of this application in the fleet driver
+     */
+    uint32_t m_fleetId;
 };
 
 } // namespace lorawan
@@ -85,8 +85,7 @@ OneShotSender::StartApplication()
 {
     NS_LOG_FUNCTION(this);
     // Schedule the next SendPacket event
-    Simulator::Cancel(m_sendEvent);
-    m_sendEvent = Simulator::Schedule(m_initialDelay, &OneShotSender::SendPacket, this);
+    ScheduleSend(m_initialDelay);
 }
 
 } // namespace lorawan
@@ -59,11 +59,9 @@ PeriodicSender::StartApplication()
 {
     NS_LOG_FUNCTION(this);
     // Schedule the next SendPacket event
-    Simulator::Cancel(m_sendEvent);
     NS_LOG_DEBUG("Starting up application with a first event with a " << m_initialDelay.GetSeconds()
                                                                       << " seconds delay");
-    m_sendEvent = Simulator::Schedule(m_initialDelay, &PeriodicSender::SendPacket, this);
-    NS_LOG_DEBUG("Event Id: " << m_sendEvent.GetUid());
+    ScheduleSend(m_initialDelay);
 }
 
 void
@@ -74,7 +72,7 @@ PeriodicSender::SendPacket()
     Ptr<Packet> packet = Create<Packet>(m_basePktSize);
     m_mac->Send(packet);
     // Schedule the next SendPacket event
-    m_sendEvent = Simulator::Schedule(m_avgInterval, &PeriodicSender::SendPacket, this);
+    ScheduleSend(m_avgInterval);
     NS_LOG_DEBUG("Sent a packet of size " << packet->GetSize());
 }
 
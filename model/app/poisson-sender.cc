@@ -45,6 +45,7 @@ PoissonSender::GetTypeId()
 PoissonSender::PoissonSender()
 {
     NS_LOG_FUNCTION(this);
+    m_interval = CreateObject<ExponentialRandomVariable>();
 }
 
 PoissonSender::~PoissonSender()
@@ -56,12 +57,18 @@ void
 PoissonSender::DoInitialize()
 {
     NS_LOG_FUNCTION(this);
-    m_interval = CreateObjectWithAttributes<ExponentialRandomVariable>(
-        "Mean",
-        DoubleValue(m_avgInterval.GetSeconds()));
+    m_interval->SetAttribute("Mean", DoubleValue(m_avgInterval.GetSeconds()));
     LoraApplication::DoInitialize();
 }
 
+int64_t
+PoissonSender::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_interval->SetStream(stream);
+    return 1;
+}
+
 void
 PoissonSender::DoDispose()
 {
@@ -75,11 +82,9 @@ PoissonSender::StartApplication()
 {
     NS_LOG_FUNCTION(this);
     // Schedule the next SendPacket event
-    Simulator::Cancel(m_sendEvent);
     NS_LOG_DEBUG("Starting up application with a first event with a " << m_initialDelay.GetSeconds()
                                                                       << " seconds delay");
-    m_sendEvent = Simulator::Schedule(m_initialDelay, &PoissonSender::SendPacket, this);
-    NS_LOG_DEBUG("Event Id: " << m_sendEvent.GetUid());
+    ScheduleSend(m_initialDelay);
 }
 
 void
@@ -95,7 +100,7 @@ PoissonSender::SendPacket()
     Time interval = Min(Seconds(m_interval->GetValue()), Days(1));
 
     // Schedule the next SendPacket event
-    m_sendEvent = Simulator::Schedule(interval, &PoissonSender::SendPacket, this);
+    ScheduleSend(interval);
 
     NS_LOG_DEBUG("Sent a packet of size " << packet->GetSize());
 }
@@ -36,6 +36,8 @@ class PoissonSender : public LoraApplication
 
     static TypeId GetTypeId();
 
+    int64_t AssignStreams(int64_t stream) override;
+
   protected:
     void DoInitialize() override;
     void DoDispose() override;
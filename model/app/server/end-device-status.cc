@@ -263,7 +263,7 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
 
     // Update current parameters
     LoraTag tag;
-    myPacket->RemovePacketTag(tag);
+    receivedPacket->PeekPacketTag(tag);
     SetFirstReceiveWindowDataRate(tag.GetDataRate());
     SetFirstReceiveWindowFrequency(tag.GetFrequency());
 
@@ -326,6 +326,20 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
     NS_LOG_DEBUG(*this);
 }
 
+void
+EndDeviceStatus::AppendReceivedPacket(Ptr<const Packet> packet, const ReceivedPacketInfo& info)
+{
+    NS_LOG_FUNCTION(this << packet);
+    m_receivedPacketList.emplace_back(packet, info);
+}
+
+void
+EndDeviceStatus::ClearReceivedPacketList()
+{
+    NS_LOG_FUNCTION(this);
+    m_receivedPacketList.clear();
+}
+
 EndDeviceStatus::ReceivedPacketInfo
 EndDeviceStatus::GetLastReceivedPacketInfo()
 {
@@ -268,6 +268,17 @@ class EndDeviceStatus : public Object
      */
     void InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Address& gwAddress);
 
+    /**
+     * Append a packet to the received packet list, with its reception
+     * information (e.g., to restore a checkpoint).
+     */
+    void AppendReceivedPacket(Ptr<const Packet> packet, const ReceivedPacketInfo& info);
+
+    /**
+     * Drop all packets of the received packet list.
+     */
+    void ClearReceivedPacketList();
+
     /**
      * Return the last packet that was received from this device.
      */
@@ -110,6 +110,13 @@ GatewayStatus::IsAvailableForTransmission(double frequency)
         return false;
     }
 
+    // Gateways reached through the packet forwarder protocol have no MAC
+    // instance here: TX constraints are enforced by their own JIT queue
+    if (!m_gatewayMac)
+    {
+        return true;
+    }
+
     // Check that the gateway is not already in TX mode
     if (m_gatewayMac->IsTransmitting())
     {
@@ -176,10 +176,8 @@ LinkCheckComponent::BeforeSendingReply(Ptr<EndDeviceStatus> status,
     fHdr.SetAsUplink();
     myPacket->RemoveHeader(fHdr);
 
-    Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq>();
-
-    // GetMacCommand returns 0 if no command is found
-    if (command)
+    // Find returns nullptr if no command is found
+    if (fHdr.GetCommandList().Find(LINK_CHECK_REQ))
     {
         status->m_reply.needsReply = true;
 
@@ -187,10 +185,8 @@ LinkCheckComponent::BeforeSendingReply(Ptr<EndDeviceStatus> status,
         // margin
         uint8_t gwCount = status->GetLastReceivedPacketInfo().gwList.size();
 
-        Ptr<LinkCheckAns> replyCommand = Create<LinkCheckAns>();
-        replyCommand->SetGwCnt(gwCount);
         status->m_reply.frameHeader.SetAsDownlink();
-        status->m_reply.frameHeader.AddCommand(replyCommand);
+        status->m_reply.frameHeader.AddLinkCheckAns(0, gwCount);
         status->m_reply.macHeader.SetFType(LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
     }
     else
@@ -39,6 +39,12 @@ NetworkScheduler::GetTypeId()
         TypeId("ns3::NetworkScheduler")
             .SetParent<Object>()
             .AddConstructor<NetworkScheduler>()
+            .AddAttribute("ReceiveWindowLead",
+                          "Time in advance of the receive windows at which replies are "
+                          "prepared and sent to the gateway, to absorb backhaul latency",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&NetworkScheduler::m_receiveWindowLead),
+                          MakeTimeChecker(Seconds(0), Seconds(1)))
             .AddTraceSource("ReceiveWindowOpened",
                             "Trace source that is fired when a receive window opportunity happens.",
                             MakeTraceSourceAccessor(&NetworkScheduler::m_receiveWindowOpened),
@@ -48,12 +54,14 @@ NetworkScheduler::GetTypeId()
 }
 
 NetworkScheduler::NetworkScheduler()
+    : m_receiveWindowLead(Seconds(0))
 {
     NS_LOG_FUNCTION(this);
 }
 
 NetworkScheduler::NetworkScheduler(Ptr<NetworkStatus> status, Ptr<NetworkController> controller)
-    : m_status(status),
+    : m_receiveWindowLead(Seconds(0)),
+      m_status(status),
       m_controller(controller)
 {
     NS_LOG_FUNCTION(this);
@@ -85,7 +93,7 @@ NetworkScheduler::OnReceivedPacket(Ptr<const Packet> packet)
 
         // Schedule OnReceiveWindowOpportunity event
         m_status->GetEndDeviceStatus(packet)->SetReceiveWindowOpportunity(
-            Simulator::Schedule(Seconds(1),
+            Simulator::Schedule(Seconds(1) - m_receiveWindowLead,
                                 &NetworkScheduler::OnReceiveWindowOpportunity,
                                 this,
                                 deviceAddress,
@@ -53,7 +53,7 @@ class NetworkScheduler : public Object
     /**
      * Method called by NetworkServer to inform the Scheduler of a newly arrived
      * uplink packet. This function schedules the OnReceiveWindowOpportunity
-     * events 1 and 2 seconds later.
+     * events 1 and 2 seconds later (anticipated by the receive window lead).
      */
     void OnReceivedPacket(Ptr<const Packet> packet);
 
@@ -68,6 +68,7 @@ class NetworkScheduler : public Object
 
   private:
     TracedCallback<Ptr<const Packet>> m_receiveWindowOpened;
+    Time m_receiveWindowLead; //!< How much in advance of receive windows replies are prepared
     Ptr<NetworkStatus> m_status;
     Ptr<NetworkController> m_controller;
 };
@@ -170,9 +170,21 @@ NetworkStatus::SendThroughGateway(Ptr<Packet> packet, Address gwAddress)
 {
     NS_LOG_FUNCTION(packet << gwAddress);
 
+    if (!m_sendCallback.IsNull())
+    {
+        m_sendCallback(packet, gwAddress);
+        return;
+    }
     m_gatewayStatuses.find(gwAddress)->second->GetNetDevice()->Send(packet, gwAddress, 0x0800);
 }
 
+void
+NetworkStatus::SetSendCallback(SendCallback callback)
+{
+    NS_LOG_FUNCTION(this);
+    m_sendCallback = callback;
+}
+
 Ptr<Packet>
 NetworkStatus::GetReplyForDevice(LoraDeviceAddress edAddress, int windowNumber)
 {
@@ -182,7 +194,7 @@ NetworkStatus::GetReplyForDevice(LoraDeviceAddress edAddress, int windowNumber)
 
     // Apply the appropriate tag
     LoraTag tag;
-    packet->RemovePacketTag(tag);
+    packet->PeekPacketTag(tag);
     switch (windowNumber)
     {
     case 1:
@@ -194,7 +206,7 @@ NetworkStatus::GetReplyForDevice(LoraDeviceAddress edAddress, int windowNumber)
         tag.SetFrequency(edStatus->GetSecondReceiveWindowFrequency());
         break;
     }
-    packet->AddPacketTag(tag);
+    tag.WriteTo(packet);
     return packet;
 }
 
@@ -261,6 +273,7 @@ NetworkStatus::DoDispose()
         gw.second->Dispose();
     }
     m_gatewayStatuses.clear();
+    m_sendCallback.Nullify();
     Object::DoDispose();
 }
 
@@ -99,6 +99,19 @@ class NetworkStatus : public Object
      */
     void SendThroughGateway(Ptr<Packet> packet, Address gwAddress);
 
+    /**
+     * Callback used to deliver downlink packets to gateways.
+     */
+    typedef Callback<void, Ptr<Packet>, Address> SendCallback;
+
+    /**
+     * Replace the default point-to-point delivery of downlink packets, for
+     * gateways that are not directly attached to the server node.
+     *
+     * \param callback The function that will forward packets to gateways.
+     */
+    void SetSendCallback(SendCallback callback);
+
     /**
      * Get the reply for the specified device address.
      */
@@ -125,6 +138,9 @@ class NetworkStatus : public Object
   public:
     std::map<LoraDeviceAddress, Ptr<EndDeviceStatus>> m_endDeviceStatuses;
     std::map<Address, Ptr<GatewayStatus>> m_gatewayStatuses;
+
+  private:
+    SendCallback m_sendCallback; //!< Downlink delivery override (null for P2P)
 };
 
 } // namespace lorawan
@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "udp-network-server.h"
+
+#include "ns3/base64.h"
+#include "ns3/boolean.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/log.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/mac64-address.h"
+#include "ns3/parson.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-forwarder.h"
+#include "ns3/uinteger.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("UdpNetworkServer");
+
+NS_OBJECT_ENSURE_REGISTERED(UdpNetworkServer);
+
+TypeId
+UdpNetworkServer::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::UdpNetworkServer")
+            .SetParent<NetworkServer>()
+            .AddConstructor<UdpNetworkServer>()
+            .AddAttribute("Port",
+                          "UDP port on which packet forwarders are served",
+                          UintegerValue(DEFAULT_PORT_UP),
+                          MakeUintegerAccessor(&UdpNetworkServer::m_port),
+                          MakeUintegerChecker<uint16_t>())
+            .AddAttribute("DownlinkLead",
+                          "Time in advance of the receive windows at which PULL_RESP datagrams "
+                          "are sent to gateways",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&UdpNetworkServer::m_downlinkLead),
+                          MakeTimeChecker(Seconds(0), Seconds(1)))
+            .AddAttribute("EnableCryptography",
+                          "Whether to verify the MIC of uplink packets",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UdpNetworkServer::m_enableCrypto),
+                          MakeBooleanChecker())
+            .AddAttribute("TxPower",
+                          "Transmission power of downlink packets (dBm)",
+                          UintegerValue(14),
+                          MakeUintegerAccessor(&UdpNetworkServer::m_txPower),
+                          MakeUintegerChecker<uint8_t>())
+            .AddTraceSource("MicFailure",
+                            "Trace source fired when an uplink packet fails MIC verification",
+                            MakeTraceSourceAccessor(&UdpNetworkServer::m_micFailure),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("TxAcknowledged",
+                            "Trace source fired when a gateway acknowledges a downlink",
+                            MakeTraceSourceAccessor(&UdpNetworkServer::m_txAcknowledged),
+                            "ns3::UdpNetworkServer::TxAckTracedCallback")
+            .SetGroupName("lorawan");
+    return tid;
+}
+
+UdpNetworkServer::UdpNetworkServer()
+    : m_port(DEFAULT_PORT_UP),
+      m_downlinkLead(MilliSeconds(100)),
+      m_enableCrypto(false),
+      m_txPower(14),
+      m_nReceivedUplinks(0),
+      m_nDroppedUplinks(0),
+      m_nSentDownlinks(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_crypto = new LoRaMacCrypto();
+    m_rng = CreateObject<UniformRandomVariable>();
+}
+
+UdpNetworkServer::~UdpNetworkServer()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+UdpNetworkServer::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    // Prepare replies early enough to reach gateways before the RX windows
+    m_scheduler->SetAttribute("ReceiveWindowLead", TimeValue(m_downlinkLead));
+    m_status->SetSendCallback(MakeCallback(&UdpNetworkServer::SendPullResp, this));
+
+    if (!m_socket)
+    {
+        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+        m_socket = Socket::CreateSocket(GetNode(), tid);
+        if (m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_port)) == -1)
+        {
+            NS_FATAL_ERROR("Failed to bind socket");
+        }
+    }
+    m_socket->SetRecvCallback(MakeCallback(&UdpNetworkServer::ReceiveDatagram, this));
+}
+
+void
+UdpNetworkServer::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_socket)
+    {
+        m_socket->Close();
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+}
+
+uint32_t
+UdpNetworkServer::GetNReceivedUplinks() const
+{
+    return m_nReceivedUplinks;
+}
+
+uint32_t
+UdpNetworkServer::GetNDroppedUplinks() const
+{
+    return m_nDroppedUplinks;
+}
+
+uint32_t
+UdpNetworkServer::GetNSentDownlinks() const
+{
+    return m_nSentDownlinks;
+}
+
+void
+UdpNetworkServer::ReceiveDatagram(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        uint32_t msg_len = packet->GetSize();
+        std::vector<uint8_t> buff(msg_len + 1);
+        packet->CopyData(buff.data(), msg_len);
+        buff[msg_len] = 0; /* add string terminator, just to be safe */
+
+        /* if the datagram does not respect protocol, just ignore it */
+        if ((msg_len < 4) || ((buff[0] != 1) && (buff[0] != PROTOCOL_VERSION)))
+        {
+            NS_LOG_WARN("ignoring invalid packet len=" << msg_len << ", protocol_version="
+                                                       << (unsigned)buff[0]);
+            continue;
+        }
+
+        switch (buff[3])
+        {
+        case PKT_PUSH_DATA: {
+            if (msg_len < 12)
+            {
+                NS_LOG_WARN("[up] ignoring truncated PUSH_DATA, len=" << msg_len);
+                break;
+            }
+            SendAck(buff[0], buff[1], buff[2], PKT_PUSH_ACK, from);
+            Address gwAddress = GetGateway(buff.data() + 4);
+            m_gateways[gwAddress].pushAddress = from;
+            HandlePushData(gwAddress, (const char*)(buff.data() + 12));
+            break;
+        }
+        case PKT_PULL_DATA: {
+            if (msg_len < 12)
+            {
+                NS_LOG_WARN("[down] ignoring truncated PULL_DATA, len=" << msg_len);
+                break;
+            }
+            SendAck(buff[0], buff[1], buff[2], PKT_PULL_ACK, from);
+            Address gwAddress = GetGateway(buff.data() + 4);
+            m_gateways[gwAddress].pullAddress = from;
+            m_gateways[gwAddress].pullKnown = true;
+            break;
+        }
+        case PKT_TX_ACK:
+            HandleTxAck((buff[1] << 8) | buff[2],
+                        (msg_len > 12) ? (const char*)(buff.data() + 12) : "");
+            break;
+        default:
+            NS_LOG_WARN("ignoring packet with unexpected id=" << (unsigned)buff[3]);
+            break;
+        }
+    }
+}
+
+void
+UdpNetworkServer::HandlePushData(const Address& gwAddress, const char* json)
+{
+    NS_LOG_DEBUG("JSON up: " << json);
+
+    JSON_Value* root_val = json_parse_string_with_comments(json);
+    if (root_val == nullptr)
+    {
+        NS_LOG_WARN("[up] invalid JSON, PUSH_DATA ignored");
+        return;
+    }
+
+    /* datagrams carrying only a status report have no rxpk array */
+    JSON_Array* rxpk_arr = json_object_get_array(json_value_get_object(root_val), "rxpk");
+    if (rxpk_arr == nullptr)
+    {
+        json_value_free(root_val);
+        return;
+    }
+
+    for (size_t i = 0; i < json_array_get_count(rxpk_arr); ++i)
+    {
+        JSON_Object* rxpk = json_array_get_object(rxpk_arr, i);
+
+        /* only LoRa packets with a valid CRC are processed */
+        if (json_object_get_number(rxpk, "stat") != 1)
+        {
+            continue;
+        }
+        const char* str = json_object_get_string(rxpk, "modu");
+        if ((str == nullptr) || (strcmp(str, "LORA") != 0))
+        {
+            continue;
+        }
+
+        unsigned sf;
+        unsigned bw;
+        str = json_object_get_string(rxpk, "datr");
+        if ((str == nullptr) || (sscanf(str, "SF%2uBW%3u", &sf, &bw) != 2))
+        {
+            NS_LOG_WARN("[up] invalid \"datr\" in rxpk, packet ignored");
+            continue;
+        }
+
+        uint8_t payload[256];
+        str = json_object_get_string(rxpk, "data");
+        int size = (str == nullptr) ? -1 : b64_to_bin(str, strlen(str), payload, sizeof payload);
+        if (size < 0)
+        {
+            NS_LOG_WARN("[up] invalid \"data\" in rxpk, packet ignored");
+            continue;
+        }
+
+        HandleUplink(gwAddress,
+                     payload,
+                     size,
+                     (uint32_t)json_object_get_number(rxpk, "tmst"),
+                     sf,
+                     std::round(1.0e6 * json_object_get_number(rxpk, "freq")),
+                     json_object_get_number(rxpk, "rssi"),
+                     json_object_get_number(rxpk, "lsnr"));
+    }
+
+    json_value_free(root_val);
+}
+
+void
+UdpNetworkServer::HandleUplink(const Address& gwAddress,
+                               uint8_t* payload,
+                               uint16_t size,
+                               uint32_t tmst,
+                               uint8_t sf,
+                               double frequency,
+                               double rssi,
+                               double snr)
+{
+    NS_LOG_FUNCTION(this << gwAddress << size << tmst << (unsigned)sf);
+
+    /* MHDR (1) + FHDR (at least 7) + MIC (4) */
+    if (size < 12)
+    {
+        NS_LOG_WARN("[up] PHYPayload too short (" << size << " bytes), packet ignored");
+        m_nDroppedUplinks++;
+        return;
+    }
+
+    Ptr<Packet> packet = Create<Packet>(payload, size);
+
+    // Extract the headers
+    Ptr<Packet> packetCopy = packet->Copy();
+    LorawanMacHeader mHdr;
+    packetCopy->RemoveHeader(mHdr);
+    if (!mHdr.IsUplink())
+    {
+        NS_LOG_WARN("[up] not an uplink data frame, packet ignored");
+        m_nDroppedUplinks++;
+        return;
+    }
+    LoraFrameHeader fHdr;
+    fHdr.SetAsUplink();
+    packetCopy->RemoveHeader(fHdr);
+
+    LoraDeviceAddress address = fHdr.GetAddress();
+    if (m_status->m_endDeviceStatuses.find(address) == m_status->m_endDeviceStatuses.end())
+    {
+        NS_LOG_WARN("[up] unknown device " << address << ", packet ignored");
+        m_nDroppedUplinks++;
+        return;
+    }
+
+    if (m_enableCrypto && !CheckMic(payload, size))
+    {
+        NS_LOG_WARN("[up] invalid MIC from device " << address << ", packet ignored");
+        m_micFailure(packet);
+        m_nDroppedUplinks++;
+        return;
+    }
+
+    // Keep the concentrator timestamps to target the receive windows. Copies
+    // of the same uplink from other gateways arrive within backhaul latency.
+    auto it = m_uplinks.find(address);
+    if (it == m_uplinks.end() || it->second.fCnt != fHdr.GetFCnt() ||
+        Simulator::Now() - it->second.arrival > Seconds(1))
+    {
+        m_uplinks[address] = {fHdr.GetFCnt(), Simulator::Now(), {}};
+    }
+    m_uplinks[address].tmst[gwAddress] = tmst;
+
+    // Rebuild the reception metadata expected by the network server logic
+    LoraPhyTxParameters params;
+    params.sf = sf;
+    LoraTag tag;
+    tag.SetTxParameters(params);
+    tag.SetDataRate(12 - sf); // BW125 data rates, as mapped by the UdpForwarder
+    tag.SetFrequency(frequency);
+    tag.SetReceivePower(rssi);
+    tag.SetSnr(snr);
+    tag.SetReceptionTime(Simulator::Now());
+    packet->AddPacketTag(tag);
+
+    m_nReceivedUplinks++;
+    Receive(nullptr, packet, 0x0800, gwAddress);
+}
+
+bool
+UdpNetworkServer::CheckMic(uint8_t* payload, uint16_t size)
+{
+    /* FHDR - DevAddr */
+    uint32_t mote_addr = payload[1];
+    mote_addr |= payload[2] << 8;
+    mote_addr |= payload[3] << 16;
+    mote_addr |= payload[4] << 24;
+    /* FHDR - FCnt */
+    uint16_t mote_fcnt = payload[6];
+    mote_fcnt |= payload[7] << 8;
+
+    uint32_t mic = 0;
+    m_crypto->ComputeCmacB0(payload,
+                            size - 4,
+                            F_NWK_S_INT_KEY,
+                            false,
+                            UPLINK,
+                            mote_addr,
+                            mote_fcnt,
+                            &mic);
+    uint32_t received;
+    memcpy(&received, payload + size - 4, 4);
+    return mic == received;
+}
+
+Address
+UdpNetworkServer::GetGateway(const uint8_t* eui)
+{
+    Mac64Address mac;
+    mac.CopyFrom(eui);
+    Address gwAddress = mac;
+    if (m_gateways.find(gwAddress) == m_gateways.end())
+    {
+        NS_LOG_INFO("New gateway connected with EUI " << mac);
+        // The gateway is only reachable through the forwarder protocol
+        auto gwStatus = CreateObject<GatewayStatus>(gwAddress, nullptr, nullptr);
+        m_status->AddGateway(gwAddress, gwStatus);
+        m_gateways[gwAddress] = {Address(), Address(), false};
+    }
+    return gwAddress;
+}
+
+void
+UdpNetworkServer::SendPullResp(Ptr<Packet> packet, Address gwAddress)
+{
+    NS_LOG_FUNCTION(this << packet << gwAddress);
+
+    auto gw = m_gateways.find(gwAddress);
+    if (gw == m_gateways.end() || !gw->second.pullKnown)
+    {
+        NS_LOG_WARN("[down] no PULL_DATA received from gateway " << gwAddress
+                                                                 << ", downlink dropped");
+        return;
+    }
+
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+
+    // Retrieve the uplink this reply answers to
+    Ptr<Packet> packetCopy = packet->Copy();
+    LorawanMacHeader mHdr;
+    packetCopy->RemoveHeader(mHdr);
+    LoraFrameHeader fHdr;
+    fHdr.SetAsDownlink();
+    packetCopy->RemoveHeader(fHdr);
+    auto up = m_uplinks.find(fHdr.GetAddress());
+    if (up == m_uplinks.end())
+    {
+        NS_LOG_WARN("[down] no uplink known from device " << fHdr.GetAddress()
+                                                          << ", downlink dropped");
+        return;
+    }
+    auto upTmst = up->second.tmst.find(gwAddress);
+    if (upTmst == up->second.tmst.end())
+    {
+        NS_LOG_WARN("[down] gateway " << gwAddress << " did not receive the last uplink of "
+                                      << fHdr.GetAddress() << ", downlink dropped");
+        return;
+    }
+
+    // The scheduler fires ahead of a window opening a whole number of
+    // seconds after the uplink: target the same instant on the concentrator.
+    int64_t delay =
+        std::llround((Simulator::Now() + m_downlinkLead - up->second.arrival).GetSeconds());
+    uint32_t tmst = upTmst->second + (uint32_t)(delay * 1000000);
+
+    uint8_t dr = tag.GetDataRate();
+    unsigned sf = (dr <= 5) ? 12 - dr : 12;
+
+    uint8_t payload[256];
+    uint32_t size = packet->CopyData(payload, sizeof payload);
+    char data[341 + 4];
+    if (bin_to_b64(payload, size, data, sizeof data) < 0)
+    {
+        NS_LOG_ERROR("[down] failed to encode downlink payload");
+        return;
+    }
+
+    /* start composing datagram with the header */
+    uint16_t token = m_rng->GetInteger(0, 0xFFFF);
+    uint8_t buff_down[1000];
+    buff_down[0] = PROTOCOL_VERSION;
+    buff_down[1] = token >> 8;
+    buff_down[2] = token & 0xFF;
+    buff_down[3] = PKT_PULL_RESP;
+    int j = snprintf((char*)(buff_down + 4),
+                     sizeof buff_down - 4,
+                     "{\"txpk\":{\"imme\":false,\"tmst\":%u,\"freq\":%.6lf,\"rfch\":0,"
+                     "\"powe\":%u,\"modu\":\"LORA\",\"datr\":\"SF%uBW125\",\"codr\":\"4/5\","
+                     "\"ipol\":true,\"size\":%u,\"data\":\"%s\"}}",
+                     tmst,
+                     tag.GetFrequency() / 1.0e6,
+                     (unsigned)m_txPower,
+                     sf,
+                     size,
+                     data);
+    NS_LOG_DEBUG("JSON down: " << (char*)(buff_down + 4));
+
+    m_socket->SendTo(Create<Packet>(buff_down, 4 + j), 0, gw->second.pullAddress);
+    m_pendingDownlinks[token] = Simulator::Now();
+    m_nSentDownlinks++;
+}
+
+void
+UdpNetworkServer::HandleTxAck(uint16_t token, const char* json)
+{
+    NS_LOG_FUNCTION(this << token);
+
+    /* an empty TX_ACK means the downlink was accepted */
+    std::string error = "NONE";
+    if (json[0] != 0)
+    {
+        JSON_Value* root_val = json_parse_string_with_comments(json);
+        if (root_val == nullptr)
+        {
+            NS_LOG_WARN("[down] invalid JSON in TX_ACK");
+            return;
+        }
+        JSON_Object* ack_obj =
+            json_object_get_object(json_value_get_object(root_val), "txpk_ack");
+        const char* str = json_object_get_string(ack_obj, "error");
+        if (str != nullptr)
+        {
+            error = str;
+        }
+        json_value_free(root_val);
+    }
+
+    auto it = m_pendingDownlinks.find(token);
+    if (it == m_pendingDownlinks.end())
+    {
+        NS_LOG_INFO("[down] TX_ACK with unknown token " << token);
+        return;
+    }
+    Time latency = Simulator::Now() - it->second;
+    m_pendingDownlinks.erase(it);
+
+    if (error != "NONE")
+    {
+        NS_LOG_WARN("[down] downlink rejected by gateway: " << error);
+    }
+    m_txAcknowledged(latency, error);
+}
+
+void
+UdpNetworkServer::SendAck(uint8_t version, uint8_t tokenH, uint8_t tokenL, uint8_t type, Address to)
+{
+    uint8_t buff_ack[4] = {version, tokenH, tokenL, type};
+    m_socket->SendTo(Create<Packet>(buff_ack, 4), 0, to);
+}
+
+void
+UdpNetworkServer::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_socket = nullptr;
+    m_rng = nullptr;
+    delete m_crypto;
+    m_crypto = nullptr;
+    m_gateways.clear();
+    m_uplinks.clear();
+    m_pendingDownlinks.clear();
+    NetworkServer::DoDispose();
+}
+
+} // namespace lorawan
+} // namespace ns3
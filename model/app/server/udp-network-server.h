@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef UDP_NETWORK_SERVER_H
+#define UDP_NETWORK_SERVER_H
+
+#include "ns3/LoRaMacCrypto.h"
+#include "ns3/network-server.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/socket.h"
+
+#include <map>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * A lightweight stand-in for a Semtech UDP network server (e.g., ChirpStack).
+ *
+ * This application listens on a UDP port and speaks the packet forwarder
+ * protocol (PUSH_DATA/PUSH_ACK, PULL_DATA/PULL_ACK, PULL_RESP, TX_ACK) with
+ * UdpForwarder instances, either inside the same simulation or with external
+ * gateways through a TapBridge. Uplinks are decoded from the rxpk JSON objects
+ * and handed to the NetworkServer logic (NetworkStatus, NetworkScheduler and
+ * controller components such as ADR), while replies are encoded as timestamped
+ * txpk objects targeting the receive windows of the device.
+ *
+ * Gateways do not need to be registered in advance: they are added to the
+ * NetworkStatus on their first datagram, identified by their EUI.
+ */
+class UdpNetworkServer : public NetworkServer
+{
+  public:
+    static TypeId GetTypeId();
+
+    UdpNetworkServer();
+    ~UdpNetworkServer() override;
+
+    /**
+     * Start the NS application.
+     */
+    void StartApplication() override;
+
+    /**
+     * Stop the NS application.
+     */
+    void StopApplication() override;
+
+    /**
+     * Get the number of uplink packets handed to the network server logic.
+     */
+    uint32_t GetNReceivedUplinks() const;
+
+    /**
+     * Get the number of uplink packets discarded because of an invalid MIC or
+     * an unknown device address.
+     */
+    uint32_t GetNDroppedUplinks() const;
+
+    /**
+     * Get the number of PULL_RESP datagrams sent to gateways.
+     */
+    uint32_t GetNSentDownlinks() const;
+
+    /**
+     * TracedCallback signature for downlink acknowledgments.
+     *
+     * \param [in] latency Time elapsed between PULL_RESP and TX_ACK.
+     * \param [in] error Error reported by the gateway ("NONE" if successful).
+     */
+    typedef void (*TxAckTracedCallback)(Time latency, std::string error);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * UDP endpoints of a gateway, as seen from the server.
+     */
+    struct GatewayEndpoints
+    {
+        Address pushAddress; //!< Source of the last PUSH_DATA
+        Address pullAddress; //!< Source of the last PULL_DATA, where PULL_RESP are sent
+        bool pullKnown;      //!< Whether a PULL_DATA was received yet
+    };
+
+    /**
+     * Reception information of the last uplink of a device.
+     */
+    struct UplinkInfo
+    {
+        uint16_t fCnt;                    //!< Frame counter of the uplink
+        Time arrival;                     //!< Arrival time of the first copy at the server
+        std::map<Address, uint32_t> tmst; //!< Concentrator timestamp for each gateway
+    };
+
+    /**
+     * Socket receive callback, dispatching datagrams by type.
+     */
+    void ReceiveDatagram(Ptr<Socket> socket);
+
+    /**
+     * Parse the rxpk array of a PUSH_DATA datagram.
+     */
+    void HandlePushData(const Address& gwAddress, const char* json);
+
+    /**
+     * Parse the optional txpk_ack object of a TX_ACK datagram.
+     */
+    void HandleTxAck(uint16_t token, const char* json);
+
+    /**
+     * Validate an uplink and hand it to the network server logic.
+     */
+    void HandleUplink(const Address& gwAddress,
+                      uint8_t* payload,
+                      uint16_t size,
+                      uint32_t tmst,
+                      uint8_t sf,
+                      double frequency,
+                      double rssi,
+                      double snr);
+
+    /**
+     * Check the message integrity code of an uplink PHYPayload.
+     */
+    bool CheckMic(uint8_t* payload, uint16_t size);
+
+    /**
+     * Get (and register, if new) the gateway with the given EUI.
+     */
+    Address GetGateway(const uint8_t* eui);
+
+    /**
+     * Encode a reply as a PULL_RESP datagram and send it to the gateway.
+     *
+     * Installed as the NetworkStatus send callback.
+     */
+    void SendPullResp(Ptr<Packet> packet, Address gwAddress);
+
+    /**
+     * Send a 4-byte acknowledgment datagram.
+     */
+    void SendAck(uint8_t version, uint8_t tokenH, uint8_t tokenL, uint8_t type, Address to);
+
+    uint16_t m_port;                  //!< UDP port the server listens on
+    Time m_downlinkLead;              //!< Time in advance of RX windows at which PULL_RESP are sent
+    bool m_enableCrypto;              //!< Whether uplink MICs are verified
+    uint8_t m_txPower;                //!< Power of downlink transmissions (dBm)
+    Ptr<Socket> m_socket;             //!< Listening socket
+    LoRaMacCrypto* m_crypto;          //!< Crypto engine for MIC verification
+    Ptr<UniformRandomVariable> m_rng; //!< To draw PULL_RESP tokens
+
+    std::map<Address, GatewayEndpoints> m_gateways;    //!< Known gateways by EUI address
+    std::map<LoraDeviceAddress, UplinkInfo> m_uplinks; //!< Last uplink of each device
+    std::map<uint16_t, Time> m_pendingDownlinks;       //!< Send time of unacknowledged PULL_RESP
+
+    uint32_t m_nReceivedUplinks; //!< Uplinks handed to the network server logic
+    uint32_t m_nDroppedUplinks;  //!< Uplinks discarded (MIC, unknown device)
+    uint32_t m_nSentDownlinks;   //!< PULL_RESP sent
+
+    TracedCallback<Ptr<const Packet>> m_micFailure;     //!< Fired on invalid MIC
+    TracedCallback<Time, std::string> m_txAcknowledged; //!< Fired on TX_ACK reception
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* UDP_NETWORK_SERVER_H */
@@ -22,9 +22,13 @@
 #include "udp-forwarder.h"
 
 #include "ns3/base64.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/gateway-lorawan-mac.h"
+#include "ns3/host-udp-socket.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/log.h"
+#include "ns3/lora-phy-math.h"
 #include "ns3/lora-tag.h"
 #include "ns3/mac64-address.h"
 #include "ns3/nstime.h"
@@ -66,11 +70,41 @@ UdpForwarder::GetTypeId()
                                           "The destination port of the outbound packets",
                                           UintegerValue(1700),
                                           MakeUintegerAccessor(&UdpForwarder::m_peerPort),
-                                          MakeUintegerChecker<uint16_t>());
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("ClockSource",
+                                          "Clock driving the concentrator counter, rxpk "
+                                          "timestamps, the JIT queue and the protocol timing",
+                                          EnumValue(UdpForwarder::HOST),
+                                          MakeEnumAccessor(&UdpForwarder::m_clockSource),
+                                          MakeEnumChecker(UdpForwarder::HOST,
+                                                          "HOST",
+                                                          UdpForwarder::SIMULATOR,
+                                                          "SIMULATOR"))
+                            .AddAttribute("TimeDilation",
+                                          "Simulated seconds elapsing in one wall-clock second "
+                                          "(SIMULATOR clock only). Used to convert the timeouts "
+                                          "of the exchanges with the server to simulated time",
+                                          DoubleValue(1.0),
+                                          MakeDoubleAccessor(&UdpForwarder::m_timeDilation),
+                                          MakeDoubleChecker<double>(1e-3))
+                            .AddAttribute("Transport",
+                                          "Transport of the PUSH/PULL datagrams: sockets of the "
+                                          "simulated node, or real sockets of the host bypassing "
+                                          "the simulated network (RemoteAddress must then be "
+                                          "reachable from the host)",
+                                          EnumValue(UdpForwarder::SIMULATED_SOCKETS),
+                                          MakeEnumAccessor(&UdpForwarder::m_transport),
+                                          MakeEnumChecker(UdpForwarder::SIMULATED_SOCKETS,
+                                                          "SIMULATED",
+                                                          UdpForwarder::HOST_SOCKETS,
+                                                          "HOST"));
     return tid;
 }
 
 UdpForwarder::UdpForwarder()
+    : m_transport(SIMULATED_SOCKETS),
+      m_clockSource(HOST),
+      m_timeDilation(1.0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -87,6 +121,7 @@ UdpForwarder::DoDispose()
     m_sockUp = nullptr;
     m_sockDown = nullptr;
     m_mac = nullptr;
+    m_recorder = nullptr;
     Application::DoDispose();
 }
 
@@ -116,59 +151,96 @@ bool
 UdpForwarder::ReceiveFromLora(Ptr<LorawanMac> mac, Ptr<const Packet> packet)
 {
     NS_LOG_FUNCTION(this << packet);
-    Ptr<Packet> pktcpy = packet->Copy();
 
     LoraTag tag;
-    pktcpy->RemovePacketTag(tag);
-
-    timeval raw_time;
-    gettimeofday(&raw_time, nullptr);
+    packet->PeekPacketTag(tag);
 
     lgw_pkt_rx_s p;
     p.freq_hz = (uint32_t)tag.GetFrequency() + 0.5;
     p.if_chain = 0;
     p.status = STAT_CRC_OK;
-    p.count_us = raw_time.tv_sec * 1000000UL + raw_time.tv_usec; /* convert time in µs */
+    p.count_us = GetConcentratorCount();
     p.rf_chain = 0;
     p.modulation = MOD_LORA;
     p.bandwidth = BW_125KHZ;
-    switch (tag.GetDataRate())
-    {
-    case 5:
-        p.datarate = DR_LORA_SF7;
-        break;
-    case 4:
-        p.datarate = DR_LORA_SF8;
-        break;
-    case 3:
-        p.datarate = DR_LORA_SF9;
-        break;
-    case 2:
-        p.datarate = DR_LORA_SF10;
-        break;
-    case 1:
-        p.datarate = DR_LORA_SF11;
-        break;
-    case 0:
-        p.datarate = DR_LORA_SF12;
-        break;
-    default:
-        p.datarate = DR_LORA_SF12;
-        break;
-    }
+    // HAL data rates are one bit per SF, from DR_LORA_SF7 up; unknown ones fall back to SF12
+    uint8_t sf = LoraPhyMath::GetSfFromDataRate(tag.GetDataRate());
+    p.datarate = (sf != 0) ? DR_LORA_SF7 << (sf - LoraPhyMath::MIN_SF) : DR_LORA_SF12;
     p.coderate = CR_LORA_4_5;
     p.rssi = tag.GetReceivePower();
     p.snr = tag.GetSnr();
     p.snr_min = tag.GetSnr();
     p.snr_max = tag.GetSnr();
     p.crc = 0; //!> TODO: ?
-    p.size = pktcpy->GetSize();
-    pktcpy->CopyData(p.payload, 256);
+    p.size = packet->GetSize();
+    packet->CopyData(p.payload, 256);
 
-    m_rxPktBuff.push(p);
+    PushRxPacket(p);
     return true;
 }
 
+void
+UdpForwarder::SetRecorder(Ptr<UplinkTraceWriter> recorder)
+{
+    NS_LOG_FUNCTION(this << recorder);
+    m_recorder = recorder;
+}
+
+void
+UdpForwarder::InjectUplink(lgw_pkt_rx_s packet)
+{
+    NS_LOG_FUNCTION(this);
+    packet.count_us = GetConcentratorCount();
+    PushRxPacket(packet);
+}
+
+void
+UdpForwarder::PushRxPacket(const lgw_pkt_rx_s& packet)
+{
+    if (m_recorder)
+    {
+        m_recorder->Write({Simulator::Now(), GetNode()->GetId(), packet});
+    }
+    m_rxPktBuff.push(packet);
+}
+
+uint32_t
+UdpForwarder::GetRxBufferSize() const
+{
+    return m_rxPktBuff.size();
+}
+
+uint32_t
+UdpForwarder::GetJitQueueSize() const
+{
+    return jit_queue.num_pkt;
+}
+
+uint64_t
+UdpForwarder::GetNPushDataSent() const
+{
+    return m_nPushDataSent;
+}
+
+uint64_t
+UdpForwarder::GetNPushAckReceived() const
+{
+    return m_nPushAckReceived;
+}
+
+Ptr<Socket>
+UdpForwarder::CreateUdpSocket() const
+{
+    if (m_transport == HOST_SOCKETS)
+    {
+        Ptr<HostUdpSocket> socket = CreateObject<HostUdpSocket>();
+        socket->SetNode(GetNode());
+        return socket;
+    }
+    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+    return Socket::CreateSocket(GetNode(), tid);
+}
+
 // This will act as the main of the protocol
 void
 UdpForwarder::StartApplication()
@@ -185,8 +257,7 @@ UdpForwarder::StartApplication()
     /* Socket up */
     if (bool(m_sockUp) == 0)
     {
-        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-        m_sockUp = Socket::CreateSocket(GetNode(), tid);
+        m_sockUp = CreateUdpSocket();
         if (Ipv4Address::IsMatchingType(m_peerAddress))
         {
             if (m_sockUp->Bind() == -1)
@@ -207,8 +278,7 @@ UdpForwarder::StartApplication()
     /* Socket down */
     if (bool(m_sockDown) == 0)
     {
-        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-        m_sockDown = Socket::CreateSocket(GetNode(), tid);
+        m_sockDown = CreateUdpSocket();
         if (Ipv4Address::IsMatchingType(m_peerAddress))
         {
             if (m_sockDown->Bind() == -1)
@@ -511,6 +581,38 @@ UdpForwarder::ThreadUp()
             NS_FATAL_ERROR("[up] snprintf failed line " << (unsigned)(__LINE__ - 4));
         }
 
+        /* Packet RX time (virtual clock only, emulating GPS time reference) */
+        if (m_clockSource == SIMULATOR)
+        {
+            struct timeval pkt_utc_time;
+            GetUnixTime(&pkt_utc_time);
+            /* go back in time of the counter difference, handling wrap-up */
+            uint64_t elapsed_us = (uint32_t)(GetConcentratorCount() - p->count_us);
+            uint64_t pkt_utc_us =
+                pkt_utc_time.tv_sec * 1000000ULL + pkt_utc_time.tv_usec - elapsed_us;
+            time_t pkt_utc_sec = pkt_utc_us / 1000000ULL;
+            struct tm x;
+            gmtime_r(&pkt_utc_sec, &x);
+            j = snprintf((char*)(buff_up + buff_index),
+                         TX_BUFF_SIZE - buff_index,
+                         ",\"time\":\"%04i-%02i-%02iT%02i:%02i:%02i.%06liZ\"",
+                         (x.tm_year) + 1900,
+                         (x.tm_mon) + 1,
+                         x.tm_mday,
+                         x.tm_hour,
+                         x.tm_min,
+                         x.tm_sec,
+                         (long)(pkt_utc_us % 1000000ULL)); /* ISO 8601 format */
+            if (j > 0)
+            {
+                buff_index += j;
+            }
+            else
+            {
+                NS_FATAL_ERROR("[up] snprintf failed line " << (unsigned)(__LINE__ - 4));
+            }
+        }
+
         /* Packet concentrator channel, RF chain & RX frequency, 34-36 useful chars */
         j = snprintf((char*)(buff_up + buff_index),
                      TX_BUFF_SIZE - buff_index,
@@ -778,14 +880,15 @@ UdpForwarder::ThreadUp()
         NS_LOG_INFO("Error while sending " << buff_index << " bytes to " << m_peerAddressString);
     }
 #endif // NS3_LOG_ENABLE
-    clock_gettime(CLOCK_MONOTONIC, &m_upSendTime);
+    GetMonotonicTime(&m_upSendTime);
     meas_up_dgram_sent += 1;
+    m_nPushDataSent++;
     meas_up_network_byte += buff_index;
 
     /* wait for acknowledge (in 2 times, to catch extra packets) */
     m_remainingRecvAckAttempts = 2;
     /* by default, act as if both ack recv timed out; re-scheduled sooner by ack recv */
-    m_upEvent = Simulator::Schedule(MicroSeconds(push_timeout_half.tv_usec * 2),
+    m_upEvent = Simulator::Schedule(DilateTimeout(MicroSeconds(push_timeout_half.tv_usec * 2)),
                                     &UdpForwarder::ThreadUp,
                                     this);
 }
@@ -802,7 +905,7 @@ UdpForwarder::ReceiveAck(Ptr<Socket> sockUp)
     uint8_t buff_ack[32]; /* buffer to receive acknowledges */
 
     j = sockUp->Recv(buff_ack, sizeof buff_ack, 0);
-    clock_gettime(CLOCK_MONOTONIC, &m_upRecvTime);
+    GetMonotonicTime(&m_upRecvTime);
     if ((j < 4) || (buff_ack[0] != PROTOCOL_VERSION) || (buff_ack[3] != PKT_PUSH_ACK))
     {
         // NS_LOG_WARN ("[up] ignored invalid non-ACL packet");
@@ -818,6 +921,7 @@ UdpForwarder::ReceiveAck(Ptr<Socket> sockUp)
         NS_LOG_INFO("[up] PUSH_ACK received in "
                     << (int)(1000 * difftimespec(m_upRecvTime, m_upSendTime)) << " ms");
         meas_up_ack_rcv += 1;
+        m_nPushAckReceived++;
         m_remainingRecvAckAttempts = 0; /* break; */
     }
 
@@ -871,7 +975,7 @@ UdpForwarder::ThreadDown()
                                            << m_peerAddressString);
     }
 #endif // NS3_LOG_ENABLE
-    clock_gettime(CLOCK_MONOTONIC, &m_downSendTime);
+    GetMonotonicTime(&m_downSendTime);
     meas_dw_pull_sent += 1;
     m_reqAck = false;
     m_autoquitCnt++;
@@ -887,11 +991,12 @@ UdpForwarder::ThreadDown()
 void
 UdpForwarder::CheckPullCondition()
 {
-    if ((int)difftimespec(m_downRecvTime, m_downSendTime) < keepalive_time)
+    if (difftimespec(m_downRecvTime, m_downSendTime) <
+        DilateTimeout(Seconds(keepalive_time)).GetSeconds())
     {
         /* emulate socket blocked by recv */
         Simulator::Cancel(m_downEvent);
-        m_downEvent = Simulator::Schedule(MicroSeconds(pull_timeout.tv_usec),
+        m_downEvent = Simulator::Schedule(DilateTimeout(MicroSeconds(pull_timeout.tv_usec)),
                                           &UdpForwarder::SockDownTimeout,
                                           this);
     }
@@ -905,7 +1010,7 @@ UdpForwarder::CheckPullCondition()
 void
 UdpForwarder::SockDownTimeout()
 {
-    clock_gettime(CLOCK_MONOTONIC, &m_downRecvTime);
+    GetMonotonicTime(&m_downRecvTime);
     CheckPullCondition();
 }
 
@@ -937,7 +1042,7 @@ UdpForwarder::ReceiveDatagram(Ptr<Socket> sockDown)
 
     /* try to receive a datagram */
     msg_len = sockDown->Recv(buff_down, (sizeof buff_down) - 1, 0);
-    clock_gettime(CLOCK_MONOTONIC, &m_downRecvTime);
+    GetMonotonicTime(&m_downRecvTime);
 
     /* if no network message was received, got back to listening sock_down socket */
     if (msg_len == -1)
@@ -1308,8 +1413,8 @@ UdpForwarder::ReceiveDatagram(Ptr<Socket> sockDown)
     /* insert packet to be sent into JIT queue */
     if (jit_result == JIT_ERROR_OK)
     {
-        gettimeofday(&current_unix_time, nullptr);
-        get_concentrator_time(&current_concentrator_time, current_unix_time);
+        GetUnixTime(&current_unix_time);
+        GetConcentratorTime(&current_concentrator_time, current_unix_time);
         jit_result = jit_enqueue(&jit_queue, &current_concentrator_time, &txpkt, downlink_type);
         if (jit_result != JIT_ERROR_OK)
         {
@@ -1337,8 +1442,8 @@ UdpForwarder::ThreadJit()
     uint8_t tx_status;
 
     /* transfer data and metadata to the concentrator, and schedule TX */
-    gettimeofday(&current_unix_time, nullptr);
-    get_concentrator_time(&current_concentrator_time, current_unix_time);
+    GetUnixTime(&current_unix_time);
+    GetConcentratorTime(&current_concentrator_time, current_unix_time);
     jit_result = jit_peek(&jit_queue, &current_concentrator_time, &pkt_index);
     if (jit_result == JIT_ERROR_OK)
     {
@@ -1421,7 +1526,9 @@ UdpForwarder::CollectStatistics()
     float dw_ack_ratio;
 
     /* get timestamp for statistics */
-    t = time(nullptr);
+    struct timeval current_unix_time;
+    GetUnixTime(&current_unix_time);
+    t = current_unix_time.tv_sec;
     strftime(stat_timestamp, sizeof stat_timestamp, "%F %T %Z", gmtime(&t));
 
     /* aggregate upstream statistics */
@@ -1806,7 +1913,16 @@ UdpForwarder::LgwSend(struct lgw_pkt_tx_s pkt_data)
     tx_allowed = true;
     if (tx_allowed)
     {
-        m_mac->Send(pkt);
+        /* the virtual concentrator emits when its counter reaches count_us, like the SX1301 */
+        int32_t wait_us = (int32_t)(pkt_data.count_us - GetConcentratorCount());
+        if (m_clockSource == SIMULATOR && wait_us > 0)
+        {
+            Simulator::Schedule(MicroSeconds(wait_us), &GatewayLorawanMac::Send, m_mac, pkt);
+        }
+        else
+        {
+            m_mac->Send(pkt);
+        }
     }
     else
     {
@@ -1817,6 +1933,67 @@ UdpForwarder::LgwSend(struct lgw_pkt_tx_s pkt_data)
     return LGW_HAL_SUCCESS;
 }
 
+void
+UdpForwarder::GetUnixTime(struct timeval* tv) const
+{
+    if (m_clockSource == HOST)
+    {
+        gettimeofday(tv, nullptr);
+        return;
+    }
+    /* virtual UTC time starts from the host time at first use, common to all gateways */
+    static const int64_t epoch_us = []() {
+        struct timeval host_time;
+        gettimeofday(&host_time, nullptr);
+        return host_time.tv_sec * 1000000LL + host_time.tv_usec -
+               Simulator::Now().GetMicroSeconds();
+    }();
+    int64_t now_us = epoch_us + Simulator::Now().GetMicroSeconds();
+    tv->tv_sec = now_us / 1000000;
+    tv->tv_usec = now_us % 1000000;
+}
+
+void
+UdpForwarder::GetConcentratorTime(struct timeval* concent_time, struct timeval unix_time) const
+{
+    if (m_clockSource == HOST)
+    {
+        get_concentrator_time(concent_time, unix_time);
+        return;
+    }
+    /* the virtual counter has no offset from unix time (see GetConcentratorCount): the JIT
+     * queue hands packets over TX_JIT_DELAY in advance and LgwSend emits them on time */
+    *concent_time = unix_time;
+}
+
+void
+UdpForwarder::GetMonotonicTime(struct timespec* ts) const
+{
+    if (m_clockSource == HOST)
+    {
+        clock_gettime(CLOCK_MONOTONIC, ts);
+        return;
+    }
+    int64_t now_ns = Simulator::Now().GetNanoSeconds();
+    ts->tv_sec = now_ns / 1000000000;
+    ts->tv_nsec = now_ns % 1000000000;
+}
+
+uint32_t
+UdpForwarder::GetConcentratorCount() const
+{
+    struct timeval raw_time;
+    GetUnixTime(&raw_time);
+    return raw_time.tv_sec * 1000000UL + raw_time.tv_usec; /* convert time in µs */
+}
+
+Time
+UdpForwarder::DilateTimeout(Time timeout) const
+{
+    /* round trips with the server happen in wall-clock time */
+    return (m_clockSource == SIMULATOR) ? timeout * m_timeDilation : timeout;
+}
+
 double
 UdpForwarder::difftimespec(struct timespec end, struct timespec beginning)
 {
@@ -31,6 +31,7 @@
 #include "ns3/packet.h"
 #include "ns3/ptr.h"
 #include "ns3/socket.h"
+#include "ns3/uplink-trace.h"
 
 #include <queue>
 
@@ -104,6 +105,24 @@ namespace lorawan
 class UdpForwarder : public Application
 {
   public:
+    /**
+     * Clock driving the concentrator counter and the protocol timing.
+     */
+    enum ClockSource
+    {
+        HOST,      //!< Host wall-clock, for real-time emulation
+        SIMULATOR, //!< Virtual clock derived from simulated time
+    };
+
+    /**
+     * Transport of the datagrams exchanged with the server.
+     */
+    enum Transport
+    {
+        SIMULATED_SOCKETS, //!< ns-3 UDP sockets over the simulated network of the node
+        HOST_SOCKETS,      //!< Real UDP sockets of the host (see HostUdpSocket)
+    };
+
     /**
      * \brief Get the type ID.
      * \return the object TypeId
@@ -140,6 +159,40 @@ class UdpForwarder : public Application
      */
     bool ReceiveFromLora(Ptr<LorawanMac> mac, Ptr<const Packet> packet);
 
+    /**
+     * Record every packet forwarded from now on to an uplink trace.
+     *
+     * \param recorder The trace writer, possibly shared with other forwarders.
+     */
+    void SetRecorder(Ptr<UplinkTraceWriter> recorder);
+
+    /**
+     * Forward a packet as if it had just been received by the concentrator.
+     *
+     * \param packet The packet, whose counter is set to the current one.
+     */
+    void InjectUplink(lgw_pkt_rx_s packet);
+
+    /**
+     * Get the number of received packets waiting to be forwarded.
+     */
+    uint32_t GetRxBufferSize() const;
+
+    /**
+     * Get the number of downlink packets in the just-in-time queue.
+     */
+    uint32_t GetJitQueueSize() const;
+
+    /**
+     * Get the number of PUSH_DATA datagrams sent since the start.
+     */
+    uint64_t GetNPushDataSent() const;
+
+    /**
+     * Get the number of PUSH_ACK datagrams received since the start.
+     */
+    uint64_t GetNPushAckReceived() const;
+
   protected:
     void DoDispose() override;
 
@@ -155,6 +208,22 @@ class UdpForwarder : public Application
 
     Ptr<GatewayLorawanMac> m_mac; //!< Pointer to the node's GatewayLorawanMac
 
+    Transport m_transport;               //!< Transport of the datagrams exchanged with the server
+    Ptr<Socket> CreateUdpSocket() const; //!< Create a socket for the configured transport
+
+    /* -------------------------------------------------------------------------- */
+    /* ---------------- Concentrator clock -------------------------------------- */
+
+    ClockSource m_clockSource; //!< Clock used for timestamps and protocol timing
+    double m_timeDilation;     //!< Simulated seconds elapsing in one wall-clock second
+
+    void GetUnixTime(struct timeval* tv) const;       //!< Replaces gettimeofday
+    void GetMonotonicTime(struct timespec* ts) const; //!< Replaces clock_gettime(CLOCK_MONOTONIC)
+    void GetConcentratorTime(struct timeval* concent_time,
+                             struct timeval unix_time) const; //!< Replaces get_concentrator_time
+    uint32_t GetConcentratorCount() const;            //!< Current concentrator counter (us)
+    Time DilateTimeout(Time timeout) const; //!< Convert a host-network timeout to simulated time
+
     /* -------------------------------------------------------------------------- */
     /* ---------------- Ns-3 INTEGRATION of lora_pkt_fwd.c ---------------------- */
 
@@ -204,6 +273,9 @@ class UdpForwarder : public Application
     int LgwReceive(int nb_pkt_max, lgw_pkt_rx_s rxpkt[]); //!< Implements concentrator lgw_receive
     std::queue<lgw_pkt_rx_s> m_rxPktBuff; //!< Emulate the concentrator reception packet buffer
 
+    void PushRxPacket(const lgw_pkt_rx_s& packet); //!< Record and buffer a received packet
+    Ptr<UplinkTraceWriter> m_recorder;             //!< Trace of forwarded packets, if any
+
     int LgwStatus(uint8_t select, uint8_t* code);
     int LgwSend(struct lgw_pkt_tx_s pkt_data);
 
@@ -250,6 +322,8 @@ class UdpForwarder : public Application
     uint32_t meas_up_payload_byte = 0; /* sum of radio payload bytes sent for upstream traffic */
     uint32_t meas_up_dgram_sent = 0;   /* number of datagrams sent for upstream traffic */
     uint32_t meas_up_ack_rcv = 0;      /* number of datagrams acknowledged for upstream traffic */
+    uint64_t m_nPushDataSent = 0;      /* number of datagrams sent since the start (never reset) */
+    uint64_t m_nPushAckReceived = 0;   /* number of datagrams acknowledged since the start */
 
     uint32_t meas_dw_pull_sent = 0; /* number of PULL requests sent for downstream traffic */
     uint32_t meas_dw_ack_rcv = 0; /* number of PULL requests acknowledged for downstream traffic */
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "uplink-replayer.h"
+
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("UplinkReplayer");
+
+NS_OBJECT_ENSURE_REGISTERED(UplinkReplayer);
+
+TypeId
+UplinkReplayer::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::UplinkReplayer")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<UplinkReplayer>()
+            .AddAttribute("File",
+                          "Uplink trace to replay",
+                          StringValue(""),
+                          MakeStringAccessor(&UplinkReplayer::m_filename),
+                          MakeStringChecker())
+            .AddAttribute("Speed",
+                          "Replay speed relative to the recording, 0 for as fast as possible",
+                          DoubleValue(1),
+                          MakeDoubleAccessor(&UplinkReplayer::m_speed),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("TimeShift",
+                          "Replay time of the origin of the trace",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&UplinkReplayer::m_timeShift),
+                          MakeTimeChecker())
+            .AddAttribute("MaxBacklog",
+                          "Packets left in the receive buffer of each forwarder when replaying "
+                          "as fast as possible",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&UplinkReplayer::m_maxBacklog),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("PollInterval",
+                          "Period at which backlogged forwarders are polled when replaying "
+                          "as fast as possible",
+                          TimeValue(MilliSeconds(10)),
+                          MakeTimeAccessor(&UplinkReplayer::m_pollInterval),
+                          MakeTimeChecker(MicroSeconds(1)))
+            .AddAttribute("FCntOffset",
+                          "Offset added to the frame counter of replayed data uplinks",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&UplinkReplayer::m_fCntOffset),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("EnableCryptography",
+                          "Recompute the MIC of uplinks with a rewritten frame counter",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&UplinkReplayer::m_enableCrypto),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+UplinkReplayer::UplinkReplayer()
+    : m_speed(1),
+      m_maxBacklog(64),
+      m_pollInterval(MilliSeconds(10)),
+      m_fCntOffset(0),
+      m_enableCrypto(false),
+      m_hasNext(false),
+      m_nReplayed(0),
+      m_nSkipped(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_crypto = new LoRaMacCrypto();
+}
+
+UplinkReplayer::~UplinkReplayer()
+{
+    NS_LOG_FUNCTION(this);
+    delete m_crypto;
+}
+
+void
+UplinkReplayer::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_event);
+    m_forwarders.clear();
+    Object::DoDispose();
+}
+
+void
+UplinkReplayer::AddForwarders(NodeContainer gateways)
+{
+    NS_LOG_FUNCTION(this);
+    for (auto node = gateways.Begin(); node != gateways.End(); ++node)
+    {
+        Ptr<UdpForwarder> forwarder;
+        for (uint32_t i = 0; i < (*node)->GetNApplications() && !forwarder; ++i)
+        {
+            forwarder = DynamicCast<UdpForwarder>((*node)->GetApplication(i));
+        }
+        NS_ABORT_MSG_UNLESS(forwarder, "Gateway " << (*node)->GetId() << " has no UdpForwarder");
+        m_forwarders[(*node)->GetId()] = forwarder;
+    }
+}
+
+void
+UplinkReplayer::Start()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_reader.Open(m_filename), "Invalid uplink trace " << m_filename);
+    m_hasNext = m_reader.Read(m_next);
+    ScheduleNext();
+}
+
+void
+UplinkReplayer::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_event);
+    m_hasNext = false;
+}
+
+uint64_t
+UplinkReplayer::GetNReplayed() const
+{
+    return m_nReplayed;
+}
+
+uint64_t
+UplinkReplayer::GetNSkipped() const
+{
+    return m_nSkipped;
+}
+
+Time
+UplinkReplayer::GetReplayTime(Time recorded) const
+{
+    if (m_speed == 1)
+    {
+        return m_timeShift + recorded;
+    }
+    return m_timeShift + NanoSeconds(std::llround(recorded.GetNanoSeconds() / m_speed));
+}
+
+void
+UplinkReplayer::ScheduleNext()
+{
+    if (!m_hasNext)
+    {
+        NS_LOG_INFO("Trace replayed: " << m_nReplayed << " records, " << m_nSkipped
+                                       << " skipped");
+        return;
+    }
+    if (m_speed == 0)
+    {
+        m_event = Simulator::ScheduleNow(&UplinkReplayer::ReplayAsFastAsPossible, this);
+        return;
+    }
+    Time delay = Max(GetReplayTime(m_next.time) - Simulator::Now(), Seconds(0));
+    m_event = Simulator::Schedule(delay, &UplinkReplayer::Replay, this);
+}
+
+void
+UplinkReplayer::Replay()
+{
+    NS_LOG_FUNCTION(this);
+    do
+    {
+        Inject();
+    } while (m_hasNext && GetReplayTime(m_next.time) <= Simulator::Now());
+    ScheduleNext();
+}
+
+void
+UplinkReplayer::ReplayAsFastAsPossible()
+{
+    NS_LOG_FUNCTION(this);
+    while (m_hasNext)
+    {
+        auto it = m_forwarders.find(m_next.gateway);
+        if (it != m_forwarders.end() && it->second->GetRxBufferSize() >= m_maxBacklog)
+        {
+            m_event = Simulator::Schedule(m_pollInterval,
+                                          &UplinkReplayer::ReplayAsFastAsPossible,
+                                          this);
+            return;
+        }
+        Inject();
+    }
+    ScheduleNext();
+}
+
+void
+UplinkReplayer::Inject()
+{
+    auto it = m_forwarders.find(m_next.gateway);
+    if (it == m_forwarders.end())
+    {
+        NS_LOG_DEBUG("Skipping record of unknown gateway " << m_next.gateway);
+        m_nSkipped++;
+    }
+    else
+    {
+        if (m_fCntOffset)
+        {
+            RewriteFCnt(m_next.packet);
+        }
+        it->second->InjectUplink(m_next.packet);
+        m_nReplayed++;
+    }
+    m_hasNext = m_reader.Read(m_next);
+}
+
+void
+UplinkReplayer::RewriteFCnt(lgw_pkt_rx_s& packet)
+{
+    /* MHDR (1) + FHDR (7 at least) + MIC (4), data uplinks only */
+    uint8_t* payload = packet.payload;
+    uint8_t mType = payload[0] >> 5;
+    if (packet.size < 12 || (mType != 0b010 && mType != 0b100))
+    {
+        return;
+    }
+    uint32_t devAddr = payload[1];
+    devAddr |= payload[2] << 8;
+    devAddr |= payload[3] << 16;
+    devAddr |= payload[4] << 24;
+    uint32_t fCnt = payload[6];
+    fCnt |= payload[7] << 8;
+    fCnt += m_fCntOffset;
+    payload[6] = fCnt & 0xff;
+    payload[7] = (fCnt >> 8) & 0xff;
+
+    if (m_enableCrypto)
+    {
+        uint32_t mic = 0;
+        m_crypto->ComputeCmacB0(payload,
+                                packet.size - 4,
+                                F_NWK_S_INT_KEY,
+                                false,
+                                UPLINK,
+                                devAddr,
+                                fCnt,
+                                &mic);
+        std::memcpy(payload + packet.size - 4, &mic, 4);
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef UPLINK_REPLAYER_H
+#define UPLINK_REPLAYER_H
+
+#include "ns3/LoRaMacCrypto.h"
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/udp-forwarder.h"
+#include "ns3/uplink-trace.h"
+
+#include <map>
+#include <string>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Re-injection of an uplink trace through the UdpForwarder of gateways.
+ *
+ * Records are handed to the forwarder of the gateway with the recorded node
+ * id, as if its concentrator had just received them, without any PHY or MAC
+ * simulation. A record recorded at time t is replayed at TimeShift + t / Speed.
+ * With a null Speed, records are replayed as fast as the forwarders fetch
+ * them, keeping at most MaxBacklog packets in the receive buffer of each
+ * forwarder. Records are always replayed in the order of the trace.
+ *
+ * A non-null FCntOffset is added to the frame counter of data uplinks, so that
+ * a trace can be replayed repeatedly against the same network server.
+ */
+class UplinkReplayer : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    UplinkReplayer();
+    ~UplinkReplayer() override;
+
+    /**
+     * Replay the records of these gateways through their UdpForwarder.
+     *
+     * Records of other gateways are skipped.
+     *
+     * \param gateways The gateways.
+     */
+    void AddForwarders(NodeContainer gateways);
+
+    /**
+     * Open the trace and start replaying it.
+     */
+    void Start();
+
+    /**
+     * Stop replaying the trace.
+     */
+    void Stop();
+
+    /**
+     * Get the number of records replayed.
+     */
+    uint64_t GetNReplayed() const;
+
+    /**
+     * Get the number of records skipped because of an unknown gateway.
+     */
+    uint64_t GetNSkipped() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Get the time at which a record is replayed.
+     */
+    Time GetReplayTime(Time recorded) const;
+
+    /**
+     * Schedule the replay of the next record, if any.
+     */
+    void ScheduleNext();
+
+    /**
+     * Replay all records due now.
+     */
+    void Replay();
+
+    /**
+     * Replay records until a forwarder is backlogged, then poll again.
+     */
+    void ReplayAsFastAsPossible();
+
+    /**
+     * Hand the next record to its forwarder, and read the following one.
+     */
+    void Inject();
+
+    /**
+     * Add the offset to the frame counter of a data uplink, and recompute its MIC.
+     */
+    void RewriteFCnt(lgw_pkt_rx_s& packet);
+
+    std::string m_filename;  //!< Trace file
+    double m_speed;          //!< Replay speed, 0 for as fast as possible
+    Time m_timeShift;        //!< Replay time of the trace origin
+    uint32_t m_maxBacklog;   //!< Receive buffer bound when replaying as fast as possible
+    Time m_pollInterval;     //!< Backlog polling period when replaying as fast as possible
+    uint32_t m_fCntOffset;   //!< Added to the frame counter of data uplinks
+    bool m_enableCrypto;     //!< Recompute the MIC of rewritten frames
+    LoRaMacCrypto* m_crypto; //!< Crypto engine for MIC computation
+
+    std::map<uint32_t, Ptr<UdpForwarder>> m_forwarders; //!< Forwarders by gateway node id
+    UplinkTraceReader m_reader;                         //!< The trace
+    UplinkRecord m_next;                                //!< Next record to replay
+    bool m_hasNext;                                     //!< Whether m_next is valid
+    EventId m_event;                                    //!< Next replay event
+    uint64_t m_nReplayed;                               //!< Records replayed
+    uint64_t m_nSkipped;                                //!< Records skipped
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* UPLINK_REPLAYER_H */
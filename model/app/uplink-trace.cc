@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "uplink-trace.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("UplinkTrace");
+
+NS_OBJECT_ENSURE_REGISTERED(UplinkTraceWriter);
+
+/* File header: magic and version */
+#define UPLINK_TRACE_MAGIC "ELUT"
+#define UPLINK_TRACE_VERSION 1
+#define UPLINK_TRACE_HEADER_SIZE 8
+
+/* Fixed part of a record, before the payload */
+#define UPLINK_RECORD_SIZE 26
+
+namespace
+{
+/* Store a value little-endian */
+template <typename T>
+uint8_t*
+Put(uint8_t* buffer, T value)
+{
+    for (uint32_t i = 0; i < sizeof(T); ++i)
+    {
+        *buffer++ = uint8_t(uint64_t(value) >> (8 * i));
+    }
+    return buffer;
+}
+
+/* Load a little-endian value */
+template <typename T>
+const uint8_t*
+Get(const uint8_t* buffer, T& value)
+{
+    uint64_t v = 0;
+    for (uint32_t i = 0; i < sizeof(T); ++i)
+    {
+        v |= uint64_t(*buffer++) << (8 * i);
+    }
+    value = T(v);
+    return buffer;
+}
+
+uint32_t
+FloatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float
+BitsFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+} // namespace
+
+TypeId
+UplinkTraceWriter::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::UplinkTraceWriter")
+                            .SetParent<Object>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<UplinkTraceWriter>();
+    return tid;
+}
+
+UplinkTraceWriter::UplinkTraceWriter()
+    : m_nRecords(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+UplinkTraceWriter::~UplinkTraceWriter()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+}
+
+void
+UplinkTraceWriter::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+    Object::DoDispose();
+}
+
+void
+UplinkTraceWriter::Open(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    Close();
+    m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open uplink trace " << filename);
+    uint8_t header[UPLINK_TRACE_HEADER_SIZE] = {};
+    std::memcpy(header, UPLINK_TRACE_MAGIC, 4);
+    header[4] = UPLINK_TRACE_VERSION;
+    m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void
+UplinkTraceWriter::Write(const UplinkRecord& record)
+{
+    NS_ASSERT_MSG(m_file.is_open(), "Uplink trace not open");
+    const lgw_pkt_rx_s& p = record.packet;
+    uint8_t size = std::min<uint16_t>(p.size, 255);
+    uint8_t buffer[UPLINK_RECORD_SIZE];
+    uint8_t* i = buffer;
+    i = Put<int64_t>(i, record.time.GetNanoSeconds());
+    i = Put<uint32_t>(i, record.gateway);
+    i = Put<uint32_t>(i, p.freq_hz);
+    i = Put<uint8_t>(i, p.datarate);
+    i = Put<uint32_t>(i, FloatBits(p.rssi));
+    i = Put<uint32_t>(i, FloatBits(p.snr));
+    i = Put<uint8_t>(i, size);
+    m_file.write(reinterpret_cast<const char*>(buffer), sizeof(buffer));
+    m_file.write(reinterpret_cast<const char*>(p.payload), size);
+    m_nRecords++;
+}
+
+void
+UplinkTraceWriter::Close()
+{
+    if (m_file.is_open())
+    {
+        m_file.close();
+    }
+}
+
+uint64_t
+UplinkTraceWriter::GetNRecords() const
+{
+    return m_nRecords;
+}
+
+UplinkTraceReader::UplinkTraceReader()
+{
+}
+
+bool
+UplinkTraceReader::Open(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    m_file.close();
+    m_file.clear();
+    m_file.open(filename, std::ios::in | std::ios::binary);
+    uint8_t header[UPLINK_TRACE_HEADER_SIZE];
+    if (!m_file.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        return false;
+    }
+    return std::memcmp(header, UPLINK_TRACE_MAGIC, 4) == 0 && header[4] == UPLINK_TRACE_VERSION;
+}
+
+bool
+UplinkTraceReader::Read(UplinkRecord& record)
+{
+    uint8_t buffer[UPLINK_RECORD_SIZE];
+    if (!m_file.read(reinterpret_cast<char*>(buffer), sizeof(buffer)))
+    {
+        return false;
+    }
+    lgw_pkt_rx_s& p = record.packet;
+    int64_t time;
+    uint8_t datarate;
+    uint32_t rssi;
+    uint32_t snr;
+    uint8_t size;
+    const uint8_t* i = buffer;
+    i = Get(i, time);
+    i = Get(i, record.gateway);
+    i = Get(i, p.freq_hz);
+    i = Get(i, datarate);
+    i = Get(i, rssi);
+    i = Get(i, snr);
+    i = Get(i, size);
+    if (!m_file.read(reinterpret_cast<char*>(p.payload), size))
+    {
+        return false;
+    }
+    record.time = NanoSeconds(time);
+    // Same constant fields as packets received by UdpForwarder
+    p.if_chain = 0;
+    p.status = STAT_CRC_OK;
+    p.count_us = 0;
+    p.rf_chain = 0;
+    p.modulation = MOD_LORA;
+    p.bandwidth = BW_125KHZ;
+    p.datarate = datarate;
+    p.coderate = CR_LORA_4_5;
+    p.rssi = BitsFloat(rssi);
+    p.snr = BitsFloat(snr);
+    p.snr_min = p.snr;
+    p.snr_max = p.snr;
+    p.crc = 0;
+    p.size = size;
+    return true;
+}
+
+void
+UplinkTraceReader::Rewind()
+{
+    m_file.clear();
+    m_file.seekg(UPLINK_TRACE_HEADER_SIZE);
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef UPLINK_TRACE_H
+#define UPLINK_TRACE_H
+
+#include "ns3/loragw_hal.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <fstream>
+#include <string>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * An uplink forwarded by a gateway, as stored in an uplink trace.
+ */
+struct UplinkRecord
+{
+    Time time;           //!< Simulated time at which the gateway received the packet
+    uint32_t gateway;    //!< Node id of the gateway
+    lgw_pkt_rx_s packet; //!< Frequency, datarate, RSSI, SNR and payload of the packet
+};
+
+/**
+ * Writer of uplink traces.
+ *
+ * Traces are a short file header followed by one record per uplink, with
+ * the fields little-endian and packed: time (int64, ns), gateway (uint32),
+ * frequency (uint32, Hz), datarate (uint8, concentrator DR_LORA_* value),
+ * RSSI and SNR (float32), payload size (uint8) and payload. Other fields of
+ * lgw_pkt_rx_s are those of every packet of UdpForwarder.
+ */
+class UplinkTraceWriter : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    UplinkTraceWriter();
+    ~UplinkTraceWriter() override;
+
+    /**
+     * Create the trace file, overwriting it.
+     *
+     * \param filename The name of the file.
+     */
+    void Open(std::string filename);
+
+    /**
+     * Append a record to the trace.
+     */
+    void Write(const UplinkRecord& record);
+
+    /**
+     * Flush and close the trace.
+     */
+    void Close();
+
+    /**
+     * Get the number of records written.
+     */
+    uint64_t GetNRecords() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    std::ofstream m_file; //!< The trace file
+    uint64_t m_nRecords;  //!< Records written
+};
+
+/**
+ * Sequential reader of uplink traces written by UplinkTraceWriter.
+ */
+class UplinkTraceReader
+{
+  public:
+    UplinkTraceReader();
+
+    /**
+     * Open a trace file, and check its header.
+     *
+     * \param filename The name of the file.
+     * \return Whether the file is a valid trace.
+     */
+    bool Open(std::string filename);
+
+    /**
+     * Read the next record.
+     *
+     * \param record The record to fill.
+     * \return False at the end of the trace, or on a truncated record.
+     */
+    bool Read(UplinkRecord& record);
+
+    /**
+     * Go back to the first record.
+     */
+    void Rewind();
+
+  private:
+    std::ifstream m_file; //!< The trace file
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* UPLINK_TRACE_H */
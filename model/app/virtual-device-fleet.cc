@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "virtual-device-fleet.h"
+
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/lorawan-frame-codec.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("VirtualDeviceFleet");
+
+NS_OBJECT_ENSURE_REGISTERED(VirtualDeviceFleet);
+
+namespace
+{
+/* Concentrator datarates of the EU868 LoRa data rates DR0 to DR5 */
+const uint32_t g_concentratorDataRates[] =
+    {DR_LORA_SF12, DR_LORA_SF11, DR_LORA_SF10, DR_LORA_SF9, DR_LORA_SF8, DR_LORA_SF7};
+
+/* Default EU868 uplink channels */
+const uint32_t g_channels[] = {868100000, 868300000, 868500000};
+
+/* Default network session key of LoRaMacCrypto, as registered by ChirpstackHelper */
+const uint8_t g_defaultKey[16] = {0x2B,
+                                  0x7E,
+                                  0x15,
+                                  0x16,
+                                  0x28,
+                                  0xAE,
+                                  0xD2,
+                                  0xA6,
+                                  0xAB,
+                                  0xF7,
+                                  0x15,
+                                  0x88,
+                                  0x09,
+                                  0xCF,
+                                  0x4F,
+                                  0x3C};
+
+/* Application payload of uplinks */
+const uint8_t g_payload[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE] = {};
+
+constexpr uint32_t KEY_SIZE = 16;
+constexpr uint32_t NWK_ADDR_BITS = 25;
+} // namespace
+
+TypeId
+VirtualDeviceFleet::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::VirtualDeviceFleet")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<VirtualDeviceFleet>()
+            .AddAttribute("NwkId",
+                          "NwkID of the device addresses of the fleet",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&VirtualDeviceFleet::m_nwkId),
+                          MakeUintegerChecker<uint8_t>(0, 127))
+            .AddAttribute("FirstNwkAddr",
+                          "NwkAddr of the first device of the fleet, to stay clear of the "
+                          "addresses of other devices in the same NwkID",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&VirtualDeviceFleet::m_firstNwkAddr),
+                          MakeUintegerChecker<uint32_t>(0, (uint32_t(1) << NWK_ADDR_BITS) - 1))
+            .AddAttribute("Interval",
+                          "Time between two uplinks of a device, in seconds",
+                          StringValue("ns3::ExponentialRandomVariable[Mean=600]"),
+                          MakePointerAccessor(&VirtualDeviceFleet::m_interval),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("Rssi",
+                          "RSSI of the reception of an uplink by a gateway, in dBm",
+                          StringValue("ns3::NormalRandomVariable[Mean=-110|Variance=64]"),
+                          MakePointerAccessor(&VirtualDeviceFleet::m_rssi),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("Snr",
+                          "SNR of the reception of an uplink by a gateway, in dB",
+                          StringValue("ns3::NormalRandomVariable[Mean=0|Variance=25]"),
+                          MakePointerAccessor(&VirtualDeviceFleet::m_snr),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("Gateways",
+                          "Number of gateways receiving an uplink, rounded down and "
+                          "limited to the number of gateways",
+                          StringValue("ns3::UniformRandomVariable[Min=1|Max=4]"),
+                          MakePointerAccessor(&VirtualDeviceFleet::m_nGateways),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("PayloadSize",
+                          "Size of the application payload of uplinks",
+                          UintegerValue(10),
+                          MakeUintegerAccessor(&VirtualDeviceFleet::m_payloadSize),
+                          MakeUintegerChecker<uint32_t>(0, 222))
+            .AddAttribute("FPort",
+                          "Port of the application payload of uplinks",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&VirtualDeviceFleet::m_fPort),
+                          MakeUintegerChecker<uint8_t>(1, 223))
+            .AddAttribute("Adr",
+                          "Whether uplinks set the ADR bit",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&VirtualDeviceFleet::m_adr),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+VirtualDeviceFleet::VirtualDeviceFleet()
+    : m_nwkId(1),
+      m_firstNwkAddr(0),
+      m_payloadSize(10),
+      m_fPort(1),
+      m_adr(true),
+      m_dataRateMix({1, 2, 3, 4, 5, 6}),
+      m_running(false),
+      m_nUplinks(0),
+      m_nDownlinks(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_crypto = new LoRaMacCrypto();
+    m_uniform = CreateObject<UniformRandomVariable>();
+}
+
+VirtualDeviceFleet::~VirtualDeviceFleet()
+{
+    NS_LOG_FUNCTION(this);
+    delete m_crypto;
+}
+
+void
+VirtualDeviceFleet::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_event);
+    m_forwarders.clear();
+    m_schedule.clear();
+    m_interval = nullptr;
+    m_rssi = nullptr;
+    m_snr = nullptr;
+    m_nGateways = nullptr;
+    m_uniform = nullptr;
+    Object::DoDispose();
+}
+
+void
+VirtualDeviceFleet::AddDevices(uint32_t n)
+{
+    NS_LOG_FUNCTION(this << n);
+    uint32_t first = m_fCntUp.size();
+    NS_ABORT_MSG_IF(uint64_t(m_firstNwkAddr) + first + n > (uint64_t(1) << NWK_ADDR_BITS),
+                    "Too many devices for a single NwkID");
+    m_fCntUp.resize(first + n, 0);
+    m_fCntDown.resize(first + n, 0);
+    m_pending.resize(first + n, 0);
+    m_dataRate.reserve(first + n);
+    m_homeGateway.reserve(first + n);
+    m_keys.reserve(uint64_t(first + n) * KEY_SIZE);
+    for (uint32_t i = first; i < first + n; ++i)
+    {
+        double draw = m_uniform->GetValue(0, m_dataRateMix.back());
+        auto dr = std::upper_bound(m_dataRateMix.begin(), m_dataRateMix.end(), draw);
+        m_dataRate.push_back(std::min<uint8_t>(dr - m_dataRateMix.begin(), 5));
+        m_homeGateway.push_back(m_uniform->GetInteger(0, UINT32_MAX - 1));
+        m_keys.insert(m_keys.end(), g_defaultKey, g_defaultKey + KEY_SIZE);
+        if (m_running)
+        {
+            ScheduleUplink(i);
+        }
+    }
+    UpdateEvent();
+}
+
+void
+VirtualDeviceFleet::AddGateways(NodeContainer gateways)
+{
+    NS_LOG_FUNCTION(this);
+    for (auto node = gateways.Begin(); node != gateways.End(); ++node)
+    {
+        Ptr<UdpForwarder> forwarder;
+        for (uint32_t i = 0; i < (*node)->GetNApplications() && !forwarder; ++i)
+        {
+            forwarder = DynamicCast<UdpForwarder>((*node)->GetApplication(i));
+        }
+        NS_ABORT_MSG_UNLESS(forwarder, "Gateway " << (*node)->GetId() << " has no UdpForwarder");
+        m_forwarders.push_back(forwarder);
+
+        auto device = DynamicCast<LoraNetDevice>((*node)->GetDevice(0));
+        NS_ABORT_MSG_UNLESS(device, "Gateway " << (*node)->GetId() << " has no LoraNetDevice");
+        device->GetMac()->TraceConnectWithoutContext(
+            "SentNewPacket",
+            MakeCallback(&VirtualDeviceFleet::ReceiveDownlink, this));
+    }
+}
+
+void
+VirtualDeviceFleet::SetDataRateMix(std::vector<double> weights)
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(weights.empty() || weights.size() > 6, "Weights of DR0 to DR5 expected");
+    m_dataRateMix.clear();
+    double sum = 0;
+    for (double w : weights)
+    {
+        NS_ABORT_MSG_IF(w < 0, "Negative data rate weight");
+        sum += w;
+        m_dataRateMix.push_back(sum);
+    }
+    NS_ABORT_MSG_UNLESS(sum > 0, "All data rate weights are null");
+}
+
+void
+VirtualDeviceFleet::Start()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    for (uint32_t i = 0; i < GetNDevices(); ++i)
+    {
+        ScheduleUplink(i);
+    }
+    UpdateEvent();
+}
+
+void
+VirtualDeviceFleet::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_running = false;
+    Simulator::Cancel(m_event);
+    m_schedule.clear();
+}
+
+uint32_t
+VirtualDeviceFleet::GetNDevices() const
+{
+    return m_fCntUp.size();
+}
+
+LoraDeviceAddress
+VirtualDeviceFleet::GetDeviceAddress(uint32_t i) const
+{
+    NS_ASSERT(i < GetNDevices());
+    return LoraDeviceAddress(m_nwkId, m_firstNwkAddr + i);
+}
+
+uint8_t
+VirtualDeviceFleet::GetDataRate(uint32_t i) const
+{
+    NS_ASSERT(i < GetNDevices());
+    return m_dataRate[i];
+}
+
+const uint8_t*
+VirtualDeviceFleet::GetSessionKey(uint32_t i) const
+{
+    NS_ASSERT(i < GetNDevices());
+    return &m_keys[uint64_t(i) * KEY_SIZE];
+}
+
+void
+VirtualDeviceFleet::SetSessionKey(uint32_t i, const uint8_t* key)
+{
+    NS_ASSERT(i < GetNDevices());
+    std::memcpy(&m_keys[uint64_t(i) * KEY_SIZE], key, KEY_SIZE);
+}
+
+uint64_t
+VirtualDeviceFleet::GetNUplinks() const
+{
+    return m_nUplinks;
+}
+
+uint64_t
+VirtualDeviceFleet::GetNDownlinks() const
+{
+    return m_nDownlinks;
+}
+
+int64_t
+VirtualDeviceFleet::AssignStreams(int64_t stream)
+{
+    m_interval->SetStream(stream);
+    m_rssi->SetStream(stream + 1);
+    m_snr->SetStream(stream + 2);
+    m_nGateways->SetStream(stream + 3);
+    m_uniform->SetStream(stream + 4);
+    return 5;
+}
+
+uint32_t
+VirtualDeviceFleet::EncodeUplink(uint32_t i, uint8_t* data)
+{
+    NS_ASSERT(i < GetNDevices());
+    uint8_t pending = m_pending[i];
+
+    LorawanFrame frame;
+    frame.fType = LorawanMacHeader::UNCONFIRMED_DATA_UP;
+    frame.devAddr = GetDeviceAddress(i).Get();
+    frame.adr = m_adr;
+    frame.ack = pending & PENDING_ACK;
+    frame.fCnt = uint16_t(m_fCntUp[i]);
+    if (pending & PENDING_LINK_ADR)
+    {
+        MacCommandValue ans(LINK_ADR_ANS);
+        ans.linkAdrAns = {true, true, true};
+        frame.fOpts.PushBack(ans);
+    }
+    if (pending & PENDING_DUTY_CYCLE)
+    {
+        frame.fOpts.PushBack(MacCommandValue(DUTY_CYCLE_ANS));
+    }
+    if (pending & PENDING_RX_PARAM_SETUP)
+    {
+        MacCommandValue ans(RX_PARAM_SETUP_ANS);
+        ans.rxParamSetupAns = {true, true, true};
+        frame.fOpts.PushBack(ans);
+    }
+    if (pending & PENDING_DEV_STATUS)
+    {
+        MacCommandValue ans(DEV_STATUS_ANS);
+        ans.devStatusAns = {0, 0}; // External power source, null margin
+        frame.fOpts.PushBack(ans);
+    }
+    if (pending & PENDING_NEW_CHANNEL)
+    {
+        MacCommandValue ans(NEW_CHANNEL_ANS);
+        ans.newChannelAns = {true, true};
+        frame.fOpts.PushBack(ans);
+    }
+    if (pending & PENDING_RX_TIMING_SETUP)
+    {
+        frame.fOpts.PushBack(MacCommandValue(RX_TIMING_SETUP_ANS));
+    }
+    if (m_payloadSize)
+    {
+        frame.fPort = m_fPort;
+        frame.frmPayload = g_payload;
+        frame.frmPayloadSize = m_payloadSize;
+    }
+    frame.mic = 0;
+
+    uint32_t size = LorawanFrameCodec::Encode(frame, data, LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE);
+    NS_ASSERT_MSG(size, "Uplink does not fit in a PHYPayload");
+
+    // MIC on the frame without its MIC field, as BaseEndDeviceLorawanMac
+    uint32_t mic = 0;
+    m_crypto->SetKey(F_NWK_S_INT_KEY, GetSessionKey(i));
+    m_crypto->ComputeCmacB0(data,
+                            size - LorawanFrameCodec::MIC_SIZE,
+                            F_NWK_S_INT_KEY,
+                            false,
+                            UPLINK,
+                            frame.devAddr,
+                            m_fCntUp[i],
+                            &mic);
+    std::memcpy(data + size - LorawanFrameCodec::MIC_SIZE, &mic, LorawanFrameCodec::MIC_SIZE);
+
+    m_fCntUp[i]++;
+    m_pending[i] = 0;
+    return size;
+}
+
+void
+VirtualDeviceFleet::ReceiveDownlink(Ptr<const Packet> packet)
+{
+    uint8_t data[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t size = packet->GetSize();
+    if (size > sizeof(data))
+    {
+        return;
+    }
+    packet->CopyData(data, size);
+    LorawanFrame frame;
+    if (!LorawanFrameCodec::Decode(data, size, frame) || LorawanFrameCodec::IsUplink(frame.fType))
+    {
+        return;
+    }
+    // Downlinks to devices outside the fleet are not ours
+    uint32_t i = (frame.devAddr & ((uint32_t(1) << NWK_ADDR_BITS) - 1)) - m_firstNwkAddr;
+    if ((frame.devAddr >> NWK_ADDR_BITS) != m_nwkId || i >= GetNDevices())
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this << GetDeviceAddress(i) << frame.fCnt);
+
+    // Rebuild the 32-bit counter from its 16 least significant bits
+    uint32_t fCnt = (m_fCntDown[i] & 0xffff0000) | frame.fCnt;
+    if (fCnt < m_fCntDown[i])
+    {
+        fCnt += 0x10000;
+    }
+    m_fCntDown[i] = fCnt + 1;
+    m_nDownlinks++;
+
+    if (frame.fType == LorawanMacHeader::CONFIRMED_DATA_DOWN)
+    {
+        m_pending[i] |= PENDING_ACK;
+    }
+    for (const auto& command : frame.fOpts)
+    {
+        switch (command.type)
+        {
+        case LINK_ADR_REQ:
+            // 0xF keeps the current data rate
+            if (command.linkAdrReq.dataRate < std::size(g_concentratorDataRates))
+            {
+                m_dataRate[i] = command.linkAdrReq.dataRate;
+            }
+            m_pending[i] |= PENDING_LINK_ADR;
+            break;
+        case DUTY_CYCLE_REQ:
+            m_pending[i] |= PENDING_DUTY_CYCLE;
+            break;
+        case RX_PARAM_SETUP_REQ:
+            m_pending[i] |= PENDING_RX_PARAM_SETUP;
+            break;
+        case DEV_STATUS_REQ:
+            m_pending[i] |= PENDING_DEV_STATUS;
+            break;
+        case NEW_CHANNEL_REQ:
+            m_pending[i] |= PENDING_NEW_CHANNEL;
+            break;
+        case RX_TIMING_SETUP_REQ:
+            m_pending[i] |= PENDING_RX_TIMING_SETUP;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void
+VirtualDeviceFleet::Fire()
+{
+    int64_t now = Simulator::Now().GetTimeStep();
+    while (!m_schedule.empty() && m_schedule.front().first <= now)
+    {
+        uint32_t i = m_schedule.front().second;
+        std::pop_heap(m_schedule.begin(), m_schedule.end(), std::greater<>());
+        m_schedule.pop_back();
+        SendUplink(i);
+        ScheduleUplink(i);
+    }
+    UpdateEvent();
+}
+
+void
+VirtualDeviceFleet::SendUplink(uint32_t i)
+{
+    if (m_forwarders.empty())
+    {
+        return;
+    }
+
+    lgw_pkt_rx_s p = {};
+    p.freq_hz = g_channels[m_uniform->GetInteger(0, std::size(g_channels) - 1)];
+    p.status = STAT_CRC_OK;
+    p.modulation = MOD_LORA;
+    p.bandwidth = BW_125KHZ;
+    p.datarate = g_concentratorDataRates[m_dataRate[i]];
+    p.coderate = CR_LORA_4_5;
+    p.size = EncodeUplink(i, p.payload);
+
+    uint32_t nGateways = m_forwarders.size();
+    double draw = std::floor(m_nGateways->GetValue());
+    uint32_t receivers = std::clamp<double>(draw, 1, nGateways);
+    NS_LOG_DEBUG("Uplink of " << GetDeviceAddress(i) << " received by " << receivers
+                              << " gateways");
+    for (uint32_t k = 0; k < receivers; ++k)
+    {
+        p.rssi = m_rssi->GetValue();
+        p.snr = m_snr->GetValue();
+        p.snr_min = p.snr;
+        p.snr_max = p.snr;
+        m_forwarders[(m_homeGateway[i] + k) % nGateways]->InjectUplink(p);
+    }
+    m_nUplinks++;
+}
+
+void
+VirtualDeviceFleet::ScheduleUplink(uint32_t i)
+{
+    Time delay = Max(Seconds(m_interval->GetValue()), TimeStep(1));
+    m_schedule.emplace_back((Simulator::Now() + delay).GetTimeStep(), i);
+    std::push_heap(m_schedule.begin(), m_schedule.end(), std::greater<>());
+}
+
+void
+VirtualDeviceFleet::UpdateEvent()
+{
+    if (!m_running || m_schedule.empty())
+    {
+        return;
+    }
+    Time delay = TimeStep(m_schedule.front().first) - Simulator::Now();
+    if (m_event.IsRunning())
+    {
+        if (Simulator::GetDelayLeft(m_event) <= delay)
+        {
+            return;
+        }
+        Simulator::Cancel(m_event);
+    }
+    m_event = Simulator::Schedule(delay, &VirtualDeviceFleet::Fire, this);
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef VIRTUAL_DEVICE_FLEET_H
+#define VIRTUAL_DEVICE_FLEET_H
+
+#include "ns3/LoRaMacCrypto.h"
+#include "ns3/event-id.h"
+#include "ns3/lora-device-address.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/udp-forwarder.h"
+
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Gateway-level traffic model of a large fleet of ABP end devices.
+ *
+ * Devices have no node, PHY or MAC: their state (DevAddr, frame counters,
+ * data rate, session key, pending answers) is kept in flat arrays indexed by
+ * device, and their uplinks are injected directly in the UdpForwarder of the
+ * gateways. Uplinks carry a valid MIC, computed with the session key of the
+ * device, so that a real network server accepts them.
+ *
+ * Send times follow the Interval random variable. Each uplink is received by
+ * a number of gateways drawn from the Gateways random variable, starting from
+ * the home gateway of the device, each with its own RSSI and SNR draws.
+ *
+ * Downlinks sent by the GatewayLorawanMac of the gateways are decoded and
+ * answered with a minimal state machine: confirmed downlinks are acknowledged
+ * in the next uplink, LinkADRReq sets the data rate of the device, and
+ * commands expecting an answer in FOpts are accepted and answered in the next
+ * uplink. The receive windows are not modelled.
+ */
+class VirtualDeviceFleet : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    VirtualDeviceFleet();
+    ~VirtualDeviceFleet() override;
+
+    /**
+     * Add devices to the fleet. Device i gets the NwkAddr FirstNwkAddr + i in the
+     * NwkID of the fleet.
+     *
+     * \param n The number of devices to add.
+     */
+    void AddDevices(uint32_t n);
+
+    /**
+     * Receive the uplinks of the fleet through the UdpForwarder of these
+     * gateways, and listen to their downlinks.
+     *
+     * \param gateways The gateways.
+     */
+    void AddGateways(NodeContainer gateways);
+
+    /**
+     * Set the distribution of the data rates of the devices added from now on.
+     *
+     * \param weights Relative weight of each data rate, starting from DR0.
+     */
+    void SetDataRateMix(std::vector<double> weights);
+
+    /**
+     * Start sending uplinks.
+     */
+    void Start();
+
+    /**
+     * Stop sending uplinks.
+     */
+    void Stop();
+
+    /**
+     * Get the number of devices in the fleet.
+     */
+    uint32_t GetNDevices() const;
+
+    /**
+     * Get the address of a device.
+     *
+     * \param i The index of the device.
+     */
+    LoraDeviceAddress GetDeviceAddress(uint32_t i) const;
+
+    /**
+     * Get the data rate of a device.
+     *
+     * \param i The index of the device.
+     */
+    uint8_t GetDataRate(uint32_t i) const;
+
+    /**
+     * Get the network session key of a device.
+     *
+     * \param i The index of the device.
+     * \return The 16 bytes of the key.
+     */
+    const uint8_t* GetSessionKey(uint32_t i) const;
+
+    /**
+     * Set the network session key of a device.
+     *
+     * \param i The index of the device.
+     * \param key The 16 bytes of the key.
+     */
+    void SetSessionKey(uint32_t i, const uint8_t* key);
+
+    /**
+     * Get the number of uplinks sent by the fleet.
+     */
+    uint64_t GetNUplinks() const;
+
+    /**
+     * Get the number of downlinks received by devices of the fleet.
+     */
+    uint64_t GetNDownlinks() const;
+
+    /**
+     * Encode the next uplink of a device, advancing its frame counter.
+     *
+     * \param i The index of the device.
+     * \param data The destination, of at least LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE bytes.
+     * \return The size of the PHYPayload.
+     */
+    uint32_t EncodeUplink(uint32_t i, uint8_t* data);
+
+    /**
+     * Handle a downlink sent by a gateway, ignoring it if not for the fleet.
+     *
+     * \param packet The PHYPayload.
+     */
+    void ReceiveDownlink(Ptr<const Packet> packet);
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream The first stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(int64_t stream);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Answers pending in the next uplink of a device.
+     */
+    enum PendingFlag : uint8_t
+    {
+        PENDING_ACK = 1 << 0,             //!< Acknowledge a confirmed downlink
+        PENDING_LINK_ADR = 1 << 1,        //!< Answer a LinkADRReq
+        PENDING_DUTY_CYCLE = 1 << 2,      //!< Answer a DutyCycleReq
+        PENDING_RX_PARAM_SETUP = 1 << 3,  //!< Answer a RXParamSetupReq
+        PENDING_DEV_STATUS = 1 << 4,      //!< Answer a DevStatusReq
+        PENDING_NEW_CHANNEL = 1 << 5,     //!< Answer a NewChannelReq
+        PENDING_RX_TIMING_SETUP = 1 << 6, //!< Answer a RXTimingSetupReq
+    };
+
+    /**
+     * Send the uplinks of all devices due now, then schedule the next wake-up.
+     */
+    void Fire();
+
+    /**
+     * Send an uplink of a device through its receiving gateways.
+     *
+     * \param i The index of the device.
+     */
+    void SendUplink(uint32_t i);
+
+    /**
+     * Schedule the next uplink of a device.
+     *
+     * \param i The index of the device.
+     */
+    void ScheduleUplink(uint32_t i);
+
+    /**
+     * Align the simulator event with the earliest uplink.
+     */
+    void UpdateEvent();
+
+    uint8_t m_nwkId;         //!< NwkID of the addresses of the fleet
+    uint32_t m_firstNwkAddr; //!< NwkAddr of the first device
+    uint32_t m_payloadSize;  //!< Size of the application payload
+    uint8_t m_fPort;         //!< Port of the application payload
+    bool m_adr;              //!< ADR bit of uplinks
+    LoRaMacCrypto* m_crypto; //!< Crypto engine for MIC computation
+
+    Ptr<RandomVariableStream> m_interval;  //!< Time between uplinks of a device, in seconds
+    Ptr<RandomVariableStream> m_rssi;      //!< RSSI of a reception, in dBm
+    Ptr<RandomVariableStream> m_snr;       //!< SNR of a reception, in dB
+    Ptr<RandomVariableStream> m_nGateways; //!< Number of gateways receiving an uplink
+    Ptr<UniformRandomVariable> m_uniform;  //!< Data rates, home gateways and channels
+    std::vector<double> m_dataRateMix;     //!< Cumulative distribution of data rates
+
+    std::vector<uint32_t> m_fCntUp;      //!< Next uplink frame counter, by device
+    std::vector<uint32_t> m_fCntDown;    //!< Next expected downlink frame counter, by device
+    std::vector<uint8_t> m_dataRate;     //!< Uplink data rate, by device
+    std::vector<uint8_t> m_pending;      //!< PendingFlag set, by device
+    std::vector<uint32_t> m_homeGateway; //!< First receiving gateway, by device
+    std::vector<uint8_t> m_keys;         //!< Network session keys, 16 bytes by device
+
+    std::vector<Ptr<UdpForwarder>> m_forwarders;          //!< Forwarders of the gateways
+    std::vector<std::pair<int64_t, uint32_t>> m_schedule; //!< Min-heap of (time step, device)
+    EventId m_event;                                      //!< Wake-up event in the simulator
+    bool m_running;                                       //!< Whether uplinks are being sent
+    uint64_t m_nUplinks;                                  //!< Uplinks sent
+    uint64_t m_nDownlinks;                                //!< Downlinks received
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* VIRTUAL_DEVICE_FLEET_H */
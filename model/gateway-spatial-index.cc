@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "gateway-spatial-index.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("GatewaySpatialIndex");
+
+NS_OBJECT_ENSURE_REGISTERED(GatewaySpatialIndex);
+
+TypeId
+GatewaySpatialIndex::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::GatewaySpatialIndex")
+                            .SetParent<Object>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<GatewaySpatialIndex>();
+    return tid;
+}
+
+GatewaySpatialIndex::GatewaySpatialIndex()
+    : m_valid(false),
+      m_cellSize(1),
+      m_originX(0),
+      m_originY(0),
+      m_nx(0),
+      m_ny(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+GatewaySpatialIndex::GatewaySpatialIndex(NodeContainer nodes)
+    : GatewaySpatialIndex()
+{
+    SetNodes(nodes);
+}
+
+GatewaySpatialIndex::~GatewaySpatialIndex()
+{
+    NS_LOG_FUNCTION(this);
+    Disconnect();
+}
+
+void
+GatewaySpatialIndex::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Disconnect();
+    m_nodes = NodeContainer();
+    m_valid = false;
+    Object::DoDispose();
+}
+
+void
+GatewaySpatialIndex::SetNodes(NodeContainer nodes)
+{
+    NS_LOG_FUNCTION(this);
+    Disconnect();
+    m_nodes = nodes;
+    m_valid = false;
+}
+
+uint32_t
+GatewaySpatialIndex::GetN() const
+{
+    return m_nodes.GetN();
+}
+
+Ptr<Node>
+GatewaySpatialIndex::GetNode(uint32_t i) const
+{
+    return m_nodes.Get(i);
+}
+
+Vector
+GatewaySpatialIndex::GetPosition(uint32_t i) const
+{
+    Build();
+    return m_byNode[i];
+}
+
+void
+GatewaySpatialIndex::NotifyCourseChange(Ptr<const MobilityModel> model)
+{
+    NS_LOG_FUNCTION(this << model);
+    m_valid = false;
+}
+
+void
+GatewaySpatialIndex::Disconnect()
+{
+    for (const auto& mobility : m_mobility)
+    {
+        mobility->TraceDisconnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&GatewaySpatialIndex::NotifyCourseChange, this));
+    }
+    m_mobility.clear();
+}
+
+void
+GatewaySpatialIndex::Build() const
+{
+    if (m_valid)
+    {
+        return;
+    }
+    m_valid = true;
+
+    // Mobility models are resolved late, as they may be installed after SetNodes
+    auto self = const_cast<GatewaySpatialIndex*>(this);
+    if (m_mobility.empty())
+    {
+        for (auto it = m_nodes.Begin(); it != m_nodes.End(); ++it)
+        {
+            auto mobility = (*it)->GetObject<MobilityModel>();
+            NS_ASSERT_MSG(mobility, "Indexed node " << (*it)->GetId() << " has no position");
+            mobility->TraceConnectWithoutContext(
+                "CourseChange",
+                MakeCallback(&GatewaySpatialIndex::NotifyCourseChange, self));
+            m_mobility.push_back(mobility);
+        }
+    }
+
+    m_byNode.clear();
+    double minX = 0;
+    double minY = 0;
+    double maxX = 0;
+    double maxY = 0;
+    for (const auto& mobility : m_mobility)
+    {
+        Vector pos = mobility->GetPosition();
+        minX = m_byNode.empty() ? pos.x : std::min(minX, pos.x);
+        minY = m_byNode.empty() ? pos.y : std::min(minY, pos.y);
+        maxX = m_byNode.empty() ? pos.x : std::max(maxX, pos.x);
+        maxY = m_byNode.empty() ? pos.y : std::max(maxY, pos.y);
+        m_byNode.push_back(pos);
+    }
+    uint32_t n = m_byNode.size();
+
+    // About one node per cell, with the grid size bounded for very uneven layouts
+    double area = std::max(maxX - minX, 1.0) * std::max(maxY - minY, 1.0);
+    m_cellSize = std::max(std::sqrt(area / std::max(n, 1U)), 1.0);
+    m_originX = minX;
+    m_originY = minY;
+    do
+    {
+        m_nx = int64_t((maxX - m_originX) / m_cellSize) + 1;
+        m_ny = int64_t((maxY - m_originY) / m_cellSize) + 1;
+        if (m_nx * m_ny <= std::max<int64_t>(1024, 4 * int64_t(n)))
+        {
+            break;
+        }
+        m_cellSize *= 2;
+    } while (true);
+
+    // Group nodes by cell (counting sort), keeping the container order in each cell
+    auto cellOf = [this](const Vector& pos) {
+        return int64_t((pos.y - m_originY) / m_cellSize) * m_nx +
+               int64_t((pos.x - m_originX) / m_cellSize);
+    };
+    m_cellStart.assign(m_nx * m_ny + 1, 0);
+    for (const auto& pos : m_byNode)
+    {
+        m_cellStart[cellOf(pos) + 1]++;
+    }
+    for (size_t c = 1; c < m_cellStart.size(); ++c)
+    {
+        m_cellStart[c] += m_cellStart[c - 1];
+    }
+    std::vector<uint32_t> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_entries.resize(n);
+    m_positions.resize(n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t slot = next[cellOf(m_byNode[i])]++;
+        m_entries[slot] = i;
+        m_positions[slot] = m_byNode[i];
+    }
+    NS_LOG_DEBUG("Indexed " << n << " nodes in " << m_nx << "x" << m_ny << " cells of "
+                            << m_cellSize << " m");
+}
+
+void
+GatewaySpatialIndex::GetCells(double x,
+                              double y,
+                              double radius,
+                              int64_t& x0,
+                              int64_t& x1,
+                              int64_t& y0,
+                              int64_t& y1) const
+{
+    // Rounding is monotonic, so nodes within the square are never assigned to outer cells.
+    // Clamp in floating point first: far positions may not fit in an integer.
+    double cx0 = std::floor((x - radius - m_originX) / m_cellSize);
+    double cx1 = std::floor((x + radius - m_originX) / m_cellSize);
+    double cy0 = std::floor((y - radius - m_originY) / m_cellSize);
+    double cy1 = std::floor((y + radius - m_originY) / m_cellSize);
+    x0 = int64_t(std::clamp(cx0, 0.0, double(m_nx)));
+    x1 = int64_t(std::clamp(cx1, -1.0, double(m_nx - 1)));
+    y0 = int64_t(std::clamp(cy0, 0.0, double(m_ny)));
+    y1 = int64_t(std::clamp(cy1, -1.0, double(m_ny - 1)));
+}
+
+std::vector<GatewaySpatialIndex::Neighbour>
+GatewaySpatialIndex::GetNearest(const Vector& position, uint32_t k) const
+{
+    NS_LOG_FUNCTION(this << position << k);
+    Build();
+    std::vector<Neighbour> best; // Max-heap of the k nearest nodes so far
+    k = std::min(k, GetN());
+    if (k == 0)
+    {
+        return best;
+    }
+    best.reserve(k);
+    auto closer = [](const Neighbour& a, const Neighbour& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+    };
+
+    // Visit square rings of cells around the position, until the nodes left out (outside the
+    // visited square, so farther horizontally) cannot be closer than the k-th nearest so far
+    double fx = std::floor((position.x - m_originX) / m_cellSize);
+    double fy = std::floor((position.y - m_originY) / m_cellSize);
+    int64_t cx = int64_t(std::clamp(fx, 0.0, double(m_nx - 1)));
+    int64_t cy = int64_t(std::clamp(fy, 0.0, double(m_ny - 1)));
+    for (int64_t ring = 0;; ++ring)
+    {
+        int64_t x0 = cx - ring;
+        int64_t x1 = cx + ring;
+        int64_t y0 = cy - ring;
+        int64_t y1 = cy + ring;
+        for (int64_t y = std::max<int64_t>(y0, 0); y <= std::min(y1, m_ny - 1); ++y)
+        {
+            // Inner rows only contribute their first and last cell
+            int64_t step = (y == y0 || y == y1) ? 1 : std::max<int64_t>(x1 - x0, 1);
+            for (int64_t x = x0; x <= x1; x += step)
+            {
+                if (x < 0 || x >= m_nx)
+                {
+                    continue;
+                }
+                int64_t cell = y * m_nx + x;
+                for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i)
+                {
+                    Neighbour candidate = {m_entries[i],
+                                           CalculateDistance(m_positions[i], position)};
+                    if (best.size() < k)
+                    {
+                        best.push_back(candidate);
+                        std::push_heap(best.begin(), best.end(), closer);
+                    }
+                    else if (closer(candidate, best.front()))
+                    {
+                        std::pop_heap(best.begin(), best.end(), closer);
+                        best.back() = candidate;
+                        std::push_heap(best.begin(), best.end(), closer);
+                    }
+                }
+            }
+        }
+        if (x0 <= 0 && y0 <= 0 && x1 >= m_nx - 1 && y1 >= m_ny - 1)
+        {
+            break; // The whole grid was visited
+        }
+        if (best.size() == k)
+        {
+            // Shrunk by a small margin for the rounding in the cell assignment
+            double bound = std::min({position.x - (m_originX + x0 * m_cellSize),
+                                     m_originX + (x1 + 1) * m_cellSize - position.x,
+                                     position.y - (m_originY + y0 * m_cellSize),
+                                     m_originY + (y1 + 1) * m_cellSize - position.y}) -
+                           m_cellSize * 1e-6;
+            if (best.front().distance < bound)
+            {
+                break;
+            }
+        }
+    }
+    std::sort_heap(best.begin(), best.end(), closer);
+    return best;
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef GATEWAY_SPATIAL_INDEX_H
+#define GATEWAY_SPATIAL_INDEX_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/object.h"
+#include "ns3/vector.h"
+
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Spatial index of the positions of a set of nodes (typically, gateways).
+ *
+ * Positions are bucketed in a uniform grid of the horizontal plane, with
+ * about one node per cell. The index is built on the first query, and
+ * rebuilt on the first query following a course change of any node.
+ * Distances are 3D, computed with CalculateDistance.
+ */
+class GatewaySpatialIndex : public Object
+{
+  public:
+    /**
+     * A node found by a query.
+     */
+    struct Neighbour
+    {
+        uint32_t index;  //!< Index of the node in the container
+        double distance; //!< Distance from the query position
+    };
+
+    static TypeId GetTypeId();
+
+    GatewaySpatialIndex();
+    GatewaySpatialIndex(NodeContainer nodes);
+    ~GatewaySpatialIndex() override;
+
+    /**
+     * Set the nodes to index. Nodes need a mobility model by the first query.
+     */
+    void SetNodes(NodeContainer nodes);
+
+    /**
+     * Get the number of indexed nodes.
+     */
+    uint32_t GetN() const;
+
+    /**
+     * Get an indexed node.
+     *
+     * \param i The index of the node in the container.
+     */
+    Ptr<Node> GetNode(uint32_t i) const;
+
+    /**
+     * Get the position of an indexed node.
+     *
+     * \param i The index of the node in the container.
+     */
+    Vector GetPosition(uint32_t i) const;
+
+    /**
+     * Find the k nodes nearest to a position.
+     *
+     * \param position The position.
+     * \param k The number of nodes.
+     * \return Up to k nodes, by increasing distance (then index).
+     */
+    std::vector<Neighbour> GetNearest(const Vector& position, uint32_t k) const;
+
+    /**
+     * Visit the nodes that may be within a horizontal radius of a position.
+     *
+     * All nodes within the radius are visited, and some farther ones may be.
+     *
+     * \param x The x coordinate of the position.
+     * \param y The y coordinate of the position.
+     * \param radius The radius.
+     * \param visit Called with the index and the position of each node.
+     */
+    template <typename F>
+    void ForEachCandidate(double x, double y, double radius, F visit) const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Mark the index as outdated.
+     */
+    void NotifyCourseChange(Ptr<const MobilityModel> model);
+
+    /**
+     * Bucket node positions in the grid, if outdated.
+     */
+    void Build() const;
+
+    /**
+     * Disconnect from the course change traces of the nodes.
+     */
+    void Disconnect();
+
+    /**
+     * Get the cells intersecting a square, clamped to the grid.
+     */
+    void GetCells(double x,
+                  double y,
+                  double radius,
+                  int64_t& x0,
+                  int64_t& x1,
+                  int64_t& y0,
+                  int64_t& y1) const;
+
+    NodeContainer m_nodes;                              //!< The indexed nodes
+    mutable std::vector<Ptr<MobilityModel>> m_mobility; //!< Mobility models, once resolved
+    mutable bool m_valid;                               //!< Whether the grid is up to date
+
+    mutable double m_cellSize;                 //!< Width of the cells
+    mutable double m_originX;                  //!< x coordinate of the grid origin
+    mutable double m_originY;                  //!< y coordinate of the grid origin
+    mutable int64_t m_nx;                      //!< Number of cells along x
+    mutable int64_t m_ny;                      //!< Number of cells along y
+    mutable std::vector<uint32_t> m_cellStart; //!< First entry of each cell, plus end
+    mutable std::vector<uint32_t> m_entries;   //!< Node indexes, grouped by cell
+    mutable std::vector<Vector> m_positions;   //!< Node positions, grouped by cell
+    mutable std::vector<Vector> m_byNode;      //!< Node positions, by node index
+};
+
+template <typename F>
+void
+GatewaySpatialIndex::ForEachCandidate(double x, double y, double radius, F visit) const
+{
+    Build();
+    int64_t x0;
+    int64_t x1;
+    int64_t y0;
+    int64_t y1;
+    GetCells(x, y, radius, x0, x1, y0, y1);
+    for (int64_t cy = y0; cy <= y1; ++cy)
+    {
+        for (uint32_t i = m_cellStart[cy * m_nx + x0]; i < m_cellStart[cy * m_nx + x1 + 1]; ++i)
+        {
+            visit(m_entries[i], m_positions[i]);
+        }
+    }
+}
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* GATEWAY_SPATIAL_INDEX_H */
@@ -26,6 +26,7 @@
 
 #include "ns3/lora-phy.h"
 #include "ns3/nstime.h"
+#include "ns3/packet.h"
 #include "ns3/tag.h"
 
 namespace ns3
@@ -160,6 +161,17 @@ class LoraTag : public Tag
      */
     double GetSnr() const;
 
+    /**
+     * Tag a packet, overwriting in place the LoraTag it may already carry.
+     *
+     * Fields are meant to be updated by peeking the tag, setting them, and writing it back:
+     * unlike removing and adding the tag again, this does not allocate, and the tag list is
+     * only copied if shared with copies of the packet (which keep their own values).
+     *
+     * \param packet The packet.
+     */
+    void WriteTo(Ptr<Packet> packet);
+
   private:
     LoraPhyTxParameters m_params; //!< The PHY transmission parameters of this packet
     uint8_t m_dataRate;           //!< The data rate of this packet
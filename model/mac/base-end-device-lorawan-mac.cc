@@ -27,8 +27,11 @@
 #include "base-end-device-lorawan-mac.h"
 
 #include "ns3/end-device-lora-phy.h"
+#include "ns3/lorawan-frame-codec.h"
 #include "ns3/simulator.h"
 
+#include <cmath>
+
 namespace ns3
 {
 namespace lorawan
@@ -235,13 +238,9 @@ BaseEndDeviceLorawanMac::DoSend(Ptr<Packet> packet)
     }
     else // Retransmission
     {
-        // Remove MIC and headers
-        packet->RemoveAtEnd(4);
-        LorawanMacHeader mHdr;
-        packet->RemoveHeader(mHdr);
-        LoraFrameHeader fHdr;
-        fHdr.SetAsUplink();
-        packet->RemoveHeader(fHdr);
+        // Remove MIC and headers, whose size is known: no need to parse them
+        packet->RemoveAtEnd(LorawanFrameCodec::MIC_SIZE);
+        packet->RemoveAtStart(m_txContext.headerSize);
         NS_LOG_DEBUG("Retransmitting an old packet.");
     }
 
@@ -273,6 +272,7 @@ BaseEndDeviceLorawanMac::DoSend(Ptr<Packet> packet)
     FillHeader(mHdr);
     packet->AddHeader(mHdr);
     NS_LOG_INFO("Added MAC header of size " << mHdr.GetSerializedSize() << " bytes.");
+    m_txContext.headerSize = mHdr.GetSerializedSize() + fHdr.GetSerializedSize();
 
     // Add (eventually encrypted) MIC to the end of the packet
     AddMIC(packet);
@@ -376,7 +376,31 @@ BaseEndDeviceLorawanMac::AddMacCommand(Ptr<MacCommand> macCommand)
 {
     NS_LOG_FUNCTION(this << macCommand);
 
-    m_fOpts.push_back(macCommand);
+    m_fOpts.PushBack(macCommand->GetValue());
+}
+
+void
+BaseEndDeviceLorawanMac::AddMacCommand(const MacCommandValue& macCommand)
+{
+    NS_LOG_FUNCTION(this << unsigned(MacCommand::GetCIDFromMacCommand(macCommand.type)));
+
+    m_fOpts.PushBack(macCommand);
+}
+
+void
+BaseEndDeviceLorawanMac::ClearMacCommands()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_fOpts.Clear();
+}
+
+int64_t
+BaseEndDeviceLorawanMac::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_uniformRV->SetStream(stream);
+    return 1;
 }
 
 void
@@ -394,19 +418,28 @@ BaseEndDeviceLorawanMac::FillHeader(LoraFrameHeader& fHdr)
     fHdr.SetFCnt(m_fCnt);
 
     // Tmp list to save commands that need to be kept sent until downlink
-    std::list<Ptr<MacCommand>> tmpCmdList;
+    MacCommandList tmpCmdList;
 
     // Add listed MAC commands to header
     for (const auto& command : m_fOpts)
     {
-        auto type = command->GetCommandType();
+        auto type = command.type;
+        if (uint32_t(fHdr.GetFOptsLen()) + command.GetSerializedSize() >
+            LorawanFrameCodec::MAX_FOPTS_SIZE)
+        {
+            // FOpts are full: send the command on next uplink
+            NS_LOG_DEBUG("No room in FOpts for CID "
+                         << unsigned(MacCommand::GetCIDFromMacCommand(type)) << ", postponed");
+            tmpCmdList.PushBack(command);
+            continue;
+        }
         NS_LOG_INFO("Applying a MAC Command of CID "
                     << unsigned(MacCommand::GetCIDFromMacCommand(type)));
         fHdr.AddCommand(command);
         // Keep sending them or not on next uplink (by specifications)
         if (type == MacCommandType::DL_CHANNEL_ANS || type == MacCommandType::RX_TIMING_SETUP_ANS)
         {
-            tmpCmdList.push_back(command);
+            tmpCmdList.PushBack(command);
         }
     }
 
@@ -462,71 +495,72 @@ BaseEndDeviceLorawanMac::ApplyMACCommands(LoraFrameHeader fHdr, Ptr<const Packet
     }
 
     // Parse and apply downlink MAC commands, queue answers
-    for (auto& cmd : fHdr.GetCommands())
+    for (const auto& cmd : fHdr.GetCommandList())
     {
         NS_LOG_DEBUG("Iterating over the MAC commands...");
-        switch (cmd->GetCommandType())
+        switch (cmd.type)
         {
         case (LINK_CHECK_ANS): {
             NS_LOG_DEBUG("Detected a LinkCheckAns command.");
-            // Cast the command
-            auto linkCheckAns = DynamicCast<LinkCheckAns>(cmd);
             // Call the appropriate function to take action
-            OnLinkCheckAns(linkCheckAns->GetMargin(), linkCheckAns->GetGwCnt());
+            OnLinkCheckAns(cmd.linkCheckAns.margin, cmd.linkCheckAns.gwCnt);
             break;
         }
         case (LINK_ADR_REQ): {
             NS_LOG_DEBUG("Detected a LinkAdrReq command.");
-            // Cast the command
-            auto linkAdrReq = DynamicCast<LinkAdrReq>(cmd);
+            // Translate the 16-bit channel mask to a list of channel indices
+            std::list<int> enabledChannels;
+            for (int i = 0; i < 16; i++)
+            {
+                if (cmd.linkAdrReq.channelMask & (0b1 << i)) // Take channel mask's i-th bit
+                {
+                    enabledChannels.push_back(i);
+                }
+            }
             // Call the appropriate function to take action
-            OnLinkAdrReq(linkAdrReq->GetDataRate(),
-                         linkAdrReq->GetTxPower(),
-                         linkAdrReq->GetEnabledChannelsList(),
-                         linkAdrReq->GetRepetitions());
+            OnLinkAdrReq(cmd.linkAdrReq.dataRate,
+                         cmd.linkAdrReq.txPower,
+                         enabledChannels,
+                         (cmd.linkAdrReq.nbRep) ? cmd.linkAdrReq.nbRep : 1);
             break;
         }
         case (DUTY_CYCLE_REQ): {
             NS_LOG_DEBUG("Detected a DutyCycleReq command.");
-            // Cast the command
-            auto dutyCycleReq = DynamicCast<DutyCycleReq>(cmd);
+            // Decode the duty cycle: 255 turns off, otherwise 1/2^maxDCycle
+            uint8_t maxDCycle = cmd.dutyCycleReq.maxDCycle;
+            double dutyCycle = (maxDCycle == 255) ? 0 : 1 / std::pow(2, double(maxDCycle));
             // Call the appropriate function to take action
-            OnDutyCycleReq(dutyCycleReq->GetMaximumAllowedDutyCycle());
+            OnDutyCycleReq(dutyCycle);
             break;
         }
         case (RX_PARAM_SETUP_REQ): {
             NS_LOG_DEBUG("Detected a RxParamSetupReq command.");
-            // Cast the command
-            auto rxParamSetupReq = DynamicCast<RxParamSetupReq>(cmd);
             // Call the appropriate function to take action
-            OnRxParamSetupReq(rxParamSetupReq);
+            OnRxParamSetupReq(cmd.rxParamSetupReq.rx1DrOffset,
+                              cmd.rxParamSetupReq.rx2DataRate,
+                              double(cmd.rxParamSetupReq.frequency));
             break;
         }
         case (DEV_STATUS_REQ): {
             NS_LOG_DEBUG("Detected a DevStatusReq command.");
-            // Cast the command
-            auto devStatusReq = DynamicCast<DevStatusReq>(cmd);
             // Call the appropriate function to take action
             OnDevStatusReq();
             break;
         }
         case (NEW_CHANNEL_REQ): {
             NS_LOG_DEBUG("Detected a NewChannelReq command.");
-            // Cast the command
-            auto newChannelReq = DynamicCast<NewChannelReq>(cmd);
             // Call the appropriate function to take action
-            OnNewChannelReq(newChannelReq->GetChannelIndex(),
-                            newChannelReq->GetFrequency(),
-                            newChannelReq->GetMinDataRate(),
-                            newChannelReq->GetMaxDataRate());
+            OnNewChannelReq(cmd.newChannelReq.chIndex,
+                            double(cmd.newChannelReq.frequency),
+                            cmd.newChannelReq.minDataRate,
+                            cmd.newChannelReq.maxDataRate);
             break;
         }
         case (RX_TIMING_SETUP_REQ): {
             NS_LOG_DEBUG("Detected a RxTimingSetupReq command.");
-            // Cast the command
-            auto rxTimingSetupReq = DynamicCast<RxTimingSetupReq>(cmd);
-            // Call the appropriate function to take action
-            OnRxTimingSetupReq(rxTimingSetupReq->GetDelay());
+            // Call the appropriate function to take action (a delay of 0 means 1 s)
+            uint8_t delay = cmd.rxTimingSetupReq.delay;
+            OnRxTimingSetupReq(Seconds((delay) ? delay : 1));
             break;
         }
         case (TX_PARAM_SETUP_REQ): {
@@ -535,10 +569,8 @@ BaseEndDeviceLorawanMac::ApplyMACCommands(LoraFrameHeader fHdr, Ptr<const Packet
         }
         case (DL_CHANNEL_REQ): {
             NS_LOG_DEBUG("Detected a DlChannelReq command.");
-            // Cast the command
-            auto dlChannelReq = DynamicCast<DlChannelReq>(cmd);
             // Call the appropriate function to take action
-            OnDlChannelReq(dlChannelReq->GetChannelIndex(), dlChannelReq->GetFrequency());
+            OnDlChannelReq(cmd.dlChannelReq.chIndex, double(cmd.dlChannelReq.frequency));
             break;
         }
         default: {
@@ -585,16 +617,16 @@ BaseEndDeviceLorawanMac::AppendCmdsFromFRMPayload(LoraFrameHeader& fHdr, Ptr<con
                                           << std::dec);
     }
 
-    //! Trigger alternative de/serialization
-    fHdr.SetFRMPaylodCmdsLen(size);
-
-    /* Append commands to the frame header and deserialize it again */
-    auto buffer = Buffer();                      //! Create buffer
-    buffer.AddAtStart(size);                     //! Allocate space for commands
-    buffer.Begin().Write(cmds, size);            //! Add serialized payload with commands
-    buffer.AddAtStart(fHdr.GetSerializedSize()); //! Allocate space for header
-    fHdr.Serialize(buffer.Begin());              //! Add frame header (but not FPort)
-    fHdr.Deserialize(buffer.Begin());
+    /* Decode the commands in place and append them to the frame header */
+    MacCommandList commands;
+    if (!LorawanFrameCodec::DecodeMacCommands(cmds, size, false, commands))
+    {
+        NS_LOG_ERROR("Invalid MAC command in FRMPayload, skipping the rest");
+    }
+    for (const auto& command : commands)
+    {
+        fHdr.AddCommand(command);
+    }
 }
 
 void
@@ -715,7 +747,9 @@ BaseEndDeviceLorawanMac::OnLinkAdrReq(uint8_t dataRate,
 
     // Craft a LinkAdrAns MAC command as a response
     ///////////////////////////////////////////////
-    m_fOpts.push_back(Create<LinkAdrAns>(txPowerOk, dataRateOk, channelMaskOk));
+    MacCommandValue answer(LINK_ADR_ANS);
+    answer.linkAdrAns = {txPowerOk, dataRateOk, channelMaskOk};
+    m_fOpts.PushBack(answer);
 }
 
 void
@@ -731,7 +765,7 @@ BaseEndDeviceLorawanMac::OnDutyCycleReq(double dutyCycle)
 
     // Craft a DutyCycleAns as response
     NS_LOG_INFO("Adding DutyCycleAns reply");
-    m_fOpts.push_back(Create<DutyCycleAns>());
+    m_fOpts.PushBack(MacCommandValue(DUTY_CYCLE_ANS));
 }
 
 void
@@ -744,7 +778,9 @@ BaseEndDeviceLorawanMac::OnDevStatusReq()
 
     // Craft a RxParamSetupAns as response
     NS_LOG_INFO("Adding DevStatusAns reply");
-    m_fOpts.push_back(Create<DevStatusAns>(battery, margin));
+    MacCommandValue answer(DEV_STATUS_ANS);
+    answer.devStatusAns = {battery, margin};
+    m_fOpts.PushBack(answer);
 }
 
 void
@@ -767,7 +803,9 @@ BaseEndDeviceLorawanMac::OnNewChannelReq(uint8_t chIndex,
     }
 
     NS_LOG_INFO("Adding NewChannelAns reply");
-    m_fOpts.push_back(Create<NewChannelAns>(dataRateRangeOk, channelFrequencyOk));
+    MacCommandValue answer(NEW_CHANNEL_ANS);
+    answer.newChannelAns = {dataRateRangeOk, channelFrequencyOk};
+    m_fOpts.PushBack(answer);
 }
 
 void
@@ -787,7 +825,9 @@ BaseEndDeviceLorawanMac::OnDlChannelReq(uint8_t chIndex, double frequency)
     }
 
     NS_LOG_INFO("Adding DlChannelAns reply");
-    m_fOpts.push_back(Create<DlChannelAns>(uplinkFrequencyExists, channelFrequencyOk));
+    MacCommandValue answer(DL_CHANNEL_ANS);
+    answer.dlChannelAns = {uplinkFrequencyExists, channelFrequencyOk};
+    m_fOpts.PushBack(answer);
 }
 
 /////////////////////////
@@ -879,6 +919,43 @@ BaseEndDeviceLorawanMac::GetADRBackoff() const
     return m_enableADRBackoff;
 }
 
+void
+BaseEndDeviceLorawanMac::SetFCnt(uint16_t fCnt)
+{
+    m_fCnt = fCnt;
+}
+
+uint16_t
+BaseEndDeviceLorawanMac::GetFCnt() const
+{
+    return m_fCnt;
+}
+
+void
+BaseEndDeviceLorawanMac::SetAdrAckCounter(uint16_t counter, bool request)
+{
+    m_ADRACKCnt = counter;
+    m_ADRACKReq = request;
+}
+
+uint16_t
+BaseEndDeviceLorawanMac::GetAdrAckCounter() const
+{
+    return m_ADRACKCnt;
+}
+
+bool
+BaseEndDeviceLorawanMac::GetAdrAckRequest() const
+{
+    return m_ADRACKReq;
+}
+
+const MacCommandList&
+BaseEndDeviceLorawanMac::GetPendingMacCommands() const
+{
+    return m_fOpts;
+}
+
 void
 BaseEndDeviceLorawanMac::DoInitialize()
 {
@@ -894,7 +971,7 @@ void
 BaseEndDeviceLorawanMac::DoDispose()
 {
     NS_LOG_FUNCTION(this);
-    m_fOpts.clear();
+    m_fOpts.Clear();
     m_txContext.packet = nullptr;
     m_uniformRV = nullptr;
     m_nextTx.Cancel();
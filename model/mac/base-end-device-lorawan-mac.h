@@ -56,6 +56,7 @@ class BaseEndDeviceLorawanMac : public LorawanMac
         uint8_t nbTxLeft;
         bool waitingAck = false;
         bool busy = false;
+        uint32_t headerSize = 0; //!< Size of the MHDR and FHDR of the last transmission
     };
 
   public:
@@ -106,6 +107,28 @@ class BaseEndDeviceLorawanMac : public LorawanMac
      */
     void AddMacCommand(Ptr<MacCommand> macCommand);
 
+    /**
+     * Add a MAC command to the list of those that will be sent out in the next
+     * packet.
+     *
+     * \param macCommand The command.
+     */
+    void AddMacCommand(const MacCommandValue& macCommand);
+
+    /**
+     * Drop the MAC commands waiting for the next uplink.
+     */
+    void ClearMacCommands();
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream The first stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(int64_t stream);
+
     /////////////////////////
     // Getters and Setters //
     /////////////////////////
@@ -206,6 +229,41 @@ class BaseEndDeviceLorawanMac : public LorawanMac
      */
     bool GetADRBackoff() const;
 
+    /**
+     * Set the uplink frame counter.
+     *
+     * \param fCnt The FCnt of the next new uplink.
+     */
+    void SetFCnt(uint16_t fCnt);
+
+    /**
+     * Get the uplink frame counter.
+     */
+    uint16_t GetFCnt() const;
+
+    /**
+     * Set the ADR acknowledgement counter (ADR_ACK_CNT) and request bit.
+     *
+     * \param counter Number of uplinks since the last downlink.
+     * \param request Whether the ADRACKReq bit is set in uplinks.
+     */
+    void SetAdrAckCounter(uint16_t counter, bool request);
+
+    /**
+     * Get the ADR acknowledgement counter (ADR_ACK_CNT).
+     */
+    uint16_t GetAdrAckCounter() const;
+
+    /**
+     * Get whether the ADRACKReq bit is set in uplinks.
+     */
+    bool GetAdrAckRequest() const;
+
+    /**
+     * Get the MAC commands waiting for the next uplink (e.g., answers).
+     */
+    const MacCommandList& GetPendingMacCommands() const;
+
   protected:
     void DoInitialize() override;
     void DoDispose() override;
@@ -245,7 +303,7 @@ class BaseEndDeviceLorawanMac : public LorawanMac
     /**
      * List of the MAC commands that need to be applied to the next UL packet.
      */
-    std::list<Ptr<MacCommand>> m_fOpts;
+    MacCommandList m_fOpts;
 
     //////////////////////////////////
     // Protected MAC Layer settings //
@@ -375,11 +433,10 @@ class BaseEndDeviceLorawanMac : public LorawanMac
      * Manage the case of MAC commands being in the FRMPayload.
      *
      * \brief Serialized MAC commands from the payload are fist decrypted (if requested),
-     *        piggybacked to the frame header, and then correctly deserialized into it.
+     *        then decoded in place and appended to the frame header.
      *
      * \param fHdr The packet frame header
-     * \param cmds The serialized FRMPayload containing MAC commands
-     * \param size Size of the serialized FRMPayload
+     * \param packet The FRMPayload containing MAC commands
      */
     void AppendCmdsFromFRMPayload(LoraFrameHeader& fHdr, Ptr<const Packet> packet);
 
@@ -415,9 +472,11 @@ class BaseEndDeviceLorawanMac : public LorawanMac
     /**
      * Perform the actions that need to be taken when receiving a RxParamSetupReq command.
      *
-     * \param rxParamSetupReq The Parameter Setup Request
+     * \param rx1DrOffset The offset to set.
+     * \param rx2DataRate The data rate to use for the second receive window.
+     * \param frequency The frequency to use for the second receive window.
      */
-    virtual void OnRxParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupReq) = 0;
+    virtual void OnRxParamSetupReq(uint8_t rx1DrOffset, uint8_t rx2DataRate, double frequency) = 0;
 
     /**
      * Perform the actions that need to be taken when receiving a DevStatusReq command.
@@ -60,6 +60,7 @@ ClassAEndDeviceLorawanMac::ClassAEndDeviceLorawanMac()
     : m_recvWinSymb(8),
       // LoRaWAN default
       m_rx1DrOffset(0),
+      m_rx2DataRate(0),
       m_lastTxCh(nullptr)
 {
     NS_LOG_FUNCTION(this);
@@ -84,7 +85,8 @@ ClassAEndDeviceLorawanMac::SendToPhy(Ptr<Packet> packet)
     // Configure PHY tx params
     m_txParams.sf = GetSfFromDataRate(m_dataRate);
     m_txParams.bandwidthHz = GetBandwidthFromDataRate(m_dataRate);
-    m_txParams.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(m_txParams) > MilliSeconds(16);
+    m_txParams.lowDataRateOptimizationEnabled =
+        LoraPhyMath::NeedsLowDataRateOptimization(m_txParams.sf, m_txParams.bandwidthHz);
     NS_LOG_DEBUG("DR: " << unsigned(m_dataRate));
     NS_LOG_DEBUG("SF: " << unsigned(m_txParams.sf));
     NS_LOG_DEBUG("BW: " << m_txParams.bandwidthHz << " Hz");
@@ -98,10 +100,10 @@ ClassAEndDeviceLorawanMac::SendToPhy(Ptr<Packet> packet)
 
     // Tag packet with datarate and frequency
     LoraTag tag;
-    packet->RemovePacketTag(tag); // Needed in case of retx!
+    packet->PeekPacketTag(tag); // Already tagged in case of retx
     tag.SetDataRate(m_dataRate);
     tag.SetFrequency(frequency);
-    packet->AddPacketTag(tag);
+    tag.WriteTo(packet);
 
     // Get the duration
     Time duration = m_phy->GetTimeOnAir(packet, m_txParams);
@@ -170,7 +172,7 @@ ClassAEndDeviceLorawanMac::Receive(Ptr<const Packet> packet)
     // Reset ADR backoff counter
     m_ADRACKCnt = 0;
     // Clear commands that are re-sent until downlink (DlChannelAns and RxTimingSetupAns)
-    m_fOpts.clear();
+    m_fOpts.Clear();
 
     // Work on a copy of the packet
     Ptr<Packet> packetCopy = packet->Copy();
@@ -275,13 +277,11 @@ ClassAEndDeviceLorawanMac::ManageRetransmissions(RxOutcome outcome)
 /////////////////////////
 
 void
-ClassAEndDeviceLorawanMac::OnRxParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupReq)
+ClassAEndDeviceLorawanMac::OnRxParamSetupReq(uint8_t rx1DrOffset,
+                                             uint8_t rx2DataRate,
+                                             double frequency)
 {
-    NS_LOG_FUNCTION(this << rxParamSetupReq);
-
-    uint8_t rx1DrOffset = rxParamSetupReq->GetRx1DrOffset();
-    uint8_t rx2DataRate = rxParamSetupReq->GetRx2DataRate();
-    double frequency = rxParamSetupReq->GetFrequency();
+    NS_LOG_FUNCTION(this << unsigned(rx1DrOffset) << unsigned(rx2DataRate) << frequency);
 
     NS_LOG_INFO(unsigned(rx1DrOffset) << unsigned(rx2DataRate) << frequency);
 
@@ -299,6 +299,7 @@ ClassAEndDeviceLorawanMac::OnRxParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupRe
         m_rx1DrOffset = rx1DrOffset;
 
         // RxWin2
+        m_rx2DataRate = rx2DataRate;
         m_rwm->SetSf(RecvWindowManager::SECOND, GetSfFromDataRate(rx2DataRate));
         m_rwm->SetDuration(RecvWindowManager::SECOND, GetReceptionWindowDuration(rx2DataRate));
         m_rwm->SetFrequency(RecvWindowManager::SECOND, frequency);
@@ -306,7 +307,9 @@ ClassAEndDeviceLorawanMac::OnRxParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupRe
 
     // Craft a RxParamSetupAns as response
     NS_LOG_INFO("Adding RxParamSetupAns reply");
-    m_fOpts.push_back(Create<RxParamSetupAns>(offsetOk, dataRateOk, channelOk));
+    MacCommandValue answer(RX_PARAM_SETUP_ANS);
+    answer.rxParamSetupAns = {offsetOk, dataRateOk, channelOk};
+    m_fOpts.PushBack(answer);
 }
 
 void
@@ -317,7 +320,7 @@ ClassAEndDeviceLorawanMac::OnRxTimingSetupReq(Time delay)
     m_rwm->SetRx1Delay(delay);
 
     NS_LOG_INFO("Adding RxTimingSetupAns reply");
-    m_fOpts.push_back(Create<RxTimingSetupAns>());
+    m_fOpts.PushBack(MacCommandValue(RX_TIMING_SETUP_ANS));
 }
 
 /////////////////////////
@@ -327,6 +330,7 @@ ClassAEndDeviceLorawanMac::OnRxTimingSetupReq(Time delay)
 void
 ClassAEndDeviceLorawanMac::SetSecondReceiveWindowDataRate(uint8_t dataRate)
 {
+    m_rx2DataRate = dataRate;
     m_rwm->SetSf(RecvWindowManager::SECOND, GetSfFromDataRate(dataRate));
     m_rwm->SetDuration(RecvWindowManager::SECOND, GetReceptionWindowDuration(dataRate));
 }
@@ -337,6 +341,42 @@ ClassAEndDeviceLorawanMac::SetSecondReceiveWindowFrequency(double frequency)
     m_rwm->SetFrequency(RecvWindowManager::SECOND, frequency);
 }
 
+uint8_t
+ClassAEndDeviceLorawanMac::GetSecondReceiveWindowDataRate() const
+{
+    return m_rx2DataRate;
+}
+
+double
+ClassAEndDeviceLorawanMac::GetSecondReceiveWindowFrequency() const
+{
+    return m_rwm->GetFrequency(RecvWindowManager::SECOND);
+}
+
+void
+ClassAEndDeviceLorawanMac::SetRx1DrOffset(uint8_t rx1DrOffset)
+{
+    m_rx1DrOffset = rx1DrOffset;
+}
+
+uint8_t
+ClassAEndDeviceLorawanMac::GetRx1DrOffset() const
+{
+    return m_rx1DrOffset;
+}
+
+void
+ClassAEndDeviceLorawanMac::SetRx1Delay(Time delay)
+{
+    m_rwm->SetRx1Delay(delay);
+}
+
+Time
+ClassAEndDeviceLorawanMac::GetRx1Delay() const
+{
+    return m_rwm->GetRx1Delay();
+}
+
 void
 ClassAEndDeviceLorawanMac::DoInitialize()
 {
@@ -109,6 +109,40 @@ class ClassAEndDeviceLorawanMac : public BaseEndDeviceLorawanMac
      */
     void SetSecondReceiveWindowFrequency(double frequency);
 
+    /**
+     * Get the Data Rate used in the second receive window.
+     */
+    uint8_t GetSecondReceiveWindowDataRate() const;
+
+    /**
+     * Get the frequency used for the second receive window.
+     */
+    double GetSecondReceiveWindowFrequency() const;
+
+    /**
+     * Set the offset of the first receive window data rate (RX1DROffset).
+     *
+     * \param rx1DrOffset The offset.
+     */
+    void SetRx1DrOffset(uint8_t rx1DrOffset);
+
+    /**
+     * Get the offset of the first receive window data rate (RX1DROffset).
+     */
+    uint8_t GetRx1DrOffset() const;
+
+    /**
+     * Set the delay of the first receive window (the second one opens 1 s later).
+     *
+     * \param delay The delay from the end of the uplink.
+     */
+    void SetRx1Delay(Time delay);
+
+    /**
+     * Get the delay of the first receive window.
+     */
+    Time GetRx1Delay() const;
+
   protected:
     void DoInitialize() override;
     void DoDispose() override;
@@ -147,12 +181,11 @@ class ClassAEndDeviceLorawanMac : public BaseEndDeviceLorawanMac
      * Perform the actions that need to be taken when receiving a RxParamSetupReq
      * command.
      *
-     * \param rxParamSetupReq The Parameter Setup Request, which contains:
-     *                            - The offset to set.
-     *                            - The data rate to use for the second receive window.
-     *                            - The frequency to use for the second receive window.
+     * \param rx1DrOffset The offset to set.
+     * \param rx2DataRate The data rate to use for the second receive window.
+     * \param frequency The frequency to use for the second receive window.
      */
-    void OnRxParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupReq) override;
+    void OnRxParamSetupReq(uint8_t rx1DrOffset, uint8_t rx2DataRate, double frequency) override;
 
     /**
      * Perform the actions that need to be taken when receiving a RxTimingSetupReq command.
@@ -176,6 +209,11 @@ class ClassAEndDeviceLorawanMac : public BaseEndDeviceLorawanMac
      */
     uint8_t m_rx1DrOffset;
 
+    /**
+     * The data rate of the second receive window
+     */
+    uint8_t m_rx2DataRate;
+
     /**
      * Last channel used for tx
      */
@@ -70,7 +70,8 @@ GatewayLorawanMac::Send(Ptr<Packet> packet)
     // Configure PHY tx params
     m_txParams.sf = GetSfFromDataRate(dataRate);
     m_txParams.bandwidthHz = GetBandwidthFromDataRate(dataRate);
-    m_txParams.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(m_txParams) > MilliSeconds(16);
+    m_txParams.lowDataRateOptimizationEnabled =
+        LoraPhyMath::NeedsLowDataRateOptimization(m_txParams.sf, m_txParams.bandwidthHz);
     NS_LOG_DEBUG("DR: " << unsigned(dataRate));
     NS_LOG_DEBUG("SF: " << unsigned(m_txParams.sf));
     NS_LOG_DEBUG("BW: " << m_txParams.bandwidthHz << " Hz");
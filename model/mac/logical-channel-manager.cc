@@ -238,6 +238,33 @@ LogicalChannelManager::DisableChannel(uint8_t chIndex)
     m_channelList.at(chIndex)->DisableForUplink();
 }
 
+std::vector<Ptr<SubBand>>
+LogicalChannelManager::GetSubBandList()
+{
+    NS_LOG_FUNCTION(this);
+    return std::vector<Ptr<SubBand>>(m_subBandList.begin(), m_subBandList.end());
+}
+
+Time
+LogicalChannelManager::GetLastTxStart() const
+{
+    return m_lastTxStart;
+}
+
+Time
+LogicalChannelManager::GetLastTxDuration() const
+{
+    return m_lastTxDuration;
+}
+
+void
+LogicalChannelManager::SetLastTransmission(Time start, Time duration)
+{
+    NS_LOG_FUNCTION(this << start << duration);
+    m_lastTxStart = start;
+    m_lastTxDuration = duration;
+}
+
 void
 LogicalChannelManager::DoDispose()
 {
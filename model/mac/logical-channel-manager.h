@@ -186,6 +186,31 @@ class LogicalChannelManager : public Object
      */
     void DisableChannel(uint8_t chIndex);
 
+    /**
+     * Get the list of SubBands currently registered on this helper.
+     *
+     * \return A list of the SubBands.
+     */
+    std::vector<Ptr<SubBand>> GetSubBandList();
+
+    /**
+     * Get the start time of the last transmission.
+     */
+    Time GetLastTxStart() const;
+
+    /**
+     * Get the duration of the last transmission.
+     */
+    Time GetLastTxDuration() const;
+
+    /**
+     * Set the last transmission, used to enforce the aggregated duty cycle.
+     *
+     * \param start The start time of the transmission.
+     * \param duration The duration of the transmission.
+     */
+    void SetLastTransmission(Time start, Time duration);
+
   protected:
     void DoDispose() override;
 
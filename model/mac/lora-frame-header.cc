@@ -25,7 +25,7 @@
 
 #include "ns3/log.h"
 
-#include <bitset>
+#include <algorithm>
 
 namespace ns3
 {
@@ -36,21 +36,13 @@ NS_LOG_COMPONENT_DEFINE("LoraFrameHeader");
 
 // Initialization list
 LoraFrameHeader::LoraFrameHeader()
-    : m_fPort(-1),
-      m_address(LoraDeviceAddress(0, 0)),
-      m_adr(0),
-      m_adrAckReq(0),
-      m_ack(0),
-      m_fPending(0),
-      m_fOptsLen(0),
-      m_fCnt(0),
+    : m_isUplink(false),
       m_frmpCmdsLen(0)
 {
 }
 
 LoraFrameHeader::~LoraFrameHeader()
 {
-    m_macCommands.clear();
 }
 
 TypeId
@@ -74,7 +66,8 @@ LoraFrameHeader::GetSerializedSize() const
 
     // Sizes in bytes:
     // 4 for DevAddr + 1 for FCtrl + 2 for FCnt + 0-1 for FPort + 0-15 for FOpts
-    uint32_t size = 7 + (m_fPort > -1 && !m_frmpCmdsLen) + m_fOptsLen;
+    uint32_t size =
+        LorawanFrameCodec::GetFrameHeaderSize(m_frame) + (m_frame.fPort > -1 && !m_frmpCmdsLen);
 
     NS_LOG_INFO("LoraFrameHeader serialized size: " << (unsigned)size);
 
@@ -86,48 +79,29 @@ LoraFrameHeader::Serialize(Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Device Address field
-    start.WriteU32(m_address.Get());
-
-    // fCtrl field
-    //
-    // TODO FCtrl has different meanings for UL and DL packets. Handle this
-    // correctly here.
-    uint8_t fCtrl = 0;
-    fCtrl |= uint8_t(m_adr << 7 & 0b10000000);
-    fCtrl |= uint8_t(m_adrAckReq << 6 & 0b1000000);
-    fCtrl |= uint8_t(m_ack << 5 & 0b100000);
-    fCtrl |= uint8_t(m_fPending << 4 & 0b10000);
-    fCtrl |= m_fOptsLen & 0b1111;
-    start.WriteU8(fCtrl);
-
-    // FCnt field
-    start.WriteU16(m_fCnt);
-
-    // FOpts field
-    for (auto it = m_macCommands.begin(); it != m_macCommands.end(); it++)
-    {
-        NS_LOG_DEBUG("Serializing a MAC command");
-        (*it)->Serialize(start);
-    }
+    // Encode on the stack, then copy to the buffer at once
+    uint8_t data[LorawanFrameCodec::MAX_FHDR_SIZE + 1];
+    uint32_t size = LorawanFrameCodec::EncodeFrameHeader(m_frame, data, sizeof(data));
+    NS_ASSERT_MSG(size, "FOpts longer than " << LorawanFrameCodec::MAX_FOPTS_SIZE << " bytes");
 
     // FPort
-    if (m_fPort > -1 && !m_frmpCmdsLen)
+    if (m_frame.fPort > -1 && !m_frmpCmdsLen)
     {
-        start.WriteU8((uint8_t)m_fPort);
+        data[size++] = uint8_t(m_frame.fPort);
     }
+    start.Write(data, size);
 
     NS_LOG_DEBUG("Serializing the following data: ");
-    NS_LOG_DEBUG("Address: " << m_address.Print());
-    NS_LOG_DEBUG("ADR: " << unsigned(m_adr));
-    NS_LOG_DEBUG("ADRAckReq: " << unsigned(m_adrAckReq));
-    NS_LOG_DEBUG("Ack: " << unsigned(m_ack));
-    NS_LOG_DEBUG("fPending: " << unsigned(m_fPending));
-    NS_LOG_DEBUG("fOptsLen: " << unsigned(m_fOptsLen));
-    NS_LOG_DEBUG("fCnt: " << unsigned(m_fCnt));
-    if (m_fPort > -1)
+    NS_LOG_DEBUG("Address: " << GetAddress().Print());
+    NS_LOG_DEBUG("ADR: " << unsigned(m_frame.adr));
+    NS_LOG_DEBUG("ADRAckReq: " << unsigned(m_frame.adrAckReq));
+    NS_LOG_DEBUG("Ack: " << unsigned(m_frame.ack));
+    NS_LOG_DEBUG("fPending: " << unsigned(m_frame.fPending));
+    NS_LOG_DEBUG("fOptsLen: " << unsigned(GetFOptsLen()));
+    NS_LOG_DEBUG("fCnt: " << unsigned(m_frame.fCnt));
+    if (m_frame.fPort > -1)
     {
-        NS_LOG_DEBUG("fPort: " << m_fPort);
+        NS_LOG_DEBUG("fPort: " << m_frame.fPort);
     }
 }
 
@@ -136,208 +110,51 @@ LoraFrameHeader::Deserialize(Buffer::Iterator start)
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Empty the list of MAC commands
-    m_macCommands.clear();
+    // Copy at most the header and the FRMPayload commands to contiguous memory
+    uint8_t data[LorawanFrameCodec::MAX_FHDR_SIZE + 1 + LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t size = std::min<uint32_t>(start.GetRemainingSize(), sizeof(data));
+    start.Read(data, size);
 
-    // Read from buffer and save into local variables
-    m_address.Set(start.ReadU32());
     // TODO FCtrl has different meanings for UL and DL packets. Handle this
     // correctly here.
-    uint8_t fCtrl = start.ReadU8();
-    m_adr = (fCtrl >> 7) & 0b1;
-    m_adrAckReq = (fCtrl >> 6) & 0b1;
-    m_ack = (fCtrl >> 5) & 0b1;
-    m_fPending = (fCtrl >> 4) & 0b1;
-    m_fOptsLen = fCtrl & 0b1111;
-    m_fCnt = start.ReadU16();
+    uint32_t consumed = LorawanFrameCodec::DecodeFrameHeader(data, size, m_isUplink, m_frame);
+    NS_ASSERT_MSG(consumed, "Truncated frame header");
 
     NS_LOG_DEBUG("Deserialized data: ");
-    NS_LOG_DEBUG("Address: " << m_address.Print());
-    NS_LOG_DEBUG("ADR: " << unsigned(m_adr));
-    NS_LOG_DEBUG("ADRAckReq: " << unsigned(m_adrAckReq));
-    NS_LOG_DEBUG("Ack: " << unsigned(m_ack));
-    NS_LOG_DEBUG("fPending: " << unsigned(m_fPending));
-    NS_LOG_DEBUG("fOptsLen: " << (unsigned)m_fOptsLen);
-    NS_LOG_DEBUG("fCnt: " << unsigned(m_fCnt));
-
-    // Deserialize MAC commands
-    NS_LOG_DEBUG("Starting deserialization of MAC commands");
-    for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen + m_frmpCmdsLen;)
+    NS_LOG_DEBUG("Address: " << GetAddress().Print());
+    NS_LOG_DEBUG("ADR: " << unsigned(m_frame.adr));
+    NS_LOG_DEBUG("ADRAckReq: " << unsigned(m_frame.adrAckReq));
+    NS_LOG_DEBUG("Ack: " << unsigned(m_frame.ack));
+    NS_LOG_DEBUG("fPending: " << unsigned(m_frame.fPending));
+    NS_LOG_DEBUG("fOptsLen: " << (unsigned)(consumed - LorawanFrameCodec::MIN_FHDR_SIZE));
+    NS_LOG_DEBUG("fCnt: " << unsigned(m_frame.fCnt));
+
+    // If m_frmpCmdsLen > 0, we expect no FPort in buffer
+    if (m_frmpCmdsLen)
     {
-        uint8_t cid = start.PeekU8();
-        NS_LOG_DEBUG("CID: " << unsigned(cid));
-
-        // Divide Uplink and Downlink messages
-        // This needs to be done because they have the same CID, and the context
-        // about where this message will be Serialized/Deserialized (i.e., at the
-        // ED or at the NS) is umportant.
-        if (m_isUplink)
-        {
-            switch (cid)
-            {
-            // In the case of Uplink messages, the NS will deserialize the
-            // request for a link check
-            case (0x02): {
-                NS_LOG_DEBUG("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create<LinkCheckReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x03): {
-                NS_LOG_DEBUG("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create<LinkAdrAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x04): {
-                NS_LOG_DEBUG("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create<DutyCycleAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x05): {
-                NS_LOG_DEBUG("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create<RxParamSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x06): {
-                NS_LOG_DEBUG("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create<DevStatusAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x07): {
-                NS_LOG_DEBUG("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create<NewChannelAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x08): {
-                NS_LOG_DEBUG("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create<RxTimingSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x09): {
-                NS_LOG_DEBUG("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create<TxParamSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x0A): {
-                NS_LOG_DEBUG("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create<DlChannelAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            default: {
-                NS_LOG_ERROR("CID not recognized during deserialization");
-            }
-            }
-        }
-        else
+        NS_ASSERT_MSG(consumed + m_frmpCmdsLen <= size, "Truncated FRMPayload commands");
+        if (!LorawanFrameCodec::DecodeMacCommands(data + consumed,
+                                                  m_frmpCmdsLen,
+                                                  m_isUplink,
+                                                  m_frame.fOpts))
         {
-            switch (cid)
-            {
-            // In the case of Downlink messages, the ED will deserialize the
-            // answer to a link check
-            case (0x02): {
-                NS_LOG_DEBUG("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create<LinkCheckAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x03): {
-                NS_LOG_DEBUG("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create<LinkAdrReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x04): {
-                NS_LOG_DEBUG("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create<DutyCycleReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x05): {
-                NS_LOG_DEBUG("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create<RxParamSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x06): {
-                NS_LOG_DEBUG("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create<DevStatusReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x07): {
-                NS_LOG_DEBUG("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create<NewChannelReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x08): {
-                NS_LOG_DEBUG("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create<RxTimingSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x09): {
-                NS_LOG_DEBUG("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create<TxParamSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x0A): {
-                NS_LOG_DEBUG("Creating a DlChannelReq command");
-                Ptr<DlChannelReq> command = Create<DlChannelReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            default: {
-                NS_LOG_ERROR("CID not recognized during deserialization");
-                byteNumber = m_fOptsLen + m_frmpCmdsLen;
-                break;
-            }
-            }
+            NS_LOG_ERROR("Invalid MAC command in FRMPayload, skipping the rest");
         }
+        consumed += m_frmpCmdsLen;
     }
-
-    // If m_frmpCmdsLen > 0, we expect no FPort in buffer
-    if (!m_frmpCmdsLen)
+    else
     {
         // "If the frame payload field is not empty, the port field SHALL be present"
         // So, if there is more data in the buffer, it is FPort
-        m_fPort = (start.IsEnd()) ? -1 : int(start.ReadU8());
+        m_frame.fPort = (consumed < size) ? int(data[consumed++]) : -1;
     }
 
-    if (m_fPort > -1)
+    if (m_frame.fPort > -1)
     {
-        NS_LOG_DEBUG("fPort: " << m_fPort);
+        NS_LOG_DEBUG("fPort: " << m_frame.fPort);
     }
 
-    return 7 + m_fOptsLen + (m_fPort > -1 && !m_frmpCmdsLen) +
-           m_frmpCmdsLen; // the number of bytes consumed.
+    return consumed; // the number of bytes consumed.
 }
 
 void
@@ -345,23 +162,23 @@ LoraFrameHeader::Print(std::ostream& os) const
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    os << "Address=" << m_address.Print() << std::endl;
-    os << "ADR=" << m_adr << std::endl;
-    os << "ADRAckReq=" << m_adrAckReq << std::endl;
-    os << "ACK=" << m_ack << std::endl;
-    os << "FPending=" << m_fPending << std::endl;
-    os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
+    os << "Address=" << GetAddress().Print() << std::endl;
+    os << "ADR=" << m_frame.adr << std::endl;
+    os << "ADRAckReq=" << m_frame.adrAckReq << std::endl;
+    os << "ACK=" << m_frame.ack << std::endl;
+    os << "FPending=" << m_frame.fPending << std::endl;
+    os << "FOptsLen=" << unsigned(GetFOptsLen()) << std::endl;
     os << "(FRMPCmdsLen=" << unsigned(m_frmpCmdsLen) << ")" << std::endl;
-    os << "FCnt=" << unsigned(m_fCnt) << std::endl;
+    os << "FCnt=" << unsigned(m_frame.fCnt) << std::endl;
 
-    for (auto it = m_macCommands.begin(); it != m_macCommands.end(); it++)
+    for (const auto& command : m_frame.fOpts)
     {
-        (*it)->Print(os);
+        command.Print(os);
     }
 
-    if (m_fPort > -1)
+    if (m_frame.fPort > -1)
     {
-        os << "FPort=" << m_fPort;
+        os << "FPort=" << m_frame.fPort;
     }
 
     os << std::endl;
@@ -386,100 +203,94 @@ LoraFrameHeader::SetAsDownlink()
 void
 LoraFrameHeader::SetFPort(int fPort)
 {
-    m_fPort = fPort;
+    m_frame.fPort = fPort;
 }
 
 int
 LoraFrameHeader::GetFPort() const
 {
-    return m_fPort;
+    return m_frame.fPort;
 }
 
 void
 LoraFrameHeader::SetAddress(LoraDeviceAddress address)
 {
-    m_address = address;
+    m_frame.devAddr = address.Get();
 }
 
 LoraDeviceAddress
 LoraFrameHeader::GetAddress() const
 {
-    return m_address;
+    return LoraDeviceAddress(m_frame.devAddr);
 }
 
 void
 LoraFrameHeader::SetAdr(bool adr)
 {
     NS_LOG_FUNCTION(this << adr);
-    m_adr = adr;
+    m_frame.adr = adr;
 }
 
 bool
 LoraFrameHeader::GetAdr() const
 {
-    return m_adr;
+    return m_frame.adr;
 }
 
 void
 LoraFrameHeader::SetAdrAckReq(bool adrAckReq)
 {
-    m_adrAckReq = adrAckReq;
+    m_frame.adrAckReq = adrAckReq;
 }
 
 bool
 LoraFrameHeader::GetAdrAckReq() const
 {
-    return m_adrAckReq;
+    return m_frame.adrAckReq;
 }
 
 void
 LoraFrameHeader::SetAck(bool ack)
 {
     NS_LOG_FUNCTION(this << ack);
-    m_ack = ack;
+    m_frame.ack = ack;
 }
 
 bool
 LoraFrameHeader::GetAck() const
 {
-    return m_ack;
+    return m_frame.ack;
 }
 
 void
 LoraFrameHeader::SetFPending(bool fPending)
 {
-    m_fPending = fPending;
+    m_frame.fPending = fPending;
 }
 
 bool
 LoraFrameHeader::GetFPending() const
 {
-    return m_fPending;
+    return m_frame.fPending;
 }
 
 uint8_t
 LoraFrameHeader::GetFOptsLen() const
 {
     // Sum the serialized lenght of all commands in the list
-    uint8_t fOptsLen = 0;
-    std::list<Ptr<MacCommand>>::const_iterator it;
-    for (it = m_macCommands.begin(); it != m_macCommands.end(); it++)
-    {
-        fOptsLen = fOptsLen + (*it)->GetSerializedSize();
-    }
-    return fOptsLen;
+    return m_frame.fOpts.GetSerializedSize();
 }
 
 void
 LoraFrameHeader::SetFCnt(uint16_t fCnt)
 {
-    m_fCnt = fCnt;
+    m_frame.fCnt = fCnt;
 }
 
 uint16_t
 LoraFrameHeader::GetFCnt() const
 {
-    return m_fCnt;
+    return m_frame.fCnt;
 }
 
 void
@@ -493,11 +304,7 @@ LoraFrameHeader::AddLinkCheckReq()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    Ptr<LinkCheckReq> command = Create<LinkCheckReq>();
-    m_macCommands.emplace_back(command);
-
-    NS_LOG_DEBUG("Command SerializedSize: " << unsigned(command->GetSerializedSize()));
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(MacCommandValue(LINK_CHECK_REQ));
 }
 
 void
@@ -505,10 +312,9 @@ LoraFrameHeader::AddLinkCheckAns(uint8_t margin, uint8_t gwCnt)
 {
     NS_LOG_FUNCTION(this << unsigned(margin) << unsigned(gwCnt));
 
-    Ptr<LinkCheckAns> command = Create<LinkCheckAns>(margin, gwCnt);
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    MacCommandValue command(LINK_CHECK_ANS);
+    command.linkCheckAns = {margin, gwCnt};
+    AddCommand(command);
 }
 
 void
@@ -532,10 +338,9 @@ LoraFrameHeader::AddLinkAdrReq(uint8_t dataRate,
     NS_LOG_DEBUG("Creating LinkAdrReq with: DR = " << unsigned(dataRate)
                                                    << " and txPower = " << unsigned(txPower));
 
-    Ptr<LinkAdrReq> command = Create<LinkAdrReq>(dataRate, txPower, channelMask, 0, repetitions);
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    MacCommandValue command(LINK_ADR_REQ);
+    command.linkAdrReq = {dataRate, txPower, channelMask, 0, uint8_t(repetitions)};
+    AddCommand(command);
 }
 
 void
@@ -543,10 +348,9 @@ LoraFrameHeader::AddLinkAdrAns(bool powerAck, bool dataRateAck, bool channelMask
 {
     NS_LOG_FUNCTION(this << powerAck << dataRateAck << channelMaskAck);
 
-    Ptr<LinkAdrAns> command = Create<LinkAdrAns>(powerAck, dataRateAck, channelMaskAck);
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    MacCommandValue command(LINK_ADR_ANS);
+    command.linkAdrAns = {powerAck, dataRateAck, channelMaskAck};
+    AddCommand(command);
 }
 
 void
@@ -554,11 +358,9 @@ LoraFrameHeader::AddDutyCycleReq(uint8_t dutyCycle)
 {
     NS_LOG_FUNCTION(this << unsigned(dutyCycle));
 
-    Ptr<DutyCycleReq> command = Create<DutyCycleReq>(dutyCycle);
-
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    MacCommandValue command(DUTY_CYCLE_REQ);
+    command.dutyCycleReq = {dutyCycle};
+    AddCommand(command);
 }
 
 void
@@ -566,11 +368,7 @@ LoraFrameHeader::AddDutyCycleAns()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<DutyCycleAns> command = Create<DutyCycleAns>();
-
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(MacCommandValue(DUTY_CYCLE_ANS));
 }
 
 void
@@ -581,11 +379,11 @@ LoraFrameHeader::AddRxParamSetupReq(uint8_t rx1DrOffset, uint8_t rx2DataRate, do
     // Evaluate whether to eliminate this assert in case new offsets can be defined.
     NS_ASSERT(0 <= rx1DrOffset && rx1DrOffset <= 5);
 
-    Ptr<RxParamSetupReq> command = Create<RxParamSetupReq>(rx1DrOffset, rx2DataRate, frequency);
-
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    MacCommandValue command(RX_PARAM_SETUP_REQ);
+    command.rxParamSetupReq.frequency = uint32_t(frequency);
+    command.rxParamSetupReq.rx1DrOffset = rx1DrOffset;
+    command.rxParamSetupReq.rx2DataRate = rx2DataRate;
+    AddCommand(command);
 }
 
 void
@@ -593,11 +391,7 @@ LoraFrameHeader::AddRxParamSetupAns()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<RxParamSetupAns> command = Create<RxParamSetupAns>();
-
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(MacCommandValue(RX_PARAM_SETUP_ANS));
 }
 
 void
@@ -605,11 +399,7 @@ LoraFrameHeader::AddDevStatusReq()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<DevStatusReq> command = Create<DevStatusReq>();
-
-    m_macCommands.push_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(MacCommandValue(DEV_STATUS_REQ));
 }
 
 void
@@ -620,12 +410,28 @@ LoraFrameHeader::AddNewChannelReq(uint8_t chIndex,
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<NewChannelReq> command =
-        Create<NewChannelReq>(chIndex, frequency, minDataRate, maxDataRate);
+    MacCommandValue command(NEW_CHANNEL_REQ);
+    command.newChannelReq.frequency = uint32_t(frequency);
+    command.newChannelReq.chIndex = chIndex;
+    command.newChannelReq.minDataRate = minDataRate;
+    command.newChannelReq.maxDataRate = maxDataRate;
+    AddCommand(command);
+}
 
-    m_macCommands.push_back(command);
+const MacCommandList&
+LoraFrameHeader::GetCommandList() const
+{
+    return m_frame.fOpts;
+}
 
-    m_fOptsLen += command->GetSerializedSize();
+void
+LoraFrameHeader::AddCommand(const MacCommandValue& command)
+{
+    NS_LOG_FUNCTION(this << unsigned(MacCommand::GetCIDFromMacCommand(command.type)));
+
+    m_frame.fOpts.PushBack(command);
+
+    NS_LOG_DEBUG("Command SerializedSize: " << unsigned(command.GetSerializedSize()));
 }
 
 std::list<Ptr<MacCommand>>
@@ -633,7 +439,12 @@ LoraFrameHeader::GetCommands()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    return m_macCommands;
+    std::list<Ptr<MacCommand>> commands;
+    for (const auto& command : m_frame.fOpts)
+    {
+        commands.push_back(command.ToMacCommand());
+    }
+    return commands;
 }
 
 void
@@ -641,8 +452,7 @@ LoraFrameHeader::AddCommand(Ptr<MacCommand> macCommand)
 {
     NS_LOG_FUNCTION(this << macCommand);
 
-    m_macCommands.push_back(macCommand);
-    m_fOptsLen += macCommand->GetSerializedSize();
+    AddCommand(macCommand->GetValue());
 }
 
 } // namespace lorawan
@@ -26,6 +26,7 @@
 
 #include "ns3/header.h"
 #include "ns3/lora-device-address.h"
+#include "ns3/lorawan-frame-codec.h"
 #include "ns3/mac-command.h"
 
 namespace ns3
@@ -213,6 +214,9 @@ class LoraFrameHeader : public Header
     /**
      * Return a pointer to a MacCommand, or 0 if the MacCommand does not exist
      * in this header.
+     *
+     * The command is created from the stored value: changes to it do not
+     * affect this header. Prefer GetCommandList, that does not allocate.
      */
     template <typename T>
     inline Ptr<T> GetMacCommand();
@@ -308,39 +312,38 @@ class LoraFrameHeader : public Header
                           uint8_t maxDataRate);
 
     /**
-     * Return a list of pointers to all the MAC commands saved in this header.
+     * Get the MAC commands saved in this header.
+     *
+     * \return The commands, in order of serialization.
      */
-    std::list<Ptr<MacCommand>> GetCommands();
+    const MacCommandList& GetCommandList() const;
 
     /**
      * Add a predefined command to the list.
+     *
+     * \param command The command.
      */
-    void AddCommand(Ptr<MacCommand> macCommand);
-
-  private:
-    int m_fPort;
-
-    LoraDeviceAddress m_address;
-
-    bool m_adr;
-    bool m_adrAckReq;
-    bool m_ack;
-    bool m_fPending;
-    uint8_t m_fOptsLen;
-
-    uint16_t m_fCnt;
-
-    Buffer m_fOpts;
+    void AddCommand(const MacCommandValue& command);
 
     /**
-     * List containing all the MacCommand instances that are contained in this
-     * LoraFrameHeader.
+     * Return a list of pointers to all the MAC commands saved in this header.
+     *
+     * Commands are created from the stored values. Prefer GetCommandList,
+     * that does not allocate.
      */
-    std::list<Ptr<MacCommand>> m_macCommands;
+    std::list<Ptr<MacCommand>> GetCommands();
 
-    bool m_isUplink;
+    /**
+     * Add a predefined command to the list.
+     *
+     * Only the value of the command is saved (see MacCommand::GetValue).
+     */
+    void AddCommand(Ptr<MacCommand> macCommand);
 
-    uint16_t m_frmpCmdsLen;
+  private:
+    LorawanFrame m_frame;   //!< Fields of the FHDR and FPort, encoded by LorawanFrameCodec
+    bool m_isUplink;        //!< Whether the header belongs to an uplink frame
+    uint16_t m_frmpCmdsLen; //!< Length of the MAC commands in the FRMPayload, if any
 };
 
 template <typename T>
@@ -348,9 +351,9 @@ Ptr<T>
 LoraFrameHeader::GetMacCommand()
 {
     // Iterate on MAC commands and try casting
-    for (const auto& cmd : m_macCommands)
+    for (const auto& command : m_frame.fOpts)
     {
-        if (auto deriv = DynamicCast<T>(cmd); bool(deriv))
+        if (auto deriv = DynamicCast<T>(command.ToMacCommand()); bool(deriv))
         {
             return deriv;
         }
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "lorawan-frame-codec.h"
+
+#include "ns3/log.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LorawanFrameCodec");
+
+LorawanFrame::LorawanFrame()
+    : fType(0),
+      major(0),
+      devAddr(0),
+      adr(false),
+      adrAckReq(false),
+      ack(false),
+      fPending(false),
+      fCnt(0),
+      fPort(-1),
+      frmPayload(nullptr),
+      frmPayloadSize(0),
+      mic(0)
+{
+}
+
+uint8_t
+LorawanFrameCodec::EncodeMacHeader(uint8_t fType, uint8_t major)
+{
+    // FType in the 3 most significant bits, RFU bits left to 0, Major in the 2 least significant
+    return uint8_t(fType << 5) | (major & 0b11);
+}
+
+void
+LorawanFrameCodec::DecodeMacHeader(uint8_t mhdr, uint8_t& fType, uint8_t& major)
+{
+    fType = mhdr >> 5;
+    major = mhdr & 0b11;
+}
+
+bool
+LorawanFrameCodec::IsUplink(uint8_t fType)
+{
+    // JOIN_REQUEST, UNCONFIRMED_DATA_UP and CONFIRMED_DATA_UP
+    return fType == 0 || fType == 2 || fType == 4;
+}
+
+uint32_t
+LorawanFrameCodec::GetFrameHeaderSize(const LorawanFrame& frame)
+{
+    return MIN_FHDR_SIZE + frame.fOpts.GetSerializedSize();
+}
+
+uint32_t
+LorawanFrameCodec::EncodeFrameHeader(const LorawanFrame& frame, uint8_t* data, uint32_t capacity)
+{
+    uint32_t fOptsLen = frame.fOpts.GetSerializedSize();
+    if (fOptsLen > MAX_FOPTS_SIZE || capacity < MIN_FHDR_SIZE + fOptsLen)
+    {
+        return 0;
+    }
+
+    // DevAddr
+    data[0] = frame.devAddr & 0xff;
+    data[1] = (frame.devAddr >> 8) & 0xff;
+    data[2] = (frame.devAddr >> 16) & 0xff;
+    data[3] = (frame.devAddr >> 24) & 0xff;
+
+    // FCtrl
+    data[4] = uint8_t(frame.adr << 7 | frame.adrAckReq << 6 | frame.ack << 5 |
+                      frame.fPending << 4 | fOptsLen);
+
+    // FCnt
+    data[5] = frame.fCnt & 0xff;
+    data[6] = frame.fCnt >> 8;
+
+    // FOpts
+    uint8_t* cursor = data + MIN_FHDR_SIZE;
+    for (const auto& command : frame.fOpts)
+    {
+        command.Serialize(cursor);
+        cursor += command.GetSerializedSize();
+    }
+    return MIN_FHDR_SIZE + fOptsLen;
+}
+
+uint32_t
+LorawanFrameCodec::DecodeFrameHeader(const uint8_t* data,
+                                     uint32_t size,
+                                     bool isUplink,
+                                     LorawanFrame& frame)
+{
+    if (size < MIN_FHDR_SIZE)
+    {
+        return 0;
+    }
+    uint8_t fOptsLen = data[4] & 0b1111;
+    if (size < MIN_FHDR_SIZE + fOptsLen)
+    {
+        return 0;
+    }
+
+    frame.devAddr = uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 |
+                    uint32_t(data[3]) << 24;
+    frame.adr = (data[4] >> 7) & 0b1;
+    frame.adrAckReq = (data[4] >> 6) & 0b1;
+    frame.ack = (data[4] >> 5) & 0b1;
+    frame.fPending = (data[4] >> 4) & 0b1;
+    frame.fCnt = uint16_t(data[5] | data[6] << 8);
+
+    frame.fOpts.Clear();
+    if (!DecodeMacCommands(data + MIN_FHDR_SIZE, fOptsLen, isUplink, frame.fOpts))
+    {
+        // Skip the rest, as the length of unknown commands is unknown
+        NS_LOG_ERROR("Invalid MAC command in FOpts, skipping the rest");
+    }
+    return MIN_FHDR_SIZE + fOptsLen;
+}
+
+bool
+LorawanFrameCodec::DecodeMacCommands(const uint8_t* data,
+                                     uint32_t size,
+                                     bool isUplink,
+                                     MacCommandList& commands)
+{
+    for (uint32_t offset = 0; offset < size;)
+    {
+        // The direction is needed because requests and answers share their CID,
+        // and the context (i.e., deserialized at the ED or at the NS) is important.
+        MacCommandValue command;
+        uint8_t consumed = command.Deserialize(data + offset, size - offset, isUplink);
+        if (!consumed)
+        {
+            NS_LOG_DEBUG("CID " << unsigned(data[offset]) << " not recognized or truncated");
+            return false;
+        }
+        commands.PushBack(command);
+        offset += consumed;
+    }
+    return true;
+}
+
+uint32_t
+LorawanFrameCodec::GetSize(const LorawanFrame& frame)
+{
+    return MHDR_SIZE + GetFrameHeaderSize(frame) + (frame.fPort > -1) + frame.frmPayloadSize +
+           MIC_SIZE;
+}
+
+uint32_t
+LorawanFrameCodec::Encode(const LorawanFrame& frame, uint8_t* data, uint32_t capacity)
+{
+    // "If the frame payload field is not empty, the port field SHALL be present"
+    if (frame.frmPayloadSize && frame.fPort < 0)
+    {
+        return 0;
+    }
+    uint32_t size = GetSize(frame);
+    if (size > capacity || size > MAX_PHY_PAYLOAD_SIZE)
+    {
+        return 0;
+    }
+
+    data[0] = EncodeMacHeader(frame.fType, frame.major);
+    uint32_t offset = MHDR_SIZE;
+    uint32_t fhdrSize = EncodeFrameHeader(frame, data + offset, capacity - offset);
+    if (!fhdrSize)
+    {
+        return 0;
+    }
+    offset += fhdrSize;
+    if (frame.fPort > -1)
+    {
+        data[offset++] = uint8_t(frame.fPort);
+    }
+    for (uint32_t i = 0; i < frame.frmPayloadSize; ++i)
+    {
+        data[offset++] = frame.frmPayload[i];
+    }
+    for (uint32_t i = 0; i < MIC_SIZE; ++i)
+    {
+        data[offset++] = (frame.mic >> (8 * i)) & 0xff;
+    }
+    return offset;
+}
+
+bool
+LorawanFrameCodec::Decode(const uint8_t* data, uint32_t size, LorawanFrame& frame)
+{
+    if (size < MHDR_SIZE + MIN_FHDR_SIZE + MIC_SIZE || size > MAX_PHY_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+    DecodeMacHeader(data[0], frame.fType, frame.major);
+    // Only data messages (UNCONFIRMED_DATA_UP to CONFIRMED_DATA_DOWN) have a FHDR
+    if (frame.fType < 2 || frame.fType > 5)
+    {
+        return false;
+    }
+
+    uint32_t end = size - MIC_SIZE;
+    uint32_t offset = MHDR_SIZE;
+    uint32_t fhdrSize =
+        DecodeFrameHeader(data + offset, end - offset, IsUplink(frame.fType), frame);
+    if (!fhdrSize)
+    {
+        return false;
+    }
+    offset += fhdrSize;
+
+    // "If the frame payload field is not empty, the port field SHALL be present"
+    frame.fPort = (offset < end) ? int(data[offset++]) : -1;
+    frame.frmPayload = data + offset;
+    frame.frmPayloadSize = end - offset;
+
+    frame.mic = uint32_t(data[end]) | uint32_t(data[end + 1]) << 8 |
+                uint32_t(data[end + 2]) << 16 | uint32_t(data[end + 3]) << 24;
+    return true;
+}
+
+} // namespace lorawan
+} // namespace ns3
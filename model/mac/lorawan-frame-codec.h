@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef LORAWAN_FRAME_CODEC_H
+#define LORAWAN_FRAME_CODEC_H
+
+#include "ns3/mac-command.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Fields of a LoRaWAN PHYPayload carrying a data message: MHDR, FHDR (with
+ * FOpts), FPort, FRMPayload and MIC.
+ *
+ * Decoding does not copy the FRMPayload: it points into the decoded bytes,
+ * which must outlive the frame.
+ */
+struct LorawanFrame
+{
+    LorawanFrame();
+
+    uint8_t fType;             //!< Message type (see LorawanMacHeader::FType)
+    uint8_t major;             //!< Major version of the message format
+    uint32_t devAddr;          //!< Device address
+    bool adr;                  //!< ADR bit
+    bool adrAckReq;            //!< ADRACKReq bit
+    bool ack;                  //!< ACK bit
+    bool fPending;             //!< FPending bit
+    uint16_t fCnt;             //!< Frame counter (16 least significant bits)
+    MacCommandList fOpts;      //!< MAC commands in FOpts
+    int fPort;                 //!< Port, or -1 if absent
+    const uint8_t* frmPayload; //!< FRMPayload, not owned
+    uint32_t frmPayloadSize;   //!< Size of the FRMPayload
+    uint32_t mic;              //!< Message integrity code
+};
+
+/**
+ * Encoder and decoder of LoRaWAN data frames on contiguous bytes.
+ *
+ * Nothing is allocated: frames are encoded into caller-provided memory and
+ * decoded in place. Decoding checks all lengths, and fails on malformed
+ * input instead of reading past the end.
+ */
+class LorawanFrameCodec
+{
+  public:
+    static constexpr uint32_t MHDR_SIZE = 1;              //!< Size of the MHDR
+    static constexpr uint32_t MIN_FHDR_SIZE = 7;          //!< Size of the FHDR without FOpts
+    static constexpr uint32_t MAX_FOPTS_SIZE = 15;        //!< Maximum size of FOpts
+    static constexpr uint32_t MAX_FHDR_SIZE = 22;         //!< Size of the FHDR with full FOpts
+    static constexpr uint32_t MIC_SIZE = 4;               //!< Size of the MIC
+    static constexpr uint32_t MAX_PHY_PAYLOAD_SIZE = 255; //!< Maximum size of a PHYPayload
+
+    /**
+     * Encode the MHDR.
+     *
+     * \param fType The message type.
+     * \param major The major version.
+     * \return The MHDR byte.
+     */
+    static uint8_t EncodeMacHeader(uint8_t fType, uint8_t major);
+
+    /**
+     * Decode the MHDR.
+     *
+     * \param mhdr The MHDR byte.
+     * \param fType The message type.
+     * \param major The major version.
+     */
+    static void DecodeMacHeader(uint8_t mhdr, uint8_t& fType, uint8_t& major);
+
+    /**
+     * Whether a message type is sent by end devices.
+     *
+     * \param fType The message type.
+     */
+    static bool IsUplink(uint8_t fType);
+
+    /**
+     * Get the size of the FHDR of a frame, FOpts included.
+     *
+     * \param frame The frame.
+     */
+    static uint32_t GetFrameHeaderSize(const LorawanFrame& frame);
+
+    /**
+     * Encode the FHDR of a frame: DevAddr, FCtrl, FCnt and FOpts.
+     *
+     * \param frame The frame.
+     * \param data The destination.
+     * \param capacity The room at the destination.
+     * \return The number of bytes written, or 0 if FOpts exceed 15 bytes or do not fit.
+     */
+    static uint32_t EncodeFrameHeader(const LorawanFrame& frame, uint8_t* data, uint32_t capacity);
+
+    /**
+     * Decode the FHDR of a frame. Other fields of the frame are left unchanged.
+     *
+     * MAC commands are parsed up to the first unknown CID, and the rest of
+     * FOpts is skipped.
+     *
+     * \param data The bytes, starting with DevAddr.
+     * \param size The number of bytes available.
+     * \param isUplink Whether the frame was sent by an end device.
+     * \param frame The frame.
+     * \return The number of bytes consumed, or 0 if the FHDR is truncated.
+     */
+    static uint32_t DecodeFrameHeader(const uint8_t* data,
+                                      uint32_t size,
+                                      bool isUplink,
+                                      LorawanFrame& frame);
+
+    /**
+     * Decode a sequence of MAC commands, e.g., from a decrypted FRMPayload.
+     *
+     * \param data The bytes.
+     * \param size The number of bytes.
+     * \param isUplink Whether the commands were sent by an end device.
+     * \param commands The list to append the commands to.
+     * \return Whether all bytes were valid commands. Commands before an invalid one are kept.
+     */
+    static bool DecodeMacCommands(const uint8_t* data,
+                                  uint32_t size,
+                                  bool isUplink,
+                                  MacCommandList& commands);
+
+    /**
+     * Get the size of the PHYPayload of a frame.
+     *
+     * \param frame The frame.
+     */
+    static uint32_t GetSize(const LorawanFrame& frame);
+
+    /**
+     * Encode a PHYPayload.
+     *
+     * \param frame The frame. The FPort is needed if the FRMPayload is not empty.
+     * \param data The destination.
+     * \param capacity The room at the destination.
+     * \return The number of bytes written, or 0 if the frame is invalid or does not fit.
+     */
+    static uint32_t Encode(const LorawanFrame& frame, uint8_t* data, uint32_t capacity);
+
+    /**
+     * Decode a PHYPayload with a data message.
+     *
+     * \param data The bytes. The FRMPayload of the frame points into them.
+     * \param size The number of bytes.
+     * \param frame The frame.
+     * \return Whether the bytes are a valid data message.
+     */
+    static bool Decode(const uint8_t* data, uint32_t size, LorawanFrame& frame);
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORAWAN_FRAME_CODEC_H */
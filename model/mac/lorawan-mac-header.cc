@@ -24,6 +24,7 @@
 #include "lorawan-mac-header.h"
 
 #include "ns3/log.h"
+#include "ns3/lorawan-frame-codec.h"
 
 #include <bitset>
 
@@ -62,7 +63,7 @@ LorawanMacHeader::GetSerializedSize() const
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    return 1; // This header only consists in 8 bits
+    return LorawanFrameCodec::MHDR_SIZE; // This header only consists in 8 bits
 }
 
 void
@@ -70,18 +71,7 @@ LorawanMacHeader::Serialize(Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // The header we need to fill
-    uint8_t header = 0;
-
-    // The FType
-    header |= m_ftype << 5;
-
-    // Do nothing for the bits that are RFU
-
-    // The major version bits
-    header |= m_major;
-
-    // Write the byte
+    uint8_t header = LorawanFrameCodec::EncodeMacHeader(m_ftype, m_major);
     start.WriteU8(header);
 
     NS_LOG_DEBUG("Serialization of MAC header: " << std::bitset<8>(header));
@@ -92,18 +82,9 @@ LorawanMacHeader::Deserialize(Buffer::Iterator start)
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Save the byte on a temporary variable
-    uint8_t byte;
-    byte = start.ReadU8();
-
-    // Get the 2 least significant bits to have the Major
-    m_major = byte & 0b11;
-
-    // Move the three most significant bits to the least significant positions
-    // to get the FType
-    m_ftype = byte >> 5;
+    LorawanFrameCodec::DecodeMacHeader(start.ReadU8(), m_ftype, m_major);
 
-    return 1; // the number of bytes consumed.
+    return LorawanFrameCodec::MHDR_SIZE; // the number of bytes consumed.
 }
 
 void
@@ -152,8 +133,7 @@ LorawanMacHeader::IsUplink() const
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    return (m_ftype == JOIN_REQUEST) || (m_ftype == UNCONFIRMED_DATA_UP) ||
-           (m_ftype == CONFIRMED_DATA_UP);
+    return LorawanFrameCodec::IsUplink(m_ftype);
 }
 
 bool
@@ -25,6 +25,7 @@
 
 #include "ns3/log.h"
 
+#include <algorithm>
 #include <bitset>
 #include <cmath>
 
@@ -111,6 +112,444 @@ MacCommand::GetCIDFromMacCommand(enum MacCommandType commandType)
     return 0;
 }
 
+/////////////////////
+// MacCommandValue //
+/////////////////////
+
+MacCommandValue::MacCommandValue()
+    : type(INVALID),
+      bytes{}
+{
+}
+
+MacCommandValue::MacCommandValue(enum MacCommandType commandType)
+    : type(commandType),
+      bytes{}
+{
+}
+
+uint8_t
+MacCommandValue::GetSerializedSize() const
+{
+    switch (type)
+    {
+    case (LINK_CHECK_REQ):
+    case (DUTY_CYCLE_ANS):
+    case (DEV_STATUS_REQ):
+    case (RX_TIMING_SETUP_ANS):
+    case (TX_PARAM_SETUP_ANS):
+        return 1;
+    case (LINK_ADR_ANS):
+    case (DUTY_CYCLE_REQ):
+    case (RX_PARAM_SETUP_ANS):
+    case (NEW_CHANNEL_ANS):
+    case (RX_TIMING_SETUP_REQ):
+    case (TX_PARAM_SETUP_REQ):
+    case (DL_CHANNEL_ANS):
+        return 2;
+    case (LINK_CHECK_ANS):
+    case (DEV_STATUS_ANS):
+        return 3;
+    case (LINK_ADR_REQ):
+    case (RX_PARAM_SETUP_REQ):
+    case (DL_CHANNEL_REQ):
+        return 5;
+    case (NEW_CHANNEL_REQ):
+        return 6;
+    case (INVALID):
+        break;
+    }
+    return 0;
+}
+
+/**
+ * Write a frequency as 3 bytes in units of 100 Hz, least significant first.
+ */
+static void
+WriteFrequency(uint8_t* data, uint32_t frequency)
+{
+    uint32_t encodedFrequency = frequency / 100;
+    data[0] = encodedFrequency & 0xff;
+    data[1] = (encodedFrequency & 0xff00) >> 8;
+    data[2] = (encodedFrequency & 0xff0000) >> 16;
+}
+
+/**
+ * Read a frequency written by WriteFrequency.
+ */
+static uint32_t
+ReadFrequency(const uint8_t* data)
+{
+    return (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16) * 100;
+}
+
+void
+MacCommandValue::Serialize(uint8_t* data) const
+{
+    NS_ASSERT_MSG(type != INVALID, "Serializing an invalid MAC command");
+
+    data[0] = MacCommand::GetCIDFromMacCommand(type);
+    switch (type)
+    {
+    case (LINK_CHECK_ANS): {
+        data[1] = linkCheckAns.margin;
+        data[2] = linkCheckAns.gwCnt;
+        break;
+    }
+    case (LINK_ADR_REQ): {
+        data[1] = linkAdrReq.dataRate << 4 | (linkAdrReq.txPower & 0b1111);
+        data[2] = linkAdrReq.channelMask & 0xff;
+        data[3] = linkAdrReq.channelMask >> 8;
+        data[4] = linkAdrReq.chMaskCntl << 4 | (linkAdrReq.nbRep & 0b1111);
+        break;
+    }
+    case (LINK_ADR_ANS): {
+        data[1] = uint8_t(linkAdrAns.powerAck) << 2 | uint8_t(linkAdrAns.dataRateAck) << 1 |
+                  uint8_t(linkAdrAns.channelMaskAck);
+        break;
+    }
+    case (DUTY_CYCLE_REQ): {
+        data[1] = dutyCycleReq.maxDCycle;
+        break;
+    }
+    case (RX_PARAM_SETUP_REQ): {
+        data[1] =
+            (rxParamSetupReq.rx1DrOffset & 0b111) << 4 | (rxParamSetupReq.rx2DataRate & 0b1111);
+        WriteFrequency(data + 2, rxParamSetupReq.frequency);
+        break;
+    }
+    case (RX_PARAM_SETUP_ANS): {
+        data[1] = uint8_t(rxParamSetupAns.rx1DrOffsetAck) << 2 |
+                  uint8_t(rxParamSetupAns.rx2DataRateAck) << 1 |
+                  uint8_t(rxParamSetupAns.channelAck);
+        break;
+    }
+    case (DEV_STATUS_ANS): {
+        data[1] = devStatusAns.battery;
+        data[2] = devStatusAns.margin;
+        break;
+    }
+    case (NEW_CHANNEL_REQ): {
+        data[1] = newChannelReq.chIndex;
+        WriteFrequency(data + 2, newChannelReq.frequency);
+        data[5] = (newChannelReq.maxDataRate << 4) | (newChannelReq.minDataRate & 0xf);
+        break;
+    }
+    case (NEW_CHANNEL_ANS): {
+        data[1] = uint8_t(newChannelAns.dataRateRangeOk) << 1 |
+                  uint8_t(newChannelAns.channelFrequencyOk);
+        break;
+    }
+    case (RX_TIMING_SETUP_REQ): {
+        data[1] = rxTimingSetupReq.delay & 0xf;
+        break;
+    }
+    case (TX_PARAM_SETUP_REQ): {
+        data[1] = 0; // EIRP and dwell time settings are not modeled
+        break;
+    }
+    case (DL_CHANNEL_REQ): {
+        data[1] = dlChannelReq.chIndex;
+        WriteFrequency(data + 2, dlChannelReq.frequency);
+        break;
+    }
+    case (DL_CHANNEL_ANS): {
+        data[1] = uint8_t(dlChannelAns.uplinkFrequencyExists) << 1 |
+                  uint8_t(dlChannelAns.channelFrequencyOk);
+        break;
+    }
+    default: {
+        break; // Only the CID
+    }
+    }
+}
+
+void
+MacCommandValue::Serialize(Buffer::Iterator& start) const
+{
+    uint8_t data[MAX_SERIALIZED_SIZE];
+    Serialize(data);
+    start.Write(data, GetSerializedSize());
+}
+
+uint8_t
+MacCommandValue::Deserialize(const uint8_t* data, uint32_t size, bool isUplink)
+{
+    // Requests travel in downlink and answers in uplink, with the same CID
+    static const enum MacCommandType uplinkCommands[] = {LINK_CHECK_REQ,
+                                                         LINK_ADR_ANS,
+                                                         DUTY_CYCLE_ANS,
+                                                         RX_PARAM_SETUP_ANS,
+                                                         DEV_STATUS_ANS,
+                                                         NEW_CHANNEL_ANS,
+                                                         RX_TIMING_SETUP_ANS,
+                                                         TX_PARAM_SETUP_ANS,
+                                                         DL_CHANNEL_ANS};
+    static const enum MacCommandType downlinkCommands[] = {LINK_CHECK_ANS,
+                                                           LINK_ADR_REQ,
+                                                           DUTY_CYCLE_REQ,
+                                                           RX_PARAM_SETUP_REQ,
+                                                           DEV_STATUS_REQ,
+                                                           NEW_CHANNEL_REQ,
+                                                           RX_TIMING_SETUP_REQ,
+                                                           TX_PARAM_SETUP_REQ,
+                                                           DL_CHANNEL_REQ};
+
+    if (size == 0 || data[0] < 0x02 || data[0] > 0x0A)
+    {
+        return 0;
+    }
+    uint8_t cid = data[0];
+    MacCommandValue command(isUplink ? uplinkCommands[cid - 0x02] : downlinkCommands[cid - 0x02]);
+    if (size < command.GetSerializedSize())
+    {
+        return 0; // Truncated
+    }
+
+    switch (command.type)
+    {
+    case (LINK_CHECK_ANS): {
+        command.linkCheckAns.margin = data[1];
+        command.linkCheckAns.gwCnt = data[2];
+        break;
+    }
+    case (LINK_ADR_REQ): {
+        command.linkAdrReq.dataRate = data[1] >> 4;
+        command.linkAdrReq.txPower = data[1] & 0b1111;
+        command.linkAdrReq.channelMask = data[2] | uint16_t(data[3]) << 8;
+        command.linkAdrReq.chMaskCntl = data[4] >> 4;
+        command.linkAdrReq.nbRep = data[4] & 0b1111;
+        break;
+    }
+    case (LINK_ADR_ANS): {
+        command.linkAdrAns.powerAck = data[1] & 0b100;
+        command.linkAdrAns.dataRateAck = data[1] & 0b10;
+        command.linkAdrAns.channelMaskAck = data[1] & 0b1;
+        break;
+    }
+    case (DUTY_CYCLE_REQ): {
+        command.dutyCycleReq.maxDCycle = data[1];
+        break;
+    }
+    case (RX_PARAM_SETUP_REQ): {
+        command.rxParamSetupReq.rx1DrOffset = (data[1] & 0b1110000) >> 4;
+        command.rxParamSetupReq.rx2DataRate = data[1] & 0b1111;
+        command.rxParamSetupReq.frequency = ReadFrequency(data + 2);
+        break;
+    }
+    case (RX_PARAM_SETUP_ANS): {
+        command.rxParamSetupAns.rx1DrOffsetAck = data[1] & 0b100;
+        command.rxParamSetupAns.rx2DataRateAck = data[1] & 0b10;
+        command.rxParamSetupAns.channelAck = data[1] & 0b1;
+        break;
+    }
+    case (DEV_STATUS_ANS): {
+        command.devStatusAns.battery = data[1];
+        command.devStatusAns.margin = data[2] & 0b111111;
+        break;
+    }
+    case (NEW_CHANNEL_REQ): {
+        command.newChannelReq.chIndex = data[1];
+        command.newChannelReq.frequency = ReadFrequency(data + 2);
+        command.newChannelReq.maxDataRate = data[5] >> 4;
+        command.newChannelReq.minDataRate = data[5] & 0xf;
+        break;
+    }
+    case (NEW_CHANNEL_ANS): {
+        command.newChannelAns.dataRateRangeOk = data[1] & 0b10;
+        command.newChannelAns.channelFrequencyOk = data[1] & 0b1;
+        break;
+    }
+    case (RX_TIMING_SETUP_REQ): {
+        command.rxTimingSetupReq.delay = data[1] & 0xf;
+        break;
+    }
+    case (DL_CHANNEL_REQ): {
+        command.dlChannelReq.chIndex = data[1];
+        command.dlChannelReq.frequency = ReadFrequency(data + 2);
+        break;
+    }
+    case (DL_CHANNEL_ANS): {
+        command.dlChannelAns.uplinkFrequencyExists = data[1] & 0b10;
+        command.dlChannelAns.channelFrequencyOk = data[1] & 0b1;
+        break;
+    }
+    default: {
+        break; // Only the CID, or a payload that is not modeled
+    }
+    }
+
+    *this = command;
+    return GetSerializedSize();
+}
+
+uint8_t
+MacCommandValue::Deserialize(Buffer::Iterator& start, bool isUplink)
+{
+    uint8_t data[MAX_SERIALIZED_SIZE];
+    uint32_t size = std::min<uint32_t>(MAX_SERIALIZED_SIZE, start.GetRemainingSize());
+    Buffer::Iterator peek = start;
+    peek.Read(data, size);
+    uint8_t consumed = Deserialize(data, size, isUplink);
+    start.Next(consumed);
+    return consumed;
+}
+
+void
+MacCommandValue::Print(std::ostream& os) const
+{
+    // Printing is not on a hot path: reuse the human-readable format of the objects
+    if (Ptr<MacCommand> command = ToMacCommand(); command)
+    {
+        command->Print(os);
+    }
+    else
+    {
+        os << "Invalid MAC command" << std::endl;
+    }
+}
+
+Ptr<MacCommand>
+MacCommandValue::ToMacCommand() const
+{
+    switch (type)
+    {
+    case (LINK_CHECK_REQ):
+        return Create<LinkCheckReq>();
+    case (LINK_CHECK_ANS):
+        return Create<LinkCheckAns>(linkCheckAns.margin, linkCheckAns.gwCnt);
+    case (LINK_ADR_REQ):
+        return Create<LinkAdrReq>(linkAdrReq.dataRate,
+                                  linkAdrReq.txPower,
+                                  linkAdrReq.channelMask,
+                                  linkAdrReq.chMaskCntl,
+                                  linkAdrReq.nbRep);
+    case (LINK_ADR_ANS):
+        return Create<LinkAdrAns>(linkAdrAns.powerAck,
+                                  linkAdrAns.dataRateAck,
+                                  linkAdrAns.channelMaskAck);
+    case (DUTY_CYCLE_REQ):
+        return Create<DutyCycleReq>(dutyCycleReq.maxDCycle);
+    case (DUTY_CYCLE_ANS):
+        return Create<DutyCycleAns>();
+    case (RX_PARAM_SETUP_REQ):
+        return Create<RxParamSetupReq>(rxParamSetupReq.rx1DrOffset,
+                                       rxParamSetupReq.rx2DataRate,
+                                       double(rxParamSetupReq.frequency));
+    case (RX_PARAM_SETUP_ANS):
+        return Create<RxParamSetupAns>(rxParamSetupAns.rx1DrOffsetAck,
+                                       rxParamSetupAns.rx2DataRateAck,
+                                       rxParamSetupAns.channelAck);
+    case (DEV_STATUS_REQ):
+        return Create<DevStatusReq>();
+    case (DEV_STATUS_ANS):
+        return Create<DevStatusAns>(devStatusAns.battery, devStatusAns.margin);
+    case (NEW_CHANNEL_REQ):
+        return Create<NewChannelReq>(newChannelReq.chIndex,
+                                     double(newChannelReq.frequency),
+                                     newChannelReq.minDataRate,
+                                     newChannelReq.maxDataRate);
+    case (NEW_CHANNEL_ANS):
+        return Create<NewChannelAns>(newChannelAns.dataRateRangeOk,
+                                     newChannelAns.channelFrequencyOk);
+    case (RX_TIMING_SETUP_REQ):
+        return Create<RxTimingSetupReq>(rxTimingSetupReq.delay);
+    case (RX_TIMING_SETUP_ANS):
+        return Create<RxTimingSetupAns>();
+    case (TX_PARAM_SETUP_REQ):
+        return Create<TxParamSetupReq>();
+    case (TX_PARAM_SETUP_ANS):
+        return Create<TxParamSetupAns>();
+    case (DL_CHANNEL_REQ):
+        return Create<DlChannelReq>(dlChannelReq.chIndex, double(dlChannelReq.frequency));
+    case (DL_CHANNEL_ANS):
+        return Create<DlChannelAns>(dlChannelAns.uplinkFrequencyExists,
+                                    dlChannelAns.channelFrequencyOk);
+    case (INVALID):
+        break;
+    }
+    return nullptr;
+}
+
+////////////////////
+// MacCommandList //
+////////////////////
+
+MacCommandList::MacCommandList()
+    : m_nInline(0)
+{
+}
+
+void
+MacCommandList::PushBack(const MacCommandValue& command)
+{
+    if (m_spilled.empty() && m_nInline < INLINE_CAPACITY)
+    {
+        m_inline[m_nInline++] = command;
+        return;
+    }
+    if (m_spilled.empty())
+    {
+        m_spilled.assign(m_inline.begin(), m_inline.begin() + m_nInline);
+    }
+    m_spilled.push_back(command);
+}
+
+void
+MacCommandList::Clear()
+{
+    m_nInline = 0;
+    m_spilled.clear();
+}
+
+uint32_t
+MacCommandList::GetN() const
+{
+    return end() - begin();
+}
+
+bool
+MacCommandList::IsEmpty() const
+{
+    return begin() == end();
+}
+
+const MacCommandValue*
+MacCommandList::Find(enum MacCommandType commandType) const
+{
+    for (const auto& command : *this)
+    {
+        if (command.type == commandType)
+        {
+            return &command;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t
+MacCommandList::GetSerializedSize() const
+{
+    uint32_t size = 0;
+    for (const auto& command : *this)
+    {
+        size += command.GetSerializedSize();
+    }
+    return size;
+}
+
+const MacCommandValue*
+MacCommandList::begin() const
+{
+    return m_spilled.empty() ? m_inline.data() : m_spilled.data();
+}
+
+const MacCommandValue*
+MacCommandList::end() const
+{
+    return m_spilled.empty() ? m_inline.data() + m_nInline : m_spilled.data() + m_spilled.size();
+}
+
 //////////////////
 // LinkCheckReq //
 //////////////////
@@ -152,6 +591,14 @@ LinkCheckReq::Print(std::ostream& os) const
     os << "LinkCheckReq" << std::endl;
 }
 
+MacCommandValue
+LinkCheckReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(LINK_CHECK_REQ);
+}
+
 //////////////////
 // LinkCheckAns //
 //////////////////
@@ -211,6 +658,16 @@ LinkCheckAns::Print(std::ostream& os) const
     os << "gwCnt: " << unsigned(m_gwCnt) << std::endl;
 }
 
+MacCommandValue
+LinkCheckAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(LINK_CHECK_ANS);
+    value.linkCheckAns = {m_margin, m_gwCnt};
+    return value;
+}
+
 void
 LinkCheckAns::SetMargin(uint8_t margin)
 {
@@ -323,6 +780,16 @@ LinkAdrReq::Print(std::ostream& os) const
     os << "nbRep: " << unsigned(m_nbRep) << std::endl;
 }
 
+MacCommandValue
+LinkAdrReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(LINK_ADR_REQ);
+    value.linkAdrReq = {m_dataRate, m_txPower, m_channelMask, m_chMaskCntl, m_nbRep};
+    return value;
+}
+
 uint8_t
 LinkAdrReq::GetDataRate()
 {
@@ -426,6 +893,16 @@ LinkAdrAns::Print(std::ostream& os) const
     os << "LinkAdrAns" << std::endl;
 }
 
+MacCommandValue
+LinkAdrAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(LINK_ADR_ANS);
+    value.linkAdrAns = {m_powerAck, m_dataRateAck, m_channelMaskAck};
+    return value;
+}
+
 //////////////////
 // DutyCycleReq //
 //////////////////
@@ -479,6 +956,16 @@ DutyCycleReq::Print(std::ostream& os) const
     os << "maxDCycle (fraction): " << GetMaximumAllowedDutyCycle() << std::endl;
 }
 
+MacCommandValue
+DutyCycleReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(DUTY_CYCLE_REQ);
+    value.dutyCycleReq = {m_maxDCycle};
+    return value;
+}
+
 double
 DutyCycleReq::GetMaximumAllowedDutyCycle() const
 {
@@ -537,6 +1024,14 @@ DutyCycleAns::Print(std::ostream& os) const
     os << "DutyCycleAns" << std::endl;
 }
 
+MacCommandValue
+DutyCycleAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(DUTY_CYCLE_ANS);
+}
+
 //////////////////
 // RxParamSetupReq //
 //////////////////
@@ -583,9 +1078,9 @@ RxParamSetupReq::Serialize(Buffer::Iterator& start) const
     uint32_t encodedFrequency = uint32_t(m_frequency / 100);
     NS_LOG_DEBUG(unsigned(encodedFrequency));
     NS_LOG_DEBUG(std::bitset<32>(encodedFrequency));
-    start.WriteU8((encodedFrequency & 0xff0000) >> 16); // Most significant byte
-    start.WriteU8((encodedFrequency & 0xff00) >> 8);    // Middle byte
     start.WriteU8(encodedFrequency & 0xff);             // Least significant byte
+    start.WriteU8((encodedFrequency & 0xff00) >> 8);    // Middle byte
+    start.WriteU8((encodedFrequency & 0xff0000) >> 16); // Most significant byte
 }
 
 uint8_t
@@ -620,6 +1115,19 @@ RxParamSetupReq::Print(std::ostream& os) const
     os << "frequency: " << m_frequency << std::endl;
 }
 
+MacCommandValue
+RxParamSetupReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(RX_PARAM_SETUP_REQ);
+    // Field by field, to keep the padding zeroed and values comparable byte by byte
+    value.rxParamSetupReq.frequency = uint32_t(m_frequency);
+    value.rxParamSetupReq.rx1DrOffset = m_rx1DrOffset;
+    value.rxParamSetupReq.rx2DataRate = m_rx2DataRate;
+    return value;
+}
+
 uint8_t
 RxParamSetupReq::GetRx1DrOffset()
 {
@@ -707,6 +1215,16 @@ RxParamSetupAns::Print(std::ostream& os) const
     os << "m_channelAck: " << m_channelAck << std::endl;
 }
 
+MacCommandValue
+RxParamSetupAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(RX_PARAM_SETUP_ANS);
+    value.rxParamSetupAns = {m_rx1DrOffsetAck, m_rx2DataRateAck, m_channelAck};
+    return value;
+}
+
 //////////////////
 // DevStatusReq //
 //////////////////
@@ -747,6 +1265,14 @@ DevStatusReq::Print(std::ostream& os) const
     os << "DevStatusReq" << std::endl;
 }
 
+MacCommandValue
+DevStatusReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(DEV_STATUS_REQ);
+}
+
 //////////////////
 // DevStatusAns //
 //////////////////
@@ -803,6 +1329,16 @@ DevStatusAns::Print(std::ostream& os) const
     os << "Margin: " << unsigned(m_margin) << std::endl;
 }
 
+MacCommandValue
+DevStatusAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(DEV_STATUS_ANS);
+    value.devStatusAns = {m_battery, m_margin};
+    return value;
+}
+
 uint8_t
 DevStatusAns::GetBattery() const
 {
@@ -856,9 +1392,10 @@ NewChannelReq::Serialize(Buffer::Iterator& start) const
 
     start.WriteU8(m_chIndex);
     uint32_t encodedFrequency = uint32_t(m_frequency / 100);
-    start.WriteU8((encodedFrequency & 0xff0000) >> 16);
-    start.WriteU8((encodedFrequency & 0xff00) >> 8);
+    // Frequency is in little endian
     start.WriteU8(encodedFrequency & 0xff);
+    start.WriteU8((encodedFrequency & 0xff00) >> 8);
+    start.WriteU8((encodedFrequency & 0xff0000) >> 16);
     start.WriteU8((m_maxDataRate << 4) | (m_minDataRate & 0xf));
 }
 
@@ -872,7 +1409,7 @@ NewChannelReq::Deserialize(Buffer::Iterator& start)
     // Read the data
     m_chIndex = start.ReadU8();
     uint32_t encodedFrequency = 0;
-    // Frequency is in big endian
+    // Frequency is in little endian
     encodedFrequency |= uint32_t(start.ReadU8());
     encodedFrequency |= uint32_t(start.ReadU8()) << 8;
     encodedFrequency |= uint32_t(start.ReadU8()) << 16;
@@ -896,6 +1433,20 @@ NewChannelReq::Print(std::ostream& os) const
     os << "MinDR: " << (unsigned)m_minDataRate << std::endl;
 }
 
+MacCommandValue
+NewChannelReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(NEW_CHANNEL_REQ);
+    // Field by field, to keep the padding zeroed
+    value.newChannelReq.frequency = uint32_t(m_frequency);
+    value.newChannelReq.chIndex = m_chIndex;
+    value.newChannelReq.minDataRate = m_minDataRate;
+    value.newChannelReq.maxDataRate = m_maxDataRate;
+    return value;
+}
+
 uint8_t
 NewChannelReq::GetChannelIndex() const
 {
@@ -986,6 +1537,16 @@ NewChannelAns::Print(std::ostream& os) const
     os << "ChannelFrequencyOk: " << m_channelFrequencyOk << std::endl;
 }
 
+MacCommandValue
+NewChannelAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(NEW_CHANNEL_ANS);
+    value.newChannelAns = {m_dataRateRangeOk, m_channelFrequencyOk};
+    return value;
+}
+
 //////////////////////
 // RxTimingSetupReq //
 //////////////////////
@@ -1040,6 +1601,16 @@ RxTimingSetupReq::Print(std::ostream& os) const
     os << "Delay: " << unsigned((m_delay) ? m_delay : 1) << "s" << std::endl;
 }
 
+MacCommandValue
+RxTimingSetupReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(RX_TIMING_SETUP_REQ);
+    value.rxTimingSetupReq = {m_delay};
+    return value;
+}
+
 Time
 RxTimingSetupReq::GetDelay()
 {
@@ -1056,7 +1627,7 @@ RxTimingSetupAns::RxTimingSetupAns()
 {
     NS_LOG_FUNCTION(this);
 
-    m_commandType = DEV_STATUS_REQ;
+    m_commandType = RX_TIMING_SETUP_ANS;
     m_serializedSize = 1;
 }
 
@@ -1088,6 +1659,14 @@ RxTimingSetupAns::Print(std::ostream& os) const
     os << "RxTimingSetupAns" << std::endl;
 }
 
+MacCommandValue
+RxTimingSetupAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(RX_TIMING_SETUP_ANS);
+}
+
 //////////////////
 // TxParamSetupReq //
 //////////////////
@@ -1096,7 +1675,7 @@ TxParamSetupReq::TxParamSetupReq()
 {
     NS_LOG_FUNCTION(this);
 
-    m_commandType = DEV_STATUS_REQ;
+    m_commandType = TX_PARAM_SETUP_REQ;
     m_serializedSize = 2;
 }
 
@@ -1107,6 +1686,8 @@ TxParamSetupReq::Serialize(Buffer::Iterator& start) const
 
     // Write the CID
     start.WriteU8(GetCIDFromMacCommand(m_commandType));
+    // EIRP and dwell time settings are not modeled
+    start.WriteU8(0);
 }
 
 uint8_t
@@ -1116,6 +1697,8 @@ TxParamSetupReq::Deserialize(Buffer::Iterator& start)
 
     // Consume the CID
     start.ReadU8();
+    // EIRP and dwell time settings are not modeled
+    start.ReadU8();
 
     return m_serializedSize;
 }
@@ -1128,6 +1711,14 @@ TxParamSetupReq::Print(std::ostream& os) const
     os << "TxParamSetupReq" << std::endl;
 }
 
+MacCommandValue
+TxParamSetupReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(TX_PARAM_SETUP_REQ);
+}
+
 //////////////////
 // TxParamSetupAns //
 //////////////////
@@ -1136,7 +1727,7 @@ TxParamSetupAns::TxParamSetupAns()
 {
     NS_LOG_FUNCTION(this);
 
-    m_commandType = DEV_STATUS_REQ;
+    m_commandType = TX_PARAM_SETUP_ANS;
     m_serializedSize = 1;
 }
 
@@ -1168,6 +1759,14 @@ TxParamSetupAns::Print(std::ostream& os) const
     os << "TxParamSetupAns" << std::endl;
 }
 
+MacCommandValue
+TxParamSetupAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    return MacCommandValue(TX_PARAM_SETUP_ANS);
+}
+
 //////////////////
 // DlChannelReq //
 //////////////////
@@ -1200,9 +1799,10 @@ DlChannelReq::Serialize(Buffer::Iterator& start) const
 
     start.WriteU8(m_chIndex);
     uint32_t encodedFrequency = uint32_t(m_frequency / 100);
-    start.WriteU8((encodedFrequency & 0xff0000) >> 16);
-    start.WriteU8((encodedFrequency & 0xff00) >> 8);
+    // Frequency is in little endian
     start.WriteU8(encodedFrequency & 0xff);
+    start.WriteU8((encodedFrequency & 0xff00) >> 8);
+    start.WriteU8((encodedFrequency & 0xff0000) >> 16);
 }
 
 uint8_t
@@ -1215,7 +1815,7 @@ DlChannelReq::Deserialize(Buffer::Iterator& start)
     // Read the data
     m_chIndex = start.ReadU8();
     uint32_t encodedFrequency = 0;
-    // Frequency is in big endian
+    // Frequency is in little endian
     encodedFrequency |= uint32_t(start.ReadU8());
     encodedFrequency |= uint32_t(start.ReadU8()) << 8;
     encodedFrequency |= uint32_t(start.ReadU8()) << 16;
@@ -1234,6 +1834,18 @@ DlChannelReq::Print(std::ostream& os) const
     os << "Frequency: " << m_frequency << std::endl;
 }
 
+MacCommandValue
+DlChannelReq::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(DL_CHANNEL_REQ);
+    // Field by field, to keep the padding zeroed
+    value.dlChannelReq.frequency = uint32_t(m_frequency);
+    value.dlChannelReq.chIndex = m_chIndex;
+    return value;
+}
+
 uint8_t
 DlChannelReq::GetChannelIndex() const
 {
@@ -1308,5 +1920,15 @@ DlChannelAns::Print(std::ostream& os) const
     os << "ChannelFrequencyOk: " << m_channelFrequencyOk << std::endl;
 }
 
+MacCommandValue
+DlChannelAns::GetValue() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    MacCommandValue value(DL_CHANNEL_ANS);
+    value.dlChannelAns = {m_uplinkFrequencyExists, m_channelFrequencyOk};
+    return value;
+}
+
 } // namespace lorawan
 } // namespace ns3
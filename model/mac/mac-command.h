@@ -28,6 +28,9 @@
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 
+#include <array>
+#include <vector>
+
 namespace ns3
 {
 namespace lorawan
@@ -59,6 +62,229 @@ enum MacCommandType
     DL_CHANNEL_ANS
 };
 
+class MacCommand;
+
+/**
+ * Compact value-type representation of a MAC command.
+ *
+ * The command type tags which member of the union holds the fields. Values
+ * are trivially copyable and can be stored inline (see MacCommandList), so
+ * that commands are built, serialized and parsed without heap allocations.
+ * Commands without payload have no fields, and unused bytes are zero.
+ */
+struct MacCommandValue
+{
+    static constexpr uint8_t MAX_SERIALIZED_SIZE = 6; //!< Size of the longest command
+
+    MacCommandValue();
+
+    /**
+     * Create a command of the given type, with all fields set to zero.
+     *
+     * \param commandType The type of the command.
+     */
+    explicit MacCommandValue(enum MacCommandType commandType);
+
+    /**
+     * Get serialized length of this MAC command, CID included.
+     *
+     * \return The number of bytes the MAC command takes up.
+     */
+    uint8_t GetSerializedSize() const;
+
+    /**
+     * Serialize this MAC command into contiguous bytes, according to the LoRaWAN standard.
+     *
+     * \param data The destination, with room for GetSerializedSize() bytes.
+     */
+    void Serialize(uint8_t* data) const;
+
+    /**
+     * Serialize this MAC command into a buffer.
+     *
+     * \param start The iterator to write the command with.
+     */
+    void Serialize(Buffer::Iterator& start) const;
+
+    /**
+     * Deserialize a MAC command from contiguous bytes.
+     *
+     * Requests and answers share their CID, so the direction selects which one
+     * is parsed. This value is left unchanged if the command is not valid.
+     *
+     * \param data The bytes, starting with the CID.
+     * \param size The number of bytes available.
+     * \param isUplink Whether the command was sent by an end device.
+     * \return The number of bytes consumed, or 0 for an unknown CID or a truncated command.
+     */
+    uint8_t Deserialize(const uint8_t* data, uint32_t size, bool isUplink);
+
+    /**
+     * Deserialize a MAC command from a buffer.
+     *
+     * \param start The iterator to read the command with.
+     * \param isUplink Whether the command was sent by an end device.
+     * \return The number of bytes consumed, or 0 for an unknown CID or a truncated command.
+     */
+    uint8_t Deserialize(Buffer::Iterator& start, bool isUplink);
+
+    /**
+     * Print the contents of this MAC command in human-readable format.
+     *
+     * \param os The std::ostream instance on which to print the MAC command.
+     */
+    void Print(std::ostream& os) const;
+
+    /**
+     * Create the MacCommand object that corresponds to this value.
+     *
+     * \return The command, or 0 for an INVALID value.
+     */
+    Ptr<MacCommand> ToMacCommand() const;
+
+    enum MacCommandType type; //!< The type of the command, tags the union
+
+    union {
+        uint8_t bytes[8]; //!< Raw storage, used to zero all fields
+
+        struct
+        {
+            uint8_t margin; //!< Demodulation margin
+            uint8_t gwCnt;  //!< Number of receiving gateways
+        } linkCheckAns;
+
+        struct
+        {
+            uint8_t dataRate;     //!< Uplink data rate
+            uint8_t txPower;      //!< Encoded transmission power
+            uint16_t channelMask; //!< Enabled channels, one bit per channel
+            uint8_t chMaskCntl;   //!< Channel mask control
+            uint8_t nbRep;        //!< Number of transmissions, 0 meaning 1
+        } linkAdrReq;
+
+        struct
+        {
+            bool powerAck;       //!< Whether the power was set
+            bool dataRateAck;    //!< Whether the data rate was set
+            bool channelMaskAck; //!< Whether the channel mask was set
+        } linkAdrAns;
+
+        struct
+        {
+            uint8_t maxDCycle; //!< Duty cycle limit, as 1/2^maxDCycle
+        } dutyCycleReq;
+
+        struct
+        {
+            uint32_t frequency;  //!< Second receive window frequency, in Hz
+            uint8_t rx1DrOffset; //!< First receive window data rate offset
+            uint8_t rx2DataRate; //!< Second receive window data rate
+        } rxParamSetupReq;
+
+        struct
+        {
+            bool rx1DrOffsetAck; //!< Whether the offset was set
+            bool rx2DataRateAck; //!< Whether the data rate was set
+            bool channelAck;     //!< Whether the frequency was set
+        } rxParamSetupAns;
+
+        struct
+        {
+            uint8_t battery; //!< Battery level
+            uint8_t margin;  //!< Demodulation margin
+        } devStatusAns;
+
+        struct
+        {
+            uint32_t frequency;  //!< Channel frequency, in Hz
+            uint8_t chIndex;     //!< Channel index
+            uint8_t minDataRate; //!< Minimum data rate of the channel
+            uint8_t maxDataRate; //!< Maximum data rate of the channel
+        } newChannelReq;
+
+        struct
+        {
+            bool dataRateRangeOk;    //!< Whether the data rate range was set
+            bool channelFrequencyOk; //!< Whether the frequency was set
+        } newChannelAns;
+
+        struct
+        {
+            uint8_t delay; //!< First receive window delay in seconds, 0 meaning 1
+        } rxTimingSetupReq;
+
+        struct
+        {
+            uint32_t frequency; //!< Downlink frequency, in Hz
+            uint8_t chIndex;    //!< Channel index
+        } dlChannelReq;
+
+        struct
+        {
+            bool uplinkFrequencyExists; //!< Whether the channel exists
+            bool channelFrequencyOk;    //!< Whether the frequency was set
+        } dlChannelAns;
+    };
+};
+
+/**
+ * Sequence of MAC command values.
+ *
+ * Values are stored inline up to the number of commands that fit in the 15
+ * bytes of FOpts. Longer sequences, i.e., commands carried in the FRMPayload,
+ * are moved to the heap.
+ */
+class MacCommandList
+{
+  public:
+    static constexpr uint8_t INLINE_CAPACITY = 15; //!< One-byte commands that fit in FOpts
+
+    MacCommandList();
+
+    /**
+     * Append a command.
+     *
+     * \param command The command.
+     */
+    void PushBack(const MacCommandValue& command);
+
+    /**
+     * Remove all commands.
+     */
+    void Clear();
+
+    /**
+     * Get the number of commands.
+     */
+    uint32_t GetN() const;
+
+    /**
+     * Whether there are no commands.
+     */
+    bool IsEmpty() const;
+
+    /**
+     * Get the first command of a type.
+     *
+     * \param commandType The type.
+     * \return The command, or nullptr if there is none of this type.
+     */
+    const MacCommandValue* Find(enum MacCommandType commandType) const;
+
+    /**
+     * Get the total serialized size of the commands.
+     */
+    uint32_t GetSerializedSize() const;
+
+    const MacCommandValue* begin() const; //!< First command, for range-based loops
+    const MacCommandValue* end() const;   //!< Past the last command, for range-based loops
+
+  private:
+    std::array<MacCommandValue, INLINE_CAPACITY> m_inline; //!< Inline storage
+    uint8_t m_nInline;                                     //!< Commands in inline storage
+    std::vector<MacCommandValue> m_spilled;                //!< All commands, past inline capacity
+};
+
 /**
  * This base class is used to represent a general MAC command.
  *
@@ -95,6 +321,13 @@ class MacCommand : public SimpleRefCount<MacCommand>
      */
     virtual void Print(std::ostream& os) const = 0;
 
+    /**
+     * Get the value-type representation of this MAC command.
+     *
+     * \return The value, with the same type and fields.
+     */
+    virtual MacCommandValue GetValue() const = 0;
+
     /**
      * Get serialized length of this MAC command.
      *
@@ -140,6 +373,7 @@ class LinkCheckReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 };
 
 /**
@@ -157,6 +391,7 @@ class LinkCheckAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Set the demodulation margin value.
@@ -224,6 +459,7 @@ class LinkAdrReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Return the data rate prescribed by this MAC command.
@@ -281,6 +517,7 @@ class LinkAdrAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
     bool m_powerAck;
@@ -309,6 +546,7 @@ class DutyCycleReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Get the maximum duty cycle prescribed by this Mac command, in fraction form.
@@ -334,6 +572,7 @@ class DutyCycleAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 };
 
 /**
@@ -356,6 +595,7 @@ class RxParamSetupReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Get this command's Rx1DrOffset parameter.
@@ -403,6 +643,7 @@ class RxParamSetupAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
     bool m_rx1DrOffsetAck;
@@ -421,6 +662,7 @@ class DevStatusReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 };
 
 /**
@@ -441,6 +683,7 @@ class DevStatusAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Get the battery information contained in this MAC command.
@@ -482,6 +725,7 @@ class NewChannelReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     uint8_t GetChannelIndex() const;
     double GetFrequency() const;
@@ -516,6 +760,7 @@ class NewChannelAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
     bool m_dataRateRangeOk;
@@ -540,6 +785,7 @@ class RxTimingSetupReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     /**
      * Get the first window delay as a Time instance.
@@ -565,6 +811,7 @@ class RxTimingSetupAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
 };
@@ -580,6 +827,7 @@ class TxParamSetupReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
 };
@@ -595,6 +843,7 @@ class TxParamSetupAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
 };
@@ -618,6 +867,7 @@ class DlChannelReq : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
     uint8_t GetChannelIndex() const;
     double GetFrequency() const;
@@ -646,6 +896,7 @@ class DlChannelAns : public MacCommand
     void Serialize(Buffer::Iterator& start) const override;
     uint8_t Deserialize(Buffer::Iterator& start) override;
     void Print(std::ostream& os) const override;
+    MacCommandValue GetValue() const override;
 
   private:
     bool m_uplinkFrequencyExists;
@@ -119,6 +119,18 @@ RecvWindowManager::SetFrequency(WinId id, double f)
     m_win[id].frequency = f;
 }
 
+Time
+RecvWindowManager::GetRx1Delay() const
+{
+    return m_win[FIRST].delay;
+}
+
+double
+RecvWindowManager::GetFrequency(WinId id) const
+{
+    return m_win[id].frequency;
+}
+
 void
 RecvWindowManager::SetPhy(Ptr<EndDeviceLoraPhy> phy)
 {
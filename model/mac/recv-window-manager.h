@@ -78,6 +78,11 @@ class RecvWindowManager : public Object
     /* Set frequency of window based on id */
     void SetFrequency(WinId id, double f);
 
+    /* Get RX1 delay */
+    Time GetRx1Delay() const;
+    /* Get frequency of window based on id */
+    double GetFrequency(WinId id) const;
+
     /* Set device physiscal layer */
     void SetPhy(Ptr<EndDeviceLoraPhy> phy);
     /* Set callback function to be called on expiration of second reception window */
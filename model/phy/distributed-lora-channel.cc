@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "distributed-lora-channel.h"
+
+#include "ns3/distributed-simulator-impl.h"
+#include "ns3/double.h"
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/header.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+#include <cstring>
+#include <limits>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("DistributedLoraChannel");
+
+NS_OBJECT_ENSURE_REGISTERED(DistributedLoraChannel);
+
+/**
+ * Header of a transmission forwarded to another rank, in front of the PHY
+ * layer packet. Delays are relative to the arrival of the message.
+ */
+class RemoteTransmissionHeader : public Header
+{
+  public:
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    bool down = false;                                               //!< Whether it is a downlink
+    uint8_t sf = 0;                                                  //!< SF of the transmission
+    Time duration;                                                   //!< On-air duration
+    double frequency = 0;                                            //!< Frequency [Hz]
+    std::vector<DistributedLoraChannel::RemoteReception> receptions; //!< Receptions on the rank
+};
+
+NS_OBJECT_ENSURE_REGISTERED(RemoteTransmissionHeader);
+
+namespace
+{
+void
+WriteDouble(Buffer::Iterator& i, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    i.WriteHtonU64(bits);
+}
+
+double
+ReadDouble(Buffer::Iterator& i)
+{
+    uint64_t bits = i.ReadNtohU64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+} // namespace
+
+TypeId
+RemoteTransmissionHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::RemoteTransmissionHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<RemoteTransmissionHeader>();
+    return tid;
+}
+
+TypeId
+RemoteTransmissionHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+RemoteTransmissionHeader::GetSerializedSize() const
+{
+    return 1 + 1 + 8 + 8 + 4 + receptions.size() * (4 + 8 + 8);
+}
+
+void
+RemoteTransmissionHeader::Serialize(Buffer::Iterator start) const
+{
+    start.WriteU8(down);
+    start.WriteU8(sf);
+    start.WriteHtonU64(duration.GetTimeStep());
+    WriteDouble(start, frequency);
+    start.WriteHtonU32(receptions.size());
+    for (const auto& reception : receptions)
+    {
+        start.WriteHtonU32(reception.index);
+        WriteDouble(start, reception.rxPowerDbm);
+        start.WriteHtonU64(reception.delay.GetTimeStep());
+    }
+}
+
+uint32_t
+RemoteTransmissionHeader::Deserialize(Buffer::Iterator start)
+{
+    down = start.ReadU8();
+    sf = start.ReadU8();
+    duration = TimeStep(start.ReadNtohU64());
+    frequency = ReadDouble(start);
+    receptions.resize(start.ReadNtohU32());
+    for (auto& reception : receptions)
+    {
+        reception.index = start.ReadNtohU32();
+        reception.rxPowerDbm = ReadDouble(start);
+        reception.delay = TimeStep(start.ReadNtohU64());
+    }
+    return GetSerializedSize();
+}
+
+void
+RemoteTransmissionHeader::Print(std::ostream& os) const
+{
+    os << (down ? "down" : "up") << " SF" << unsigned(sf) << " " << duration << " " << frequency
+       << "Hz " << receptions.size() << " receptions";
+}
+
+TypeId
+DistributedLoraChannel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::DistributedLoraChannel")
+            .SetParent<LoraChannel>()
+            .SetGroupName("lorawan")
+            .AddConstructor<DistributedLoraChannel>()
+            .AddAttribute("RxPowerCutoff",
+                          "Receptions weaker than this power are skipped, on every rank [dBm]",
+                          DoubleValue(-std::numeric_limits<double>::infinity()),
+                          MakeDoubleAccessor(&DistributedLoraChannel::m_rxPowerCutoff),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("MaxTxPower",
+                          "Highest transmission power of the PHYs, to find the nodes of "
+                          "different ranks within range of each other [dBm]",
+                          DoubleValue(27),
+                          MakeDoubleAccessor(&DistributedLoraChannel::m_maxTxPower),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("MinLookAhead",
+                          "Shortest lookahead that Setup accepts, below which ranks would "
+                          "synchronize too often",
+                          TimeValue(MicroSeconds(100)),
+                          MakeTimeAccessor(&DistributedLoraChannel::m_minLookAhead),
+                          MakeTimeChecker(TimeStep(1)));
+    return tid;
+}
+
+DistributedLoraChannel::DistributedLoraChannel()
+    : m_rxPowerCutoff(-std::numeric_limits<double>::infinity()),
+      m_maxTxPower(27),
+      m_minLookAhead(MicroSeconds(100)),
+      m_lookAhead(Time::Max()),
+      m_rank(0),
+      m_nRanks(0),
+      m_nMessages(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+DistributedLoraChannel::DistributedLoraChannel(Ptr<PropagationLossModel> loss,
+                                               Ptr<PropagationDelayModel> delay)
+    : LoraChannel(loss, delay),
+      m_rxPowerCutoff(-std::numeric_limits<double>::infinity()),
+      m_maxTxPower(27),
+      m_minLookAhead(MicroSeconds(100)),
+      m_lookAhead(Time::Max()),
+      m_rank(0),
+      m_nRanks(0),
+      m_nMessages(0)
+{
+    NS_LOG_FUNCTION(this << loss << delay);
+}
+
+DistributedLoraChannel::~DistributedLoraChannel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+DistributedLoraChannel::Setup()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(MpiInterface::IsEnabled(), "MPI must be enabled before the setup");
+    auto simulator = DynamicCast<DistributedSimulatorImpl>(Simulator::GetImplementation());
+    NS_ABORT_MSG_UNLESS(simulator, "The channel requires the ns3::DistributedSimulatorImpl");
+    m_rank = MpiInterface::GetSystemId();
+    m_nRanks = MpiInterface::GetSize();
+    m_batches.assign(m_nRanks, {});
+
+    // Remote transmissions reach the channel through any local PHY
+    for (const auto* receivers : {&m_phyListUp, &m_phyListDown})
+    {
+        for (const auto& phy : *receivers)
+        {
+            Ptr<NetDevice> device = phy->GetDevice();
+            if (device->GetNode()->GetSystemId() != m_rank || device->GetObject<MpiReceiver>())
+            {
+                continue;
+            }
+            auto receiver = CreateObject<MpiReceiver>();
+            receiver->SetReceiveCallback(
+                MakeCallback(&DistributedLoraChannel::ReceiveRemote, this));
+            device->AggregateObject(receiver);
+        }
+    }
+
+    // Transmissions only go from end devices to gateways and back. Without
+    // cutoff, the loss model is not evaluated, not to draw random variables.
+    bool cutoff = m_rxPowerCutoff > -std::numeric_limits<double>::infinity();
+    m_lookAhead = Time::Max();
+    for (const auto& gateway : m_phyListUp)
+    {
+        uint32_t owner = gateway->GetDevice()->GetNode()->GetSystemId();
+        auto gwMobility = gateway->GetMobility();
+        for (const auto& device : m_phyListDown)
+        {
+            if (device->GetDevice()->GetNode()->GetSystemId() == owner)
+            {
+                continue;
+            }
+            auto edMobility = device->GetMobility();
+            if (cutoff && GetRxPower(m_maxTxPower, edMobility, gwMobility) < m_rxPowerCutoff &&
+                GetRxPower(m_maxTxPower, gwMobility, edMobility) < m_rxPowerCutoff)
+            {
+                continue;
+            }
+            m_lookAhead = Min(m_lookAhead,
+                              Min(m_delay->GetDelay(edMobility, gwMobility),
+                                  m_delay->GetDelay(gwMobility, edMobility)));
+        }
+    }
+    if (m_lookAhead != Time::Max())
+    {
+        // Receptions are delivered at preamble lock
+        m_lookAhead += m_preambleLockTime;
+        NS_ABORT_MSG_IF(m_lookAhead < m_minLookAhead,
+                        "Lookahead " << m_lookAhead << " shorter than " << m_minLookAhead
+                                     << ", set a PreambleLockTime or an RxPowerCutoff");
+        simulator->BoundLookAhead(m_lookAhead);
+    }
+    NS_LOG_INFO("Rank " << m_rank << "/" << m_nRanks << ", lookahead " << m_lookAhead);
+}
+
+void
+DistributedLoraChannel::Send(Ptr<LoraPhy> sender,
+                             Ptr<Packet> packet,
+                             double txPowerDbm,
+                             uint8_t sf,
+                             Time duration,
+                             double frequency) const
+{
+    NS_LOG_FUNCTION(this << sender << packet << txPowerDbm << (unsigned)sf << duration
+                         << frequency);
+    NS_ABORT_MSG_IF(m_batches.empty(), "DistributedLoraChannel::Setup was not called");
+    NS_ASSERT_MSG(sender->GetDevice()->GetNode()->GetSystemId() == m_rank,
+                  "Only the rank owning a node can make it transmit");
+    auto senderMobility = sender->GetMobility();
+    NS_ASSERT(bool(senderMobility) != 0);
+    bool down = !DynamicCast<EndDeviceLoraPhy>(sender);
+    auto& receivers = (down) ? m_phyListDown : m_phyListUp;
+    LoraDeviceAddress destination;
+    if (down && !receivers.empty())
+    {
+        destination = EndDeviceLoraPhy::GetDestination(packet);
+    }
+
+    // Same order of evaluation of the loss model as the single-process channel
+    for (uint32_t i = 0; i < receivers.size(); ++i)
+    {
+        const auto& phy = receivers[i];
+        auto receiverMobility = phy->GetMobility();
+        Time delay = m_delay->GetDelay(senderMobility, receiverMobility) + m_preambleLockTime;
+        double rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+        if (rxPowerDbm < m_rxPowerCutoff)
+        {
+            continue;
+        }
+        uint32_t owner = phy->GetDevice()->GetNode()->GetSystemId();
+        if (owner == m_rank)
+        {
+            ScheduleReception(phy,
+                              delay,
+                              packet,
+                              rxPowerDbm,
+                              sf,
+                              duration,
+                              frequency,
+                              down,
+                              destination);
+        }
+        else
+        {
+            m_batches[owner].push_back({i, rxPowerDbm, delay});
+        }
+        m_packetSent(packet);
+    }
+
+    // One message per rank, arriving with the earliest delivery of the batch
+    for (uint32_t rank = 0; rank < m_nRanks; ++rank)
+    {
+        auto& batch = m_batches[rank];
+        if (batch.empty())
+        {
+            continue;
+        }
+        Time first = Time::Max();
+        for (const auto& reception : batch)
+        {
+            first = Min(first, reception.delay);
+        }
+        NS_ABORT_MSG_IF(first < m_lookAhead,
+                        "Delivery delay " << first << " shorter than the lookahead "
+                                             << m_lookAhead << ", did nodes move?");
+        RemoteTransmissionHeader header;
+        header.down = down;
+        header.sf = sf;
+        header.duration = duration;
+        header.frequency = frequency;
+        header.receptions.swap(batch);
+        for (auto& reception : header.receptions)
+        {
+            reception.delay -= first;
+        }
+        Ptr<Packet> message = packet->Copy();
+        message->AddHeader(header);
+
+        Ptr<NetDevice> device = receivers[header.receptions.front().index]->GetDevice();
+        MpiInterface::SendPacket(message,
+                                 Simulator::Now() + first,
+                                 device->GetNode()->GetId(),
+                                 device->GetIfIndex());
+        m_nMessages++;
+        // Give the storage back to the batch
+        header.receptions.clear();
+        batch.swap(header.receptions);
+    }
+}
+
+void
+DistributedLoraChannel::ReceiveRemote(Ptr<Packet> message)
+{
+    NS_LOG_FUNCTION(this << message);
+    RemoteTransmissionHeader header;
+    message->RemoveHeader(header);
+    NS_LOG_DEBUG("Remote transmission: " << header);
+    auto& receivers = (header.down) ? m_phyListDown : m_phyListUp;
+    LoraDeviceAddress destination;
+    if (header.down)
+    {
+        destination = EndDeviceLoraPhy::GetDestination(message);
+    }
+    for (const auto& reception : header.receptions)
+    {
+        NS_ASSERT_MSG(reception.index < receivers.size(), "Unknown receiver, are PHYs different?");
+        ScheduleReception(receivers[reception.index],
+                          reception.delay,
+                          message,
+                          reception.rxPowerDbm,
+                          header.sf,
+                          header.duration,
+                          header.frequency,
+                          header.down,
+                          destination);
+    }
+}
+
+Time
+DistributedLoraChannel::GetLookAhead() const
+{
+    return m_lookAhead;
+}
+
+uint64_t
+DistributedLoraChannel::GetNMessages() const
+{
+    return m_nMessages;
+}
+
+} // namespace lorawan
+} // namespace ns3
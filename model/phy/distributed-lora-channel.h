@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef DISTRIBUTED_LORA_CHANNEL_H
+#define DISTRIBUTED_LORA_CHANNEL_H
+
+#include "ns3/lora-channel.h"
+
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * A LoraChannel for distributed simulations with ns-3's MPI simulator.
+ *
+ * Every rank builds the same network, and each node is owned by one rank
+ * (its system id), typically the rank of the region of the space where it
+ * lies. Only the owner of a node runs its applications. When a PHY sends a
+ * packet, receptions at PHYs of local nodes are scheduled as in LoraChannel,
+ * while receptions at PHYs of remote nodes are batched in one message per
+ * destination rank. A message holds the received power of each PHY, computed
+ * by the sender with the loss model, and reaches its rank at the earliest
+ * propagation delay of the batch. The receiving rank then schedules each
+ * reception at the time the single-process channel would have.
+ *
+ * Receptions weaker than the RxPowerCutoff attribute, local or remote, are
+ * skipped. Since gateways account for every signal in their interference,
+ * even under the sensitivity, the default cutoff skips none, so results
+ * match a single-process LoraChannel with the same deterministic loss
+ * model. A higher cutoff (e.g., well below the noise floor) lets ranks
+ * whose nodes never hear each other skip all messages, and lengthens the
+ * lookahead.
+ *
+ * Every rank delivers receptions at preamble lock, the PreambleLockTime
+ * attribute after the arrival of the signal, as LoraChannel does. The
+ * lookahead is the lock time plus the shortest propagation delay between an
+ * end device and a gateway owned by different ranks, among those receiving
+ * each other above the cutoff at MaxTxPower. Propagation delays alone are
+ * tens of nanoseconds between nearby nodes, so without a lock time the ranks
+ * would synchronize too often to be of use: Setup aborts when the lookahead
+ * is shorter than the MinLookAhead attribute.
+ *
+ * Setup must be called after all PHYs are connected, and before the
+ * simulation runs. Nodes must not move, nor PHYs be removed, after Setup.
+ * The synchronization relies on the granted time window
+ * DistributedSimulatorImpl.
+ */
+class DistributedLoraChannel : public LoraChannel
+{
+  public:
+    /**
+     * A reception at a PHY of another rank.
+     */
+    struct RemoteReception
+    {
+        uint32_t index;    //!< Index of the PHY in the list of receivers
+        double rxPowerDbm; //!< Received power
+        Time delay;        //!< Propagation delay
+    };
+
+    static TypeId GetTypeId();
+
+    DistributedLoraChannel();
+    ~DistributedLoraChannel() override;
+
+    /**
+     * Construct a DistributedLoraChannel with a loss and delay model.
+     *
+     * \param loss The loss model to associate to this channel.
+     * \param delay The delay model to associate to this channel.
+     */
+    DistributedLoraChannel(Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay);
+
+    void Send(Ptr<LoraPhy> sender,
+              Ptr<Packet> packet,
+              double txPowerDbm,
+              uint8_t sf,
+              Time duration,
+              double frequency) const override;
+
+    /**
+     * Prepare local PHYs to receive remote transmissions, and bound the
+     * lookahead of the distributed simulator.
+     */
+    void Setup();
+
+    /**
+     * Get the lookahead computed by Setup.
+     *
+     * \return The lookahead, or Time::Max if no pair of nodes owned by
+     * different ranks can hear each other.
+     */
+    Time GetLookAhead() const;
+
+    /**
+     * Get the number of messages sent to other ranks so far.
+     */
+    uint64_t GetNMessages() const;
+
+  private:
+    /**
+     * Schedule the receptions of a message from another rank.
+     *
+     * \param message The PHY layer packet, with the receptions in a header.
+     */
+    void ReceiveRemote(Ptr<Packet> message);
+
+    double m_rxPowerCutoff; //!< Receptions weaker than this are skipped [dBm]
+    double m_maxTxPower;    //!< Highest transmission power, to bound the range [dBm]
+    Time m_minLookAhead;    //!< Shortest lookahead accepted by Setup
+    Time m_lookAhead;       //!< Lookahead computed by Setup
+    uint32_t m_rank;        //!< Rank of this process
+    uint32_t m_nRanks;      //!< Number of ranks
+
+    mutable std::vector<std::vector<RemoteReception>> m_batches; //!< Receptions, by rank
+    mutable uint64_t m_nMessages;                                //!< Messages sent
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* DISTRIBUTED_LORA_CHANNEL_H */
@@ -108,9 +108,9 @@ EndDeviceLoraPhy::Send(Ptr<Packet> packet,
 
     // Tag the packet with information about its Spreading Factor
     LoraTag tag;
-    packet->RemovePacketTag(tag);
+    packet->PeekPacketTag(tag);
     tag.SetTxParameters(txParams);
-    packet->AddPacketTag(tag);
+    tag.WriteTo(packet);
 
     // Get the time a packet with these parameters will take to be transmitted
     Time duration = GetTimeOnAir(packet, txParams);
@@ -156,14 +156,43 @@ EndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
                                double frequency)
 {
     NS_LOG_FUNCTION(this << packet << rxPowerDbm << unsigned(sf) << duration << frequency);
+    StartReceiveDownlink(packet, rxPowerDbm, sf, duration, frequency, GetDestination(packet));
+}
+
+LoraDeviceAddress
+EndDeviceLoraPhy::GetDestination(Ptr<const Packet> packet)
+{
+    // Work on a packet copy
+    auto copy = packet->Copy();
+    LorawanMacHeader mHdr;
+    copy->RemoveHeader(mHdr);
+    NS_ASSERT_MSG(!mHdr.IsUplink(), "We should not be able to lock onto uplink preambles");
+    LoraFrameHeader fHdr;
+    fHdr.SetAsDownlink();
+    copy->RemoveHeader(fHdr);
+    return fHdr.GetAddress();
+}
+
+void
+EndDeviceLoraPhy::StartReceiveDownlink(Ptr<Packet> packet,
+                                       double rxPowerDbm,
+                                       uint8_t sf,
+                                       Time duration,
+                                       double frequency,
+                                       LoraDeviceAddress destination)
+{
+    NS_LOG_FUNCTION(this << packet << rxPowerDbm << unsigned(sf) << duration << frequency
+                         << destination);
     // Notify the LoraInterferenceHelper of the impinging signal, and remember
     // the event it creates. This will be used then to correctly handle the end
     // of reception event.
     //
     // We need to do this regardless of our state or frequency, since these could
     // change (and making the interference relevant) while the interference is
-    // still incoming.
-    auto event = m_interference->Add(duration, rxPowerDbm, sf, packet, frequency);
+    // still incoming. The signal started before the channel delivered it, when
+    // the preamble was locked.
+    Time lock = m_channel ? m_channel->GetPreambleLockTime() : Seconds(0);
+    auto event = m_interference->Add(duration, rxPowerDbm, sf, packet, frequency, lock);
     // Switch on the current PHY state
     switch (m_state)
     {
@@ -194,7 +223,7 @@ EndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
         // Flag to signal whether we can receive the packet or not
         bool canLockOnPacket = true;
         // Save needed sensitivity
-        double sensitivity = EndDeviceLoraPhy::sensitivity[unsigned(sf) - 7];
+        double sensitivity = LoraPhyMath::END_DEVICE_SENSITIVITY[unsigned(sf) - 7];
         // Check frequency (manage double comparison)
         //////////////////
         if (frequency != m_rxFrequency)
@@ -232,14 +261,19 @@ EndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
         if (canLockOnPacket)
         {
             // Packet Filtering based on Preamble Start (SX1272 Datasheet)
-            duration = GetFilteredDuration(packet, duration);
+            duration = GetFilteredDuration(packet, duration, destination);
             // Switch to RX state
             // EndReceive will handle the switch back to STANDBY state
             SwitchToRx();
             // Schedule the end of the reception of the packet
             NS_LOG_INFO("Scheduling reception of a packet. End in " << duration.GetSeconds()
                                                                     << " seconds");
-            Simulator::Schedule(duration, &EndDeviceLoraPhy::EndReceive, this, packet, event);
+            Simulator::Schedule(duration,
+                                &EndDeviceLoraPhy::EndReceiveDownlink,
+                                this,
+                                packet,
+                                event,
+                                destination);
             // Fire the beginning of reception trace source
             m_phyRxBeginTrace(packet);
         }
@@ -248,24 +282,18 @@ EndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
 }
 
 Time
-EndDeviceLoraPhy::GetFilteredDuration(Ptr<const Packet> packet, Time duration) const
+EndDeviceLoraPhy::GetFilteredDuration(Ptr<const Packet> packet,
+                                      Time duration,
+                                      LoraDeviceAddress destination) const
 {
-    // Work on a packet copy
-    auto copy = packet->Copy();
-    LorawanMacHeader mHdr;
-    copy->RemoveHeader(mHdr);
-    NS_ASSERT_MSG(!mHdr.IsUplink(), "We should not be able to lock onto uplink preambles");
     // Check address
-    LoraFrameHeader fHdr;
-    fHdr.SetAsDownlink();
-    copy->RemoveHeader(fHdr);
-    if (m_address != fHdr.GetAddress())
+    if (m_address != destination)
     {
         // Get transmission parameters
         LoraTag tag;
-        copy->RemovePacketTag(tag);
+        packet->PeekPacketTag(tag);
         // MHDR (1B) + 4B of Addr in FHdr
-        return GetTimeOnAir(Create<Packet>(5), tag.GetTxParameters());
+        return GetTimeOnAir(5, tag.GetTxParameters());
     }
     return duration;
 }
@@ -274,20 +302,22 @@ void
 EndDeviceLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event)
 {
     NS_LOG_FUNCTION(this << packet << event);
+    EndReceiveDownlink(packet, event, GetDestination(packet));
+}
+
+void
+EndDeviceLoraPhy::EndReceiveDownlink(Ptr<Packet> packet,
+                                     Ptr<LoraInterferenceHelper::Event> event,
+                                     LoraDeviceAddress destination)
+{
+    NS_LOG_FUNCTION(this << packet << event << destination);
     // Automatically switch to Standby
     SwitchToStandby();
     // Fire the trace source
     m_phyRxEndTrace(packet);
 
     // Check early returns from filtered packets
-    auto copy = packet->Copy();
-    LorawanMacHeader mHdr;
-    copy->RemoveHeader(mHdr);
-    LoraFrameHeader fHdr;
-    fHdr.SetAsDownlink();
-    copy->RemoveHeader(fHdr);
-    // Check address
-    if (m_address != fHdr.GetAddress())
+    if (m_address != destination)
     {
         NS_LOG_INFO("Packet filtered early due to wrong destination address");
         // If there is one, perform the callback to inform the upper layer of the
@@ -308,10 +338,10 @@ EndDeviceLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Eve
         NS_LOG_INFO("Packet destroyed by interference");
         // Update the packet's LoraTag
         LoraTag tag;
-        packet->RemovePacketTag(tag);
+        packet->PeekPacketTag(tag);
         tag.SetDestroyedBy(packetDestroyed);
-        tag.SetReceptionTime(Simulator::Now());
-        packet->AddPacketTag(tag);
+        tag.SetReceptionTime(event->GetEndTime());
+        tag.WriteTo(packet);
         // If there is one, perform the callback to inform the upper layer of the
         // lost packet
         if (!m_rxFailedCallback.IsNull())
@@ -327,11 +357,11 @@ EndDeviceLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Eve
     // Set the receive power, frequency and SNR of this packet in the LoraTag:
     // here this information is useful for filling the packet sniffing header.
     LoraTag tag;
-    packet->RemovePacketTag(tag);
-    tag.SetReceptionTime(Simulator::Now());
+    packet->PeekPacketTag(tag);
+    tag.SetReceptionTime(event->GetEndTime());
     tag.SetReceivePower(event->GetRxPowerdBm());
     tag.SetSnr(RxPowerToSNR(event->GetRxPowerdBm()));
-    packet->AddPacketTag(tag);
+    tag.WriteTo(packet);
     // If there is one, perform the callback to inform the upper layer
     if (!m_rxOkCallback.IsNull())
     {
@@ -449,10 +479,5 @@ EndDeviceLoraPhy::DoDispose()
     LoraPhy::DoDispose();
 }
 
-// Downlink sensitivity (from SX1272 datasheet)
-// {SF7, SF8, SF9, SF10, SF11, SF12}
-// These sensitivites are for a bandwidth of 125000 Hz
-const double EndDeviceLoraPhy::sensitivity[6] = {-124, -127, -130, -133, -135, -137};
-
 } // namespace lorawan
 } // namespace ns3
@@ -161,6 +161,34 @@ class EndDeviceLoraPhy : public LoraPhy
                       Time duration,
                       double frequency) override;
 
+    /**
+     * Start receiving a downlink packet whose destination is already known.
+     *
+     * Same as StartReceive, without parsing the headers of the packet: the
+     * channel decodes the destination once per transmission.
+     *
+     * \param packet The packet.
+     * \param rxPowerDbm The received power, in dBm.
+     * \param sf The spreading factor of the packet.
+     * \param duration The duration of the packet.
+     * \param frequency The frequency of the packet, in Hz.
+     * \param destination The address in the frame header of the packet.
+     */
+    void StartReceiveDownlink(Ptr<Packet> packet,
+                              double rxPowerDbm,
+                              uint8_t sf,
+                              Time duration,
+                              double frequency,
+                              LoraDeviceAddress destination);
+
+    /**
+     * Decode the destination address of a downlink packet.
+     *
+     * \param packet The packet, starting with the MAC header.
+     * \return The address in the frame header.
+     */
+    static LoraDeviceAddress GetDestination(Ptr<const Packet> packet);
+
     // Implementation of LoraPhy's pure virtual functions
     bool IsTransmitting() override;
 
@@ -230,12 +258,24 @@ class EndDeviceLoraPhy : public LoraPhy
     // Implementation of LoraPhy's pure virtual functions
     void EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event) override;
 
+    /**
+     * Finish the reception of a downlink packet whose destination is already known.
+     *
+     * \param packet The packet.
+     * \param event The interference event of the packet.
+     * \param destination The address in the frame header of the packet.
+     */
+    void EndReceiveDownlink(Ptr<Packet> packet,
+                            Ptr<LoraInterferenceHelper::Event> event,
+                            LoraDeviceAddress destination);
+
     /**
      * Compute the shorter duration of packets being filtered
-     * early during reception for being uplink or for being
-     * destined to another device
+     * early during reception for being destined to another device
      */
-    Time GetFilteredDuration(Ptr<const Packet> packet, Time duration) const;
+    Time GetFilteredDuration(Ptr<const Packet> packet,
+                             Time duration,
+                             LoraDeviceAddress destination) const;
 
     /**
      * Internal call when transmission finishes.
@@ -262,8 +302,6 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     LoraDeviceAddress m_address;
 
-    static const double sensitivity[6]; //!< The sensitivity vector of this device to different SFs
-
     std::vector<EndDeviceLoraPhyListener*> m_listeners; //!< PHY listeners
 
     /**
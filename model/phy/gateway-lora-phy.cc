@@ -123,12 +123,25 @@ GatewayLoraPhy::GetTypeId()
             .AddTraceSource("OccupiedReceptionPaths",
                             "Number of currently occupied reception paths",
                             MakeTraceSourceAccessor(&GatewayLoraPhy::m_occupiedReceptionPaths),
-                            "ns3::TracedValueCallback::Int");
+                            "ns3::TracedValueCallback::Int")
+            .AddTraceSource("ReceptionPathUtilization",
+                            "Time-weighted mean fraction of occupied reception paths, "
+                            "updated on each change of the occupancy",
+                            MakeTraceSourceAccessor(&GatewayLoraPhy::m_utilization),
+                            "ns3::TracedValueCallback::Double")
+            .AddTraceSource(
+                "OccupancyInterval",
+                "Number of occupied reception paths and duration of each interval "
+                "where it was constant",
+                MakeTraceSourceAccessor(&GatewayLoraPhy::m_occupancyInterval),
+                "ns3::lorawan::GatewayLoraPhy::OccupancyIntervalTracedCallback");
     return tid;
 }
 
 GatewayLoraPhy::GatewayLoraPhy()
-    : m_isTransmitting(false)
+    : m_isTransmitting(false),
+      m_occupiedReceptionPaths(0),
+      m_utilization(0)
 {
     NS_LOG_FUNCTION(this);
     SetReceptionPaths(8);
@@ -156,48 +169,42 @@ GatewayLoraPhy::StartReceive(Ptr<Packet> packet,
         m_noReceptionBecauseTransmitting(packet, m_nodeId);
         return;
     }
-    // Add the event to the LoraInterferenceHelper
-    auto event = m_interference->Add(duration, rxPowerDbm, sf, packet, frequency);
-    // Cycle over the receive paths to check availability to receive the packet
-    for (auto& path : m_receptionPaths)
+    // Add the event to the LoraInterferenceHelper, from the arrival of the
+    // signal: the channel delivers it once the preamble is locked
+    Time lock = m_channel ? m_channel->GetPreambleLockTime() : Seconds(0);
+    auto event = m_interference->Add(duration, rxPowerDbm, sf, packet, frequency, lock);
+    // Check whether a receive path is available to receive the packet
+    if (m_freePaths.empty())
     {
-        if (path->IsAvailable()) // If the receive path is available we have a candidate
-        {
-            // See whether the reception power is above or below the sensitivity
-            // for that spreading factor
-            double sensitivity = GatewayLoraPhy::sensitivity[unsigned(sf) - 7];
-            if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
-            {
-                NS_LOG_INFO("Dropping packet reception of packet with sf = "
-                            << unsigned(sf) << " because under the sensitivity of " << sensitivity
-                            << " dBm");
-                // Fire the trace sources
-                m_underSensitivity(packet, m_nodeId);
-            }
-            else // We have sufficient sensitivity to start receiving
-            {
-                NS_LOG_INFO("Scheduling reception of a packet, occupying one demodulator");
-                // Block this resource
-                path->LockOnEvent(event);
-                m_occupiedReceptionPaths++;
-                // Schedule the end of the reception of the packet
-                path->SetEndReceive(Simulator::Schedule(duration,
-                                                        &GatewayLoraPhy::EndReceive,
-                                                        this,
-                                                        packet,
-                                                        event));
-                // Fire the trace source
-                m_phyRxBeginTrace(packet);
-            }
-            return;
-        }
+        // If we get to this point, there are no demodulators we can use
+        NS_LOG_INFO("Dropping packet reception of packet with sf = "
+                    << unsigned(sf) << " and frequency " << frequency
+                    << "Hz because no suitable demodulator was found");
+        // Fire the trace source
+        m_noMoreDemodulators(packet, m_nodeId);
+        return;
+    }
+    // See whether the reception power is above or below the sensitivity
+    // for that spreading factor
+    double sensitivity = LoraPhyMath::GATEWAY_SENSITIVITY[unsigned(sf) - 7];
+    if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
+    {
+        NS_LOG_INFO("Dropping packet reception of packet with sf = "
+                    << unsigned(sf) << " because under the sensitivity of " << sensitivity
+                    << " dBm");
+        // Fire the trace sources
+        m_underSensitivity(packet, m_nodeId);
+        return;
     }
-    // If we get to this point, there are no demodulators we can use
-    NS_LOG_INFO("Dropping packet reception of packet with sf = "
-                << unsigned(sf) << " and frequency " << frequency
-                << "Hz because no suitable demodulator was found");
+    // We have sufficient sensitivity to start receiving
+    NS_LOG_INFO("Scheduling reception of a packet, occupying one demodulator");
+    // Block this resource
+    ReceptionPath& path = LockPath(event);
+    // Schedule the end of the reception of the packet
+    path.SetEndReceive(
+        Simulator::Schedule(duration, &GatewayLoraPhy::EndReceive, this, packet, event));
     // Fire the trace source
-    m_noMoreDemodulators(packet, m_nodeId);
+    m_phyRxBeginTrace(packet);
 }
 
 void
@@ -216,10 +223,10 @@ GatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event
         NS_LOG_DEBUG("packetDestroyed by interference on SF " << unsigned(packetDestroyed));
         // Update the packet's LoraTag
         LoraTag tag;
-        packet->RemovePacketTag(tag);
+        packet->PeekPacketTag(tag);
         tag.SetDestroyedBy(packetDestroyed);
-        tag.SetReceptionTime(Simulator::Now());
-        packet->AddPacketTag(tag);
+        tag.SetReceptionTime(event->GetEndTime());
+        tag.WriteTo(packet);
         // Fire the trace source
         m_interferedPacket(packet, m_nodeId);
     }
@@ -231,11 +238,11 @@ GatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event
         // information can be useful for upper layers trying to control link
         // quality and to fill the packet sniffing header.
         LoraTag tag;
-        packet->RemovePacketTag(tag);
-        tag.SetReceptionTime(Simulator::Now());
+        packet->PeekPacketTag(tag);
+        tag.SetReceptionTime(event->GetEndTime());
         tag.SetReceivePower(event->GetRxPowerdBm());
         tag.SetSnr(RxPowerToSNR(event->GetRxPowerdBm()));
-        packet->AddPacketTag(tag);
+        tag.WriteTo(packet);
         // Forward the packet to the upper layer
         if (!m_rxOkCallback.IsNull())
         {
@@ -249,15 +256,12 @@ GatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event
             m_phySniffRxTrace(packet);
         }
     }
-    // Search for the demodulator that was locked on this event to free it.
-    for (auto& path : m_receptionPaths)
+    // Free the demodulator that was locked on this event.
+    int32_t index = event->GetReceptionPath();
+    if (index >= 0 && uint32_t(index) < m_receptionPaths.size() &&
+        m_receptionPaths[index].GetEvent() == event)
     {
-        if (path->GetEvent() == event)
-        {
-            path->Free();
-            m_occupiedReceptionPaths--;
-            return;
-        }
+        FreePath(index);
     }
 }
 
@@ -270,22 +274,23 @@ GatewayLoraPhy::Send(Ptr<Packet> packet,
     NS_LOG_FUNCTION(this << packet << txParams << frequency << txPowerDbm);
 
     // Interrupt all receive operations
-    for (auto& path : m_receptionPaths)
-        if (!path->IsAvailable()) // Reception path is occupied
+    for (uint32_t i = 0; m_occupiedReceptionPaths > 0 && i < m_receptionPaths.size(); ++i)
+    {
+        if (!m_receptionPaths[i].IsAvailable()) // Reception path is occupied
         {
             // Fire the trace source for reception interrupted by transmission
-            m_noReceptionBecauseTransmitting(path->GetEvent()->GetPacket(), m_nodeId);
-            // Cancel the scheduled EndReceive call
-            Simulator::Cancel(path->GetEndReceive());
-            // Free it and resets all parameters
-            path->Free();
+            m_noReceptionBecauseTransmitting(m_receptionPaths[i].GetEvent()->GetPacket(),
+                                             m_nodeId);
+            // Free it, cancelling the scheduled EndReceive call
+            FreePath(i);
         }
+    }
 
     // Tag packet with PHY layer tx info
     LoraTag tag;
-    packet->RemovePacketTag(tag);
+    packet->PeekPacketTag(tag);
     tag.SetTxParameters(txParams);
-    packet->AddPacketTag(tag);
+    tag.WriteTo(packet);
 
     // Get the time a packet with these parameters will take to be transmitted
     Time duration = GetTimeOnAir(packet, txParams);
@@ -331,29 +336,96 @@ void
 GatewayLoraPhy::SetReceptionPaths(uint8_t number)
 {
     NS_LOG_FUNCTION(this << (unsigned)number);
-    m_receptionPaths.clear();
-    for (uint32_t i = 0; i < number; ++i)
+    m_receptionPaths.assign(number, ReceptionPath());
+    // Lowest indexes on top of the stack
+    m_freePaths.clear();
+    for (uint32_t i = number; i > 0; --i)
     {
-        m_receptionPaths.push_back(Create<ReceptionPath>());
+        m_freePaths.push_back(i - 1);
     }
+    m_occupiedReceptionPaths = 0;
+    m_occupancyTime.assign(number + 1, Seconds(0));
+    m_busyTime = Seconds(0);
+    m_statsStart = Simulator::Now();
+    m_lastOccupancyChange = m_statsStart;
+    m_utilization = 0;
+}
+
+std::vector<Time>
+GatewayLoraPhy::GetOccupancyHistogram() const
+{
+    NS_LOG_FUNCTION(this);
+    std::vector<Time> histogram = m_occupancyTime;
+    histogram[m_occupiedReceptionPaths] += Simulator::Now() - m_lastOccupancyChange;
+    return histogram;
+}
+
+double
+GatewayLoraPhy::GetUtilization() const
+{
+    NS_LOG_FUNCTION(this);
+    Time elapsed = Simulator::Now() - m_statsStart;
+    if (m_receptionPaths.empty() || !elapsed.IsStrictlyPositive())
+    {
+        return 0;
+    }
+    Time current = Simulator::Now() - m_lastOccupancyChange;
+    double busy = (m_busyTime + TimeStep(current.GetTimeStep() * m_occupiedReceptionPaths))
+                      .GetSeconds();
+    return busy / (elapsed.GetSeconds() * m_receptionPaths.size());
+}
+
+GatewayLoraPhy::ReceptionPath&
+GatewayLoraPhy::LockPath(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+    uint32_t index = m_freePaths.back();
+    m_freePaths.pop_back();
+    ReceptionPath& path = m_receptionPaths[index];
+    path.LockOnEvent(event);
+    event->SetReceptionPath(index);
+    UpdateOccupancy(1);
+    return path;
+}
+
+void
+GatewayLoraPhy::FreePath(uint32_t index)
+{
+    NS_LOG_FUNCTION(this << index);
+    ReceptionPath& path = m_receptionPaths[index];
+    path.GetEvent()->SetReceptionPath(-1);
+    path.Free();
+    m_freePaths.push_back(index);
+    UpdateOccupancy(-1);
+}
+
+void
+GatewayLoraPhy::UpdateOccupancy(int delta)
+{
+    NS_LOG_FUNCTION(this << delta);
+    Time now = Simulator::Now();
+    Time elapsed = now - m_lastOccupancyChange;
+    int occupied = m_occupiedReceptionPaths;
+    m_occupancyTime[occupied] += elapsed;
+    m_busyTime += TimeStep(elapsed.GetTimeStep() * occupied);
+    m_lastOccupancyChange = now;
+    m_occupancyInterval(occupied, elapsed);
+    m_occupiedReceptionPaths += delta;
+    m_utilization = GetUtilization();
 }
 
 void
 GatewayLoraPhy::DoDispose()
 {
     NS_LOG_FUNCTION(this);
-    for (auto rp : m_receptionPaths)
+    for (auto& path : m_receptionPaths)
     {
-        rp->Free();
+        path.Free();
     }
     m_receptionPaths.clear();
+    m_freePaths.clear();
     LoraPhy::DoDispose();
 }
 
-// Uplink sensitivity (Source: SX1301 datasheet)
-// {SF7, SF8, SF9, SF10, SF11, SF12}
-// These sensitivities are for a bandwidth of 125000 Hz
-const double GatewayLoraPhy::sensitivity[6] = {-126.5, -129, -131.5, -134, -136.5, -139.5};
-
 } // namespace lorawan
 } // namespace ns3
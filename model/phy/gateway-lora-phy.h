@@ -27,6 +27,8 @@
 #include "ns3/lora-phy.h"
 #include "ns3/traced-value.h"
 
+#include <vector>
+
 namespace ns3
 {
 namespace lorawan
@@ -41,6 +43,12 @@ namespace lorawan
  * simultaneously. This characteristic of the chip is modeled using the
  * ReceivePath class, which describes a single parallel receiver. GatewayLoraPhy
  * essentially holds and manages a collection of these objects.
+ *
+ * Free reception paths are kept in a free list, and the index of the path
+ * locked on a signal is stored in its LoraInterferenceHelper Event, so that
+ * locking and freeing a path take constant time whatever the number of paths.
+ * The time spent with each number of occupied paths is recorded, for capacity
+ * planning.
  */
 class GatewayLoraPhy : public LoraPhy
 {
@@ -51,7 +59,7 @@ class GatewayLoraPhy : public LoraPhy
      * listen for a certain SF. ReceptionPaths be either locked on an event or
      * free.
      */
-    class ReceptionPath : public SimpleRefCount<GatewayLoraPhy::ReceptionPath>
+    class ReceptionPath
     {
       public:
         /**
@@ -123,6 +131,14 @@ class GatewayLoraPhy : public LoraPhy
     };
 
   public:
+    /**
+     * TracedCallback signature for the end of an occupancy interval.
+     *
+     * \param occupied The number of occupied reception paths in the interval.
+     * \param duration The duration of the interval.
+     */
+    typedef void (*OccupancyIntervalTracedCallback)(uint32_t occupied, Time duration);
+
     static TypeId GetTypeId();
 
     GatewayLoraPhy();
@@ -146,9 +162,26 @@ class GatewayLoraPhy : public LoraPhy
 
     /**
      * Set a certain number of reception paths.
+     *
+     * This also resets the occupancy statistics.
      */
     void SetReceptionPaths(uint8_t number);
 
+    /**
+     * Get the time spent with each number of occupied reception paths.
+     *
+     * \return The time spent with i occupied paths at index i, since the last
+     * call to SetReceptionPaths, including the current interval.
+     */
+    std::vector<Time> GetOccupancyHistogram() const;
+
+    /**
+     * Get the time-weighted mean fraction of occupied reception paths.
+     *
+     * \return The utilization since the last call to SetReceptionPaths, in [0, 1].
+     */
+    double GetUtilization() const;
+
   protected:
     void DoDispose() override;
 
@@ -159,25 +192,63 @@ class GatewayLoraPhy : public LoraPhy
      */
     virtual void TxFinished(Ptr<Packet> packet);
 
+    /**
+     * Lock a free reception path on an event.
+     *
+     * \param event The event, which keeps the index of the path.
+     * \return The path.
+     */
+    ReceptionPath& LockPath(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Free a reception path and put it back in the free list.
+     *
+     * \param index The index of the path.
+     */
+    void FreePath(uint32_t index);
+
+    /**
+     * Account for the time spent at the current occupancy, then change it.
+     *
+     * \param delta The change in the number of occupied reception paths.
+     */
+    void UpdateOccupancy(int delta);
+
     /**
      * A vector containing the various parallel receivers that are managed by this
      * Gateway.
      */
-    std::vector<Ptr<ReceptionPath>> m_receptionPaths;
-
-    bool m_isTransmitting; //!< Flag indicating whether a transmission is going on
+    std::vector<ReceptionPath> m_receptionPaths;
 
     /**
-     * A vector containing the sensitivities required to correctly decode
-     * different spreading factors.
+     * The indexes of the free reception paths, used as a stack.
      */
-    static const double sensitivity[6];
+    std::vector<uint32_t> m_freePaths;
+
+    bool m_isTransmitting; //!< Flag indicating whether a transmission is going on
 
     /**
      * The number of occupied reception paths.
      */
     TracedValue<int> m_occupiedReceptionPaths;
 
+    std::vector<Time> m_occupancyTime; //!< Time spent with each number of occupied paths
+    Time m_busyTime;                   //!< Time integral of the number of occupied paths
+    Time m_statsStart;                 //!< Start of the occupancy statistics
+    Time m_lastOccupancyChange;        //!< Start of the current occupancy interval
+
+    /**
+     * The time-weighted mean fraction of occupied reception paths, updated on
+     * each change of the occupancy.
+     */
+    TracedValue<double> m_utilization;
+
+    /**
+     * Trace source fired at the end of each interval with a constant number of
+     * occupied reception paths.
+     */
+    TracedCallback<uint32_t, Time> m_occupancyInterval;
+
     /**
      * Trace source that is fired when a packet cannot be received because all
      * available ReceivePath instances are busy.
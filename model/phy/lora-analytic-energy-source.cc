@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "lora-analytic-energy-source.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraAnalyticEnergySource");
+
+NS_OBJECT_ENSURE_REGISTERED(LoraAnalyticEnergySource);
+
+TypeId
+LoraAnalyticEnergySource::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LoraAnalyticEnergySource")
+            .SetParent<EnergySource>()
+            .SetGroupName("Energy")
+            .AddConstructor<LoraAnalyticEnergySource>()
+            .AddAttribute("InitialEnergyJ",
+                          "Initial energy stored in the source.",
+                          DoubleValue(10), // in Joules
+                          MakeDoubleAccessor(&LoraAnalyticEnergySource::SetInitialEnergy,
+                                             &LoraAnalyticEnergySource::GetInitialEnergy),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("SupplyVoltageV",
+                          "Supply voltage of the source.",
+                          DoubleValue(3.0), // in Volts
+                          MakeDoubleAccessor(&LoraAnalyticEnergySource::SetSupplyVoltage,
+                                             &LoraAnalyticEnergySource::GetSupplyVoltage),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("LowBatteryThreshold",
+                          "Fraction of the initial energy below which the battery is depleted.",
+                          DoubleValue(0.10),
+                          MakeDoubleAccessor(&LoraAnalyticEnergySource::m_lowBatteryTh),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("HighBatteryThreshold",
+                          "Fraction of the initial energy above which a depleted battery is "
+                          "recharged.",
+                          DoubleValue(0.15),
+                          MakeDoubleAccessor(&LoraAnalyticEnergySource::m_highBatteryTh),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddTraceSource("RemainingEnergy",
+                            "Remaining energy, updated on changes of the current.",
+                            MakeTraceSourceAccessor(&LoraAnalyticEnergySource::m_remainingEnergyJ),
+                            "ns3::TracedValueCallback::Double");
+    return tid;
+}
+
+LoraAnalyticEnergySource::LoraAnalyticEnergySource()
+    : m_initialEnergyJ(0),
+      m_supplyVoltageV(0),
+      m_lowBatteryTh(0),
+      m_highBatteryTh(0),
+      m_remainingEnergyJ(0),
+      m_totalCurrentA(0),
+      m_lastUpdateTime(Seconds(0)),
+      m_depleted(false)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LoraAnalyticEnergySource::~LoraAnalyticEnergySource()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LoraAnalyticEnergySource::SetInitialEnergy(double initialEnergyJ)
+{
+    NS_LOG_FUNCTION(this << initialEnergyJ);
+    NS_ASSERT(initialEnergyJ >= 0);
+    m_initialEnergyJ = initialEnergyJ;
+    m_remainingEnergyJ = initialEnergyJ;
+}
+
+void
+LoraAnalyticEnergySource::SetSupplyVoltage(double supplyVoltageV)
+{
+    NS_LOG_FUNCTION(this << supplyVoltageV);
+    m_supplyVoltageV = supplyVoltageV;
+}
+
+double
+LoraAnalyticEnergySource::GetInitialEnergy() const
+{
+    return m_initialEnergyJ;
+}
+
+double
+LoraAnalyticEnergySource::GetSupplyVoltage() const
+{
+    return m_supplyVoltageV;
+}
+
+double
+LoraAnalyticEnergySource::GetRemainingEnergy()
+{
+    NS_LOG_FUNCTION(this);
+    // The current is constant since the last update: no need to poll the models
+    Integrate();
+    return m_remainingEnergyJ;
+}
+
+double
+LoraAnalyticEnergySource::GetEnergyFraction()
+{
+    NS_LOG_FUNCTION(this);
+    return GetRemainingEnergy() / m_initialEnergyJ;
+}
+
+double
+LoraAnalyticEnergySource::GetTotalCurrentA() const
+{
+    return m_totalCurrentA;
+}
+
+void
+LoraAnalyticEnergySource::UpdateEnergySource()
+{
+    NS_LOG_FUNCTION(this);
+    if (Simulator::IsFinished())
+    {
+        return;
+    }
+    Integrate();
+    m_totalCurrentA = CalculateTotalCurrent();
+    CheckThresholds();
+}
+
+void
+LoraAnalyticEnergySource::NotifyCurrentChange(double deltaA)
+{
+    NS_LOG_FUNCTION(this << deltaA);
+    Integrate();
+    m_totalCurrentA += deltaA;
+    CheckThresholds();
+}
+
+/*
+ * Private functions start here.
+ */
+
+void
+LoraAnalyticEnergySource::DoInitialize()
+{
+    NS_LOG_FUNCTION(this);
+    UpdateEnergySource();
+    EnergySource::DoInitialize();
+}
+
+void
+LoraAnalyticEnergySource::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_deadline.Cancel();
+    BreakDeviceEnergyModelRefCycle();
+    EnergySource::DoDispose();
+}
+
+void
+LoraAnalyticEnergySource::Integrate()
+{
+    Time now = Simulator::Now();
+    if (now == m_lastUpdateTime)
+    {
+        return;
+    }
+    double energyJ = m_totalCurrentA * m_supplyVoltageV * (now - m_lastUpdateTime).GetSeconds();
+    m_remainingEnergyJ = std::max(m_remainingEnergyJ - energyJ, 0.0);
+    m_lastUpdateTime = now;
+}
+
+void
+LoraAnalyticEnergySource::CheckThresholds()
+{
+    double lowJ = m_lowBatteryTh * m_initialEnergyJ;
+    double highJ = m_highBatteryTh * m_initialEnergyJ;
+
+    // Handlers may change the current (e.g., turning the radio off), and so call back
+    // this method: the state is updated before notifying
+    if (!m_depleted && m_remainingEnergyJ <= lowJ)
+    {
+        NS_LOG_DEBUG("Energy depleted at " << Simulator::Now().As(Time::S));
+        m_depleted = true;
+        NotifyEnergyDrained();
+    }
+    else if (m_depleted && m_remainingEnergyJ > highJ)
+    {
+        NS_LOG_DEBUG("Energy recharged at " << Simulator::Now().As(Time::S));
+        m_depleted = false;
+        NotifyEnergyRecharged();
+    }
+
+    // Time to the next crossing at the present current (negative when harvesting)
+    double powerW = m_totalCurrentA * m_supplyVoltageV;
+    double seconds;
+    if (!m_depleted && powerW > 0)
+    {
+        seconds = (m_remainingEnergyJ - lowJ) / powerW;
+    }
+    else if (m_depleted && powerW < 0)
+    {
+        seconds = (highJ - m_remainingEnergyJ) / -powerW;
+    }
+    else
+    {
+        return; // No crossing until the current changes
+    }
+    if (seconds > 1e9)
+    {
+        return; // Beyond any simulation, and beyond the range of Time
+    }
+
+    // Rounded up, so that the threshold is crossed when the deadline expires. An earlier
+    // deadline is kept: it will be recomputed when it expires.
+    Time delay = NanoSeconds(std::ceil(seconds * 1e9) + 1);
+    if (m_deadline.IsRunning() && Simulator::GetDelayLeft(m_deadline) <= delay)
+    {
+        return;
+    }
+    m_deadline.Cancel();
+    m_deadline = Simulator::Schedule(delay, &LoraAnalyticEnergySource::UpdateEnergySource, this);
+}
+
+} // namespace lorawan
+} // namespace ns3
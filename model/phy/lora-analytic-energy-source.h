@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef LORA_ANALYTIC_ENERGY_SOURCE_H
+#define LORA_ANALYTIC_ENERGY_SOURCE_H
+
+#include "ns3/energy-source.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup energy
+ *
+ * An ideal energy source (like BasicEnergySource) that is not updated
+ * periodically.
+ *
+ * The remaining energy is computed on demand from the total current drawn
+ * since the last change, and a single event is kept at the next time the
+ * battery can cross the low (or, when recharging, the high) threshold.
+ * Device models that know this source (see LoraRadioEnergyModel) notify it
+ * of the changes of their current with NotifyCurrentChange, which does not
+ * query the other models. UpdateEnergySource still polls all models and
+ * harvesters, as required by other device models.
+ */
+class LoraAnalyticEnergySource : public EnergySource
+{
+  public:
+    static TypeId GetTypeId();
+
+    LoraAnalyticEnergySource();
+    ~LoraAnalyticEnergySource() override;
+
+    /**
+     * \param initialEnergyJ Initial energy, in Joules.
+     *
+     * Sets initial energy stored in the energy source, which is also the
+     * remaining energy.
+     */
+    void SetInitialEnergy(double initialEnergyJ);
+
+    /**
+     * \param supplyVoltageV Supply voltage at the energy source, in Volts.
+     */
+    void SetSupplyVoltage(double supplyVoltageV);
+
+    /**
+     * \return Initial energy stored in energy source, in Joules.
+     */
+    double GetInitialEnergy() const override;
+
+    /**
+     * \return Supply voltage at the energy source.
+     */
+    double GetSupplyVoltage() const override;
+
+    /**
+     * \return Remaining energy in energy source, in Joules.
+     */
+    double GetRemainingEnergy() override;
+
+    /**
+     * \return Energy fraction.
+     */
+    double GetEnergyFraction() override;
+
+    /**
+     * Poll the current of all device models and harvesters, then update the
+     * remaining energy and the threshold deadline.
+     */
+    void UpdateEnergySource() override;
+
+    /**
+     * Account for a change of the current drawn by a device model.
+     *
+     * \param deltaA The increase of the current, in Ampere (negative if it decreases).
+     */
+    void NotifyCurrentChange(double deltaA);
+
+    /**
+     * \return The total current drawn at the moment, in Ampere.
+     */
+    double GetTotalCurrentA() const;
+
+  private:
+    void DoInitialize() override;
+    void DoDispose() override;
+
+    /**
+     * Decrease the remaining energy by the consumption since the last update.
+     */
+    void Integrate();
+
+    /**
+     * Fire threshold crossings, and schedule the next possible one.
+     */
+    void CheckThresholds();
+
+    double m_initialEnergyJ;                //!< Initial energy, in Joules
+    double m_supplyVoltageV;                //!< Supply voltage, in Volts
+    double m_lowBatteryTh;                  //!< Low battery threshold, as a fraction
+    double m_highBatteryTh;                 //!< High battery threshold, as a fraction
+    TracedValue<double> m_remainingEnergyJ; //!< Remaining energy at the last update
+    double m_totalCurrentA;                 //!< Current drawn since the last update
+    Time m_lastUpdateTime;                  //!< Time of the last update
+    bool m_depleted;                        //!< Whether the low threshold was crossed
+    EventId m_deadline;                     //!< Next possible threshold crossing
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_ANALYTIC_ENERGY_SOURCE_H */
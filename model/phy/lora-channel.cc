@@ -54,6 +54,12 @@ LoraChannel::GetTypeId()
                           PointerValue(),
                           MakePointerAccessor(&LoraChannel::m_delay),
                           MakePointerChecker<PropagationDelayModel>())
+            .AddAttribute("PreambleLockTime",
+                          "Time from the arrival of a signal to the lock of receivers on "
+                          "its preamble, when the reception is delivered to PHYs",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&LoraChannel::m_preambleLockTime),
+                          MakeTimeChecker(Seconds(0)))
             .AddTraceSource("PacketSent",
                             "Trace source fired whenever a packet goes out on the channel",
                             MakeTraceSourceAccessor(&LoraChannel::m_packetSent),
@@ -138,6 +144,12 @@ LoraChannel::Send(Ptr<LoraPhy> sender,
     auto& receivers = (down) ? m_phyListDown : m_phyListUp;
     NS_LOG_INFO("Starting cycle over " << receivers.size() << " PHYs"
                                        << ((down) ? " in downlink" : " in uplink"));
+    // Decode the destination of downlinks once, instead of in every end device
+    LoraDeviceAddress destination;
+    if (down && !receivers.empty())
+    {
+        destination = EndDeviceLoraPhy::GetDestination(packet);
+    }
     // Cycle over all registered PHYs
     for (auto& phy : receivers)
     {
@@ -153,6 +165,45 @@ LoraChannel::Send(Ptr<LoraPhy> sender,
                      << senderMobility->GetDistanceFrom(receiverMobility) << "m, delay=" << delay);
         // Schedule the receive event
         NS_LOG_INFO("Scheduling reception of the packet");
+        ScheduleReception(phy,
+                          delay + m_preambleLockTime,
+                          packet,
+                          rxPowerDbm,
+                          sf,
+                          duration,
+                          frequency,
+                          down,
+                          destination);
+        // Fire the trace source for sent packet
+        m_packetSent(packet);
+    }
+}
+
+void
+LoraChannel::ScheduleReception(Ptr<LoraPhy> phy,
+                               Time delay,
+                               Ptr<Packet> packet,
+                               double rxPowerDbm,
+                               uint8_t sf,
+                               Time duration,
+                               double frequency,
+                               bool down,
+                               LoraDeviceAddress destination)
+{
+    if (down)
+    {
+        Simulator::Schedule(delay,
+                            &EndDeviceLoraPhy::StartReceiveDownlink,
+                            StaticCast<EndDeviceLoraPhy>(phy),
+                            packet,
+                            rxPowerDbm,
+                            sf,
+                            duration,
+                            frequency,
+                            destination);
+    }
+    else
+    {
         Simulator::Schedule(delay,
                             &LoraPhy::StartReceive,
                             phy,
@@ -161,8 +212,6 @@ LoraChannel::Send(Ptr<LoraPhy> sender,
                             sf,
                             duration,
                             frequency);
-        // Fire the trace source for sent packet
-        m_packetSent(packet);
     }
 }
 
@@ -175,5 +224,11 @@ LoraChannel::GetRxPower(double txPowerDbm,
     return m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
 }
 
+Time
+LoraChannel::GetPreambleLockTime() const
+{
+    return m_preambleLockTime;
+}
+
 } // namespace lorawan
 } // namespace ns3
@@ -29,6 +29,7 @@
 
 #include "ns3/channel.h"
 #include "ns3/log.h"
+#include "ns3/lora-device-address.h"
 #include "ns3/lora-phy.h"
 #include "ns3/mobility-model.h"
 #include "ns3/nstime.h"
@@ -52,6 +53,11 @@ struct LoraPhyTxParameters;
  * computing the power at every receiver using a PropagationLossModel and
  * notifying them of the reception event after a delay based on some
  * PropagationDelayModel.
+ *
+ * Receptions are delivered when receivers lock on the preamble, the
+ * PreambleLockTime attribute after the signal arrives. PHYs account for the
+ * signal from its arrival, but commit to it, and learn its outcome, that much
+ * later.
  */
 class LoraChannel : public Channel
 {
@@ -116,12 +122,12 @@ class LoraChannel : public Channel
      * When this method is called, the channel schedules an internal Receive call
      * that performs the actual call to the PHY's StartReceive function.
      */
-    void Send(Ptr<LoraPhy> sender,
-              Ptr<Packet> packet,
-              double txPowerDbm,
-              uint8_t sf,
-              Time duration,
-              double frequency) const;
+    virtual void Send(Ptr<LoraPhy> sender,
+                      Ptr<Packet> packet,
+                      double txPowerDbm,
+                      uint8_t sf,
+                      Time duration,
+                      double frequency) const;
 
     /**
      * Compute the received power when transmitting from a point to another one.
@@ -139,7 +145,37 @@ class LoraChannel : public Channel
                       Ptr<MobilityModel> senderMobility,
                       Ptr<MobilityModel> receiverMobility) const;
 
-  private:
+    /**
+     * Get the time from the arrival of a signal to its delivery to a PHY.
+     *
+     * \return The PreambleLockTime attribute.
+     */
+    Time GetPreambleLockTime() const;
+
+  protected:
+    /**
+     * Schedule the start of the reception of a packet at a PHY.
+     *
+     * \param phy The receiving PHY.
+     * \param delay The delay of the delivery: propagation and preamble lock.
+     * \param packet The PHY layer packet.
+     * \param rxPowerDbm The power received by the PHY.
+     * \param sf The SF used by the transmitter.
+     * \param duration The on-air duration of the packet.
+     * \param frequency The frequency of the transmission.
+     * \param down Whether the packet is a downlink (the PHY is an end device).
+     * \param destination The destination of the downlink.
+     */
+    static void ScheduleReception(Ptr<LoraPhy> phy,
+                                  Time delay,
+                                  Ptr<Packet> packet,
+                                  double rxPowerDbm,
+                                  uint8_t sf,
+                                  Time duration,
+                                  double frequency,
+                                  bool down,
+                                  LoraDeviceAddress destination);
+
     /**
      * The vector containing the PHYs that are currently connected to the
      * channel.
@@ -160,6 +196,11 @@ class LoraChannel : public Channel
      */
     Ptr<PropagationDelayModel> m_delay;
 
+    /**
+     * Time from the arrival of a signal to its delivery to PHYs.
+     */
+    Time m_preambleLockTime;
+
     /**
      * Callback for when a packet is being sent on the channel.
      */
@@ -23,8 +23,14 @@
 
 #include "lora-interference-helper.h"
 
+#include "ns3/abort.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+
 namespace ns3
 {
 namespace lorawan
@@ -34,6 +40,35 @@ NS_LOG_COMPONENT_DEFINE("LoraInterferenceHelper");
 
 NS_OBJECT_ENSURE_REGISTERED(LoraInterferenceHelper);
 
+namespace
+{
+/* Events carved from each system allocation */
+constexpr size_t EVENTS_PER_CHUNK = 256;
+
+/* Recycled event memory, linked through the blocks themselves */
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+/* Event memory shared by all helpers of the (single-threaded) simulation */
+struct EventPool
+{
+    FreeBlock* free = nullptr;       //!< Head of the free list
+    bool enabled = true;             //!< Whether events are taken from the free list
+    uint64_t nLive = 0;              //!< Events currently allocated
+    uint64_t nSystemAllocations = 0; //!< Requests to the system allocator
+};
+
+/* Never destroyed: events may be released during static destruction */
+EventPool&
+GetEventPool()
+{
+    static auto pool = new EventPool;
+    return *pool;
+}
+} // namespace
+
 /***************************************
  *    Event    *
  ***************************************/
@@ -43,13 +78,16 @@ LoraInterferenceHelper::Event::Event(Time duration,
                                      double rxPowerdBm,
                                      uint8_t spreadingFactor,
                                      Ptr<Packet> packet,
-                                     double frequency)
-    : m_startTime(Simulator::Now()),
+                                     double frequency,
+                                     Time elapsed)
+    : m_startTime(Simulator::Now() - elapsed),
       m_endTime(m_startTime + duration),
       m_sf(spreadingFactor),
       m_rxPowerdBm(rxPowerdBm),
+      m_rxPowerW(pow(10, rxPowerdBm / 10) / 1000),
       m_packet(packet),
-      m_frequencyHz(frequency)
+      m_frequencyHz(frequency),
+      m_receptionPath(-1)
 {
 }
 
@@ -83,6 +121,12 @@ LoraInterferenceHelper::Event::GetRxPowerdBm() const
     return m_rxPowerdBm;
 }
 
+double
+LoraInterferenceHelper::Event::GetRxPowerW() const
+{
+    return m_rxPowerW;
+}
+
 uint8_t
 LoraInterferenceHelper::Event::GetSpreadingFactor() const
 {
@@ -101,6 +145,18 @@ LoraInterferenceHelper::Event::GetFrequency() const
     return m_frequencyHz;
 }
 
+void
+LoraInterferenceHelper::Event::SetReceptionPath(int32_t path)
+{
+    m_receptionPath = path;
+}
+
+int32_t
+LoraInterferenceHelper::Event::GetReceptionPath() const
+{
+    return m_receptionPath;
+}
+
 void
 LoraInterferenceHelper::Event::Print(std::ostream& stream) const
 {
@@ -115,6 +171,74 @@ operator<<(std::ostream& os, const LoraInterferenceHelper::Event& event)
     return os;
 }
 
+void*
+LoraInterferenceHelper::Event::operator new(size_t size)
+{
+    EventPool& pool = GetEventPool();
+    if (size != sizeof(Event))
+    {
+        return ::operator new(size);
+    }
+    pool.nLive++;
+    if (!pool.enabled)
+    {
+        pool.nSystemAllocations++;
+        return ::operator new(size);
+    }
+    if (!pool.free)
+    {
+        // Chain a new chunk of blocks in address order
+        static_assert(sizeof(Event) >= sizeof(FreeBlock), "Events can not hold a free list");
+        auto chunk = static_cast<char*>(::operator new(EVENTS_PER_CHUNK * sizeof(Event)));
+        pool.nSystemAllocations++;
+        for (size_t i = EVENTS_PER_CHUNK; i-- > 0;)
+        {
+            auto block = reinterpret_cast<FreeBlock*>(chunk + i * sizeof(Event));
+            block->next = pool.free;
+            pool.free = block;
+        }
+    }
+    FreeBlock* block = pool.free;
+    pool.free = block->next;
+    return block;
+}
+
+void
+LoraInterferenceHelper::Event::operator delete(void* block, size_t size)
+{
+    if (size != sizeof(Event))
+    {
+        ::operator delete(block);
+        return;
+    }
+    EventPool& pool = GetEventPool();
+    pool.nLive--;
+    if (!pool.enabled)
+    {
+        ::operator delete(block);
+        return;
+    }
+    // Blocks are recycled whatever their origin, chunks are never returned
+    auto freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = pool.free;
+    pool.free = freeBlock;
+}
+
+void
+LoraInterferenceHelper::Event::SetPooling(bool enable)
+{
+    EventPool& pool = GetEventPool();
+    NS_ABORT_MSG_IF(pool.enabled && !enable && pool.nLive > 0,
+                    "Pooling can not be disabled while events are allocated");
+    pool.enabled = enable;
+}
+
+uint64_t
+LoraInterferenceHelper::Event::GetNSystemAllocations()
+{
+    return GetEventPool().nSystemAllocations;
+}
+
 /****************************
  *  LoraInterferenceHelper  *
  ****************************/
@@ -143,7 +267,11 @@ LoraInterferenceHelper::GetTypeId()
 }
 
 LoraInterferenceHelper::LoraInterferenceHelper()
-    : m_isolationMatrix(CROCE)
+    : m_nEvents(0),
+      m_firstEnd(std::numeric_limits<int64_t>::max()),
+      m_nextOrder(0),
+      m_isolationMatrix(CROCE),
+      m_isolationLinear{}
 {
     NS_LOG_FUNCTION(this);
 }
@@ -158,92 +286,94 @@ LoraInterferenceHelper::Add(Time duration,
                             double rxPower,
                             uint8_t spreadingFactor,
                             Ptr<Packet> packet,
-                            double frequency)
+                            double frequency,
+                            Time elapsed)
 {
     NS_LOG_FUNCTION(this << duration.GetSeconds() << rxPower << unsigned(spreadingFactor) << packet
-                         << frequency);
+                         << frequency << elapsed);
     // Create an event based on the parameters
-    auto event = Create<Event>(duration, rxPower, spreadingFactor, packet, frequency);
-    // Add the event to the list
-    m_events.push_back(event);
-    // Clean the event list
-    if (m_events.size() > 100)
+    auto event = Create<Event>(duration, rxPower, spreadingFactor, packet, frequency, elapsed);
+    // Add the event to the arrays of its channel
+    ChannelEvents& channel = m_events[frequency];
+    channel.start.push_back(event->GetStartTime().GetTimeStep());
+    channel.end.push_back(event->GetEndTime().GetTimeStep());
+    channel.rxPowerW.push_back(event->GetRxPowerW());
+    channel.sfIndex.push_back(spreadingFactor - 7);
+    channel.order.push_back(m_nextOrder++);
+    channel.events.push_back(event);
+    m_firstEnd = std::min(m_firstEnd, channel.end.back());
+    // Clean the event list, once the earliest event is old
+    if (++m_nEvents > 100 &&
+        m_firstEnd < (Simulator::Now() - m_oldEventThreshold).GetTimeStep())
     {
         CleanOldEvents();
     }
     return event;
 }
 
-uint8_t
-LoraInterferenceHelper::IsDestroyedByInterference(Ptr<Event> event)
+void
+LoraInterferenceHelper::AccumulateInterference(const ChannelEvents& channel,
+                                               Ptr<Event> event,
+                                               std::array<double, 6>& energy)
 {
     NS_LOG_FUNCTION(this << event);
-    // We want to see the interference affecting this event: cycle through events
-    // that overlap with this one and see whether it survives the interference or
-    // not.
-    NS_LOG_INFO("Current number of events in LoraInterferenceHelper: " << m_events.size());
-    // Gather information about the event
-    double rxPowerDbm = event->GetRxPowerdBm();
-    uint8_t sf = event->GetSpreadingFactor();
-    double frequency = event->GetFrequency();
-    // Handy information about the time frame when the packet was received
-    Time now = Simulator::Now();
-    Time duration = event->GetDuration();
-    Time packetStartTime = now - duration;
-    // Energy for interferers of various SFs
-    std::vector<double> cumulativeInterferenceEnergy(6, 0);
-    // Cycle over the events
-    for (auto& interferer : m_events)
+    size_t n = channel.events.size();
+    int64_t start = event->GetStartTime().GetTimeStep();
+    int64_t end = event->GetEndTime().GetTimeStep();
+    // Overlap-weighted energy of each event, branch-free so that it vectorizes
+    m_energy.resize(n);
+    const int64_t* s = channel.start.data();
+    const int64_t* e = channel.end.data();
+    const double* p = channel.rxPowerW.data();
+    double* w = m_energy.data();
+    for (size_t i = 0; i < n; ++i)
     {
-        // Only consider the current event if the channel is the same: we
-        // assume there's no interchannel interference. Also skip the current
-        // event if it's the same that we want to analyze.
-        if (!(interferer->GetFrequency() == frequency) || interferer == event)
+        int64_t overlap = std::min(e[i], end) - std::max(s[i], start);
+        w[i] = double(std::max(overlap, int64_t(0))) * p[i];
+    }
+    // Sum per SF in arrival order, skipping the event itself
+    const uint8_t* sf = channel.sfIndex.data();
+    for (size_t i = 0; i < n; ++i)
+    {
+        double contribution = (channel.events[i] == event) ? 0.0 : w[i];
+        for (uint8_t j = 0; j < 6; ++j)
         {
-            NS_LOG_DEBUG("Different channel or same event");
-            continue; // Continues from the first line inside the for cycle
+            energy[j] += (sf[i] == j) ? contribution : 0.0;
         }
-        NS_LOG_DEBUG("Interferer on same channel");
-        // Gather information about this interferer
-        uint8_t interfererSf = interferer->GetSpreadingFactor();
-        double interfererPower = interferer->GetRxPowerdBm();
-        Time interfererStartTime = interferer->GetStartTime();
-        Time interfererEndTime = interferer->GetEndTime();
-        NS_LOG_INFO("Found an interferer: sf = " << unsigned(interfererSf)
-                                                 << ", power = " << interfererPower
-                                                 << ", start time = " << interfererStartTime
-                                                 << ", end time = " << interfererEndTime);
-        // Compute the fraction of time the two events are overlapping
-        Time overlap = GetOverlapTime(event, interferer);
-        NS_LOG_DEBUG("The two events overlap for " << overlap.GetSeconds() << " s.");
-        // Compute the equivalent energy of the interference
-        // Power [mW] = 10^(Power[dBm]/10)
-        // Power [W] = Power [mW] / 1000
-        double interfererPowerW = pow(10, interfererPower / 10) / 1000;
-        // Energy [J] = Time [s] * Power [W]
-        double interferenceEnergy = overlap.GetSeconds() * interfererPowerW;
-        cumulativeInterferenceEnergy.at(unsigned(interfererSf) - 7) += interferenceEnergy;
-        NS_LOG_DEBUG("Interferer power in W: " << interfererPowerW);
-        NS_LOG_DEBUG("Interference energy: " << interferenceEnergy);
     }
+}
+
+uint8_t
+LoraInterferenceHelper::IsDestroyedByInterference(Ptr<Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+    // We want to see the interference affecting this event: sum the energy of
+    // the events overlapping with this one, per SF, and see whether it
+    // survives the interference or not.
+    NS_LOG_INFO("Current number of events in LoraInterferenceHelper: " << m_nEvents);
+    // Energy for interferers of various SFs. We assume there's no
+    // interchannel interference: only events on the same channel count.
+    std::array<double, 6> cumulativeInterferenceEnergy{};
+    auto it = m_events.find(event->GetFrequency());
+    if (it != m_events.end())
+    {
+        AccumulateInterference(it->second, event, cumulativeInterferenceEnergy);
+    }
+    // Energy [W * time step] = Time [time step] * Power [W]
+    double signalEnergy = double(event->GetDuration().GetTimeStep()) * event->GetRxPowerW();
+    NS_LOG_DEBUG("Signal energy: " << signalEnergy);
+    unsigned sf = unsigned(event->GetSpreadingFactor()) - 7;
     // For each SF, check if there was destructive interference
     for (uint8_t currentSf = 7; currentSf <= 12; ++currentSf)
     {
-        NS_LOG_DEBUG("Cumulative Interference Energy: "
-                     << cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
-        // Use the computed cumulativeInterferenceEnergy to determine whether the
-        // interference with this SF destroys the packet
-        double signalPowerW = pow(10, rxPowerDbm / 10) / 1000;
-        double signalEnergy = duration.GetSeconds() * signalPowerW;
-        NS_LOG_DEBUG("Signal power in W: " << signalPowerW);
-        NS_LOG_DEBUG("Signal energy: " << signalEnergy);
-        // Check whether the packet survives the interference of this SF
-        double sirIsolation = m_isolationMatrix[unsigned(sf) - 7][unsigned(currentSf) - 7];
-        NS_LOG_DEBUG("The needed isolation to survive is " << sirIsolation << " dB");
-        double sir =
-            10 * log10(signalEnergy / cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
-        NS_LOG_DEBUG("The current SIR is " << sir << " dB");
-        if (sir >= sirIsolation)
+        unsigned j = unsigned(currentSf) - 7;
+        NS_LOG_DEBUG("Cumulative Interference Energy: " << cumulativeInterferenceEnergy[j]);
+        // Check whether the packet survives the interference of this SF, in
+        // the linear domain: 10 log10(ratio) >= isolation [dB]
+        NS_LOG_DEBUG("The needed isolation to survive is " << m_isolationMatrix[sf][j] << " dB");
+        double ratio = signalEnergy / cumulativeInterferenceEnergy[j];
+        NS_LOG_DEBUG("The current SIR is " << 10 * log10(ratio) << " dB");
+        if (ratio >= m_isolationLinear[sf][j])
         {
             // Move on and check the rest of the interferers
             NS_LOG_DEBUG("Packet survived interference with SF " << unsigned(currentSf));
@@ -263,7 +393,25 @@ LoraInterferenceHelper::IsDestroyedByInterference(Ptr<Event> event)
 std::list<Ptr<LoraInterferenceHelper::Event>>
 LoraInterferenceHelper::GetInterferers()
 {
-    return m_events;
+    // Merge the channels back in arrival order
+    std::vector<std::pair<uint64_t, Ptr<Event>>> events;
+    events.reserve(m_nEvents);
+    for (const auto& [frequency, channel] : m_events)
+    {
+        for (size_t i = 0; i < channel.events.size(); ++i)
+        {
+            events.emplace_back(channel.order[i], channel.events[i]);
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    std::list<Ptr<Event>> interferers;
+    for (const auto& e : events)
+    {
+        interferers.push_back(e.second);
+    }
+    return interferers;
 }
 
 void
@@ -271,7 +419,7 @@ LoraInterferenceHelper::PrintEvents(std::ostream& stream)
 {
     NS_LOG_FUNCTION_NOARGS();
     stream << "Currently registered events:" << std::endl;
-    for (const auto& e : m_events)
+    for (const auto& e : GetInterferers())
     {
         stream << e << std::endl;
     }
@@ -318,6 +466,8 @@ LoraInterferenceHelper::ClearAllEvents()
 {
     NS_LOG_FUNCTION_NOARGS();
     m_events.clear();
+    m_nEvents = 0;
+    m_firstEnd = std::numeric_limits<int64_t>::max();
 }
 
 void
@@ -325,6 +475,8 @@ LoraInterferenceHelper::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_events.clear();
+    m_nEvents = 0;
+    m_firstEnd = std::numeric_limits<int64_t>::max();
     Object::DoDispose();
 }
 
@@ -332,11 +484,37 @@ void
 LoraInterferenceHelper::CleanOldEvents()
 {
     NS_LOG_FUNCTION(this);
-    // Cycle the events, and clean up if an event is old.
-    Time now = Simulator::Now();
-    Time threshold = m_oldEventThreshold;
-    auto isOld = [&now, &threshold](Ptr<Event> e) { return e->GetEndTime() + threshold < now; };
-    m_events.remove_if(isOld);
+    // Cycle the events, and clean up if an event is old. The arrays of each
+    // channel are compacted in place, keeping the arrival order.
+    int64_t limit = (Simulator::Now() - m_oldEventThreshold).GetTimeStep();
+    m_nEvents = 0;
+    m_firstEnd = std::numeric_limits<int64_t>::max();
+    for (auto& [frequency, channel] : m_events)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < channel.events.size(); ++i)
+        {
+            if (channel.end[i] < limit)
+            {
+                continue;
+            }
+            channel.start[kept] = channel.start[i];
+            channel.end[kept] = channel.end[i];
+            channel.rxPowerW[kept] = channel.rxPowerW[i];
+            channel.sfIndex[kept] = channel.sfIndex[i];
+            channel.order[kept] = channel.order[i];
+            channel.events[kept] = channel.events[i];
+            m_firstEnd = std::min(m_firstEnd, channel.end[i]);
+            kept++;
+        }
+        channel.start.resize(kept);
+        channel.end.resize(kept);
+        channel.rxPowerW.resize(kept);
+        channel.sfIndex.resize(kept);
+        channel.order.resize(kept);
+        channel.events.resize(kept);
+        m_nEvents += kept;
+    }
 }
 
 void
@@ -357,6 +535,14 @@ LoraInterferenceHelper::SetIsolationMatrix(IsolationMatrix matrix)
         m_isolationMatrix = LoraInterferenceHelper::m_CROCE;
         break;
     }
+    // Minimum energy ratios. The infinite isolations of ALOHA become inf and 0.
+    for (size_t i = 0; i < 6; ++i)
+    {
+        for (size_t j = 0; j < 6; ++j)
+        {
+            m_isolationLinear[i][j] = pow(10, m_isolationMatrix[i][j] / 10);
+        }
+    }
 }
 
 void
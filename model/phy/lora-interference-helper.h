@@ -29,6 +29,9 @@
 #include "ns3/object.h"
 #include "ns3/packet.h"
 
+#include <array>
+#include <map>
+
 namespace ns3
 {
 namespace lorawan
@@ -59,7 +62,8 @@ class LoraInterferenceHelper : public Object
               double rxPowerdBm,
               uint8_t spreadingFactor,
               Ptr<Packet> packet,
-              double frequency);
+              double frequency,
+              Time elapsed = Seconds(0));
         ~Event();
 
         /**
@@ -82,6 +86,11 @@ class LoraInterferenceHelper : public Object
          */
         double GetRxPowerdBm() const;
 
+        /**
+         * Get the power of the event in W.
+         */
+        double GetRxPowerW() const;
+
         /**
          * Get the spreading factor used by this signal.
          */
@@ -97,11 +106,52 @@ class LoraInterferenceHelper : public Object
          */
         double GetFrequency() const;
 
+        /**
+         * Set the index of the receiver locked on this event, if any.
+         *
+         * Used by PHYs with several receivers to find the receiver back on
+         * reception end.
+         */
+        void SetReceptionPath(int32_t path);
+
+        /**
+         * Get the index of the receiver locked on this event.
+         *
+         * \return The index, or -1 if no receiver is locked on the event.
+         */
+        int32_t GetReceptionPath() const;
+
         /**
          * Print the current event in a human readable form.
          */
         void Print(std::ostream& stream) const;
 
+        /**
+         * Allocate an event from the free list of recycled events, refilled
+         * by chunks of events when empty.
+         */
+        static void* operator new(size_t size);
+
+        /**
+         * Put the memory of an event back in the free list, or release it to
+         * the system when recycling is disabled.
+         */
+        static void operator delete(void* block, size_t size);
+
+        /**
+         * Enable or disable the recycling of event memory (enabled by default).
+         *
+         * When disabled, each event is a request to the system allocator, as
+         * a reference to measure the effect of recycling. Recycling can only
+         * be disabled while no event is allocated.
+         */
+        static void SetPooling(bool enable);
+
+        /**
+         * Get the number of requests made to the system allocator for events.
+         */
+        static uint64_t GetNSystemAllocations();
+
       private:
         /**
          * The time this signal begins (at the device).
@@ -123,6 +173,11 @@ class LoraInterferenceHelper : public Object
          */
         double m_rxPowerdBm;
 
+        /**
+         * The power of this event in W (at the device), computed once.
+         */
+        double m_rxPowerW;
+
         /**
          * The packet this event was generated for.
          */
@@ -132,6 +187,11 @@ class LoraInterferenceHelper : public Object
          * The frequency this event was on.
          */
         double m_frequencyHz;
+
+        /**
+         * The index of the receiver locked on this event, or -1.
+         */
+        int32_t m_receptionPath;
     };
 
     enum IsolationMatrix
@@ -155,6 +215,7 @@ class LoraInterferenceHelper : public Object
      * \param spreadingFactor the spreading factor used by the transmission.
      * \param packet The packet carried by this transmission.
      * \param frequency The frequency this event was sent at.
+     * \param elapsed The time since the signal started (e.g., at preamble lock).
      *
      * \return the newly created event
      */
@@ -162,7 +223,8 @@ class LoraInterferenceHelper : public Object
                    double rxPower,
                    uint8_t spreadingFactor,
                    Ptr<Packet> packet,
-                   double frequency);
+                   double frequency,
+                   Time elapsed = Seconds(0));
 
     /**
      * Determine whether the event was destroyed by interference or not. This is
@@ -211,7 +273,34 @@ class LoraInterferenceHelper : public Object
 
   private:
     /**
-     * Delete old events in this LoraInterferenceHelper.
+     * The events on a channel, as parallel arrays in order of arrival.
+     */
+    struct ChannelEvents
+    {
+        std::vector<int64_t> start;     //!< Start times [time steps]
+        std::vector<int64_t> end;       //!< End times [time steps]
+        std::vector<double> rxPowerW;   //!< Received powers [W]
+        std::vector<uint8_t> sfIndex;   //!< Spreading factors, minus 7
+        std::vector<uint64_t> order;    //!< Arrival order among all channels
+        std::vector<Ptr<Event>> events; //!< The events
+    };
+
+    /**
+     * Accumulate the energy of the interferers of an event, per spreading factor.
+     *
+     * Interferers are the events of the channel overlapping with the event,
+     * except the event itself. Energies are in W per time step.
+     *
+     * \param channel The events on the channel of the event.
+     * \param event The event.
+     * \param energy The cumulative energy of interferers, per spreading factor minus 7.
+     */
+    void AccumulateInterference(const ChannelEvents& channel,
+                                Ptr<Event> event,
+                                std::array<double, 6>& energy);
+
+    /**
+     * Delete old events in this LoraInterferenceHelper, recycling them.
      */
     void CleanOldEvents();
 
@@ -221,15 +310,40 @@ class LoraInterferenceHelper : public Object
     void SetIsolationMatrixAttribute(EnumValue matrix);
 
     /**
-     * A list of the events this LoraInterferenceHelper is keeping track of.
+     * The events this LoraInterferenceHelper is keeping track of, by frequency.
+     */
+    std::map<double, ChannelEvents> m_events;
+
+    /**
+     * The number of events in m_events.
+     */
+    size_t m_nEvents;
+
+    /**
+     * The earliest end time of the events in m_events [time steps].
+     */
+    int64_t m_firstEnd;
+
+    /**
+     * The arrival order of the next event.
      */
-    std::list<Ptr<Event>> m_events;
+    uint64_t m_nextOrder;
+
+    /**
+     * Overlap-weighted energy of the events of a channel, reused across calls.
+     */
+    std::vector<double> m_energy;
 
     /**
      * The SIR matrix used to determine if packets survive interference.
      */
     sirMatrix_t m_isolationMatrix;
 
+    /**
+     * The SIR matrix in the linear domain, i.e., minimum energy ratios.
+     */
+    std::array<std::array<double, 6>, 6> m_isolationLinear;
+
     /**
      * The threshold after which an event is considered old and removed from the
      * list.
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef LORA_PHY_MATH_H
+#define LORA_PHY_MATH_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Arithmetic of the LoRa modulation, without packets or simulator types.
+ *
+ * Everything but the SNR conversion is constexpr. The number of payload
+ * symbols of a frame is tabulated at compile time for SF7 to SF12, all coding
+ * rates, header and CRC modes, low data rate optimization and all payload
+ * sizes, as the bandwidth only enters the time on air through the symbol
+ * time. Counts are computed on integers, and are exactly those of the
+ * floating point formula of the SX1272 LoRa modem designer's guide.
+ */
+class LoraPhyMath
+{
+  public:
+    static constexpr uint8_t MIN_SF = 7;              //!< Lowest tabulated spreading factor
+    static constexpr uint8_t MAX_SF = 12;             //!< Highest tabulated spreading factor
+    static constexpr uint8_t N_SF = 6;                //!< Number of tabulated spreading factors
+    static constexpr uint8_t N_CODING_RATES = 4;      //!< Coding rates 4/5 to 4/8
+    static constexpr uint32_t MAX_PAYLOAD_SIZE = 255; //!< Largest tabulated payload [B]
+    static constexpr double NOISE_FIGURE = 6;         //!< Noise figure of receivers [dB]
+    static constexpr double MAX_SYMBOL_TIME = 0.016;  //!< Longest symbol without LDRO [s]
+
+    /**
+     * Uplink sensitivity of gateways at 125 kHz (source: SX1301 datasheet)
+     * [dBm], from SF7 to SF12.
+     */
+    static constexpr double GATEWAY_SENSITIVITY[N_SF] =
+        {-126.5, -129, -131.5, -134, -136.5, -139.5};
+
+    /**
+     * Downlink sensitivity of end devices at 125 kHz (source: SX1272
+     * datasheet) [dBm], from SF7 to SF12.
+     */
+    static constexpr double END_DEVICE_SENSITIVITY[N_SF] = {-124, -127, -130, -133, -135, -137};
+
+    /**
+     * Compute the duration of a symbol.
+     *
+     * \param sf The spreading factor.
+     * \param bandwidthHz The bandwidth [Hz].
+     * \return The symbol time [s].
+     */
+    static constexpr double GetSymbolTime(uint8_t sf, double bandwidthHz)
+    {
+        return double(uint64_t(1) << sf) / bandwidthHz;
+    }
+
+    /**
+     * Whether the low data rate optimization is mandated, that is, whether
+     * symbols last more than 16 ms.
+     *
+     * \param sf The spreading factor.
+     * \param bandwidthHz The bandwidth [Hz].
+     */
+    static constexpr bool NeedsLowDataRateOptimization(uint8_t sf, double bandwidthHz)
+    {
+        return GetSymbolTime(sf, bandwidthHz) > MAX_SYMBOL_TIME;
+    }
+
+    /**
+     * Compute the number of symbols of the payload of a frame, header and
+     * CRC included but preamble excluded.
+     *
+     * \param sf The spreading factor.
+     * \param codingRate The coding rate (4/(codingRate+4)).
+     * \param size The size of the PHY payload [B].
+     * \param crcEnabled Whether the CRC is sent.
+     * \param headerDisabled Whether the header is implicit.
+     * \param lowDataRateOptimization Whether the low data rate optimization is enabled.
+     * \return The number of symbols.
+     */
+    static constexpr uint32_t ComputePayloadSymbols(uint8_t sf,
+                                                    uint8_t codingRate,
+                                                    uint32_t size,
+                                                    bool crcEnabled,
+                                                    bool headerDisabled,
+                                                    bool lowDataRateOptimization)
+    {
+        int64_t num = 8 * int64_t(size) - 4 * sf + 28 + 16 * crcEnabled - 20 * headerDisabled;
+        int64_t den = 4 * (sf - 2 * lowDataRateOptimization);
+        int64_t blocks = (num > 0) ? (num + den - 1) / den : -(-num / den);
+        return 8 + uint32_t(std::max<int64_t>(blocks * (codingRate + 4), 0));
+    }
+
+    /**
+     * Get the number of symbols of the payload of a frame, from the table
+     * when the parameters are tabulated.
+     *
+     * \copydetails ComputePayloadSymbols
+     */
+    static constexpr uint32_t GetPayloadSymbols(uint8_t sf,
+                                                uint8_t codingRate,
+                                                uint32_t size,
+                                                bool crcEnabled,
+                                                bool headerDisabled,
+                                                bool lowDataRateOptimization);
+
+    /**
+     * Convert the power of a received signal into its SNR, ignoring
+     * interference.
+     *
+     * \param rxPowerDbm The received power [dBm].
+     * \param bandwidthHz The bandwidth [Hz].
+     * \return The SNR [dB].
+     */
+    static double RxPowerToSnr(double rxPowerDbm, double bandwidthHz = 125000)
+    {
+        return rxPowerDbm + 174 - 10 * log10(bandwidthHz) - NOISE_FIGURE;
+    }
+
+    /**
+     * Get the spreading factor of the 125 kHz data rates of the EU868
+     * region (DR0 to DR5).
+     *
+     * \param dataRate The data rate.
+     * \return The spreading factor, or 0 if the data rate is not one of them.
+     */
+    static constexpr uint8_t GetSfFromDataRate(uint8_t dataRate)
+    {
+        return (dataRate <= MAX_SF - MIN_SF) ? MAX_SF - dataRate : 0;
+    }
+
+    /**
+     * Get the data rate of a spreading factor at 125 kHz in the EU868 region.
+     *
+     * \param sf The spreading factor.
+     * \return The data rate, or 0xff if the spreading factor is not one of them.
+     */
+    static constexpr uint8_t GetDataRateFromSf(uint8_t sf)
+    {
+        return (sf >= MIN_SF && sf <= MAX_SF) ? MAX_SF - sf : 0xff;
+    }
+
+    /**
+     * Number of entries of the payload symbols table.
+     */
+    static constexpr uint32_t N_PAYLOAD_SYMBOLS =
+        N_SF * N_CODING_RATES * 8 * (MAX_PAYLOAD_SIZE + 1);
+
+    /**
+     * Number of payload symbols, by SF, coding rate, flags (CRC, implicit
+     * header, LDRO) and size.
+     */
+    static const std::array<uint16_t, N_PAYLOAD_SYMBOLS> PAYLOAD_SYMBOLS;
+
+  private:
+    /**
+     * Get the position of a set of parameters in the payload symbols table.
+     */
+    static constexpr uint32_t GetTableIndex(uint8_t sf,
+                                            uint8_t codingRate,
+                                            uint32_t size,
+                                            bool crcEnabled,
+                                            bool headerDisabled,
+                                            bool lowDataRateOptimization)
+    {
+        uint32_t flags = crcEnabled | headerDisabled << 1 | lowDataRateOptimization << 2;
+        return (((sf - MIN_SF) * N_CODING_RATES + codingRate - 1) * 8 + flags) *
+                   (MAX_PAYLOAD_SIZE + 1) +
+               size;
+    }
+
+    /**
+     * Fill the payload symbols table.
+     */
+    static constexpr std::array<uint16_t, N_PAYLOAD_SYMBOLS> BuildPayloadSymbols()
+    {
+        std::array<uint16_t, N_PAYLOAD_SYMBOLS> table{};
+        for (uint8_t sf = MIN_SF; sf <= MAX_SF; ++sf)
+        {
+            for (uint8_t cr = 1; cr <= N_CODING_RATES; ++cr)
+            {
+                for (uint8_t flags = 0; flags < 8; ++flags)
+                {
+                    for (uint32_t size = 0; size <= MAX_PAYLOAD_SIZE; ++size)
+                    {
+                        bool crc = flags & 1;
+                        bool implicit = flags & 2;
+                        bool ldro = flags & 4;
+                        table[GetTableIndex(sf, cr, size, crc, implicit, ldro)] =
+                            uint16_t(ComputePayloadSymbols(sf, cr, size, crc, implicit, ldro));
+                    }
+                }
+            }
+        }
+        return table;
+    }
+};
+
+inline constexpr std::array<uint16_t, LoraPhyMath::N_PAYLOAD_SYMBOLS> LoraPhyMath::PAYLOAD_SYMBOLS =
+    LoraPhyMath::BuildPayloadSymbols();
+
+constexpr uint32_t
+LoraPhyMath::GetPayloadSymbols(uint8_t sf,
+                               uint8_t codingRate,
+                               uint32_t size,
+                               bool crcEnabled,
+                               bool headerDisabled,
+                               bool lowDataRateOptimization)
+{
+    if (sf < MIN_SF || sf > MAX_SF || codingRate < 1 || codingRate > N_CODING_RATES ||
+        size > MAX_PAYLOAD_SIZE)
+    {
+        return ComputePayloadSymbols(sf,
+                                     codingRate,
+                                     size,
+                                     crcEnabled,
+                                     headerDisabled,
+                                     lowDataRateOptimization);
+    }
+    return PAYLOAD_SYMBOLS[GetTableIndex(sf,
+                                         codingRate,
+                                         size,
+                                         crcEnabled,
+                                         headerDisabled,
+                                         lowDataRateOptimization)];
+}
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_PHY_MATH_H */
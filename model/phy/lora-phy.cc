@@ -25,8 +25,6 @@
 
 #include "ns3/node.h"
 
-#define NOISE_FIGURE 6 //! Noise Figure (dB)
-
 namespace ns3
 {
 namespace lorawan
@@ -220,13 +218,20 @@ Time
 LoraPhy::GetTSym(const LoraPhyTxParameters& txParams)
 {
     NS_LOG_FUNCTION(txParams);
-    return Seconds(pow(2, int(txParams.sf)) / (txParams.bandwidthHz));
+    return Seconds(LoraPhyMath::GetSymbolTime(txParams.sf, txParams.bandwidthHz));
 }
 
 Time
 LoraPhy::GetTimeOnAir(Ptr<const Packet> packet, const LoraPhyTxParameters& txParams)
 {
     NS_LOG_FUNCTION(packet << txParams);
+    return GetTimeOnAir(packet->GetSize(), txParams);
+}
+
+Time
+LoraPhy::GetTimeOnAir(uint32_t size, const LoraPhyTxParameters& txParams)
+{
+    NS_LOG_FUNCTION(size << txParams);
 
     // The contents of this function are based on [1].
     // [1] SX1272 LoRa modem designer's guide.
@@ -237,28 +242,19 @@ LoraPhy::GetTimeOnAir(Ptr<const Packet> packet, const LoraPhyTxParameters& txPar
     // Compute the preamble duration
     Time tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
 
-    // Payload size
-    uint32_t pl = packet->GetSize(); // Size in bytes
-    NS_LOG_DEBUG("Packet of size " << pl << " bytes");
-
-    // This step is needed since the formula deals with double values.
-    // de = 1 when the low data rate optimization is enabled, 0 otherwise
-    // h = 1 when header is implicit, 0 otherwise
-    double de = txParams.lowDataRateOptimizationEnabled ? 1 : 0;
-    double h = txParams.headerDisabled ? 1 : 0;
-    double crc = txParams.crcEnabled ? 1 : 0;
-
-    // num and den refer to numerator and denominator of the time on air formula
-    double num = 8 * pl - 4 * txParams.sf + 28 + 16 * crc - 20 * h;
-    double den = 4 * (txParams.sf - 2 * de);
-    double payloadSymbNb =
-        8 + std::max(std::ceil(num / den) * (txParams.codingRate + 4), double(0));
+    // Number of payload symbols, tabulated for the usual parameters
+    double payloadSymbNb = LoraPhyMath::GetPayloadSymbols(txParams.sf,
+                                                          txParams.codingRate,
+                                                          size,
+                                                          txParams.crcEnabled,
+                                                          txParams.headerDisabled,
+                                                          txParams.lowDataRateOptimizationEnabled);
 
     // Time to transmit the payload
     Time tPayload = payloadSymbNb * tSym;
 
-    NS_LOG_DEBUG("Time computation: num = " << num << ", den = " << den << ", payloadSymbNb = "
-                                            << payloadSymbNb << ", tSym = " << tSym);
+    NS_LOG_DEBUG("Time computation: size = " << size << ", payloadSymbNb = " << payloadSymbNb
+                                             << ", tSym = " << tSym);
     NS_LOG_DEBUG("tPreamble = " << tPreamble);
     NS_LOG_DEBUG("tPayload = " << tPayload);
     NS_LOG_DEBUG("Total time = " << tPreamble + tPayload);
@@ -272,7 +268,7 @@ LoraPhy::RxPowerToSNR(double transmissionPower, double bandwidth)
 {
     NS_LOG_FUNCTION(transmissionPower);
     // The following conversion ignores interfering packets
-    return transmissionPower + 174 - 10 * log10(bandwidth) - NOISE_FIGURE;
+    return LoraPhyMath::RxPowerToSnr(transmissionPower, bandwidth);
 }
 
 std::ostream&
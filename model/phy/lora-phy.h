@@ -26,6 +26,7 @@
 
 #include "ns3/lora-channel.h"
 #include "ns3/lora-interference-helper.h"
+#include "ns3/lora-phy-math.h"
 #include "ns3/mobility-model.h"
 #include "ns3/net-device.h"
 
@@ -241,6 +242,16 @@ class LoraPhy : public Object
      */
     static Time GetTimeOnAir(Ptr<const Packet> packet, const LoraPhyTxParameters& txParams);
 
+    /**
+     * Compute the time that a payload of a given size will take to be
+     * transmitted, without the need for a packet.
+     *
+     * \param size The size of the PHY payload [B].
+     * \param txParams The set of parameters that will be used for transmission.
+     * \return The time necessary to transmit the payload.
+     */
+    static Time GetTimeOnAir(uint32_t size, const LoraPhyTxParameters& txParams);
+
     /**
      * Compute the Signal to Noise Ratio (SNR) from the transmission power
      * measured at packet reception.
@@ -85,6 +85,7 @@ LoraRadioEnergyModel::LoraRadioEnergyModel()
     m_lastUpdateTime = Seconds(0.0);
     m_nPendingChangeState = 0;
     m_isSupersededChangeState = false;
+    m_txPowerDbm = 0;
     m_energyDepletionCallback.Nullify();
     m_source = nullptr;
     // set callback for EndDeviceLoraPhy listener
@@ -107,6 +108,12 @@ LoraRadioEnergyModel::SetEnergySource(Ptr<EnergySource> source)
     NS_LOG_FUNCTION(this << source);
     NS_ASSERT(source != nullptr);
     m_source = source;
+    m_analyticSource = DynamicCast<LoraAnalyticEnergySource>(source);
+    if (m_analyticSource)
+    {
+        // The analytic source sums the current changes notified by the models
+        m_analyticSource->NotifyCurrentChange(DoGetCurrentA());
+    }
 }
 
 double
@@ -179,6 +186,18 @@ LoraRadioEnergyModel::GetCurrentState() const
     return m_currentState;
 }
 
+Time
+LoraRadioEnergyModel::GetTimeInState(EndDeviceLoraPhy::State state) const
+{
+    return m_timeInState[state];
+}
+
+const std::map<double, Time>&
+LoraRadioEnergyModel::GetTxTimePerPower() const
+{
+    return m_txTimePerPower;
+}
+
 void
 LoraRadioEnergyModel::SetEnergyDepletionCallback(LoraRadioEnergyDepletionCallback callback)
 {
@@ -210,6 +229,7 @@ LoraRadioEnergyModel::SetTxCurrentModel(Ptr<LoraTxCurrentModel> model)
 void
 LoraRadioEnergyModel::SetTxCurrentFromModel(double txPowerDbm)
 {
+    m_txPowerDbm = txPowerDbm;
     if (m_txCurrentModel)
     {
         m_txCurrentA = m_txCurrentModel->CalcTxCurrent(txPowerDbm);
@@ -248,9 +268,30 @@ LoraRadioEnergyModel::ChangeState(int newState)
     // update total energy consumption
     m_totalEnergyConsumption += energyToDecrease;
 
+    // update time in state
+    m_timeInState[m_currentState] += duration;
+    if (m_currentState == EndDeviceLoraPhy::TX)
+    {
+        m_txTimePerPower[m_txPowerDbm] += duration;
+    }
+
     // update last update time stamp
     m_lastUpdateTime = Simulator::Now();
 
+    if (m_analyticSource)
+    {
+        // The state is set before notifying the source, so that state changes triggered by
+        // the energy depletion callback are applied in order
+        double previousCurrentA = DoGetCurrentA();
+        SetLoraRadioState((EndDeviceLoraPhy::State)newState);
+        double deltaA = DoGetCurrentA() - previousCurrentA;
+        if (deltaA != 0)
+        {
+            m_analyticSource->NotifyCurrentChange(deltaA);
+        }
+        return;
+    }
+
     m_nPendingChangeState++;
 
     // notify energy source
@@ -325,6 +366,7 @@ LoraRadioEnergyModel::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_source = nullptr;
+    m_analyticSource = nullptr;
     m_txCurrentModel = nullptr;
     DeviceEnergyModel::DoDispose();
 }
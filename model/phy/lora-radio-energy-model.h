@@ -20,12 +20,16 @@
 #ifndef LORA_RADIO_ENERGY_MODEL_H
 #define LORA_RADIO_ENERGY_MODEL_H
 
+#include "lora-analytic-energy-source.h"
 #include "lora-tx-current-model.h"
 
 #include "ns3/device-energy-model.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/traced-value.h"
 
+#include <array>
+#include <map>
+
 namespace ns3
 {
 namespace lorawan
@@ -127,6 +131,12 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
  * object. The EnergySource object will query this model for the total current.
  * Then the EnergySource object uses the total current to calculate energy.
  *
+ * With a LoraAnalyticEnergySource, the model only notifies the source of the
+ * change of its current, and the source computes the remaining energy in closed
+ * form, without periodic updates.
+ *
+ * The time spent in each state, and transmitting at each power, is
+ * accumulated in both cases.
  */
 class LoraRadioEnergyModel : public DeviceEnergyModel
 {
@@ -220,6 +230,18 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
      */
     EndDeviceLoraPhy::State GetCurrentState() const;
 
+    /**
+     * \param state A radio state.
+     * \returns Time spent in the state, up to the last state change.
+     */
+    Time GetTimeInState(EndDeviceLoraPhy::State state) const;
+
+    /**
+     * \returns Time spent transmitting, by nominal tx power in dBm, up to the
+     * last state change.
+     */
+    const std::map<double, Time>& GetTxTimePerPower() const;
+
     /**
      * \param callback Callback function.
      *
@@ -322,6 +344,13 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
     uint8_t m_nPendingChangeState;  ///< pending state change
     bool m_isSupersededChangeState; ///< superseded change state
 
+    std::array<Time, 4> m_timeInState;       ///< time spent in each state
+    std::map<double, Time> m_txTimePerPower; ///< time spent transmitting, by tx power
+    double m_txPowerDbm;                     ///< nominal tx power of the last transmission
+
+    /// Energy source notified of current changes only, if analytic
+    Ptr<LoraAnalyticEnergySource> m_analyticSource;
+
     /// Energy depletion callback
     LoraRadioEnergyDepletionCallback m_energyDepletionCallback;
 
@@ -21,11 +21,13 @@
 #include "range-position-allocator.h"
 
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/mobility-module.h"
 #include "ns3/node-container.h"
 #include "ns3/pointer.h"
 #include "ns3/string.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace ns3
@@ -71,13 +73,27 @@ RangePositionAllocator::GetTypeId()
                                           "Random variable to extract z coordinates for positions.",
                                           DoubleValue(0),
                                           MakePointerAccessor(&RangePositionAllocator::m_zrv),
-                                          MakePointerChecker<RandomVariableStream>());
+                                          MakePointerChecker<RandomVariableStream>())
+                            .AddAttribute("Sampler",
+                                          "How candidate positions are drawn: uniformly in the "
+                                          "allocation disc (the same positions for the same "
+                                          "stream), or in the union of the coverage discs (the "
+                                          "same distribution, fewer rejections when the nodes "
+                                          "cover a small part of the disc)",
+                                          EnumValue(RangePositionAllocator::REJECTION),
+                                          MakeEnumAccessor(&RangePositionAllocator::m_sampler),
+                                          MakeEnumChecker(RangePositionAllocator::REJECTION,
+                                                          "REJECTION",
+                                                          RangePositionAllocator::COVERAGE_UNION,
+                                                          "COVERAGE_UNION"));
     return tid;
 }
 
 RangePositionAllocator::RangePositionAllocator()
+    : m_sampler(REJECTION)
 {
     m_rv = CreateObject<UniformRandomVariable>();
+    m_index = CreateObject<lorawan::GatewaySpatialIndex>();
 }
 
 RangePositionAllocator::~RangePositionAllocator()
@@ -123,31 +139,70 @@ RangePositionAllocator::SetZ(Ptr<RandomVariableStream> z)
 void
 RangePositionAllocator::SetNodes(NodeContainer nodes)
 {
-    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
-    {
-        m_nodes.push_back(*i);
-    }
+    m_nodes.Add(nodes);
+    m_index->SetNodes(m_nodes);
 }
 
 bool
 RangePositionAllocator::OutOfRange(double x, double y, double z) const
 {
+    Vector position(x, y, z);
     bool oor = true;
-    for (auto i : m_nodes)
-    {
-        Ptr<MobilityModel> pos = CreateObject<ConstantPositionMobilityModel>();
-        pos->SetPosition(Vector(x, y, z));
-        double dist = i->GetObject<MobilityModel>()->GetDistanceFrom(pos);
+    bool tooClose = false;
+    m_index->ForEachCandidate(x, y, std::max(m_range, 1.0), [&](uint32_t, const Vector& node) {
+        double dist = CalculateDistance(node, position);
 
         if (dist <= 1.0)
-            return true;
+            tooClose = true;
 
         if (dist < m_range)
         {
             oor = false;
         }
+    });
+    return tooClose || oor;
+}
+
+uint32_t
+RangePositionAllocator::CountCovering(double x, double y) const
+{
+    uint32_t count = 0;
+    m_index->ForEachCandidate(x, y, m_range, [&](uint32_t, const Vector& node) {
+        double dx = node.x - x;
+        double dy = node.y - y;
+        count += (std::sqrt(dx * dx + dy * dy) < m_range);
+    });
+    return count;
+}
+
+Vector
+RangePositionAllocator::SampleCoverageUnion(double z) const
+{
+    while (true)
+    {
+        // Uniform position in the horizontal coverage disc of a random node
+        Vector center = m_index->GetPosition(m_rv->GetInteger(0, m_index->GetN() - 1));
+        double r = m_range * std::sqrt(m_rv->GetValue(0, 1));
+        double a = m_rv->GetValue(0, 2 * M_PI);
+        double x = center.x + r * std::cos(a);
+        double y = center.y + r * std::sin(a);
+
+        // Accept once per covering disc: uniform in the union
+        uint32_t count = CountCovering(x, y);
+        if (count == 0 || m_rv->GetValue(0, 1) * count >= 1)
+        {
+            continue;
+        }
+
+        // Apply the constraints of the allocation disc and of the range in 3D
+        double dx = x - m_x;
+        double dy = y - m_y;
+        if (std::sqrt(dx * dx + dy * dy) > m_rho || OutOfRange(x, y, z))
+        {
+            continue;
+        }
+        return Vector(x, y, z);
     }
-    return oor;
 }
 
 Vector
@@ -158,6 +213,12 @@ RangePositionAllocator::GetNext() const
     double z;
 
     z = (bool(m_zrv) == 0) ? m_z : m_zrv->GetValue();
+    if (m_sampler == COVERAGE_UNION && m_nodes.GetN() > 0)
+    {
+        Vector position = SampleCoverageUnion(z);
+        NS_LOG_DEBUG("In-range position x=" << position.x << ", y=" << position.y << ", z=" << z);
+        return position;
+    }
     do
     {
         x = m_rv->GetValue(-m_rho, m_rho);
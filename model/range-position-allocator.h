@@ -21,20 +21,35 @@
 #ifndef RANGE_POSITION_ALLOCATOR_H
 #define RANGE_POSITION_ALLOCATOR_H
 
+#include "ns3/gateway-spatial-index.h"
 #include "ns3/node-container.h"
 #include "ns3/position-allocator.h"
 
 #include <cmath>
+#include <vector>
 
 namespace ns3
 {
 
 /**
  * \brief Produce positions in range of a set of nodes.
+ *
+ * Positions are uniformly distributed over the part of the allocation disc within range of the
+ * nodes. Node positions are kept in a GatewaySpatialIndex, so the range test only visits nearby
+ * nodes.
  */
 class RangePositionAllocator : public PositionAllocator
 {
   public:
+    /**
+     * How candidate positions are drawn
+     */
+    enum Sampler
+    {
+        REJECTION,      //!< Uniformly in the allocation disc, until one is in range
+        COVERAGE_UNION, //!< Uniformly in the union of the coverage discs of the nodes
+    };
+
     static TypeId GetTypeId();
     RangePositionAllocator();
     ~RangePositionAllocator() override;
@@ -80,14 +95,26 @@ class RangePositionAllocator : public PositionAllocator
   private:
     bool OutOfRange(double x, double y, double z) const;
 
-    Ptr<UniformRandomVariable> m_rv; //!< pointer to uniform random variable
-    double m_rho;                    //!< value of the radius of the disc
-    double m_range;                  //!< the max range from any provided nodes
-    double m_x;                      //!< x coordinate of center of disc
-    double m_y;                      //!< y coordinate of center of disc
-    double m_z;                      //!< z coordinate of the disc
-    Ptr<RandomVariableStream> m_zrv; //!< random variable to extract z coordinates
-    std::vector<Ptr<Node>> m_nodes;  //!< the nodes to be in range of
+    /**
+     * Count the nodes whose horizontal distance from a position is below the range.
+     */
+    uint32_t CountCovering(double x, double y) const;
+
+    /**
+     * Draw a position from the union of the coverage discs of the nodes.
+     */
+    Vector SampleCoverageUnion(double z) const;
+
+    Ptr<UniformRandomVariable> m_rv;           //!< pointer to uniform random variable
+    double m_rho;                              //!< value of the radius of the disc
+    double m_range;                            //!< the max range from any provided nodes
+    double m_x;                                //!< x coordinate of center of disc
+    double m_y;                                //!< y coordinate of center of disc
+    double m_z;                                //!< z coordinate of the disc
+    Ptr<RandomVariableStream> m_zrv;           //!< random variable to extract z coordinates
+    NodeContainer m_nodes;                     //!< the nodes to be in range of
+    Ptr<lorawan::GatewaySpatialIndex> m_index; //!< index of the node positions
+    Sampler m_sampler;                         //!< how candidate positions are drawn
 };
 
 } // namespace ns3
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "realtime-lag-monitor.h"
+
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/lora-application.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("RealtimeLagMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED(RealtimeLagMonitor);
+
+TypeId
+RealtimeLagMonitor::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::RealtimeLagMonitor")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<RealtimeLagMonitor>()
+            .AddAttribute("Interval",
+                          "Simulated time between two lag measurements",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&RealtimeLagMonitor::m_interval),
+                          MakeTimeChecker(MilliSeconds(1)))
+            .AddAttribute("ReportInterval",
+                          "Simulated time between two lag reports on standard output (0 to "
+                          "disable)",
+                          TimeValue(Minutes(1)),
+                          MakeTimeAccessor(&RealtimeLagMonitor::m_reportInterval),
+                          MakeTimeChecker(Seconds(0)))
+            .AddAttribute("Threshold",
+                          "Lag above which the configured policy is applied",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&RealtimeLagMonitor::m_threshold),
+                          MakeTimeChecker(Seconds(0)))
+            .AddAttribute("Policy",
+                          "Action taken when the lag exceeds the threshold",
+                          EnumValue(RealtimeLagMonitor::WARN),
+                          MakeEnumAccessor(&RealtimeLagMonitor::m_policy),
+                          MakeEnumChecker(RealtimeLagMonitor::WARN,
+                                          "WARN",
+                                          RealtimeLagMonitor::ABORT,
+                                          "ABORT",
+                                          RealtimeLagMonitor::SHED,
+                                          "SHED"))
+            .AddAttribute("ShedFraction",
+                          "Fraction of the still running applications stopped at each shedding "
+                          "step (SHED policy)",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(&RealtimeLagMonitor::m_shedFraction),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("ShedHoldOff",
+                          "Minimum simulated time between two shedding steps, to let the "
+                          "scheduler drain the backlog (SHED policy)",
+                          TimeValue(Seconds(10)),
+                          MakeTimeAccessor(&RealtimeLagMonitor::m_shedHoldOff),
+                          MakeTimeChecker(Seconds(0)))
+            .AddTraceSource("Lag",
+                            "Lag of the simulated time with respect to wall-clock time",
+                            MakeTraceSourceAccessor(&RealtimeLagMonitor::m_lag),
+                            "ns3::TracedValueCallback::Time")
+            .AddTraceSource("ThresholdExceeded",
+                            "Trace source fired when the measured lag exceeds the threshold",
+                            MakeTraceSourceAccessor(&RealtimeLagMonitor::m_thresholdExceeded),
+                            "ns3::RealtimeLagMonitor::LagTracedCallback");
+    return tid;
+}
+
+RealtimeLagMonitor::RealtimeLagMonitor()
+    : m_interval(MilliSeconds(100)),
+      m_reportInterval(Minutes(1)),
+      m_threshold(MilliSeconds(100)),
+      m_policy(WARN),
+      m_shedFraction(0.1),
+      m_shedHoldOff(Seconds(10)),
+      m_simOrigin(Seconds(0)),
+      m_realtime(false),
+      m_lastShed(Seconds(0)),
+      m_reportMaxLag(Seconds(0)),
+      m_maxLag(Seconds(0)),
+      m_nShed(0),
+      m_nExceeded(0),
+      m_lag(Seconds(0))
+{
+    NS_LOG_FUNCTION(this);
+    m_rng = CreateObject<UniformRandomVariable>();
+}
+
+RealtimeLagMonitor::~RealtimeLagMonitor()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+RealtimeLagMonitor::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    m_apps = ApplicationContainer();
+    m_rng = nullptr;
+    Object::DoDispose();
+}
+
+void
+RealtimeLagMonitor::Start()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_sampleEvent);
+    m_sampleEvent = Simulator::ScheduleNow(&RealtimeLagMonitor::DoStart, this);
+}
+
+void
+RealtimeLagMonitor::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_sampleEvent);
+    Simulator::Cancel(m_reportEvent);
+}
+
+void
+RealtimeLagMonitor::SetApplications(ApplicationContainer apps)
+{
+    NS_LOG_FUNCTION(this);
+    m_apps = apps;
+}
+
+Time
+RealtimeLagMonitor::GetLag() const
+{
+    return m_lag;
+}
+
+Time
+RealtimeLagMonitor::GetMaxLag() const
+{
+    return m_maxLag;
+}
+
+uint32_t
+RealtimeLagMonitor::GetNShedApplications() const
+{
+    return m_nShed;
+}
+
+int64_t
+RealtimeLagMonitor::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_rng->SetStream(stream);
+    return 1;
+}
+
+void
+RealtimeLagMonitor::DoStart()
+{
+    NS_LOG_FUNCTION(this);
+    // The realtime implementation already keeps a wall-clock reference
+    // synchronized with simulated time, we use our own otherwise.
+    m_realtime = bool(DynamicCast<RealtimeSimulatorImpl>(Simulator::GetImplementation()));
+    if (!m_realtime)
+    {
+        NS_LOG_WARN("Simulator is not real-time: lag will be measured against the wall-clock "
+                    "time elapsed since the start");
+    }
+    m_simOrigin = Simulator::Now();
+    m_wallOrigin = std::chrono::steady_clock::now();
+    m_lastShed = m_simOrigin - m_shedHoldOff;
+    Sample();
+    if (m_reportInterval.IsStrictlyPositive())
+    {
+        m_reportEvent =
+            Simulator::Schedule(m_reportInterval, &RealtimeLagMonitor::PrintReport, this);
+    }
+}
+
+Time
+RealtimeLagMonitor::GetWallClockElapsed() const
+{
+    if (m_realtime)
+    {
+        auto impl = DynamicCast<RealtimeSimulatorImpl>(Simulator::GetImplementation());
+        return impl->RealtimeNow() - m_simOrigin;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - m_wallOrigin;
+    return NanoSeconds(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void
+RealtimeLagMonitor::Sample()
+{
+    Time lag = GetWallClockElapsed() - (Simulator::Now() - m_simOrigin);
+    m_lag = lag;
+    m_maxLag = Max(m_maxLag, lag);
+    m_reportMaxLag = Max(m_reportMaxLag, lag);
+    NS_LOG_DEBUG("Scheduler lag: " << lag.As(Time::MS));
+
+    if (lag > m_threshold)
+    {
+        m_nExceeded++;
+        m_thresholdExceeded(lag);
+        ApplyPolicy();
+    }
+
+    m_sampleEvent = Simulator::Schedule(m_interval, &RealtimeLagMonitor::Sample, this);
+}
+
+void
+RealtimeLagMonitor::PrintReport()
+{
+    std::cout << "Scheduler lag: " << m_lag.Get().GetMilliSeconds() << " ms (max "
+              << m_reportMaxLag.GetMilliSeconds() << " ms in the last "
+              << m_reportInterval.GetSeconds() << " s, " << m_nExceeded
+              << " samples over threshold, " << m_nShed << " applications shed)" << std::endl;
+    m_reportMaxLag = Seconds(0);
+    m_nExceeded = 0;
+    m_reportEvent = Simulator::Schedule(m_reportInterval, &RealtimeLagMonitor::PrintReport, this);
+}
+
+void
+RealtimeLagMonitor::ApplyPolicy()
+{
+    switch (m_policy)
+    {
+    case WARN:
+        NS_LOG_WARN("Scheduler lag of " << m_lag.Get().As(Time::MS) << " exceeds the threshold of "
+                                        << m_threshold.As(Time::MS));
+        break;
+    case ABORT:
+        NS_FATAL_ERROR("Scheduler lag of " << m_lag.Get().As(Time::MS)
+                                           << " exceeds the threshold of "
+                                           << m_threshold.As(Time::MS)
+                                           << ": the host cannot sustain real-time execution");
+        break;
+    case SHED:
+        if (Simulator::Now() - m_lastShed >= m_shedHoldOff)
+        {
+            ShedLoad();
+            m_lastShed = Simulator::Now();
+        }
+        break;
+    }
+}
+
+void
+RealtimeLagMonitor::ShedLoad()
+{
+    NS_LOG_FUNCTION(this);
+    std::vector<Ptr<LoraApplication>> running;
+    for (auto it = m_apps.Begin(); it != m_apps.End(); ++it)
+    {
+        auto app = DynamicCast<LoraApplication>(*it);
+        if (app && app->IsRunning())
+        {
+            running.push_back(app);
+        }
+    }
+    if (running.empty())
+    {
+        NS_LOG_WARN("Scheduler lag of " << m_lag.Get().As(Time::MS)
+                                        << " but no application left to shed");
+        return;
+    }
+
+    // Partial Fisher-Yates shuffle to pick the applications to stop
+    uint32_t n = std::ceil(m_shedFraction * running.size());
+    if (n == 0)
+    {
+        NS_LOG_WARN("Scheduler lag of " << m_lag.Get().As(Time::MS)
+                                        << " but the shed fraction is zero");
+        return;
+    }
+    n = std::min<uint32_t>(n, running.size());
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t j = m_rng->GetInteger(i, running.size() - 1);
+        std::swap(running[i], running[j]);
+        running[i]->Suspend();
+    }
+    m_nShed += n;
+
+    NS_LOG_WARN("Scheduler lag of " << m_lag.Get().As(Time::MS) << ": stopped " << n << " of "
+                                    << running.size() << " running applications");
+}
+
+} // namespace lorawan
+} // namespace ns3
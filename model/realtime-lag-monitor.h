@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef REALTIME_LAG_MONITOR_H
+#define REALTIME_LAG_MONITOR_H
+
+#include "ns3/application-container.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+
+#include <chrono>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Monitor of the delay accumulated by the simulator with respect to wall-clock time.
+ *
+ * When running with the RealtimeSimulatorImpl, events are executed as soon as
+ * their timestamp is reached on the host clock. If the host is not able to
+ * keep up with the event rate, simulated time falls behind wall-clock time and
+ * all timestamps exchanged with the outside world (e.g., gateway count_us and
+ * RX windows) become inconsistent. This object periodically samples that lag,
+ * exposes it as a trace source, and applies a configurable policy when it
+ * exceeds a threshold.
+ */
+class RealtimeLagMonitor : public Object
+{
+  public:
+    /**
+     * Action taken when the measured lag exceeds the threshold.
+     */
+    enum Policy
+    {
+        WARN,  //!< Only log a warning
+        ABORT, //!< Terminate the simulation with an error
+        SHED,  //!< Stop a fraction of the registered device applications
+    };
+
+    static TypeId GetTypeId();
+
+    RealtimeLagMonitor();
+    ~RealtimeLagMonitor() override;
+
+    /**
+     * Start sampling the lag. Must be called before Simulator::Run, the
+     * wall-clock reference is taken when the simulation actually starts.
+     */
+    void Start();
+
+    /**
+     * Stop sampling the lag.
+     */
+    void Stop();
+
+    /**
+     * Set the device applications that can be stopped by the SHED policy.
+     *
+     * \param apps Container of LoraApplication instances.
+     */
+    void SetApplications(ApplicationContainer apps);
+
+    /**
+     * Get the last lag measurement.
+     */
+    Time GetLag() const;
+
+    /**
+     * Get the maximum lag measured since the start.
+     */
+    Time GetMaxLag() const;
+
+    /**
+     * Get the number of applications stopped by the SHED policy so far.
+     */
+    uint32_t GetNShedApplications() const;
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream The first stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    /**
+     * TracedCallback signature for threshold violations.
+     *
+     * \param [in] lag The lag that exceeded the threshold.
+     */
+    typedef void (*LagTracedCallback)(Time lag);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Take the wall-clock reference (executed at simulated time 0).
+     */
+    void DoStart();
+
+    /**
+     * Measure the current lag, apply policy, and re-schedule itself.
+     */
+    void Sample();
+
+    /**
+     * Print a periodic summary of the measured lag.
+     */
+    void PrintReport();
+
+    /**
+     * Apply the configured policy to the current lag.
+     */
+    void ApplyPolicy();
+
+    /**
+     * Stop a random fraction of the running applications.
+     */
+    void ShedLoad();
+
+    /**
+     * Compute the current wall-clock time elapsed since the start.
+     */
+    Time GetWallClockElapsed() const;
+
+    Time m_interval;       //!< Sampling interval (simulated time)
+    Time m_reportInterval; //!< Interval between periodic reports (0 = disabled)
+    Time m_threshold;      //!< Lag above which the policy is applied
+    Policy m_policy;       //!< Action taken when the threshold is exceeded
+    double m_shedFraction; //!< Fraction of running applications stopped at each shedding step
+    Time m_shedHoldOff;    //!< Minimum time between two shedding steps
+
+    Time m_simOrigin;                                     //!< Simulated time at start
+    std::chrono::steady_clock::time_point m_wallOrigin;   //!< Wall-clock time at start
+    bool m_realtime;                                      //!< Using RealtimeSimulatorImpl
+    Time m_lastShed;                                      //!< Last time load was shed
+    Time m_reportMaxLag;                                  //!< Max lag since last report
+    Time m_maxLag;                                        //!< Max lag since start
+    uint32_t m_nShed;                                     //!< Number of stopped applications
+    uint32_t m_nExceeded;                                 //!< Samples above threshold
+    EventId m_sampleEvent;                                //!< Next sampling event
+    EventId m_reportEvent;                                //!< Next report event
+    ApplicationContainer m_apps;                          //!< Applications subject to shedding
+    Ptr<UniformRandomVariable> m_rng;                     //!< To choose applications to shed
+
+    TracedValue<Time> m_lag;                  //!< Last measured lag
+    TracedCallback<Time> m_thresholdExceeded; //!< Fired when lag exceeds the threshold
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* REALTIME_LAG_MONITOR_H */
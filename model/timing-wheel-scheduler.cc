@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#include "timing-wheel-scheduler.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("TimingWheelScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(TimingWheelScheduler);
+
+namespace
+{
+/// Min-heap order of the events
+bool
+Later(const Scheduler::Event& a, const Scheduler::Event& b)
+{
+    return b.key < a.key;
+}
+} // namespace
+
+TypeId
+TimingWheelScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::TimingWheelScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<TimingWheelScheduler>();
+    return tid;
+}
+
+TimingWheelScheduler::TimingWheelScheduler()
+    : m_current(0),
+      m_size(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_occupied.fill(0);
+}
+
+TimingWheelScheduler::~TimingWheelScheduler()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+TimingWheelScheduler::Insert(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    Place(ev);
+    m_size++;
+}
+
+bool
+TimingWheelScheduler::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+Scheduler::Event
+TimingWheelScheduler::PeekNext() const
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    if (m_near.empty())
+    {
+        // Turning the wheel does not change the set of events
+        const_cast<TimingWheelScheduler*>(this)->Advance();
+    }
+    return m_near.front();
+}
+
+Scheduler::Event
+TimingWheelScheduler::RemoveNext()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    if (m_near.empty())
+    {
+        Advance();
+    }
+    std::pop_heap(m_near.begin(), m_near.end(), Later);
+    Event ev = m_near.back();
+    m_near.pop_back();
+    m_size--;
+    return ev;
+}
+
+void
+TimingWheelScheduler::Remove(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    auto sameUid = [&ev](const Event& other) { return other.key.m_uid == ev.key.m_uid; };
+    uint64_t slot = ev.key.m_ts >> SLOT_SHIFT;
+    if (slot <= m_current)
+    {
+        auto it = std::find_if(m_near.begin(), m_near.end(), sameUid);
+        NS_ASSERT_MSG(it != m_near.end(), "Event not found");
+        *it = m_near.back();
+        m_near.pop_back();
+        std::make_heap(m_near.begin(), m_near.end(), Later);
+    }
+    else
+    {
+        uint32_t level = GetLevel(slot);
+        uint32_t index = (slot >> (LEVEL_BITS * level)) & (N_SLOTS - 1);
+        auto& bucket = m_wheel[level][index];
+        auto it = std::find_if(bucket.begin(), bucket.end(), sameUid);
+        NS_ASSERT_MSG(it != bucket.end(), "Event not found");
+        *it = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty())
+        {
+            m_occupied[level] &= ~(uint64_t(1) << index);
+        }
+    }
+    m_size--;
+}
+
+void
+TimingWheelScheduler::Place(const Event& ev)
+{
+    uint64_t slot = ev.key.m_ts >> SLOT_SHIFT;
+    if (slot <= m_current)
+    {
+        // Due in the current slot (or earlier, after a peek in real-time mode)
+        m_near.push_back(ev);
+        std::push_heap(m_near.begin(), m_near.end(), Later);
+        return;
+    }
+    uint32_t level = GetLevel(slot);
+    uint32_t index = (slot >> (LEVEL_BITS * level)) & (N_SLOTS - 1);
+    m_wheel[level][index].push_back(ev);
+    m_occupied[level] |= uint64_t(1) << index;
+}
+
+void
+TimingWheelScheduler::Advance()
+{
+    NS_LOG_FUNCTION(this);
+    while (m_near.empty())
+    {
+        // Find the first non-empty bucket after the current slot, lowest level first.
+        // Buckets of a level only hold events after the current slot of that level.
+        uint32_t level = 0;
+        uint64_t pending = 0;
+        for (; level < N_LEVELS; ++level)
+        {
+            uint32_t index = (m_current >> (LEVEL_BITS * level)) & (N_SLOTS - 1);
+            if (index < N_SLOTS - 1)
+            {
+                pending = m_occupied[level] & (~uint64_t(0) << (index + 1));
+            }
+            if (pending)
+            {
+                break;
+            }
+        }
+        NS_ASSERT_MSG(level < N_LEVELS, "No event left in the wheel");
+
+        // Jump to the start of the bucket, then spread its events on lower levels
+        uint32_t index = __builtin_ctzll(pending);
+        uint32_t shift = LEVEL_BITS * level;
+        m_current = ((m_current >> (shift + LEVEL_BITS)) << (shift + LEVEL_BITS)) |
+                    (uint64_t(index) << shift);
+        m_occupied[level] &= ~(uint64_t(1) << index);
+        std::vector<Event> bucket;
+        bucket.swap(m_wheel[level][index]);
+        for (const auto& ev : bucket)
+        {
+            Place(ev);
+        }
+        // Give the storage back to the (still empty) bucket
+        bucket.clear();
+        m_wheel[level][index].swap(bucket);
+    }
+}
+
+uint32_t
+TimingWheelScheduler::GetLevel(uint64_t slot) const
+{
+    NS_ASSERT(slot > m_current);
+    // Highest group of bits differing from the current slot
+    uint32_t msb = 63 - __builtin_clzll(slot ^ m_current);
+    return msb / LEVEL_BITS;
+}
+
+} // namespace lorawan
+} // namespace ns3
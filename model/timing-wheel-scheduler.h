@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+#ifndef TIMING_WHEEL_SCHEDULER_H
+#define TIMING_WHEEL_SCHEDULER_H
+
+#include "ns3/scheduler.h"
+
+#include <array>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Event scheduler tuned for LoRaWAN workloads.
+ *
+ * LoRaWAN simulations hold a large population of long-horizon timers
+ * (application periods of minutes to days, duty-cycle backoffs) next to
+ * bursts of sub-second PHY and MAC events (receptions, receive windows).
+ *
+ * Events are kept in a hierarchical timing wheel of 64-slot levels. Slots of
+ * the first level span 2^24 time steps (about 16.8 ms with the default
+ * nanosecond resolution), and each following level is 64 times coarser, so
+ * that 7 levels cover the whole time range. Insertion in the wheel is O(1),
+ * and a far event is moved down one level at a time as the simulation clock
+ * approaches it. Events due in the current slot of the first level are kept
+ * in a small binary heap, which provides exact (timestamp, uid) ordering.
+ *
+ * Select it with, e.g., --SchedulerType=ns3::TimingWheelScheduler.
+ */
+class TimingWheelScheduler : public Scheduler
+{
+  public:
+    static TypeId GetTypeId();
+
+    TimingWheelScheduler();
+    ~TimingWheelScheduler() override;
+
+    // Inherited
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  private:
+    static constexpr uint32_t SLOT_SHIFT = 24; //!< Log2 of the first level slot width
+    static constexpr uint32_t LEVEL_BITS = 6;  //!< Log2 of the number of slots per level
+    static constexpr uint32_t N_SLOTS = 1 << LEVEL_BITS;
+    static constexpr uint32_t N_LEVELS = (64 - SLOT_SHIFT + LEVEL_BITS - 1) / LEVEL_BITS;
+
+    /**
+     * Place an event in the near-term heap or in the wheel.
+     *
+     * \param ev The event.
+     */
+    void Place(const Event& ev);
+
+    /**
+     * Move the wheel forward until the near-term heap holds the next events.
+     *
+     * \pre The near-term heap is empty and the wheel is not.
+     */
+    void Advance();
+
+    /**
+     * Compute the level of the wheel holding a first-level slot.
+     *
+     * \param slot The absolute first-level slot of an event, after m_current.
+     */
+    uint32_t GetLevel(uint64_t slot) const;
+
+    /// Buckets of the wheel, per level and slot
+    std::array<std::array<std::vector<Event>, N_SLOTS>, N_LEVELS> m_wheel;
+
+    std::vector<Event> m_near;                 //!< Heap of the events up to the current slot
+    std::array<uint64_t, N_LEVELS> m_occupied; //!< Bitmap of the non-empty buckets per level
+    uint64_t m_current;                        //!< Current absolute first-level slot
+    uint32_t m_size;                           //!< Number of events held
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* TIMING_WHEEL_SCHEDULER_H */
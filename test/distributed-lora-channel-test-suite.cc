@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023 Orange SA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Alessandro Aimi <alessandro.aimi@orange.com>
+ *                         <alessandro.aimi@cnam.fr>
+ */
+
+/*
+ * This file includes testing for the following components:
+ * - DistributedLoraChannel, through the distributed-aloha example
+ */
+
+#include "ns3/log.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DistributedLoraChannelTestSuite");
+
+/******************************
+ * DistributedEquivalenceTest *
+ *****************************/
+
+class DistributedEquivalenceTest : public TestCase
+{
+  public:
+    DistributedEquivalenceTest(uint32_t nRanks);
+    ~DistributedEquivalenceTest() override;
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Run the distributed-aloha example.
+     *
+     * \param nRanks The number of MPI processes.
+     * \return The per-SF counters printed by the example.
+     */
+    std::string RunExample(uint32_t nRanks);
+
+    uint32_t m_nRanks; //!< Number of ranks of the run compared to a single rank
+};
+
+// Add some help text to this case to describe what it is intended to test
+DistributedEquivalenceTest::DistributedEquivalenceTest(uint32_t nRanks)
+    : TestCase("Verify that a run with " + std::to_string(nRanks) +
+               " ranks sends and receives the packets of a single rank run"),
+      m_nRanks(nRanks)
+{
+}
+
+// Reminder that the test case should clean up after itself
+DistributedEquivalenceTest::~DistributedEquivalenceTest()
+{
+}
+
+std::string
+DistributedEquivalenceTest::RunExample(uint32_t nRanks)
+{
+    std::string output =
+        CreateTempDirFilename("distributed-aloha-" + std::to_string(nRanks) + ".log");
+    // Like ExampleAsTestCase, from the top of the ns-3 tree
+    std::stringstream command;
+    command << "python3 ./ns3 run distributed-aloha --no-build --command-template=\"mpiexec -n "
+            << nRanks << " %s --nDevices=500 --simulationTime=1200\" 2>&1 | grep '^SF' > "
+            << output;
+    NS_LOG_DEBUG(command.str());
+    int status = std::system(command.str().c_str());
+    NS_TEST_EXPECT_MSG_EQ(status, 0, "Run with " << nRanks << " ranks failed");
+
+    std::ifstream in(output);
+    std::stringstream counters;
+    counters << in.rdbuf();
+    return counters.str();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+DistributedEquivalenceTest::DoRun()
+{
+    NS_LOG_DEBUG("DistributedEquivalenceTest");
+
+    std::string single = RunExample(1);
+    std::string distributed = RunExample(m_nRanks);
+    NS_TEST_ASSERT_MSG_EQ(single.empty(), false, "No counters printed");
+    NS_TEST_EXPECT_MSG_EQ(distributed, single, "Per-SF counters differ");
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+// The TestSuite class names the TestSuite, identifies what type of TestSuite,
+// and enables the TestCases to be run. Typically, only the constructor for
+// this class must be defined
+
+class DistributedLoraChannelTestSuite : public TestSuite
+{
+  public:
+    DistributedLoraChannelTestSuite();
+};
+
+DistributedLoraChannelTestSuite::DistributedLoraChannelTestSuite()
+    : TestSuite("distributed-lora-channel", EXAMPLE)
+{
+    LogComponentEnable("DistributedLoraChannelTestSuite", LOG_LEVEL_DEBUG);
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new DistributedEquivalenceTest(2), TestCase::EXTENSIVE);
+    AddTestCase(new DistributedEquivalenceTest(3), TestCase::EXTENSIVE);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+static DistributedLoraChannelTestSuite distributedLoraChannelTestSuite;
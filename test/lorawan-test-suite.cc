@@ -1,18 +1,60 @@
 
 // Include headers of classes to test
+#include "utilities.h"
+
+#include "ns3/async-pcap-writer.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/bike-sharing-mobility-helper.h"
+#include "ns3/boolean.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
 #include "ns3/end-device-lora-phy.h"
+#include "ns3/enum.h"
+#include "ns3/fleet-traffic-driver.h"
+#include "ns3/gateway-spatial-index.h"
 #include "ns3/gateway-lora-phy.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/host-udp-socket.h"
 #include "ns3/log.h"
+#include "ns3/lora-analytic-energy-source.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lorawan-frame-codec.h"
 #include "ns3/lorawan-helper.h"
 #include "ns3/lorawan-mac-header.h"
+#include "ns3/mac48-address.h"
+#include "ns3/metrics-exporter.h"
+#include "ns3/map-scheduler.h"
 #include "ns3/mobility-helper.h"
+#include "ns3/network-checkpoint-helper.h"
 #include "ns3/one-shot-sender-helper.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/periodic-sender.h"
+#include "ns3/poisson-sender.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/range-position-allocator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/string.h"
+#include "ns3/timing-wheel-scheduler.h"
+#include "ns3/udp-forwarder.h"
+#include "ns3/uinteger.h"
+#include "ns3/uplink-replayer.h"
+#include "ns3/uplink-trace.h"
+#include "ns3/virtual-device-fleet.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
 using namespace ns3;
 using namespace lorawan;
 
@@ -180,6 +222,53 @@ InterferenceTest::DoRun()
     NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
                           0,
                           "Packet did not survive interference as expected");
+
+    // ALOHA matrix: any same-SF overlap destroys the packet, other SFs never do
+    interference->SetIsolationMatrix(LoraInterferenceHelper::ALOHA);
+    interference->ClearAllEvents();
+    event = interference->Add(Seconds(2), 14, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
+                          0,
+                          "Packet did not survive without interferers as expected");
+    interference->Add(Seconds(2), 14 + 30, 8, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
+                          0,
+                          "Packet did not survive interference as expected");
+    interference->Add(Seconds(1), 14 - 30, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
+                          7,
+                          "Packet was not destroyed by interference as expected");
+
+    // CROCE matrix: 1 dB of same-SF isolation
+    interference->SetIsolationMatrix(LoraInterferenceHelper::CROCE);
+    interference->ClearAllEvents();
+    event = interference->Add(Seconds(2), 14, 7, nullptr, frequency);
+    interference->Add(Seconds(2), 14 - 2, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
+                          0,
+                          "Packet did not survive interference as expected");
+    interference->Add(Seconds(2), 14 - 2, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interference->IsDestroyedByInterference(event),
+                          7,
+                          "Packet was not destroyed by interference as expected");
+
+    // Released events are recycled by the pool
+    event = nullptr;
+    interference->ClearAllEvents();
+    for (int i = 0; i < 200; ++i)
+    {
+        interference->Add(Seconds(1), 14, 7, nullptr, frequency);
+    }
+    interference->ClearAllEvents();
+    uint64_t allocations = LoraInterferenceHelper::Event::GetNSystemAllocations();
+    for (int i = 0; i < 200; ++i)
+    {
+        interference->Add(Seconds(1), 14, 7, nullptr, frequency);
+    }
+    interference->ClearAllEvents();
+    NS_TEST_EXPECT_MSG_EQ(LoraInterferenceHelper::Event::GetNSystemAllocations(),
+                          allocations,
+                          "Events were not recycled by the pool");
 }
 
 /***************
@@ -626,6 +715,17 @@ ReceivePathTest::DoRun()
 
     Simulator::Stop(Hours(2));
     Simulator::Run();
+
+    // One path busy in [2, 3) and [6, 7), two in [3, 6)
+    std::vector<Time> histogram = gatewayPhy->GetOccupancyHistogram();
+    NS_TEST_EXPECT_MSG_EQ(histogram.size(), 3U, "Unexpected histogram size");
+    NS_TEST_EXPECT_MSG_EQ(histogram[0], Hours(2) - Seconds(5), "Unexpected idle time");
+    NS_TEST_EXPECT_MSG_EQ(histogram[1], Seconds(2), "Unexpected time with one busy path");
+    NS_TEST_EXPECT_MSG_EQ(histogram[2], Seconds(3), "Unexpected time with two busy paths");
+    NS_TEST_EXPECT_MSG_EQ_TOL(gatewayPhy->GetUtilization(),
+                              8.0 / (2 * 7200),
+                              1e-12,
+                              "Unexpected utilization");
     Simulator::Destroy();
 
     NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls, 0, "Unexpected value");
@@ -1786,13 +1886,1898 @@ LorawanMacTest::DoRun()
     NS_LOG_DEBUG("LorawanMacTest");
 }
 
-/**************
- * Test Suite *
- **************/
+/***********************
+ * AsyncPcapWriterTest *
+ ***********************/
 
-// The TestSuite class names the TestSuite, identifies what type of TestSuite,
-// and enables the TestCases to be run. Typically, only the constructor for
-// this class must be defined
+class AsyncPcapWriterTest : public TestCase
+{
+  public:
+    AsyncPcapWriterTest();
+    ~AsyncPcapWriterTest() override;
+
+  private:
+    void DoRun() override;
+    uint64_t GetFileSize(std::string filename);
+};
+
+// Add some help text to this case to describe what it is intended to test
+AsyncPcapWriterTest::AsyncPcapWriterTest()
+    : TestCase("Verify that the background pcap writer produces complete captures")
+{
+}
+
+// Reminder that the test case should clean up after itself
+AsyncPcapWriterTest::~AsyncPcapWriterTest()
+{
+}
+
+uint64_t
+AsyncPcapWriterTest::GetFileSize(std::string filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.is_open() ? uint64_t(file.tellg()) : 0;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+AsyncPcapWriterTest::DoRun()
+{
+    NS_LOG_DEBUG("AsyncPcapWriterTest");
+
+    // One classic pcap file per interface
+    std::string gw0 = CreateTempDirFilename("async-gw0.pcap");
+    std::string gw1 = CreateTempDirFilename("async-gw1.pcap");
+    auto writer = CreateObject<AsyncPcapWriter>();
+    uint32_t if0 = writer->AddInterface(gw0, PcapHelper::DLT_LORATAP);
+    uint32_t if1 = writer->AddInterface(gw1, PcapHelper::DLT_LORATAP);
+    NS_TEST_EXPECT_MSG_EQ(if0, 0, "Unexpected interface index");
+    NS_TEST_EXPECT_MSG_EQ(if1, 1, "Unexpected interface index");
+    for (int i = 0; i < 3; ++i)
+    {
+        writer->Write(if0, Seconds(i), Create<Packet>(10));
+    }
+    writer->Write(if1, Seconds(1), Create<Packet>(20));
+    writer->Close();
+    NS_TEST_EXPECT_MSG_EQ(writer->GetNDropped(), 0, "No packet should be dropped");
+    // Global header (24 bytes), then record header (16 bytes) and data
+    NS_TEST_EXPECT_MSG_EQ(GetFileSize(gw0), 24 + 3 * (16 + 10), "Unexpected capture size");
+    NS_TEST_EXPECT_MSG_EQ(GetFileSize(gw1), 24 + 1 * (16 + 20), "Unexpected capture size");
+
+    // Single pcapng file
+    std::string merged = CreateTempDirFilename("async-merged.pcapng");
+    writer = CreateObjectWithAttributes<AsyncPcapWriter>("MergedFile", StringValue(merged));
+    if0 = writer->AddInterface("gw0", PcapHelper::DLT_LORATAP);
+    if1 = writer->AddInterface("gw1", PcapHelper::DLT_LORATAP);
+    writer->Write(if0, Seconds(1), Create<Packet>(10));
+    writer->Write(if1, Seconds(2), Create<Packet>(10));
+    writer->Close();
+    // Section header (28 bytes), 2 interface blocks (40 bytes), 2 packet blocks (44 bytes)
+    NS_TEST_EXPECT_MSG_EQ(GetFileSize(merged), 28 + 2 * 40 + 2 * 44, "Unexpected capture size");
+    // Each block starts and ends with its length, and blocks cover the whole file
+    std::ifstream in(merged, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<uint32_t> lengths;
+    size_t offset = 0;
+    while (offset + 12 <= bytes.size())
+    {
+        uint32_t length;
+        std::memcpy(&length, &bytes[offset + 4], 4);
+        NS_TEST_ASSERT_MSG_EQ(length % 4, 0, "Block length not aligned");
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(length, 12, "Block too short");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(offset + length, bytes.size(), "Block past the file end");
+        uint32_t trailing;
+        std::memcpy(&trailing, &bytes[offset + length - 4], 4);
+        NS_TEST_EXPECT_MSG_EQ(trailing, length, "Leading and trailing lengths differ");
+        lengths.push_back(length);
+        offset += length;
+    }
+    NS_TEST_EXPECT_MSG_EQ(offset, bytes.size(), "Blocks do not cover the file");
+    NS_TEST_EXPECT_MSG_EQ((lengths == std::vector<uint32_t>{28, 40, 40, 44, 44}),
+                          true,
+                          "Unexpected block lengths");
+
+    // A small ring overflows: packets are dropped but files stay consistent
+    writer = CreateObjectWithAttributes<AsyncPcapWriter>("BufferSize", UintegerValue(4096));
+    if0 = writer->AddInterface(gw0, PcapHelper::DLT_LORATAP);
+    uint32_t nPackets = 1000;
+    for (uint32_t i = 0; i < nPackets; ++i)
+    {
+        writer->Write(if0, MilliSeconds(i), Create<Packet>(1000));
+    }
+    writer->Close();
+    NS_TEST_EXPECT_MSG_EQ(writer->GetNQueued() + writer->GetNDropped(),
+                          nPackets,
+                          "Packets should be either queued or dropped");
+    NS_TEST_EXPECT_MSG_EQ(GetFileSize(gw0),
+                          24 + writer->GetNQueued() * (16 + 1000),
+                          "Capture does not match the queued packets");
+}
+
+/**************************
+ * FleetTrafficDriverTest *
+ **************************/
+
+class FleetTrafficDriverTest : public TestCase
+{
+  public:
+    FleetTrafficDriverTest();
+    ~FleetTrafficDriverTest() override;
+
+  private:
+    /// A packet handed to the MAC: node, time step and size
+    using Send = std::tuple<uint32_t, int64_t, uint32_t>;
+
+    void DoRun() override;
+    std::vector<Send> RunTraffic(bool fleet);
+    static void OnSend(std::vector<Send>* sends, uint32_t node, Ptr<const Packet> packet);
+};
+
+// Add some help text to this case to describe what it is intended to test
+FleetTrafficDriverTest::FleetTrafficDriverTest()
+    : TestCase("Verify that the fleet driver reproduces the traffic of standalone applications")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FleetTrafficDriverTest::~FleetTrafficDriverTest()
+{
+}
+
+void
+FleetTrafficDriverTest::OnSend(std::vector<Send>* sends, uint32_t node, Ptr<const Packet> packet)
+{
+    sends->emplace_back(node, Simulator::Now().GetTimeStep(), packet->GetSize());
+}
+
+std::vector<FleetTrafficDriverTest::Send>
+FleetTrafficDriverTest::RunTraffic(bool fleet)
+{
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+    RngSeedManager::ResetNextStreamIndex();
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    NodeContainer endDevices = CreateEndDevices(40, mobility, CreateChannel());
+
+    // Periodic senders with random periods and sizes, Poisson senders
+    PeriodicSenderHelper appHelper;
+    appHelper.SetPeriodGenerator(
+        CreateObjectWithAttributes<UniformRandomVariable>("Min",
+                                                          DoubleValue(60),
+                                                          "Max",
+                                                          DoubleValue(600)));
+    appHelper.SetPacketSizeGenerator(
+        CreateObjectWithAttributes<UniformRandomVariable>("Min",
+                                                          DoubleValue(5),
+                                                          "Max",
+                                                          DoubleValue(50)));
+    ApplicationContainer apps;
+    for (uint32_t i = 0; i < endDevices.GetN(); ++i)
+    {
+        if (i % 2)
+        {
+            apps.Add(appHelper.Install(endDevices.Get(i)));
+        }
+        else
+        {
+            auto app = CreateObjectWithAttributes<PoissonSender>("Interval",
+                                                                 TimeValue(Seconds(300)));
+            app->SetInitialDelay(Seconds(i));
+            endDevices.Get(i)->AddApplication(app);
+            apps.Add(app);
+        }
+    }
+    apps.Start(Seconds(0));
+    apps.Stop(Hours(3));
+
+    Ptr<FleetTrafficDriver> driver;
+    if (fleet)
+    {
+        driver = CreateObject<FleetTrafficDriver>();
+        driver->Add(apps);
+        NS_TEST_EXPECT_MSG_EQ(driver->GetNApplications(),
+                              endDevices.GetN(),
+                              "All applications should be driven");
+    }
+
+    // Move some pending sends, mostly earlier than they were
+    Simulator::Schedule(Hours(1), [apps]() {
+        for (uint32_t i = 1; i < apps.GetN(); i += 4)
+        {
+            DynamicCast<LoraApplication>(apps.Get(i))->SetNextSendDelay(Seconds(i));
+        }
+    });
+
+    std::vector<Send> sends;
+    for (uint32_t i = 0; i < endDevices.GetN(); ++i)
+    {
+        GetMacLayerFromNode<LorawanMac>(endDevices.Get(i))
+            ->TraceConnectWithoutContext("SentNewPacket", MakeBoundCallback(&OnSend, &sends, i));
+    }
+
+    Simulator::Stop(Hours(4));
+    Simulator::Run();
+    if (fleet)
+    {
+        NS_TEST_EXPECT_MSG_EQ(driver->GetNPending(), 0, "Stopped applications should not send");
+    }
+    Simulator::Destroy();
+    return sends;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FleetTrafficDriverTest::DoRun()
+{
+    NS_LOG_DEBUG("FleetTrafficDriverTest");
+
+    std::vector<Send> standalone = RunTraffic(false);
+    std::vector<Send> driven = RunTraffic(true);
+    NS_TEST_ASSERT_MSG_GT(standalone.size(), 0, "Applications should send packets");
+    NS_TEST_ASSERT_MSG_EQ(driven.size(), standalone.size(), "Different number of packets");
+    for (size_t i = 0; i < standalone.size(); ++i)
+    {
+        NS_TEST_EXPECT_MSG_EQ((standalone[i] == driven[i]), true, "Packet " << i << " differs");
+    }
+}
+
+/****************************
+ * TimingWheelSchedulerTest *
+ ****************************/
+
+class TimingWheelSchedulerTest : public TestCase
+{
+  public:
+    TimingWheelSchedulerTest();
+    ~TimingWheelSchedulerTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+TimingWheelSchedulerTest::TimingWheelSchedulerTest()
+    : TestCase("Verify that the timing wheel scheduler orders events like the map scheduler")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TimingWheelSchedulerTest::~TimingWheelSchedulerTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TimingWheelSchedulerTest::DoRun()
+{
+    NS_LOG_DEBUG("TimingWheelSchedulerTest");
+
+    Ptr<Scheduler> wheel = CreateObject<TimingWheelScheduler>();
+    Ptr<Scheduler> reference = CreateObject<MapScheduler>();
+    auto rv = CreateObject<UniformRandomVariable>();
+    uint32_t uid = 0;
+    uint64_t now = 0;
+    std::vector<Scheduler::Event> removable;
+
+    auto insert = [&](uint64_t delay) {
+        Scheduler::Event ev;
+        ev.impl = nullptr;
+        ev.key.m_ts = now + delay;
+        ev.key.m_uid = uid++;
+        ev.key.m_context = 0;
+        wheel->Insert(ev);
+        reference->Insert(ev);
+        if (ev.key.m_uid % 7 == 0)
+        {
+            removable.push_back(ev);
+        }
+    };
+
+    // Mix of PHY-scale, MAC-scale and application-scale delays (in ns)
+    const uint64_t scales[] = {1000, 1000000000, 3600000000000, 86400000000000};
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        insert(rv->GetValue(0, scales[i % 4]));
+    }
+    for (uint32_t i = 0; i < 20000 && !reference->IsEmpty(); ++i)
+    {
+        if (i % 3 == 0)
+        {
+            insert(rv->GetValue(0, scales[rv->GetInteger(0, 3)]));
+        }
+        if (i % 11 == 0 && !removable.empty())
+        {
+            // Remove an event that is still pending
+            Scheduler::Event ev = removable.back();
+            removable.pop_back();
+            if (ev.key.m_ts > now)
+            {
+                wheel->Remove(ev);
+                reference->Remove(ev);
+            }
+        }
+        NS_TEST_ASSERT_MSG_EQ(wheel->PeekNext().key.m_uid,
+                              reference->PeekNext().key.m_uid,
+                              "Different next event");
+        Scheduler::Event next = wheel->RemoveNext();
+        NS_TEST_ASSERT_MSG_EQ(next.key.m_uid, reference->RemoveNext().key.m_uid, "Wrong order");
+        now = next.key.m_ts;
+    }
+    while (!reference->IsEmpty())
+    {
+        NS_TEST_ASSERT_MSG_EQ(wheel->RemoveNext().key.m_uid,
+                              reference->RemoveNext().key.m_uid,
+                              "Wrong order");
+    }
+    NS_TEST_EXPECT_MSG_EQ(wheel->IsEmpty(), true, "Events left in the wheel");
+}
+
+/***************************
+ * BikeSharingMobilityTest *
+ ***************************/
+
+class BikeSharingMobilityTest : public TestCase
+{
+  public:
+    BikeSharingMobilityTest();
+    ~BikeSharingMobilityTest() override;
+
+  private:
+    void DoRun() override;
+    void CheckPosition(Ptr<MobilityModel> mobility, Vector expected);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BikeSharingMobilityTest::BikeSharingMobilityTest()
+    : TestCase("Verify that bike trips are loaded, cached and followed by nodes")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BikeSharingMobilityTest::~BikeSharingMobilityTest()
+{
+}
+
+void
+BikeSharingMobilityTest::CheckPosition(Ptr<MobilityModel> mobility, Vector expected)
+{
+    NS_TEST_EXPECT_MSG_EQ_TOL(CalculateDistance(mobility->GetPosition(), expected),
+                              0,
+                              1e-6,
+                              "Wrong bike position");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BikeSharingMobilityTest::DoRun()
+{
+    NS_LOG_DEBUG("BikeSharingMobilityTest");
+
+    // Two bikes with interleaved trips, a comment and a blank line
+    std::string csv = CreateTempDirFilename("bike-trips.csv");
+    {
+        std::ofstream out(csv);
+        out << "started_at,ended_at,start_x,start_y,end_x,end_y,bike_id\n";
+        out << "# comment line\n\n";
+        for (int i = 0; i < 40; ++i)
+        {
+            out << i * 100 << "," << i * 100 + 50 << "," << i << ",0," << i + 1 << ",0,A\n";
+            out << i * 100 + 10 << ", " << i * 100 + 20 << ",0," << i << ",0," << -i << ", B\n";
+        }
+    }
+
+    for (bool cached : {false, true})
+    {
+        BikeSharingMobilityHelper helper;
+        helper.SetLookahead(3);
+        helper.Add(csv, 2.0);
+        NS_TEST_EXPECT_MSG_EQ(helper.GetNBikes(), 2, "Wrong number of bikes");
+        NS_TEST_EXPECT_MSG_EQ(std::ifstream(csv + ".idx").good(), true, "No cached index");
+
+        NodeContainer bikes;
+        bikes.Create(2);
+        helper.Install(bikes);
+        auto mobilityA = bikes.Get(0)->GetObject<MobilityModel>();
+        auto mobilityB = bikes.Get(1)->GetObject<MobilityModel>();
+        for (int i = 0; i < 40; ++i)
+        {
+            Simulator::Schedule(Seconds(i * 100 + 50),
+                                &BikeSharingMobilityTest::CheckPosition,
+                                this,
+                                mobilityA,
+                                Vector(i + 1, 0, 2));
+            Simulator::Schedule(Seconds(i * 100 + 20),
+                                &BikeSharingMobilityTest::CheckPosition,
+                                this,
+                                mobilityB,
+                                Vector(0, -i, 2));
+        }
+        Simulator::Run();
+        NS_TEST_EXPECT_MSG_EQ(bikes.Get(0)->GetObject<WaypointMobilityModel>()->WaypointsLeft(),
+                              0,
+                              (cached ? "Cached: " : "") << "Trips left to follow");
+        Simulator::Destroy();
+    }
+}
+
+/***************
+ * LoraTagTest *
+ ***************/
+
+class LoraTagTest : public TestCase
+{
+  public:
+    LoraTagTest();
+    ~LoraTagTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+LoraTagTest::LoraTagTest()
+    : TestCase("Verify that LoraTag updates in place leave packet copies untouched")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LoraTagTest::~LoraTagTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LoraTagTest::DoRun()
+{
+    NS_LOG_DEBUG("LoraTagTest");
+
+    // Untagged packets get a new tag
+    Ptr<Packet> packet = Create<Packet>(10);
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    tag.SetDataRate(5);
+    tag.SetFrequency(868100000);
+    tag.WriteTo(packet);
+
+    // A copy shares the tag list of the original (e.g., one reception per gateway)
+    Ptr<Packet> copy = packet->Copy();
+    packet->PeekPacketTag(tag);
+    tag.SetReceivePower(-110);
+    tag.SetSnr(3.5);
+    tag.WriteTo(packet);
+
+    LoraTag updated;
+    NS_TEST_ASSERT_MSG_EQ(packet->PeekPacketTag(updated), true, "Tag lost");
+    NS_TEST_ASSERT_MSG_EQ(unsigned(updated.GetDataRate()), 5, "Field lost in the update");
+    NS_TEST_ASSERT_MSG_EQ(updated.GetFrequency(), 868100000, "Field lost in the update");
+    NS_TEST_ASSERT_MSG_EQ(updated.GetReceivePower(), -110, "Field not updated");
+    NS_TEST_ASSERT_MSG_EQ(updated.GetSnr(), 3.5, "Field not updated");
+    LoraTag original;
+    NS_TEST_ASSERT_MSG_EQ(copy->PeekPacketTag(original), true, "Tag lost by the copy");
+    NS_TEST_ASSERT_MSG_EQ(original.GetReceivePower(), 0, "Copy modified by the update");
+
+    // A single LoraTag is carried
+    packet->RemovePacketTag(tag);
+    NS_TEST_ASSERT_MSG_EQ(packet->PeekPacketTag(tag), false, "Duplicate tag");
+}
+
+/***********************
+ * MacCommandValueTest *
+ ***********************/
+
+class MacCommandValueTest : public TestCase
+{
+  public:
+    MacCommandValueTest();
+    ~MacCommandValueTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+MacCommandValueTest::MacCommandValueTest()
+    : TestCase("Verify that MAC command values serialize like the MacCommand objects")
+{
+}
+
+// Reminder that the test case should clean up after itself
+MacCommandValueTest::~MacCommandValueTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+MacCommandValueTest::DoRun()
+{
+    NS_LOG_DEBUG("MacCommandValueTest");
+
+    // Requests are parsed from downlinks and answers from uplinks
+    std::vector<std::tuple<Ptr<MacCommand>, bool>> commands = {
+        {Create<LinkCheckReq>(), true},
+        {Create<LinkCheckAns>(7, 3), false},
+        {Create<LinkAdrReq>(5, 2, 0b111, 0, 1), false},
+        {Create<LinkAdrAns>(true, false, true), true},
+        {Create<DutyCycleReq>(4), false},
+        {Create<DutyCycleAns>(), true},
+        {Create<RxParamSetupReq>(2, 3, 869525000), false},
+        {Create<RxParamSetupAns>(true, true, false), true},
+        {Create<DevStatusReq>(), false},
+        {Create<DevStatusAns>(200, 20), true},
+        {Create<NewChannelReq>(3, 867100000, 0, 5), false},
+        {Create<NewChannelAns>(true, false), true},
+        {Create<RxTimingSetupReq>(3), false},
+        {Create<RxTimingSetupAns>(), true},
+        {Create<TxParamSetupReq>(), false},
+        {Create<TxParamSetupAns>(), true},
+        {Create<DlChannelReq>(2, 868500000), false},
+        {Create<DlChannelAns>(false, true), true}};
+
+    for (const auto& [command, isUplink] : commands)
+    {
+        MacCommandValue value = command->GetValue();
+        NS_TEST_ASSERT_MSG_EQ(value.type, command->GetCommandType(), "Wrong type");
+        NS_TEST_ASSERT_MSG_EQ(unsigned(value.GetSerializedSize()),
+                              unsigned(command->GetSerializedSize()),
+                              "Wrong size");
+
+        // Same bytes as the object
+        uint8_t size = value.GetSerializedSize();
+        Buffer objectBuffer;
+        objectBuffer.AddAtStart(size);
+        Buffer::Iterator objectIt = objectBuffer.Begin();
+        command->Serialize(objectIt);
+        Buffer valueBuffer;
+        valueBuffer.AddAtStart(size);
+        Buffer::Iterator valueIt = valueBuffer.Begin();
+        value.Serialize(valueIt);
+        uint8_t objectBytes[8];
+        uint8_t valueBytes[8];
+        objectBuffer.CopyData(objectBytes, size);
+        valueBuffer.CopyData(valueBytes, size);
+        NS_TEST_ASSERT_MSG_EQ(std::memcmp(objectBytes, valueBytes, size),
+                              0,
+                              "Different serialization for type " << value.type);
+
+        // Same value back
+        MacCommandValue parsed;
+        Buffer::Iterator start = valueBuffer.Begin();
+        NS_TEST_ASSERT_MSG_EQ(unsigned(parsed.Deserialize(start, isUplink)),
+                              unsigned(size),
+                              "Wrong number of bytes consumed");
+        NS_TEST_ASSERT_MSG_EQ(parsed.type, value.type, "Type changes in the round trip");
+        NS_TEST_ASSERT_MSG_EQ(std::memcmp(parsed.bytes, value.bytes, sizeof(value.bytes)),
+                              0,
+                              "Fields change in the round trip for type " << value.type);
+    }
+
+    // Commands beyond the inline capacity (i.e., from the FRMPayload) are kept in order
+    MacCommandList list;
+    for (uint8_t i = 0; i < 2 * MacCommandList::INLINE_CAPACITY; ++i)
+    {
+        MacCommandValue value(DEV_STATUS_ANS);
+        value.devStatusAns = {i, 0};
+        list.PushBack(value);
+    }
+    NS_TEST_ASSERT_MSG_EQ(list.GetN(), 2U * MacCommandList::INLINE_CAPACITY, "Commands lost");
+    unsigned battery = 0;
+    for (const auto& value : list)
+    {
+        NS_TEST_ASSERT_MSG_EQ(unsigned(value.devStatusAns.battery), battery++, "Wrong order");
+    }
+    NS_TEST_ASSERT_MSG_EQ(bool(list.Find(DEV_STATUS_ANS)), true, "Command not found");
+    NS_TEST_ASSERT_MSG_EQ(bool(list.Find(LINK_ADR_ANS)), false, "Spurious command found");
+
+    // The compatibility layer of the frame header
+    LoraFrameHeader fHdr;
+    fHdr.SetAsDownlink();
+    fHdr.AddCommand(Create<LinkAdrReq>(3, 1, 0b101, 0, 2));
+    fHdr.AddLinkCheckAns(10, 2);
+    Ptr<LinkAdrReq> linkAdrReq = fHdr.GetMacCommand<LinkAdrReq>();
+    NS_TEST_ASSERT_MSG_EQ(bool(linkAdrReq), true, "LinkAdrReq not found");
+    NS_TEST_ASSERT_MSG_EQ(linkAdrReq->GetEnabledChannelsList().size(), 2U, "Wrong channels");
+    NS_TEST_ASSERT_MSG_EQ(linkAdrReq->GetRepetitions(), 2, "Wrong repetitions");
+    NS_TEST_ASSERT_MSG_EQ(unsigned(fHdr.GetFOptsLen()), 8U, "Wrong FOpts length");
+    NS_TEST_ASSERT_MSG_EQ(fHdr.GetCommands().size(), 2U, "Wrong number of commands");
+}
+
+/*************************
+ * LorawanFrameCodecTest *
+ *************************/
+
+class LorawanFrameCodecTest : public TestCase
+{
+  public:
+    LorawanFrameCodecTest();
+    ~LorawanFrameCodecTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+LorawanFrameCodecTest::LorawanFrameCodecTest()
+    : TestCase("Verify that the frame codec matches the headers and survives malformed input")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LorawanFrameCodecTest::~LorawanFrameCodecTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LorawanFrameCodecTest::DoRun()
+{
+    NS_LOG_DEBUG("LorawanFrameCodecTest");
+
+    // Same bytes as the packet headers
+    uint8_t payload[5] = {1, 2, 3, 4, 5};
+    Ptr<Packet> packet = Create<Packet>(payload, sizeof(payload));
+    LoraFrameHeader fHdr;
+    fHdr.SetAsUplink();
+    fHdr.SetAddress(LoraDeviceAddress(0x12345678));
+    fHdr.SetAdr(true);
+    fHdr.SetFCnt(0x0102);
+    fHdr.SetFPort(1);
+    fHdr.AddLinkAdrAns(true, false, true);
+    fHdr.AddCommand(Create<DevStatusAns>(200, 20));
+    packet->AddHeader(fHdr);
+    LorawanMacHeader mHdr;
+    mHdr.SetFType(LorawanMacHeader::CONFIRMED_DATA_UP);
+    packet->AddHeader(mHdr);
+    uint8_t mic[4] = {0xd4, 0xc3, 0xb2, 0xa1};
+    packet->AddAtEnd(Create<Packet>(mic, sizeof(mic)));
+    uint8_t expected[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t expectedSize = packet->CopyData(expected, sizeof(expected));
+
+    LorawanFrame frame;
+    frame.fType = LorawanMacHeader::CONFIRMED_DATA_UP;
+    frame.devAddr = 0x12345678;
+    frame.adr = true;
+    frame.fCnt = 0x0102;
+    frame.fOpts = fHdr.GetCommandList();
+    frame.fPort = 1;
+    frame.frmPayload = payload;
+    frame.frmPayloadSize = sizeof(payload);
+    frame.mic = 0xa1b2c3d4;
+    uint8_t data[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t size = LorawanFrameCodec::Encode(frame, data, sizeof(data));
+    NS_TEST_ASSERT_MSG_EQ(size, expectedSize, "Wrong encoded size");
+    NS_TEST_ASSERT_MSG_EQ(std::memcmp(data, expected, size), 0, "Different encoding");
+
+    // Same fields back, with the FRMPayload pointing into the input
+    LorawanFrame decoded;
+    NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Decode(data, size, decoded), true, "Decode failed");
+    NS_TEST_ASSERT_MSG_EQ(decoded.devAddr, frame.devAddr, "Wrong address");
+    NS_TEST_ASSERT_MSG_EQ(decoded.adr, true, "Wrong ADR bit");
+    NS_TEST_ASSERT_MSG_EQ(decoded.fCnt, frame.fCnt, "Wrong frame counter");
+    NS_TEST_ASSERT_MSG_EQ(decoded.fOpts.GetN(), 2U, "Wrong number of commands");
+    NS_TEST_ASSERT_MSG_EQ(decoded.fPort, 1, "Wrong port");
+    NS_TEST_ASSERT_MSG_EQ(decoded.frmPayload == data + size - 9, true, "FRMPayload copied");
+    NS_TEST_ASSERT_MSG_EQ(decoded.frmPayloadSize, 5U, "Wrong FRMPayload size");
+    NS_TEST_ASSERT_MSG_EQ(decoded.mic, frame.mic, "Wrong MIC");
+
+    // No room, no encoding
+    NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Encode(frame, data, size - 1), 0U, "Overflow");
+
+    // Random and mutated frames: decoding never fails badly, and decoded frames are
+    // re-encoded to bytes decoding to the same frame
+    auto sameFrame = [](const LorawanFrame& a, const LorawanFrame& b) {
+        if (a.fType != b.fType || a.major != b.major || a.devAddr != b.devAddr ||
+            a.adr != b.adr || a.adrAckReq != b.adrAckReq || a.ack != b.ack ||
+            a.fPending != b.fPending || a.fCnt != b.fCnt || a.fPort != b.fPort ||
+            a.frmPayloadSize != b.frmPayloadSize || a.mic != b.mic ||
+            a.fOpts.GetN() != b.fOpts.GetN() ||
+            std::memcmp(a.frmPayload, b.frmPayload, a.frmPayloadSize))
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < a.fOpts.GetN(); ++i)
+        {
+            const MacCommandValue& x = a.fOpts.begin()[i];
+            const MacCommandValue& y = b.fOpts.begin()[i];
+            if (x.type != y.type || std::memcmp(x.bytes, y.bytes, sizeof(x.bytes)))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto rv = CreateObject<UniformRandomVariable>();
+    rv->SetStream(1);
+    uint32_t valid = 0;
+    for (int i = 0; i < 5000; ++i)
+    {
+        uint8_t input[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+        uint32_t inputSize;
+        if (i % 2)
+        {
+            inputSize = rv->GetInteger(0, sizeof(input));
+            for (uint32_t j = 0; j < inputSize; ++j)
+            {
+                input[j] = rv->GetInteger(0, 255);
+            }
+        }
+        else
+        {
+            // Flip a few bytes of the valid frame, and cut it
+            std::memcpy(input, expected, expectedSize);
+            for (int j = 0; j < 3; ++j)
+            {
+                input[rv->GetInteger(0, expectedSize - 1)] = rv->GetInteger(0, 255);
+            }
+            inputSize = rv->GetInteger(0, expectedSize);
+        }
+
+        LorawanFrame first;
+        if (!LorawanFrameCodec::Decode(input, inputSize, first))
+        {
+            continue;
+        }
+        valid++;
+        NS_TEST_ASSERT_MSG_EQ(first.frmPayload + first.frmPayloadSize <= input + inputSize,
+                              true,
+                              "FRMPayload out of the input");
+        uint8_t encoded[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+        uint32_t encodedSize = LorawanFrameCodec::Encode(first, encoded, sizeof(encoded));
+        NS_TEST_ASSERT_MSG_GT(encodedSize, 0U, "Decoded frame not encodable");
+        LorawanFrame second;
+        NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Decode(encoded, encodedSize, second),
+                              true,
+                              "Encoded frame not decodable");
+        NS_TEST_ASSERT_MSG_EQ(sameFrame(first, second), true, "Frame changes in the round trip");
+    }
+    NS_TEST_ASSERT_MSG_GT(valid, 0U, "No valid input generated");
+}
+
+/******************************
+ * RangePositionAllocatorTest *
+ ******************************/
+
+class RangePositionAllocatorTest : public TestCase
+{
+  public:
+    RangePositionAllocatorTest();
+    ~RangePositionAllocatorTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+RangePositionAllocatorTest::RangePositionAllocatorTest()
+    : TestCase("Verify that the range position allocator only produces positions in range")
+{
+}
+
+// Reminder that the test case should clean up after itself
+RangePositionAllocatorTest::~RangePositionAllocatorTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+RangePositionAllocatorTest::DoRun()
+{
+    NS_LOG_DEBUG("RangePositionAllocatorTest");
+
+    // Two rings of sparse gateways: coverage discs do not fill the allocation disc
+    double range = 1000;
+    NodeContainer gateways;
+    gateways.Create(7);
+    auto hexAllocator = CreateObject<HexGridPositionAllocator>();
+    hexAllocator->SetAttribute("Z", DoubleValue(15.0));
+    hexAllocator->SetAttribute("distance", DoubleValue(3 * range));
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.SetPositionAllocator(hexAllocator);
+    mobility.Install(gateways);
+
+    std::vector<Vector> gwPositions;
+    for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+    {
+        gwPositions.push_back((*gw)->GetObject<MobilityModel>()->GetPosition());
+    }
+
+    double meanDist[2];
+    for (auto sampler : {RangePositionAllocator::REJECTION, RangePositionAllocator::COVERAGE_UNION})
+    {
+        auto allocator = CreateObject<RangePositionAllocator>();
+        allocator->SetAttribute("rho", DoubleValue(5 * range));
+        allocator->SetAttribute("range", DoubleValue(range));
+        allocator->SetAttribute("Z", DoubleValue(1.0));
+        allocator->SetAttribute("Sampler", EnumValue(sampler));
+        allocator->SetNodes(gateways);
+
+        uint32_t n = 5000;
+        double sum = 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            Vector pos = allocator->GetNext();
+            double nearest = range;
+            for (const auto& gw : gwPositions)
+            {
+                nearest = std::min(nearest, CalculateDistance(gw, pos));
+            }
+            NS_TEST_ASSERT_MSG_LT(nearest, range, "Position out of range");
+            NS_TEST_ASSERT_MSG_GT(nearest, 1.0, "Position too close to a gateway");
+            NS_TEST_ASSERT_MSG_LT_OR_EQ(std::sqrt(pos.x * pos.x + pos.y * pos.y),
+                                        5 * range,
+                                        "Position out of the allocation disc");
+            sum += nearest;
+        }
+        meanDist[sampler] = sum / n;
+    }
+    // Both samplers are uniform over the covered area (mean distance 2/3 of the range)
+    NS_TEST_EXPECT_MSG_EQ_TOL(meanDist[0], meanDist[1], 0.03 * range, "Different distributions");
+    NS_TEST_EXPECT_MSG_EQ_TOL(meanDist[0], 2.0 / 3 * range, 0.03 * range, "Not uniform");
+}
+
+/***************************
+ * GatewaySpatialIndexTest *
+ ***************************/
+
+class GatewaySpatialIndexTest : public TestCase
+{
+  public:
+    GatewaySpatialIndexTest();
+    ~GatewaySpatialIndexTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewaySpatialIndexTest::GatewaySpatialIndexTest()
+    : TestCase("Verify that the gateway spatial index finds the nearest gateways")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewaySpatialIndexTest::~GatewaySpatialIndexTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+GatewaySpatialIndexTest::DoRun()
+{
+    NS_LOG_DEBUG("GatewaySpatialIndexTest");
+
+    NodeContainer gateways;
+    gateways.Create(200);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.SetPositionAllocator("ns3::UniformDiscPositionAllocator",
+                                  "rho",
+                                  DoubleValue(10000),
+                                  "Z",
+                                  DoubleValue(15.0));
+    mobility.Install(gateways);
+    auto index = CreateObject<GatewaySpatialIndex>(gateways);
+
+    // Compare with a sort of all gateways, for positions in and out of the deployment
+    auto rv = CreateObject<UniformRandomVariable>();
+    auto check = [&](uint32_t k) {
+        Vector pos(rv->GetValue(-15000, 15000), rv->GetValue(-15000, 15000), 1.0);
+        std::vector<std::pair<double, uint32_t>> all;
+        for (uint32_t i = 0; i < gateways.GetN(); ++i)
+        {
+            Vector gw = gateways.Get(i)->GetObject<MobilityModel>()->GetPosition();
+            all.emplace_back(CalculateDistance(gw, pos), i);
+        }
+        std::sort(all.begin(), all.end());
+        auto nearest = index->GetNearest(pos, k);
+        NS_TEST_ASSERT_MSG_EQ(nearest.size(), std::min<size_t>(k, all.size()), "Wrong count");
+        for (uint32_t i = 0; i < nearest.size(); ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ(nearest[i].index, all[i].second, "Wrong gateway");
+            NS_TEST_ASSERT_MSG_EQ(nearest[i].distance, all[i].first, "Wrong distance");
+        }
+    };
+    for (uint32_t k : {1, 3, 8, 250})
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            check(k);
+        }
+    }
+
+    // Moving a gateway is followed by the index
+    gateways.Get(42)->GetObject<MobilityModel>()->SetPosition(Vector(20000, 20000, 15.0));
+    auto nearest = index->GetNearest(Vector(20001, 20000, 15.0), 1);
+    NS_TEST_ASSERT_MSG_EQ(nearest[0].index, 42U, "Moved gateway not found");
+    NS_TEST_ASSERT_MSG_EQ_TOL(nearest[0].distance, 1.0, 1e-9, "Wrong distance");
+    for (int i = 0; i < 100; ++i)
+    {
+        check(3);
+    }
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+// The TestSuite class names the TestSuite, identifies what type of TestSuite,
+// and enables the TestCases to be run. Typically, only the constructor for
+// this class must be defined
+
+/****************************
+ * AnalyticEnergySourceTest *
+ ****************************/
+
+class AnalyticEnergySourceTest : public TestCase
+{
+  public:
+    AnalyticEnergySourceTest();
+    ~AnalyticEnergySourceTest() override;
+
+  private:
+    void DoRun() override;
+    void CompareSources(Ptr<EnergySource> basic, Ptr<EnergySource> analytic);
+    void Depleted();
+
+    Time m_depletionTime;
+};
+
+// Add some help text to this case to describe what it is intended to test
+AnalyticEnergySourceTest::AnalyticEnergySourceTest()
+    : TestCase("Verify that the analytic energy source matches the basic one without updates")
+{
+}
+
+// Reminder that the test case should clean up after itself
+AnalyticEnergySourceTest::~AnalyticEnergySourceTest()
+{
+}
+
+void
+AnalyticEnergySourceTest::CompareSources(Ptr<EnergySource> basic, Ptr<EnergySource> analytic)
+{
+    NS_TEST_EXPECT_MSG_EQ_TOL(analytic->GetRemainingEnergy(),
+                              basic->GetRemainingEnergy(),
+                              1e-9,
+                              "Different remaining energy at " << Simulator::Now().As(Time::S));
+}
+
+void
+AnalyticEnergySourceTest::Depleted()
+{
+    m_depletionTime = Simulator::Now();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+AnalyticEnergySourceTest::DoRun()
+{
+    NS_LOG_DEBUG("AnalyticEnergySourceTest");
+
+    // The same radio activity drains a basic and an analytic source
+    Ptr<Node> node = CreateObject<Node>();
+    auto basic = CreateObject<BasicEnergySource>();
+    basic->SetInitialEnergy(100);
+    basic->SetSupplyVoltage(3);
+    basic->SetNode(node);
+    auto analytic = CreateObject<LoraAnalyticEnergySource>();
+    analytic->SetInitialEnergy(100);
+    analytic->SetSupplyVoltage(3);
+    analytic->SetNode(node);
+    std::vector<Ptr<LoraRadioEnergyModel>> models;
+    for (Ptr<EnergySource> source : {Ptr<EnergySource>(basic), Ptr<EnergySource>(analytic)})
+    {
+        auto model = CreateObject<LoraRadioEnergyModel>();
+        model->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(model);
+        models.push_back(model);
+        for (auto [t, state] : {std::make_pair(1.0, EndDeviceLoraPhy::TX),
+                                std::make_pair(2.5, EndDeviceLoraPhy::STANDBY),
+                                std::make_pair(3.5, EndDeviceLoraPhy::RX),
+                                std::make_pair(4.0, EndDeviceLoraPhy::SLEEP)})
+        {
+            Simulator::Schedule(Seconds(t), &LoraRadioEnergyModel::ChangeState, model, int(state));
+        }
+    }
+    for (double t : {2.0, 3.7, 10.0})
+    {
+        Simulator::Schedule(Seconds(t),
+                            &AnalyticEnergySourceTest::CompareSources,
+                            this,
+                            basic,
+                            analytic);
+    }
+    Simulator::Stop(Seconds(100));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(models[1]->GetTimeInState(EndDeviceLoraPhy::TX),
+                          Seconds(1.5),
+                          "Wrong time in TX");
+    NS_TEST_ASSERT_MSG_EQ(models[1]->GetTxTimePerPower().size(), 1U, "Wrong TX powers");
+    NS_TEST_ASSERT_MSG_EQ_TOL(models[1]->GetTotalEnergyConsumption(),
+                              models[0]->GetTotalEnergyConsumption(),
+                              1e-12,
+                              "Different consumption");
+    Simulator::Destroy();
+
+    // Depletion is notified at the analytic deadline: 0.9 J above the 10% threshold,
+    // drained at 0.028 A * 3 V from t = 1 s
+    node = CreateObject<Node>();
+    analytic = CreateObject<LoraAnalyticEnergySource>();
+    analytic->SetInitialEnergy(1);
+    analytic->SetSupplyVoltage(3);
+    analytic->SetNode(node);
+    auto model = CreateObject<LoraRadioEnergyModel>();
+    model->SetEnergySource(analytic);
+    analytic->AppendDeviceEnergyModel(model);
+    model->SetEnergyDepletionCallback(MakeCallback(&AnalyticEnergySourceTest::Depleted, this));
+    Simulator::Schedule(Seconds(1),
+                        &LoraRadioEnergyModel::ChangeState,
+                        model,
+                        int(EndDeviceLoraPhy::TX));
+    Simulator::Stop(Seconds(100));
+    Simulator::Run();
+    Time expectedTime = Seconds(1 + 0.9 / (0.028 * 3));
+    NS_TEST_ASSERT_MSG_EQ_TOL(m_depletionTime, expectedTime, MilliSeconds(1), "Wrong depletion");
+    Simulator::Destroy();
+}
+
+/*************************
+ * NetworkCheckpointTest *
+ *************************/
+
+class NetworkCheckpointTest : public TestCase
+{
+  public:
+    NetworkCheckpointTest();
+    ~NetworkCheckpointTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+NetworkCheckpointTest::NetworkCheckpointTest()
+    : TestCase("Verify that a checkpoint restores the state of a network in a new run")
+{
+}
+
+// Reminder that the test case should clean up after itself
+NetworkCheckpointTest::~NetworkCheckpointTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+NetworkCheckpointTest::DoRun()
+{
+    NS_LOG_DEBUG("NetworkCheckpointTest");
+
+    std::string filename = CreateTempDirFilename("network.ckpt");
+    NetworkCheckpointHelper checkpoint;
+    NS_TEST_ASSERT_MSG_EQ(checkpoint.Restore(filename), false, "Restored a missing checkpoint");
+
+    // Warm up a network with a device in a non-default state
+    NetworkComponents warm = InitializeNetwork(1, 1);
+    auto mac = GetMacLayerFromNode<ClassAEndDeviceLorawanMac>(warm.endDevices.Get(0));
+    mac->SetDataRate(3);
+    mac->SetTransmissionPower(8);
+    mac->SetFCnt(42);
+    mac->SetAdrAckCounter(70, true);
+    mac->SetRx1DrOffset(2);
+    mac->SetSecondReceiveWindowDataRate(3);
+    mac->SetRx1Delay(Seconds(2));
+    MacCommandValue answer(LINK_ADR_ANS);
+    answer.linkAdrAns = {true, false, true};
+    mac->AddMacCommand(answer);
+    mac->GetLogicalChannelManager()->DisableChannel(2);
+    mac->GetLogicalChannelManager()->GetSubBandList().front()->SetNextTransmissionTime(
+        Seconds(25));
+    auto app = CreateObject<PeriodicSender>();
+    app->SetInterval(Seconds(600));
+    app->SetInitialDelay(Seconds(20));
+    warm.endDevices.Get(0)->AddApplication(app);
+
+    auto server = DynamicCast<NetworkServer>(warm.nsNode->GetApplication(0));
+    Ptr<EndDeviceStatus> status =
+        server->GetNetworkStatus()->GetEndDeviceStatus(mac->GetDeviceAddress());
+    EndDeviceStatus::ReceivedPacketInfo info;
+    info.sf = 9;
+    info.frequency = 868100000;
+    EndDeviceStatus::PacketInfoPerGw gwInfo;
+    gwInfo.gwAddress = Mac48Address("00:00:00:00:00:01");
+    gwInfo.receivedTime = Seconds(3);
+    gwInfo.rxPower = -110.5;
+    info.gwList[gwInfo.gwAddress] = gwInfo;
+    status->AppendReceivedPacket(Create<Packet>(20), info);
+
+    Simulator::Stop(Seconds(15));
+    Simulator::Run();
+
+    LoraPacketTracker tracker;
+    Ptr<Packet> packet = Create<Packet>(10);
+    LorawanMacHeader mHdr;
+    mHdr.SetFType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+    packet->AddHeader(mHdr);
+    LoraTag tag;
+    tag.SetDataRate(3);
+    packet->AddPacketTag(tag);
+    tracker.TransmissionCallback(packet, 0);
+    tracker.PacketReceptionCallback(packet, 7);
+    std::vector<int> counts = tracker.CountPhyPacketsPerGw(Seconds(15), Seconds(16), 7);
+
+    checkpoint.SetEndDevices(warm.endDevices);
+    checkpoint.SetGateways(warm.gateways);
+    checkpoint.SetNetworkServer(server);
+    checkpoint.SetPacketTracker(tracker);
+    NS_TEST_ASSERT_MSG_EQ(checkpoint.Save(filename), true, "Checkpoint not saved");
+    Simulator::Destroy();
+
+    // Restore in a new network, before the applications start
+    NetworkComponents restored = InitializeNetwork(1, 1);
+    auto restoredMac = GetMacLayerFromNode<ClassAEndDeviceLorawanMac>(restored.endDevices.Get(0));
+    auto restoredApp = CreateObject<PeriodicSender>();
+    restoredApp->SetInterval(Seconds(600));
+    restored.endDevices.Get(0)->AddApplication(restoredApp);
+    auto restoredServer = DynamicCast<NetworkServer>(restored.nsNode->GetApplication(0));
+    LoraPacketTracker restoredTracker;
+    // Answers left over from a previous use of the device are replaced
+    restoredMac->AddMacCommand(MacCommandValue(DUTY_CYCLE_ANS));
+    restoredMac->AddMacCommand(answer);
+    // And so is the history of a server that already received uplinks
+    Ptr<EndDeviceStatus> usedStatus =
+        restoredServer->GetNetworkStatus()->GetEndDeviceStatus(restoredMac->GetDeviceAddress());
+    usedStatus->AppendReceivedPacket(Create<Packet>(30), info);
+    usedStatus->AppendReceivedPacket(Create<Packet>(40), info);
+
+    checkpoint.SetEndDevices(restored.endDevices);
+    checkpoint.SetGateways(restored.gateways);
+    checkpoint.SetNetworkServer(restoredServer);
+    checkpoint.SetPacketTracker(restoredTracker);
+    NS_TEST_ASSERT_MSG_EQ(checkpoint.Restore(filename), true, "Checkpoint not restored");
+
+    NS_TEST_EXPECT_MSG_EQ(unsigned(restoredMac->GetDataRate()), 3U, "Wrong data rate");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(restoredMac->GetTransmissionPower()), 8U, "Wrong power");
+    NS_TEST_EXPECT_MSG_EQ(restoredMac->GetFCnt(), 42, "Wrong FCnt");
+    NS_TEST_EXPECT_MSG_EQ(restoredMac->GetAdrAckCounter(), 70, "Wrong ADR_ACK_CNT");
+    NS_TEST_EXPECT_MSG_EQ(restoredMac->GetAdrAckRequest(), true, "Wrong ADRACKReq");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(restoredMac->GetRx1DrOffset()), 2U, "Wrong RX1DROffset");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(restoredMac->GetSecondReceiveWindowDataRate()),
+                          3U,
+                          "Wrong RX2 data rate");
+    NS_TEST_EXPECT_MSG_EQ(restoredMac->GetRx1Delay(), Seconds(2), "Wrong RX1 delay");
+    const MacCommandList& commands = restoredMac->GetPendingMacCommands();
+    NS_TEST_ASSERT_MSG_EQ(commands.GetN(), 1U, "Wrong pending commands");
+    NS_TEST_EXPECT_MSG_EQ(commands.begin()->type, LINK_ADR_ANS, "Wrong pending command");
+    NS_TEST_EXPECT_MSG_EQ(commands.begin()->linkAdrAns.dataRateAck, false, "Wrong answer");
+    Ptr<LogicalChannelManager> manager = restoredMac->GetLogicalChannelManager();
+    NS_TEST_EXPECT_MSG_EQ(manager->GetChannel(2)->IsEnabledForUplink(), false, "Wrong mask");
+    NS_TEST_EXPECT_MSG_EQ(manager->GetChannel(1)->IsEnabledForUplink(), true, "Wrong mask");
+    NS_TEST_EXPECT_MSG_EQ(manager->GetSubBandList().front()->GetNextTransmissionTime(),
+                          Seconds(10),
+                          "Wrong duty-cycle backoff");
+
+    Ptr<EndDeviceStatus> restoredStatus =
+        restoredServer->GetNetworkStatus()->GetEndDeviceStatus(restoredMac->GetDeviceAddress());
+    NS_TEST_ASSERT_MSG_EQ(restoredStatus->GetReceivedPacketList().size(), 1U, "Wrong history");
+    NS_TEST_EXPECT_MSG_EQ(restoredStatus->GetReceivedPacketList().front().first->GetSize(),
+                          20U,
+                          "Wrong history packet");
+    const auto& restoredInfo = restoredStatus->GetReceivedPacketList().front().second;
+    NS_TEST_EXPECT_MSG_EQ(unsigned(restoredInfo.sf), 9U, "Wrong history SF");
+    NS_TEST_ASSERT_MSG_EQ(restoredInfo.gwList.size(), 1U, "Wrong history gateways");
+    NS_TEST_EXPECT_MSG_EQ(restoredInfo.gwList.begin()->first,
+                          Address(Mac48Address("00:00:00:00:00:01")),
+                          "Wrong history gateway");
+    NS_TEST_EXPECT_MSG_EQ(restoredInfo.gwList.begin()->second.rxPower, -110.5, "Wrong power");
+    NS_TEST_EXPECT_MSG_EQ(restoredInfo.gwList.begin()->second.receivedTime,
+                          Seconds(-12),
+                          "Wrong reception time");
+
+    NS_TEST_EXPECT_MSG_EQ((restoredTracker.CountPhyPacketsPerGw(Seconds(0), Seconds(1), 7) ==
+                           counts),
+                          true,
+                          "Wrong tracker records");
+
+    // The first send follows the checkpoint phase
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(restoredApp->GetNextSendDelay(), Seconds(4), "Wrong application phase");
+    Simulator::Destroy();
+}
+
+/***********************
+ * MetricsExporterTest *
+ ***********************/
+
+class MetricsExporterTest : public TestCase
+{
+  public:
+    MetricsExporterTest();
+    ~MetricsExporterTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+MetricsExporterTest::MetricsExporterTest()
+    : TestCase("Verify that the metrics exporter writes snapshots of the network")
+{
+}
+
+// Reminder that the test case should clean up after itself
+MetricsExporterTest::~MetricsExporterTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+MetricsExporterTest::DoRun()
+{
+    NS_LOG_DEBUG("MetricsExporterTest");
+
+    NetworkComponents components = InitializeNetwork(1, 1);
+    OneShotSenderHelper appHelper;
+    appHelper.SetSendTime(Seconds(2));
+    appHelper.Install(components.endDevices);
+    LoraPacketTracker tracker;
+
+    std::string filename = CreateTempDirFilename("metrics.prom");
+    auto exporter = CreateObjectWithAttributes<MetricsExporter>("File",
+                                                                StringValue(filename),
+                                                                "Interval",
+                                                                TimeValue(Seconds(1)));
+    exporter->AddGateways(components.gateways);
+    exporter->SetPacketTracker(tracker);
+    exporter->Start();
+
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+    exporter->Stop();
+    NS_TEST_EXPECT_MSG_GT(exporter->GetNSnapshots(), 4U, "Snapshots not taken periodically");
+    Simulator::Destroy();
+
+    // The last snapshot is exported before Stop returns
+    std::ifstream file(filename);
+    NS_TEST_ASSERT_MSG_EQ(file.is_open(), true, "Metrics file not written");
+    std::stringstream text;
+    text << file.rdbuf();
+    std::ostringstream rx;
+    rx << "elora_gateway_rx_packets_total{gateway=\"" << components.gateways.Get(0)->GetId()
+       << "\"} 1\n";
+    NS_TEST_EXPECT_MSG_NE(text.str().find(rx.str()), std::string::npos, "Missing reception");
+    NS_TEST_EXPECT_MSG_NE(text.str().find("elora_simulation_time_seconds 5\n"),
+                          std::string::npos,
+                          "Missing final snapshot");
+    NS_TEST_EXPECT_MSG_NE(text.str().find("elora_packet_tracker_entries{layer=\"phy\"} 0\n"),
+                          std::string::npos,
+                          "Missing tracker size");
+}
+
+/*******************
+ * UplinkTraceTest *
+ *******************/
+
+class UplinkTraceTest : public TestCase
+{
+  public:
+    UplinkTraceTest();
+    ~UplinkTraceTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+UplinkTraceTest::UplinkTraceTest()
+    : TestCase("Verify that uplink traces are read back as written")
+{
+}
+
+// Reminder that the test case should clean up after itself
+UplinkTraceTest::~UplinkTraceTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+UplinkTraceTest::DoRun()
+{
+    NS_LOG_DEBUG("UplinkTraceTest");
+
+    UplinkRecord written;
+    written.time = MilliSeconds(1234);
+    written.gateway = 7;
+    written.packet.freq_hz = 868300000;
+    written.packet.datarate = DR_LORA_SF9;
+    written.packet.rssi = -117.5;
+    written.packet.snr = -3.25;
+    written.packet.size = 20;
+    for (uint8_t i = 0; i < written.packet.size; ++i)
+    {
+        written.packet.payload[i] = i * 13;
+    }
+
+    std::string filename = CreateTempDirFilename("uplinks.trace");
+    auto writer = CreateObject<UplinkTraceWriter>();
+    writer->Open(filename);
+    writer->Write(written);
+    written.time = Seconds(3600);
+    written.packet.size = 0;
+    writer->Write(written);
+    writer->Close();
+    NS_TEST_EXPECT_MSG_EQ(writer->GetNRecords(), 2U, "Wrong number of records written");
+
+    UplinkTraceReader reader;
+    NS_TEST_ASSERT_MSG_EQ(reader.Open(filename), true, "Trace header not recognized");
+    UplinkRecord read;
+    NS_TEST_ASSERT_MSG_EQ(reader.Read(read), true, "Missing first record");
+    NS_TEST_EXPECT_MSG_EQ(read.time, MilliSeconds(1234), "Wrong time");
+    NS_TEST_EXPECT_MSG_EQ(read.gateway, 7U, "Wrong gateway");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.freq_hz, 868300000U, "Wrong frequency");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.datarate, DR_LORA_SF9, "Wrong datarate");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.rssi, -117.5, "Wrong RSSI");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.snr, -3.25, "Wrong SNR");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.status, STAT_CRC_OK, "Wrong status");
+    NS_TEST_ASSERT_MSG_EQ(read.packet.size, 20, "Wrong payload size");
+    NS_TEST_EXPECT_MSG_EQ(std::memcmp(read.packet.payload, written.packet.payload, 20),
+                          0,
+                          "Wrong payload");
+    NS_TEST_ASSERT_MSG_EQ(reader.Read(read), true, "Missing second record");
+    NS_TEST_EXPECT_MSG_EQ(read.time, Seconds(3600), "Wrong time");
+    NS_TEST_EXPECT_MSG_EQ(read.packet.size, 0, "Wrong payload size");
+    NS_TEST_EXPECT_MSG_EQ(reader.Read(read), false, "Read past the end of the trace");
+
+    reader.Rewind();
+    NS_TEST_EXPECT_MSG_EQ(reader.Read(read), true, "Rewind failed");
+    NS_TEST_EXPECT_MSG_EQ(read.time, MilliSeconds(1234), "Wrong time after rewind");
+}
+
+/**********************
+ * UplinkReplayerTest *
+ **********************/
+
+class UplinkReplayerTest : public TestCase
+{
+  public:
+    UplinkReplayerTest();
+    ~UplinkReplayerTest() override;
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Build a received unconfirmed data uplink.
+     *
+     * \param devAddr The address of the sender.
+     * \param fCnt The frame counter.
+     */
+    lgw_pkt_rx_s CreateUplink(uint32_t devAddr, uint16_t fCnt);
+};
+
+// Add some help text to this case to describe what it is intended to test
+UplinkReplayerTest::UplinkReplayerTest()
+    : TestCase("Verify that the uplink replayer follows the timing and rewrites frame counters")
+{
+}
+
+// Reminder that the test case should clean up after itself
+UplinkReplayerTest::~UplinkReplayerTest()
+{
+}
+
+lgw_pkt_rx_s
+UplinkReplayerTest::CreateUplink(uint32_t devAddr, uint16_t fCnt)
+{
+    LorawanFrame frame;
+    frame.fType = LorawanMacHeader::UNCONFIRMED_DATA_UP;
+    frame.devAddr = devAddr;
+    frame.fCnt = fCnt;
+    lgw_pkt_rx_s packet = {};
+    packet.freq_hz = 868100000;
+    packet.status = STAT_CRC_OK;
+    packet.datarate = DR_LORA_SF7;
+    packet.size = LorawanFrameCodec::Encode(frame, packet.payload, sizeof(packet.payload));
+    return packet;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+UplinkReplayerTest::DoRun()
+{
+    NS_LOG_DEBUG("UplinkReplayerTest");
+
+    // Forwarders that are never started keep everything in their receive buffer
+    NodeContainer gateways;
+    gateways.Create(3);
+    std::vector<Ptr<UdpForwarder>> forwarders;
+    for (uint32_t i = 0; i < gateways.GetN(); ++i)
+    {
+        auto forwarder = CreateObject<UdpForwarder>();
+        forwarder->SetStartTime(Seconds(1000));
+        gateways.Get(i)->AddApplication(forwarder);
+        forwarders.push_back(forwarder);
+    }
+
+    // Record a short run on the first two gateways
+    std::string recorded = CreateTempDirFilename("recorded.trace");
+    auto recorder = CreateObject<UplinkTraceWriter>();
+    recorder->Open(recorded);
+    forwarders[0]->SetRecorder(recorder);
+    forwarders[1]->SetRecorder(recorder);
+    uint32_t devAddr = LoraDeviceAddress(1, 10).Get();
+    lgw_pkt_rx_s joinRequest = {};
+    joinRequest.status = STAT_CRC_OK;
+    joinRequest.size = 23; // MType 0b000
+    Simulator::Schedule(Seconds(1),
+                        &UdpForwarder::InjectUplink,
+                        forwarders[0],
+                        CreateUplink(devAddr, 5));
+    Simulator::Schedule(MilliSeconds(1500),
+                        &UdpForwarder::InjectUplink,
+                        forwarders[0],
+                        CreateUplink(devAddr, 6));
+    Simulator::Schedule(Seconds(2),
+                        &UdpForwarder::InjectUplink,
+                        forwarders[1],
+                        CreateUplink(devAddr, 7));
+    Simulator::Schedule(Seconds(3), &UdpForwarder::InjectUplink, forwarders[0], joinRequest);
+    Simulator::Schedule(Seconds(5), &UplinkTraceWriter::Close, recorder);
+
+    // Replay it twice as fast, 10 s later, on the first gateway only
+    std::string replayed = CreateTempDirFilename("replayed.trace");
+    auto replayRecorder = CreateObject<UplinkTraceWriter>();
+    replayRecorder->Open(replayed);
+    const uint32_t fCntOffset = 70000;
+    auto replayer = CreateObjectWithAttributes<UplinkReplayer>("File",
+                                                               StringValue(recorded),
+                                                               "Speed",
+                                                               DoubleValue(2),
+                                                               "TimeShift",
+                                                               TimeValue(Seconds(10)),
+                                                               "FCntOffset",
+                                                               UintegerValue(fCntOffset),
+                                                               "EnableCryptography",
+                                                               BooleanValue(true));
+    replayer->AddForwarders(NodeContainer(gateways.Get(0)));
+    Simulator::Schedule(Seconds(6), &UdpForwarder::SetRecorder, forwarders[0], replayRecorder);
+    Simulator::Schedule(Seconds(6), &UplinkReplayer::Start, replayer);
+
+    // Replay four uplinks as fast as possible on the third gateway
+    std::string burst = CreateTempDirFilename("burst.trace");
+    auto burstWriter = CreateObject<UplinkTraceWriter>();
+    burstWriter->Open(burst);
+    for (uint16_t fCnt = 0; fCnt < 4; ++fCnt)
+    {
+        burstWriter->Write({Seconds(fCnt), gateways.Get(2)->GetId(), CreateUplink(devAddr, fCnt)});
+    }
+    burstWriter->Close();
+    auto burstReplayer = CreateObjectWithAttributes<UplinkReplayer>("File",
+                                                                    StringValue(burst),
+                                                                    "Speed",
+                                                                    DoubleValue(0),
+                                                                    "MaxBacklog",
+                                                                    UintegerValue(2));
+    burstReplayer->AddForwarders(NodeContainer(gateways.Get(2)));
+    Simulator::Schedule(Seconds(20), &UplinkReplayer::Start, burstReplayer);
+
+    Simulator::Stop(Seconds(30));
+    Simulator::Run();
+    replayRecorder->Close();
+
+    // Records of unknown gateways are skipped
+    NS_TEST_EXPECT_MSG_EQ(replayer->GetNReplayed(), 3U, "Wrong number of replayed uplinks");
+    NS_TEST_EXPECT_MSG_EQ(replayer->GetNSkipped(), 1U, "Wrong number of skipped uplinks");
+
+    // Replay times are shifted and scaled, counters rewritten and MICs recomputed
+    UplinkTraceReader reader;
+    NS_TEST_ASSERT_MSG_EQ(reader.Open(replayed), true, "Replayed trace not recognized");
+    std::vector<Time> times = {MilliSeconds(10500), MilliSeconds(10750)};
+    LoRaMacCrypto crypto;
+    UplinkRecord record;
+    for (uint16_t i = 0; i < times.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(reader.Read(record), true, "Missing replayed uplink");
+        NS_TEST_EXPECT_MSG_EQ(record.time, times[i], "Wrong injection time");
+        NS_TEST_EXPECT_MSG_EQ(record.gateway, gateways.Get(0)->GetId(), "Wrong gateway");
+        uint8_t* payload = record.packet.payload;
+        uint32_t size = record.packet.size;
+        uint32_t fCnt = 5 + i + fCntOffset;
+        NS_TEST_EXPECT_MSG_EQ(unsigned(payload[6]), fCnt & 0xff, "Wrong FCnt low byte");
+        NS_TEST_EXPECT_MSG_EQ(unsigned(payload[7]), (fCnt >> 8) & 0xff, "Wrong FCnt high byte");
+        uint32_t mic = 0;
+        crypto.ComputeCmacB0(payload,
+                             size - 4,
+                             F_NWK_S_INT_KEY,
+                             false,
+                             UPLINK,
+                             devAddr,
+                             fCnt,
+                             &mic);
+        uint32_t received;
+        std::memcpy(&received, payload + size - 4, 4);
+        NS_TEST_EXPECT_MSG_EQ(received, mic, "Wrong MIC");
+    }
+    NS_TEST_ASSERT_MSG_EQ(reader.Read(record), true, "Missing replayed join request");
+    NS_TEST_EXPECT_MSG_EQ(record.time, MilliSeconds(11500), "Wrong injection time");
+    NS_TEST_EXPECT_MSG_EQ(record.packet.size, 23, "Wrong join request size");
+    uint8_t zeros[23] = {};
+    NS_TEST_EXPECT_MSG_EQ(std::memcmp(record.packet.payload, zeros, 23),
+                          0,
+                          "Join request rewritten");
+    NS_TEST_EXPECT_MSG_EQ(reader.Read(record), false, "Unexpected replayed uplink");
+
+    // As fast as possible, the replay waits for the backlog to be forwarded
+    NS_TEST_EXPECT_MSG_EQ(burstReplayer->GetNReplayed(), 2U, "Backlog limit not applied");
+    NS_TEST_EXPECT_MSG_EQ(forwarders[2]->GetRxBufferSize(), 2U, "Wrong backlog");
+    burstReplayer->Stop();
+
+    Simulator::Destroy();
+}
+
+/**************************
+ * VirtualDeviceFleetTest *
+ **************************/
+
+class VirtualDeviceFleetTest : public TestCase
+{
+  public:
+    VirtualDeviceFleetTest();
+    ~VirtualDeviceFleetTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+VirtualDeviceFleetTest::VirtualDeviceFleetTest()
+    : TestCase("Verify that virtual devices send valid uplinks and answer downlinks")
+{
+}
+
+// Reminder that the test case should clean up after itself
+VirtualDeviceFleetTest::~VirtualDeviceFleetTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+VirtualDeviceFleetTest::DoRun()
+{
+    NS_LOG_DEBUG("VirtualDeviceFleetTest");
+
+    // The fleet follows 100 real devices of the same network
+    auto fleet = CreateObjectWithAttributes<VirtualDeviceFleet>("FirstNwkAddr", UintegerValue(100));
+    fleet->SetDataRateMix({0, 0, 1}); // DR2 only
+    fleet->AddDevices(3);
+    NS_TEST_EXPECT_MSG_EQ(fleet->GetNDevices(), 3, "Wrong number of devices");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(fleet->GetDataRate(2)), 2, "Wrong data rate");
+    uint32_t address = fleet->GetDeviceAddress(2).Get();
+    NS_TEST_EXPECT_MSG_EQ(address, LoraDeviceAddress(1, 102).Get(), "Wrong device address");
+
+    // Uplinks carry the MIC of the session key of the device
+    uint8_t key[16];
+    for (uint8_t i = 0; i < 16; ++i)
+    {
+        key[i] = i;
+    }
+    fleet->SetSessionKey(2, key);
+    uint8_t data[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t size = fleet->EncodeUplink(2, data);
+    LorawanFrame frame;
+    NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Decode(data, size, frame), true, "Invalid uplink");
+    NS_TEST_EXPECT_MSG_EQ(frame.devAddr, address, "Wrong address in the uplink");
+    NS_TEST_EXPECT_MSG_EQ(frame.fCnt, 0, "Wrong frame counter");
+    NS_TEST_EXPECT_MSG_EQ(frame.ack, false, "Unexpected ACK");
+    NS_TEST_EXPECT_MSG_EQ(frame.fOpts.IsEmpty(), true, "Unexpected MAC commands");
+    LoRaMacCrypto crypto;
+    crypto.SetKey(F_NWK_S_INT_KEY, key);
+    uint32_t mic = 0;
+    crypto.ComputeCmacB0(data, size - 4, F_NWK_S_INT_KEY, false, UPLINK, address, 0, &mic);
+    uint32_t received;
+    std::memcpy(&received, data + size - 4, 4);
+    NS_TEST_EXPECT_MSG_EQ(received, mic, "Wrong MIC");
+
+    // A confirmed downlink with MAC commands is answered in the next uplink
+    LorawanFrame downlink;
+    downlink.fType = LorawanMacHeader::CONFIRMED_DATA_DOWN;
+    downlink.devAddr = address;
+    MacCommandValue linkAdrReq(LINK_ADR_REQ);
+    linkAdrReq.linkAdrReq = {5, 1, 0x0007, 0, 1};
+    downlink.fOpts.PushBack(linkAdrReq);
+    downlink.fOpts.PushBack(MacCommandValue(DEV_STATUS_REQ));
+    uint8_t bytes[LorawanFrameCodec::MAX_PHY_PAYLOAD_SIZE];
+    uint32_t downlinkSize = LorawanFrameCodec::Encode(downlink, bytes, sizeof(bytes));
+    NS_TEST_ASSERT_MSG_GT(downlinkSize, 0, "Downlink not encoded");
+    fleet->ReceiveDownlink(Create<Packet>(bytes, downlinkSize));
+    NS_TEST_EXPECT_MSG_EQ(fleet->GetNDownlinks(), 1, "Downlink not received");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(fleet->GetDataRate(2)), 5, "LinkADRReq not applied");
+
+    size = fleet->EncodeUplink(2, data);
+    NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Decode(data, size, frame), true, "Invalid uplink");
+    NS_TEST_EXPECT_MSG_EQ(frame.fCnt, 1, "Frame counter not incremented");
+    NS_TEST_EXPECT_MSG_EQ(frame.ack, true, "Confirmed downlink not acknowledged");
+    NS_TEST_EXPECT_MSG_EQ(bool(frame.fOpts.Find(LINK_ADR_ANS)), true, "Missing LinkADRAns");
+    NS_TEST_EXPECT_MSG_EQ(bool(frame.fOpts.Find(DEV_STATUS_ANS)), true, "Missing DevStatusAns");
+
+    // Answers are sent once, and downlinks to other networks are ignored
+    size = fleet->EncodeUplink(2, data);
+    NS_TEST_ASSERT_MSG_EQ(LorawanFrameCodec::Decode(data, size, frame), true, "Invalid uplink");
+    NS_TEST_EXPECT_MSG_EQ(frame.ack, false, "ACK repeated");
+    NS_TEST_EXPECT_MSG_EQ(frame.fOpts.IsEmpty(), true, "Answers repeated");
+    downlink.devAddr = LoraDeviceAddress(0, 2).Get();
+    downlinkSize = LorawanFrameCodec::Encode(downlink, bytes, sizeof(bytes));
+    fleet->ReceiveDownlink(Create<Packet>(bytes, downlinkSize));
+    NS_TEST_EXPECT_MSG_EQ(fleet->GetNDownlinks(), 1, "Downlink of another network received");
+    downlink.devAddr = LoraDeviceAddress(1, 2).Get();
+    downlinkSize = LorawanFrameCodec::Encode(downlink, bytes, sizeof(bytes));
+    fleet->ReceiveDownlink(Create<Packet>(bytes, downlinkSize));
+    NS_TEST_EXPECT_MSG_EQ(fleet->GetNDownlinks(), 1, "Downlink of a real device received");
+}
+
+/*******************
+ * LoraPhyMathTest *
+ *******************/
+
+class LoraPhyMathTest : public TestCase
+{
+  public:
+    LoraPhyMathTest();
+    ~LoraPhyMathTest() override;
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Time on air with the floating point formula of the SX1272 LoRa modem
+     * designer's guide, as LoraPhy computed it before LoraPhyMath.
+     */
+    Time GetReferenceTimeOnAir(uint32_t size, const LoraPhyTxParameters& txParams);
+};
+
+// Add some help text to this case to describe what it is intended to test
+LoraPhyMathTest::LoraPhyMathTest()
+    : TestCase("Verify that LoraPhyMath matches the runtime LoRa formulas exactly")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LoraPhyMathTest::~LoraPhyMathTest()
+{
+}
+
+Time
+LoraPhyMathTest::GetReferenceTimeOnAir(uint32_t size, const LoraPhyTxParameters& txParams)
+{
+    Time tSym = Seconds(pow(2, int(txParams.sf)) / (txParams.bandwidthHz));
+    Time tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
+    double de = txParams.lowDataRateOptimizationEnabled ? 1 : 0;
+    double h = txParams.headerDisabled ? 1 : 0;
+    double crc = txParams.crcEnabled ? 1 : 0;
+    double num = 8 * double(size) - 4 * txParams.sf + 28 + 16 * crc - 20 * h;
+    double den = 4 * (txParams.sf - 2 * de);
+    double payloadSymbNb =
+        8 + std::max(std::ceil(num / den) * (txParams.codingRate + 4), double(0));
+    return tPreamble + payloadSymbNb * tSym;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LoraPhyMathTest::DoRun()
+{
+    NS_LOG_DEBUG("LoraPhyMathTest");
+
+    // Tables are built at compile time
+    constexpr uint32_t symbols = LoraPhyMath::GetPayloadSymbols(7, 1, 23, true, false, false);
+    NS_TEST_EXPECT_MSG_EQ(symbols, 48, "Unexpected number of payload symbols");
+
+    // Every tabulated time on air, with and without a packet
+    uint32_t mismatches = 0;
+    uint32_t packetMismatches = 0;
+    LoraPhyTxParameters txParams;
+    for (double bandwidth : {125000.0, 250000.0, 500000.0})
+    {
+        txParams.bandwidthHz = bandwidth;
+        for (uint8_t sf = LoraPhyMath::MIN_SF; sf <= LoraPhyMath::MAX_SF; ++sf)
+        {
+            txParams.sf = sf;
+            NS_TEST_EXPECT_MSG_EQ(LoraPhy::GetTSym(txParams),
+                                  Seconds(pow(2, int(sf)) / bandwidth),
+                                  "Wrong symbol time");
+            NS_TEST_EXPECT_MSG_EQ(LoraPhyMath::NeedsLowDataRateOptimization(sf, bandwidth),
+                                  LoraPhy::GetTSym(txParams) > MilliSeconds(16),
+                                  "Wrong low data rate optimization");
+            for (uint8_t cr = 1; cr <= LoraPhyMath::N_CODING_RATES; ++cr)
+            {
+                txParams.codingRate = cr;
+                for (uint8_t flags = 0; flags < 8; ++flags)
+                {
+                    txParams.crcEnabled = flags & 1;
+                    txParams.headerDisabled = flags & 2;
+                    txParams.lowDataRateOptimizationEnabled = flags & 4;
+                    for (uint32_t size = 0; size <= LoraPhyMath::MAX_PAYLOAD_SIZE; ++size)
+                    {
+                        Time reference = GetReferenceTimeOnAir(size, txParams);
+                        mismatches += (LoraPhy::GetTimeOnAir(size, txParams) != reference);
+                        if (size % 64 == 0)
+                        {
+                            Ptr<Packet> packet = Create<Packet>(size);
+                            packetMismatches +=
+                                (LoraPhy::GetTimeOnAir(packet, txParams) != reference);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    NS_TEST_EXPECT_MSG_EQ(mismatches, 0, "Time on air differs from the reference formula");
+    NS_TEST_EXPECT_MSG_EQ(packetMismatches, 0, "Time on air of packets differs from sizes");
+
+    // Out of the table, the formula is evaluated on the fly
+    txParams.sf = 6;
+    NS_TEST_EXPECT_MSG_EQ(LoraPhy::GetTimeOnAir(300, txParams),
+                          GetReferenceTimeOnAir(300, txParams),
+                          "Wrong time on air out of the table");
+
+    // Short frames at high SFs do not wrap around
+    txParams = LoraPhyTxParameters();
+    NS_TEST_EXPECT_MSG_LT(LoraPhy::GetTimeOnAir(5, txParams),
+                          Seconds(1),
+                          "Time on air of a frame header wrapped around");
+
+    // SNR conversion, sensitivities and data rates
+    for (double power : {-140.0, -120.5, -80.25})
+    {
+        for (double bandwidth : {125000.0, 250000.0, 500000.0})
+        {
+            NS_TEST_EXPECT_MSG_EQ(LoraPhy::RxPowerToSNR(power, bandwidth),
+                                  power + 174 - 10 * log10(bandwidth) - 6,
+                                  "Wrong SNR");
+        }
+    }
+    NS_TEST_EXPECT_MSG_EQ(LoraPhyMath::GATEWAY_SENSITIVITY[12 - 7], -139.5, "Wrong sensitivity");
+    NS_TEST_EXPECT_MSG_EQ(LoraPhyMath::END_DEVICE_SENSITIVITY[7 - 7], -124, "Wrong sensitivity");
+    for (uint8_t dr = 0; dr <= 5; ++dr)
+    {
+        uint8_t sf = LoraPhyMath::GetSfFromDataRate(dr);
+        NS_TEST_EXPECT_MSG_EQ(unsigned(sf), 12U - dr, "Wrong SF of data rate");
+        NS_TEST_EXPECT_MSG_EQ(unsigned(LoraPhyMath::GetDataRateFromSf(sf)),
+                              unsigned(dr),
+                              "Wrong data rate of SF");
+    }
+    NS_TEST_EXPECT_MSG_EQ(unsigned(LoraPhyMath::GetSfFromDataRate(6)), 0, "Unexpected SF");
+}
+
+/*********************
+ * HostUdpSocketTest *
+ *********************/
+
+class HostUdpSocketTest : public TestCase
+{
+  public:
+    HostUdpSocketTest();
+    ~HostUdpSocketTest() override;
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Read the datagrams received by a socket.
+     */
+    void Receive(Ptr<Socket> socket);
+
+    /**
+     * Keep the simulation alive until all datagrams arrive from the host.
+     */
+    void Wait();
+
+    std::vector<uint32_t> m_sizes; //!< Sizes of the received datagrams, in order
+    Address m_from;                //!< Source of the last received datagram
+    uint32_t m_expected;           //!< Number of datagrams sent
+    uint32_t m_polls;              //!< Number of waits so far
+};
+
+// Add some help text to this case to describe what it is intended to test
+HostUdpSocketTest::HostUdpSocketTest()
+    : TestCase("Verify that HostUdpSocket sends and receives batches over the loopback"),
+      m_expected(0),
+      m_polls(0)
+{
+}
+
+// Reminder that the test case should clean up after itself
+HostUdpSocketTest::~HostUdpSocketTest()
+{
+}
+
+void
+HostUdpSocketTest::Receive(Ptr<Socket> socket)
+{
+    Address from;
+    while (Ptr<Packet> packet = socket->RecvFrom(from))
+    {
+        m_sizes.push_back(packet->GetSize());
+        m_from = from;
+    }
+}
+
+void
+HostUdpSocketTest::Wait()
+{
+    if (m_sizes.size() >= m_expected || ++m_polls > 2000)
+    {
+        return;
+    }
+    // Datagrams arrive in wall-clock time, through the reception thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    Simulator::Schedule(MilliSeconds(1), &HostUdpSocketTest::Wait, this);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+HostUdpSocketTest::DoRun()
+{
+    NS_LOG_DEBUG("HostUdpSocketTest");
+
+    Ptr<HostUdpSocket> receiver = CreateObject<HostUdpSocket>();
+    NS_TEST_ASSERT_MSG_EQ(receiver->Bind(InetSocketAddress(Ipv4Address("127.0.0.1"), 0)),
+                          0,
+                          "Failed to bind the receiver");
+    receiver->SetRecvCallback(MakeCallback(&HostUdpSocketTest::Receive, this));
+    Address receiverAddress;
+    receiver->GetSockName(receiverAddress);
+
+    // Several sendmmsg calls for the datagrams of the same instant
+    Ptr<HostUdpSocket> sender = CreateObject<HostUdpSocket>();
+    sender->SetAttribute("MaxBatch", UintegerValue(4));
+    NS_TEST_ASSERT_MSG_EQ(sender->Bind(InetSocketAddress(Ipv4Address("127.0.0.1"), 0)),
+                          0,
+                          "Failed to bind the sender");
+    Address senderAddress;
+    sender->GetSockName(senderAddress);
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        NS_TEST_EXPECT_MSG_EQ(sender->SendTo(Create<Packet>(10 + i), 0, receiverAddress),
+                              int(10 + i),
+                              "Datagram not queued");
+    }
+    NS_TEST_ASSERT_MSG_EQ(sender->Connect(receiverAddress), 0, "Failed to connect");
+    NS_TEST_EXPECT_MSG_EQ(sender->Send(Create<Packet>(100), 0), 100, "Datagram not queued");
+    m_expected = 11;
+
+    Simulator::Schedule(MilliSeconds(1), &HostUdpSocketTest::Wait, this);
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_sizes.size(), m_expected, "Datagrams lost on the loopback");
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        NS_TEST_EXPECT_MSG_EQ(m_sizes[i], 10 + i, "Datagrams reordered or truncated");
+    }
+    NS_TEST_EXPECT_MSG_EQ(m_sizes[10], 100, "Wrong size of the connected datagram");
+    NS_TEST_EXPECT_MSG_EQ(m_from, senderAddress, "Wrong source address");
+    NS_TEST_EXPECT_MSG_EQ(sender->GetRxAvailable(), 0, "Datagram handed to the wrong socket");
+
+    Simulator::Destroy();
+}
 
 class LorawanTestSuite : public TestSuite
 {
@@ -1813,6 +3798,23 @@ LorawanTestSuite::LorawanTestSuite()
     AddTestCase(new TimeOnAirTest, TestCase::QUICK);
     AddTestCase(new PhyConnectivityTest, TestCase::QUICK);
     AddTestCase(new LorawanMacTest, TestCase::QUICK);
+    AddTestCase(new AsyncPcapWriterTest, TestCase::QUICK);
+    AddTestCase(new FleetTrafficDriverTest, TestCase::QUICK);
+    AddTestCase(new TimingWheelSchedulerTest, TestCase::QUICK);
+    AddTestCase(new BikeSharingMobilityTest, TestCase::QUICK);
+    AddTestCase(new LoraTagTest, TestCase::QUICK);
+    AddTestCase(new MacCommandValueTest, TestCase::QUICK);
+    AddTestCase(new LorawanFrameCodecTest, TestCase::QUICK);
+    AddTestCase(new RangePositionAllocatorTest, TestCase::QUICK);
+    AddTestCase(new GatewaySpatialIndexTest, TestCase::QUICK);
+    AddTestCase(new AnalyticEnergySourceTest, TestCase::QUICK);
+    AddTestCase(new NetworkCheckpointTest, TestCase::QUICK);
+    AddTestCase(new MetricsExporterTest, TestCase::QUICK);
+    AddTestCase(new UplinkTraceTest, TestCase::QUICK);
+    AddTestCase(new UplinkReplayerTest, TestCase::QUICK);
+    AddTestCase(new VirtualDeviceFleetTest, TestCase::QUICK);
+    AddTestCase(new LoraPhyMathTest, TestCase::QUICK);
+    AddTestCase(new HostUdpSocketTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
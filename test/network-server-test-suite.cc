@@ -16,9 +16,15 @@
 
 #include "ns3/callback.h"
 #include "ns3/core-module.h"
+#include "ns3/csma-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
 #include "ns3/log.h"
 #include "ns3/network-server-helper.h"
 #include "ns3/network-server.h"
+#include "ns3/udp-forwarder-helper.h"
+#include "ns3/udp-forwarder.h"
+#include "ns3/udp-network-server.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -274,6 +280,143 @@ LinkCheckTest::DoRun()
     NS_ASSERT(m_receivedPacketAtEd);
 }
 
+///////////////////////////
+// UdpDownlinkPacketTest //
+///////////////////////////
+
+class UdpDownlinkPacketTest : public TestCase
+{
+  public:
+    UdpDownlinkPacketTest();
+    ~UdpDownlinkPacketTest() override;
+
+    void ReceivedPacketAtEndDevice(uint8_t requiredTransmissions,
+                                   bool success,
+                                   Time time,
+                                   Ptr<Packet> packet);
+    void TxAcknowledged(Time latency, std::string error);
+    void SendPacket(Ptr<Node> endDevice);
+
+  private:
+    void DoRun() override;
+    bool m_receivedPacketAtEd = false;
+    std::string m_txAckError;
+};
+
+// Add some help text to this case to describe what it is intended to test
+UdpDownlinkPacketTest::UdpDownlinkPacketTest()
+    : TestCase("Verify that devices requesting an acknowledgment receive a reply "
+               "from the UdpNetworkServer through the packet forwarder protocol")
+{
+}
+
+// Reminder that the test case should clean up after itself
+UdpDownlinkPacketTest::~UdpDownlinkPacketTest()
+{
+}
+
+void
+UdpDownlinkPacketTest::ReceivedPacketAtEndDevice(uint8_t requiredTransmissions,
+                                                 bool success,
+                                                 Time time,
+                                                 Ptr<Packet> packet)
+{
+    NS_LOG_DEBUG("Received a packet at the ED");
+    m_receivedPacketAtEd = success;
+}
+
+void
+UdpDownlinkPacketTest::TxAcknowledged(Time latency, std::string error)
+{
+    NS_LOG_DEBUG("TX_ACK received in " << latency.As(Time::MS) << ", error " << error);
+    m_txAckError = error;
+}
+
+void
+UdpDownlinkPacketTest::SendPacket(Ptr<Node> endDevice)
+{
+    auto mac = DynamicCast<BaseEndDeviceLorawanMac>(
+        DynamicCast<LoraNetDevice>(endDevice->GetDevice(0))->GetMac());
+    mac->SetFType(LorawanMacHeader::CONFIRMED_DATA_UP);
+    mac->Send(Create<Packet>(20));
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+UdpDownlinkPacketTest::DoRun()
+{
+    NS_LOG_DEBUG("UdpDownlinkPacketTest");
+
+    // MICs are computed by devices and verified by the server
+    Config::SetDefault("ns3::BaseEndDeviceLorawanMac::EnableCryptography", BooleanValue(true));
+    Config::SetDefault("ns3::UdpForwarder::ClockSource", EnumValue(UdpForwarder::SIMULATOR));
+
+    Ptr<LoraChannel> channel = CreateChannel();
+
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::UniformDiscPositionAllocator",
+                                  "rho",
+                                  DoubleValue(1000),
+                                  "X",
+                                  DoubleValue(0.0),
+                                  "Y",
+                                  DoubleValue(0.0));
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    NodeContainer endDevices = CreateEndDevices(1, mobility, channel);
+    NodeContainer gateways = CreateGateways(1, mobility, channel);
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    // IP backhaul between gateways and server
+    Ptr<Node> nsNode = CreateObject<Node>();
+    NodeContainer backhaul(NodeContainer(nsNode), gateways);
+    CsmaHelper csma;
+    csma.SetChannelAttribute("Delay", TimeValue(MilliSeconds(2)));
+    NetDeviceContainer csmaNetDevs = csma.Install(backhaul);
+    InternetStackHelper internet;
+    internet.Install(backhaul);
+    Ipv4AddressHelper addresses;
+    addresses.SetBase("10.1.2.0", "255.255.255.0");
+    addresses.Assign(csmaNetDevs);
+
+    NetworkServerHelper networkServerHelper;
+    networkServerHelper.SetType("ns3::UdpNetworkServer");
+    networkServerHelper.SetAttribute("EnableCryptography", BooleanValue(true));
+    networkServerHelper.SetEndDevices(endDevices);
+    networkServerHelper.Install(nsNode);
+
+    UdpForwarderHelper forwarderHelper;
+    forwarderHelper.SetAttribute("RemoteAddress", AddressValue(Ipv4Address("10.1.2.1")));
+    forwarderHelper.Install(gateways);
+
+    // Connect the trace sources
+    DynamicCast<BaseEndDeviceLorawanMac>(
+        DynamicCast<LoraNetDevice>(endDevices.Get(0)->GetDevice(0))->GetMac())
+        ->TraceConnectWithoutContext(
+            "RequiredTransmissions",
+            MakeCallback(&UdpDownlinkPacketTest::ReceivedPacketAtEndDevice, this));
+    nsNode->GetApplication(0)->TraceConnectWithoutContext(
+        "TxAcknowledged",
+        MakeCallback(&UdpDownlinkPacketTest::TxAcknowledged, this));
+
+    // Send a packet in uplink
+    Simulator::Schedule(Seconds(1), &UdpDownlinkPacketTest::SendPacket, this, endDevices.Get(0));
+
+    Simulator::Stop(Seconds(10)); // Allow for time to receive a downlink packet
+    Simulator::Run();
+
+    auto server = DynamicCast<UdpNetworkServer>(nsNode->GetApplication(0));
+    NS_TEST_EXPECT_MSG_EQ(server->GetNReceivedUplinks(), 1, "Uplink not delivered to the server");
+    NS_TEST_EXPECT_MSG_EQ(server->GetNDroppedUplinks(), 0, "Uplink rejected by the server");
+    NS_TEST_EXPECT_MSG_EQ(server->GetNSentDownlinks(), 1, "Reply not sent to the gateway");
+    NS_TEST_EXPECT_MSG_EQ(m_txAckError, "NONE", "Reply rejected by the gateway");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketAtEd, true, "Reply not received by the device");
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
 /**************
  * Test Suite *
  **************/
@@ -312,6 +455,7 @@ NetworkServerTestSuite::NetworkServerTestSuite()
     AddTestCase(new UplinkPacketTest, TestCase::QUICK);
     AddTestCase(new DownlinkPacketTest, TestCase::QUICK);
     AddTestCase(new LinkCheckTest, TestCase::QUICK);
+    AddTestCase(new UdpDownlinkPacketTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -150,6 +150,24 @@ LoRaMacCrypto::ComputeCmacB0 (uint8_t *msg, uint16_t len, KeyIdentifier_t keyID,
   return LORAMAC_CRYPTO_SUCCESS;
 }
 
+SecureElementStatus_t
+LoRaMacCrypto::SetKey (KeyIdentifier_t keyID, const uint8_t *key)
+{
+  if (key == NULL)
+    {
+      return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+  Key_t *keyItem;
+  SecureElementStatus_t retval = GetKeyByID (keyID, &keyItem);
+
+  if (retval == SECURE_ELEMENT_SUCCESS)
+    {
+      memcpy1 (keyItem->KeyValue, key, SE_KEY_SIZE);
+    }
+  return retval;
+}
+
 SecureElementStatus_t
 LoRaMacCrypto::SecureElementAesEncrypt (uint8_t *buffer, uint16_t size, KeyIdentifier_t keyID,
                                         uint8_t *encBuffer)
@@ -378,6 +378,15 @@ public:
                                        bool isAck, uint8_t dir, uint32_t devAddr, uint32_t fCnt,
                                        uint32_t *cmac);
 
+  /*!
+   * Sets a key
+   *
+   * \param[IN]  keyID          - Key identifier
+   * \param[IN]  key            - Key value
+   * \retval                    - Status of the operation
+   */
+  SecureElementStatus_t SetKey (KeyIdentifier_t keyID, const uint8_t *key);
+
 private:
   /*!
    * Encrypt a buffer